@@ -0,0 +1,358 @@
+//
+// LightWave Object batch loader
+//
+// Headless tool that loads many objects concurrently through the same path
+// as the viewer (ObjectReader: parse, then triangulate) and reports how
+// fast each file and the whole batch loaded. Used to validate and time an
+// object library without a display, e.g. on Linux batch nodes.
+//
+// Usage: LWObjectBatch [-j threads] [-q] [-s] [-p] [-t trace.json] file-or-directory...
+//
+// -s adds a breakdown of where the loads spent their time, summed over
+// every file. -p adds the CPU's cycles, instructions, cache misses and
+// branch misses per phase, on Linux where perf events are allowed; they
+// only count the loading thread, so pool work in a parallel parse is
+// missed. -t writes a timeline of the loads on every thread that
+// chrome://tracing and Perfetto can open; setting LWO_TRACE to a file
+// does the same.
+//
+// Directories are searched recursively for .lwo files. Uses only the
+// standard library, so on Linux it builds from this file, ../ObjectReader.cpp,
+// ../MeshCache.cpp and ../LightWaveObject/**/*.cpp with -std=c++17 -pthread.
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../ObjectReader.h"
+
+using namespace std;
+
+namespace {
+
+	// Outcome of loading one file
+	struct LOAD_RESULT {
+		string pathname;
+		bool loaded = false;
+		string message;				// Error, or warning for a loaded file
+		size_t bytes = 0;
+		size_t polygons = 0;
+		size_t triangles = 0;
+		double seconds = 0;
+		LOAD_STATISTICS statistics;
+		string hardwareCountersError;	// Why hardware counts are missing, if they were asked for
+	};
+
+	// Command line options
+	struct OPTIONS {
+		unsigned numThreads = 0;	// 0 for one per hardware thread
+		bool quiet = false;			// Only print the summary
+		bool statistics = false;	// Print the load phase breakdown
+		bool hardwareCounters = false;	// Add hardware counts to the breakdown
+		string tracePathname;		// Timeline to write, if any
+		vector<string> pathnames;
+	};
+
+	const double MB = 1024.0 * 1024.0;
+
+	/// <summary>
+	/// Print usage
+	/// </summary>
+	void printUsage() {
+		cerr << "Usage: LWObjectBatch [-j threads] [-q] [-s] [-p] [-t trace.json] file-or-directory..." << endl;
+	}
+
+	/// <summary>
+	/// Parse the command line
+	/// </summary>
+	/// <param name="argc">Argument count</param>
+	/// <param name="argv">Arguments</param>
+	/// <param name="options">Parsed options</param>
+	/// <returns>False if the command line is invalid</returns>
+	bool parseArguments(int argc, char* argv[], OPTIONS& options) {
+
+		for (int argIndex = 1; argIndex < argc; argIndex++) {
+			string arg = argv[argIndex];
+			if (arg == "-j" && argIndex + 1 < argc) {
+				options.numThreads = unsigned(max(0, atoi(argv[++argIndex])));
+			}
+			else if (arg == "-q") {
+				options.quiet = true;
+			}
+			else if (arg == "-s") {
+				options.statistics = true;
+			}
+			else if (arg == "-p") {
+				options.statistics = true;
+				options.hardwareCounters = true;
+			}
+			else if (arg == "-t" && argIndex + 1 < argc) {
+				options.tracePathname = argv[++argIndex];
+			}
+			else if (arg.size() > 1 && arg[0] == '-') {
+				return false;
+			}
+			else {
+				options.pathnames.push_back(arg);
+			}
+		}
+
+		return !options.pathnames.empty();
+	}
+
+	/// <summary>
+	/// Check for a LightWave object file extension
+	/// </summary>
+	/// <param name="path">File path</param>
+	/// <returns>True for .lwo in any case</returns>
+	bool isObjectFile(const filesystem::path& path) {
+		string extension = path.extension().string();
+		transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(tolower((unsigned char)c)); });
+		return extension == ".lwo";
+	}
+
+	/// <summary>
+	/// Expand the command line paths into a list of object files
+	/// </summary>
+	/// <param name="pathnames">Files and directories</param>
+	/// <returns>Object files; files named directly are kept whatever their extension</returns>
+	vector<string> findObjectFiles(const vector<string>& pathnames) {
+
+		vector<string> files;
+		for (const string& pathname : pathnames) {
+
+			error_code error;
+			if (!filesystem::is_directory(pathname, error)) {
+				files.push_back(pathname);
+				continue;
+			}
+
+			// Walk the directory, in a stable order
+			vector<string> found;
+			filesystem::recursive_directory_iterator iterator(pathname, filesystem::directory_options::skip_permission_denied, error);
+			for (; !error && iterator != filesystem::recursive_directory_iterator(); iterator.increment(error)) {
+				if (iterator->is_regular_file(error) && isObjectFile(iterator->path())) {
+					found.push_back(iterator->path().string());
+				}
+			}
+			sort(found.begin(), found.end());
+			files.insert(files.end(), found.begin(), found.end());
+		}
+
+		return files;
+	}
+
+	/// <summary>
+	/// Convert a message to narrow characters for the console; messages are plain ASCII
+	/// </summary>
+	/// <param name="message">Wide message</param>
+	/// <returns>Narrow message</returns>
+	string narrow(const wstring& message) {
+		string result;
+		result.reserve(message.size());
+		for (wchar_t c : message) {
+			result.push_back(c < 0x80 ? char(c) : '?');
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Load one object and time it
+	/// </summary>
+	/// <param name="pathname">Object file</param>
+	/// <param name="options">Which statistics to collect</param>
+	/// <returns>Load result</returns>
+	LOAD_RESULT loadObject(const string& pathname, const OPTIONS& options) {
+
+		using Clock = chrono::steady_clock;
+
+		LOAD_RESULT result;
+		result.pathname = pathname;
+		error_code error;
+		result.bytes = size_t(filesystem::file_size(pathname, error));
+
+		// Parse and triangulate, exactly as the viewer does
+		TraceScope trace("Batch load", "bytes", int64_t(result.bytes));
+		Clock::time_point start = Clock::now();
+		ObjectReader reader;
+		reader.SetCollectStatistics(options.statistics);
+		reader.SetSampleHardwareCounters(options.hardwareCounters);
+		wstring errorReason;
+		result.loaded = reader.ReadObjectFile(pathname, errorReason);
+		result.seconds = chrono::duration<double>(Clock::now() - start).count();
+
+		result.message = narrow(errorReason);
+		if (result.loaded) {
+			result.polygons = size_t(reader.GetNumPolygons());
+			result.triangles = size_t(reader.GetNumTriangles());
+			result.statistics = reader.GetLoadStatistics();
+		}
+		result.hardwareCountersError = narrow(reader.GetHardwareCountersError());
+
+		return result;
+	}
+
+	/// <summary>
+	/// Print one file's result
+	/// </summary>
+	/// <param name="result">Load result</param>
+	void printResult(const LOAD_RESULT& result) {
+
+		cout << (result.loaded ? "ok   " : "FAIL ") << result.pathname;
+		if (result.loaded) {
+			cout << fixed << setprecision(2)
+				<< "  " << result.bytes / MB << " MB"
+				<< "  " << result.polygons << " polygons"
+				<< "  " << result.seconds * 1000.0 << " ms"
+				<< "  " << (result.seconds > 0 ? result.bytes / MB / result.seconds : 0) << " MB/s";
+		}
+		if (!result.message.empty()) {
+			cout << "  (" << result.message << ")";
+		}
+		cout << endl;
+	}
+
+	/// <summary>
+	/// Get a percentile of sorted values, by the nearest-rank method
+	/// </summary>
+	/// <param name="sorted">Values in ascending order</param>
+	/// <param name="percent">Percentile, from 0 to 100</param>
+	/// <returns>Percentile value</returns>
+	double percentile(const vector<double>& sorted, double percent) {
+		if (sorted.empty()) return 0;
+		size_t rank = size_t(ceil(percent / 100.0 * sorted.size()));
+		return sorted[min(sorted.size(), max<size_t>(rank, 1)) - 1];
+	}
+
+	/// <summary>
+	/// Print the batch summary
+	/// </summary>
+	/// <param name="results">Every file's result</param>
+	/// <param name="numThreads">Worker threads used</param>
+	/// <param name="wallSeconds">Elapsed time for the whole batch</param>
+	/// <param name="printStatistics">True to add the load phase breakdown</param>
+	void printSummary(const vector<LOAD_RESULT>& results, unsigned numThreads, double wallSeconds, bool printStatistics) {
+
+		size_t numLoaded = 0;
+		size_t bytes = 0;
+		size_t polygons = 0;
+		size_t triangles = 0;
+		vector<double> latencies;
+		LOAD_STATISTICS statistics;
+		for (const LOAD_RESULT& result : results) {
+			if (!result.loaded) continue;
+			statistics.add(result.statistics);
+			numLoaded++;
+			bytes += result.bytes;
+			polygons += result.polygons;
+			triangles += result.triangles;
+			latencies.push_back(result.seconds);
+		}
+		sort(latencies.begin(), latencies.end());
+
+		cout << fixed << setprecision(2) << endl
+			<< "Files:       " << numLoaded << " loaded, " << results.size() - numLoaded << " failed" << endl
+			<< "Threads:     " << numThreads << endl
+			<< "Data:        " << bytes / MB << " MB, " << polygons << " polygons, " << triangles << " triangles" << endl
+			<< "Wall time:   " << wallSeconds << " s" << endl
+			<< "Throughput:  " << (wallSeconds > 0 ? bytes / MB / wallSeconds : 0) << " MB/s, "
+			<< (wallSeconds > 0 ? polygons / wallSeconds : 0) << " polygons/s" << endl
+			<< "Latency:     p50 " << percentile(latencies, 50) * 1000.0 << " ms, p99 " << percentile(latencies, 99) * 1000.0
+			<< " ms, max " << (latencies.empty() ? 0 : latencies.back() * 1000.0) << " ms" << endl;
+
+		// Phase times are summed over files, so with several threads they exceed the wall time
+		if (printStatistics) {
+			cout << endl << statistics.getReport();
+		}
+
+		// The counters fail the same way for every file, so one reason will do
+		for (const LOAD_RESULT& result : results) {
+			if (!result.hardwareCountersError.empty()) {
+				cout << "Hardware counters unavailable: " << result.hardwareCountersError << endl;
+				break;
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	OPTIONS options;
+	if (!parseArguments(argc, argv, options)) {
+		printUsage();
+		return 2;
+	}
+
+	vector<string> files = findObjectFiles(options.pathnames);
+	if (files.empty()) {
+		cerr << "No object files found" << endl;
+		return 1;
+	}
+
+	// Record a timeline of the batch if asked to
+	TraceRecorder& traceRecorder = TraceRecorder::getShared();
+	traceRecorder.setThreadName("Main");
+	if (!options.tracePathname.empty()) {
+		traceRecorder.start();
+	}
+	else {
+		traceRecorder.startFromEnvironment(options.tracePathname);
+	}
+
+	// Workers take the next file from a shared queue until it runs out
+	unsigned numThreads = options.numThreads ? options.numThreads : max(1u, thread::hardware_concurrency());
+	numThreads = unsigned(min<size_t>(numThreads, files.size()));
+
+	vector<LOAD_RESULT> results(files.size());
+	atomic<size_t> nextFile { 0 };
+	atomic<size_t> numFinished { 0 };
+	mutex outputMutex;
+
+	auto worker = [&]() {
+		for (size_t fileIndex = nextFile++; fileIndex < files.size(); fileIndex = nextFile++) {
+			results[fileIndex] = loadObject(files[fileIndex], options);
+			traceRecorder.counter("Files loaded", int64_t(++numFinished));
+			if (!options.quiet) {
+				lock_guard<mutex> lock(outputMutex);
+				printResult(results[fileIndex]);
+			}
+		}
+	};
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<thread> workers;
+	for (unsigned threadIndex = 1; threadIndex < numThreads; threadIndex++) {
+		workers.emplace_back([&, threadIndex]() {
+			traceRecorder.setThreadName(("Batch worker " + to_string(threadIndex)).c_str());
+			worker();
+		});
+	}
+	worker();
+	for (thread& workerThread : workers) {
+		workerThread.join();
+	}
+	double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printSummary(results, numThreads, wallSeconds, options.statistics);
+
+	// Write the timeline
+	if (traceRecorder.isEnabled()) {
+		traceRecorder.stop();
+		wstring errorReason;
+		if (!traceRecorder.writeFile(options.tracePathname, errorReason)) {
+			cerr << options.tracePathname << ": " << narrow(errorReason) << endl;
+		}
+	}
+
+	// Non-zero exit if anything failed, for scripts
+	bool allLoaded = all_of(results.begin(), results.end(), [](const LOAD_RESULT& result) { return result.loaded; });
+	return allLoaded ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+//
+// Allocation budgets
+//
+// Checks that a hot path makes no more heap allocations than its budget, so
+// that an allocation per element or per record fails as soon as it's added
+// rather than showing up later as a slower benchmark. Budgets are fixed
+// counts, checked at several sizes, so they also catch growth with size.
+//
+#pragma once
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+
+// Outcome of one budget check
+struct ALLOCATION_BUDGET_RESULT {
+	std::string name;
+	size_t budget = 0;			// Most allocations allowed
+	size_t allocations = 0;		// Allocations made by one run
+	size_t bytes = 0;			// Bytes requested by one run
+	bool passed = false;
+};
+
+// Result recording, defined in BenchmarkMain.cpp
+void recordBudgetResult(const ALLOCATION_BUDGET_RESULT& result);
+
+/// <summary>
+/// Print a budget check result
+/// </summary>
+/// <param name="result">Budget check result</param>
+inline void printBudgetResult(const ALLOCATION_BUDGET_RESULT& result) {
+	std::cout << std::left << std::setw(48) << result.name << std::right
+		<< std::setw(10) << result.allocations << " allocs"
+		<< std::setw(6) << "<=" << std::setw(6) << result.budget
+		<< std::setw(14) << result.bytes << " bytes"
+		<< (result.passed ? "    ok" : "    OVER BUDGET") << std::endl;
+}
+
+/// <summary>
+/// Count the allocations made by a body and check them against a budget.
+/// The body runs once first so that one-time setup, such as static tables
+/// and thread pools, isn't charged to it.
+/// </summary>
+/// <param name="name">Check name</param>
+/// <param name="budget">Most allocations one run may make</param>
+/// <param name="body">Code to check</param>
+/// <returns>Check result, passed if the check wasn't selected</returns>
+template<typename Body>
+ALLOCATION_BUDGET_RESULT checkAllocationBudget(const std::string& name, size_t budget, Body body) {
+
+	ALLOCATION_BUDGET_RESULT result;
+	result.name = name;
+	result.budget = budget;
+	result.passed = true;
+	if (!isBenchmarkSelected(name)) return result;
+
+	body();
+
+	ALLOCATION_COUNTS startCounts = getAllocationCounts();
+	body();
+	ALLOCATION_COUNTS endCounts = getAllocationCounts();
+
+	result.allocations = endCounts.allocations - startCounts.allocations;
+	result.bytes = endCounts.bytes - startCounts.bytes;
+	result.passed = result.allocations <= budget;
+	printBudgetResult(result);
+	recordBudgetResult(result);
+
+	return result;
+}
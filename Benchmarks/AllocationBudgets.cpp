@@ -0,0 +1,169 @@
+//
+// Allocation budgets
+//
+// Budgets for the hot paths of loading an object, checked at the hot path
+// benchmark sizes. The parsers size their arrays before decoding, so each
+// makes a fixed number of allocations whatever the size of the chunk.
+//
+#include <vector>
+
+#include "AllocationBudget.h"
+#include "BenchmarkObjects.h"
+#include "../LightWaveObject/LightWaveObject.h"
+#include "../LightWaveObject/Chunks/Points.h"
+#include "../LightWaveObject/Chunks/Polygons.h"
+#include "../LightWaveObject/Chunks/PolygonTags.h"
+#include "../LightWaveObject/Chunks/Surface.h"
+#include "../LightWaveObject/Chunks/Tags.h"
+#include "../LightWaveObject/Chunks/VertexMap.h"
+#include "../ObjectReader.h"
+
+namespace {
+
+	// Grid sizes, as in the hot path benchmarks
+	const unsigned GRID_SIZES[] = { 32, 256, 1024 };
+
+	// Tag and surface sub-chunk counts
+	const unsigned RECORD_COUNTS[] = { 16, 256, 4096 };
+
+	// The points array
+	const size_t POINTS_BUDGET = 1;
+
+	// The segment list, and the offsets, flags and indices of the polygon
+	// list; offsets start with one entry and grow once
+	const size_t POLYGONS_BUDGET = 5;
+
+	// The tag of each polygon
+	const size_t POLYGON_TAGS_BUDGET = 1;
+
+	// The channel list, an array per channel, and the point list of a sparse
+	// map or the mapped flags of a dense one with gaps; checked on a full UV
+	// map and a sparse weight map, which both have three
+	const size_t VERTEX_MAP_BUDGET = 3;
+
+	// Distance between the points of the sparse weight map
+	const unsigned SPARSE_MAP_STEP = 16;
+
+	// The tag list; names this short are stored in the strings themselves
+	const size_t TAGS_BUDGET = 1;
+
+	// The surface keeps only the values it understands, in fixed fields
+	const size_t SURFACE_BUDGET = 0;
+
+	// The arena's blocks, the layer and chunk directories, and the object's
+	// input; blocks grow geometrically, so this covers every size checked
+	const size_t READ_BUDGET = 32;
+
+	// The vertex and index streams, the layer, surface and range tables, the
+	// per-layer work list and its point arrays, the per-chunk work list and
+	// its normal arrays, the block list and its per-surface index counts, and
+	// three parallel loop bodies too large for std::function to hold inline
+	const size_t TRANSFER_BUDGET = 14;
+
+	/// <summary>
+	/// Check the chunk parsers, Read and the mesh transfer on one grid
+	/// </summary>
+	/// <param name="gridSize">Quads along each side of the grid</param>
+	void checkGridBudgets(unsigned gridSize) {
+
+		string suffix = "/" + to_string(size_t(gridSize) * gridSize);
+
+		vector<char> pointsChunk = makeChunk("PNTS", makeGridPoints(gridSize));
+		LWO_CHUNK_HEADER pointsHeader = LWUtils::parseChunkHeader(pointsChunk.data());
+		checkAllocationBudget("Budget Points::parse" + suffix, POINTS_BUDGET, [&]() {
+			Points points;
+			points.parse(BufferView(pointsChunk.data(), pointsChunk.size()), pointsHeader);
+			keepResult(points.getPoints().back());
+		});
+
+		vector<char> polygonsChunk = makeChunk("POLS", makeGridPolygons(gridSize));
+		LWO_CHUNK_HEADER polygonsHeader = LWUtils::parseChunkHeader(polygonsChunk.data());
+		checkAllocationBudget("Budget Polygons::parse" + suffix, POLYGONS_BUDGET, [&]() {
+			Polygons polygons;
+			polygons.parse(BufferView(polygonsChunk.data(), polygonsChunk.size()), polygonsHeader);
+			keepResult(polygons.getPolygons().pointIndex.back());
+		});
+
+		vector<char> polygonTagsChunk = makeChunk("PTAG", makePolygonTags(gridSize * gridSize, 8));
+		LWO_CHUNK_HEADER polygonTagsHeader = LWUtils::parseChunkHeader(polygonTagsChunk.data());
+		checkAllocationBudget("Budget PolygonTags::parse" + suffix, POLYGON_TAGS_BUDGET, [&]() {
+			PolygonTags polygonTags;
+			polygonTags.parse(BufferView(polygonTagsChunk.data(), polygonTagsChunk.size()), polygonTagsHeader);
+			keepResult(polygonTags.getTags().back());
+		});
+
+		unsigned numPoints = (gridSize + 1) * (gridSize + 1);
+		vector<char> uvMapChunk = makeChunk("VMAP", makeVertexMap("TXUV", 2, numPoints));
+		LWO_CHUNK_HEADER uvMapHeader = LWUtils::parseChunkHeader(uvMapChunk.data());
+		checkAllocationBudget("Budget VertexMap::parse/TXUV" + suffix, VERTEX_MAP_BUDGET, [&]() {
+			VertexMap vertexMap;
+			vertexMap.parse(BufferView(uvMapChunk.data(), uvMapChunk.size()), uvMapHeader);
+			keepResult(vertexMap.getChannel(1).back());
+		});
+
+		vector<char> weightMapChunk = makeChunk("VMAP", makeVertexMap("WGHT", 1, numPoints, SPARSE_MAP_STEP));
+		LWO_CHUNK_HEADER weightMapHeader = LWUtils::parseChunkHeader(weightMapChunk.data());
+		checkAllocationBudget("Budget VertexMap::parse/sparse WGHT" + suffix, VERTEX_MAP_BUDGET, [&]() {
+			VertexMap vertexMap;
+			vertexMap.parse(BufferView(weightMapChunk.data(), weightMapChunk.size()), weightMapHeader);
+			keepResult(vertexMap.getChannel(0).back());
+		});
+
+		vector<char> object = makeGridObject(1, gridSize);
+		checkAllocationBudget("Budget LightWaveObject::Read" + suffix, READ_BUDGET, [&]() {
+			LightWaveObject lwObject;
+			wstring errorReason;
+			lwObject.Read(object.data(), object.size(), errorReason);
+			keepResult(lwObject.GetNumLayers());
+		});
+
+		// A new reader each run, so its mesh streams are allocated every time
+		LightWaveObject lwObject;
+		wstring errorReason;
+		if (!lwObject.Read(object.data(), object.size(), errorReason)) return;
+		checkAllocationBudget("Budget ObjectReader::TransferMeshDataFromLWO" + suffix, TRANSFER_BUDGET, [&]() {
+			ObjectReader reader;
+			reader.TransferMeshDataFromLWO(lwObject, errorReason);
+			keepResult(reader.GetNumTriangles());
+		});
+	}
+
+	/// <summary>
+	/// Check the record-list parsers
+	/// </summary>
+	/// <param name="numRecords">Tags or surface sub-chunks</param>
+	void checkRecordBudgets(unsigned numRecords) {
+
+		string suffix = "/" + to_string(numRecords);
+
+		vector<char> tagsChunk = makeChunk("TAGS", makeTags(numRecords));
+		LWO_CHUNK_HEADER tagsHeader = LWUtils::parseChunkHeader(tagsChunk.data());
+		checkAllocationBudget("Budget Tags::parse" + suffix, TAGS_BUDGET, [&]() {
+			Tags tags;
+			tags.parse(BufferView(tagsChunk.data(), tagsChunk.size()), tagsHeader);
+			keepResult(tags.getTag());
+		});
+
+		vector<char> surfaceChunk = makeChunk("SURF", makeSurface(numRecords));
+		LWO_CHUNK_HEADER surfaceHeader = LWUtils::parseChunkHeader(surfaceChunk.data());
+		checkAllocationBudget("Budget Surface::parse" + suffix, SURFACE_BUDGET, [&]() {
+			Surface surface;
+			surface.parse(BufferView(surfaceChunk.data(), surfaceChunk.size()), surfaceHeader);
+			keepResult(surface.getCol12Color());
+		});
+	}
+}
+
+/// <summary>
+/// Run allocation budget checks
+/// </summary>
+void runAllocationBudgets() {
+
+	for (unsigned gridSize : GRID_SIZES) {
+		checkGridBudgets(gridSize);
+	}
+
+	for (unsigned numRecords : RECORD_COUNTS) {
+		checkRecordBudgets(numRecords);
+	}
+}
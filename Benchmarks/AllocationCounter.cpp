@@ -0,0 +1,97 @@
+//
+// Allocation counter
+//
+// Replaces the global allocation functions with versions that count calls
+// and bytes. Array and nothrow forms forward to these in the standard
+// library, so only the plain and aligned forms need replacing.
+//
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+#include "AllocationCounter.h"
+
+namespace {
+
+	// Totals; relaxed ordering is enough for counters read between runs
+	std::atomic<size_t> allocations { 0 };
+	std::atomic<size_t> allocatedBytes { 0 };
+
+	/// <summary>
+	/// Allocate and count a block
+	/// </summary>
+	/// <param name="size">Requested size</param>
+	/// <param name="alignment">Requested alignment, or 0 for the default</param>
+	/// <returns>Block, or nullptr if out of memory</returns>
+	void* countedAllocate(size_t size, size_t alignment) {
+
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (size == 0) size = 1;
+		if (alignment == 0) return malloc(size);
+
+#ifdef _MSC_VER
+		return _aligned_malloc(size, alignment);
+#else
+		// aligned_alloc needs a size that is a multiple of the alignment
+		return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	}
+
+	/// <summary>
+	/// Free a block from countedAllocate
+	/// </summary>
+	/// <param name="block">Block to free</param>
+	/// <param name="aligned">True if it was allocated with an alignment</param>
+	void countedFree(void* block, [[maybe_unused]] bool aligned) {
+#ifdef _MSC_VER
+		if (aligned) {
+			_aligned_free(block);
+			return;
+		}
+#endif
+		free(block);
+	}
+}
+
+/// <summary>
+/// Get the current totals
+/// </summary>
+/// <returns>Allocations and bytes since the program started</returns>
+ALLOCATION_COUNTS getAllocationCounts() {
+	ALLOCATION_COUNTS counts;
+	counts.allocations = allocations.load(std::memory_order_relaxed);
+	counts.bytes = allocatedBytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+// Replacement allocation functions
+
+void* operator new(size_t size) {
+	void* block = countedAllocate(size, 0);
+	if (block == nullptr) throw std::bad_alloc();
+	return block;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	void* block = countedAllocate(size, size_t(alignment));
+	if (block == nullptr) throw std::bad_alloc();
+	return block;
+}
+
+void operator delete(void* block) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete(void* block, size_t) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
+
+void operator delete(void* block, size_t, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
@@ -0,0 +1,17 @@
+//
+// Allocation counter
+//
+// Counts every allocation made through the global operator new, including
+// those made for the standard containers and by the parser's arenas.
+//
+#pragma once
+#include <stddef.h>
+
+// Running totals since the program started
+struct ALLOCATION_COUNTS {
+	size_t allocations = 0;		// Number of allocations
+	size_t bytes = 0;			// Bytes requested
+};
+
+// Get the current totals
+ALLOCATION_COUNTS getAllocationCounts();
@@ -0,0 +1,120 @@
+//
+// Benchmark harness
+//
+// Minimal timing harness for the parser benchmarks. Each case runs its body
+// repeatedly and reports the fastest run, with the allocations made per run.
+// Results are also recorded so main can write them out as JSON.
+//
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "AllocationCounter.h"
+
+// Result of a single benchmark case
+struct BENCHMARK_RESULT {
+	std::string name;
+	size_t elements = 0;		// Elements processed per run
+	size_t bytes = 0;			// Bytes processed per run
+	double nsPerElement = 0;
+	double bytesPerSecond = 0;
+	double allocationsPerRun = 0;
+	double allocatedBytesPerRun = 0;
+	int runs = 0;				// Timed runs
+};
+
+// Sink that stops the optimizer from discarding benchmark results
+extern volatile size_t benchmarkSink;
+
+// Keep a value alive
+template<typename T>
+inline void keepResult(const T& value) {
+	benchmarkSink = benchmarkSink + *(const volatile unsigned char*)&value;
+}
+
+// Case selection and result recording, defined in BenchmarkMain.cpp
+bool isBenchmarkSelected(const std::string& name);
+void recordResult(const BENCHMARK_RESULT& result);
+
+// Minimum number of runs and total time per case
+const int BENCHMARK_MIN_RUNS = 5;
+const double BENCHMARK_MIN_SECONDS = 0.25;
+
+/// <summary>
+/// Print a benchmark result
+/// </summary>
+/// <param name="result">Benchmark result</param>
+inline void printResult(const BENCHMARK_RESULT& result) {
+	std::cout << std::left << std::setw(48) << result.name
+		<< std::right << std::fixed << std::setprecision(2)
+		<< std::setw(12) << result.nsPerElement << " ns/elem"
+		<< std::setw(12) << result.bytesPerSecond / (1024.0 * 1024.0) << " MB/s"
+		<< std::setw(12) << std::setprecision(0) << result.allocationsPerRun << " allocs" << std::endl;
+}
+
+/// <summary>
+/// Time a benchmark body and report the fastest run
+/// </summary>
+/// <param name="name">Case name</param>
+/// <param name="elements">Elements processed by one call of the body</param>
+/// <param name="bytes">Bytes processed by one call of the body</param>
+/// <param name="body">Code to time</param>
+/// <returns>Benchmark result, empty if the case wasn't selected</returns>
+template<typename Body>
+BENCHMARK_RESULT runBenchmark(const std::string& name, size_t elements, size_t bytes, Body body) {
+
+	using Clock = std::chrono::steady_clock;
+
+	if (!isBenchmarkSelected(name)) return BENCHMARK_RESULT {};
+
+	// Warm up caches and allocators
+	body();
+
+	// Repeat until enough runs and time have accumulated
+	double bestSeconds = 1e30;
+	double totalSeconds = 0;
+	int runs = 0;
+	ALLOCATION_COUNTS startCounts = getAllocationCounts();
+	while (runs < BENCHMARK_MIN_RUNS || totalSeconds < BENCHMARK_MIN_SECONDS) {
+		Clock::time_point start = Clock::now();
+		body();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		bestSeconds = std::min(bestSeconds, seconds);
+		totalSeconds += seconds;
+		runs++;
+	}
+	ALLOCATION_COUNTS endCounts = getAllocationCounts();
+
+	// Report fastest run
+	BENCHMARK_RESULT result;
+	result.name = name;
+	result.elements = elements;
+	result.bytes = bytes;
+	result.nsPerElement = elements ? bestSeconds * 1e9 / elements : 0;
+	result.bytesPerSecond = bestSeconds > 0 ? bytes / bestSeconds : 0;
+	result.allocationsPerRun = double(endCounts.allocations - startCounts.allocations) / runs;
+	result.allocatedBytesPerRun = double(endCounts.bytes - startCounts.bytes) / runs;
+	result.runs = runs;
+	printResult(result);
+	recordResult(result);
+
+	return result;
+}
+
+// Benchmark groups
+void runAllocationBudgets();
+void runContentHashBenchmarks();
+void runFloatDecodeBenchmarks();
+void runHotPathBenchmarks();
+void runObjectLoadBenchmarks();
+void runPolygonParseBenchmarks();
+void runTagDispatchBenchmarks();
+
+// Self test groups
+void runObjectLoaderSelfTests();
+void runObjectReaderSelfTests();
+void runSpscQueueSelfTests();
+void runSurfaceSelfTests();
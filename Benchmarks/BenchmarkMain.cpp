@@ -0,0 +1,198 @@
+//
+// LightWave Object parser benchmarks
+//
+// Usage: LWObjectBenchmarks [--filter text] [--json pathname] [--budgets] [--selftest]
+//
+// --filter runs only the cases whose names contain the text, and --json
+// writes every result to a file so runs can be compared. --budgets runs
+// only the allocation budget checks, and --selftest only the self tests.
+// Exits with 1 if any check is over budget or any self test fails.
+//
+#include <fstream>
+#include <string.h>
+#include <vector>
+
+#include "AllocationBudget.h"
+#include "Benchmark.h"
+#include "SelfTest.h"
+#include "../LightWaveObject/FloatDecoder.h"
+#include "../LightWaveObject/ThreadPool.h"
+
+using namespace std;
+
+volatile size_t benchmarkSink = 0;
+
+namespace {
+
+	// Command line options
+	string nameFilter;
+
+	// Results of every case and budget check run so far
+	vector<BENCHMARK_RESULT> results;
+	vector<ALLOCATION_BUDGET_RESULT> budgetResults;
+	vector<SELF_TEST_RESULT> selfTestResults;
+
+	/// <summary>
+	/// Quote a string for JSON
+	/// </summary>
+	/// <param name="text">Text to quote</param>
+	/// <returns>Quoted text</returns>
+	string quoteJson(const string& text) {
+		string quoted = "\"";
+		for (char character : text) {
+			if (character == '"' || character == '\\') quoted += '\\';
+			quoted += character;
+		}
+		return quoted + "\"";
+	}
+
+	/// <summary>
+	/// Write the recorded results as JSON
+	/// </summary>
+	/// <param name="pathname">Output pathname</param>
+	/// <returns>True if the file was written</returns>
+	bool writeJson(const string& pathname) {
+
+		ofstream file(pathname, ios::trunc);
+		if (!file) return false;
+
+		file << "{\n"
+			<< "  \"threads\": " << ThreadPool::getShared().getNumThreads() << ",\n"
+			<< "  \"float_kernel\": " << quoteJson(FloatDecoder::getKernelName(FloatDecoder::getKernel())) << ",\n"
+			<< "  \"benchmarks\": [";
+
+		file << fixed << setprecision(3);
+		for (size_t index = 0; index < results.size(); index++) {
+			const BENCHMARK_RESULT& result = results[index];
+			file << (index ? ",\n" : "\n")
+				<< "    { \"name\": " << quoteJson(result.name)
+				<< ", \"elements\": " << result.elements
+				<< ", \"bytes\": " << result.bytes
+				<< ", \"ns_per_element\": " << result.nsPerElement
+				<< ", \"bytes_per_second\": " << result.bytesPerSecond
+				<< ", \"allocations\": " << result.allocationsPerRun
+				<< ", \"allocated_bytes\": " << result.allocatedBytesPerRun
+				<< ", \"runs\": " << result.runs << " }";
+		}
+		file << "\n  ],\n  \"allocation_budgets\": [";
+
+		for (size_t index = 0; index < budgetResults.size(); index++) {
+			const ALLOCATION_BUDGET_RESULT& result = budgetResults[index];
+			file << (index ? ",\n" : "\n")
+				<< "    { \"name\": " << quoteJson(result.name)
+				<< ", \"budget\": " << result.budget
+				<< ", \"allocations\": " << result.allocations
+				<< ", \"allocated_bytes\": " << result.bytes
+				<< ", \"passed\": " << (result.passed ? "true" : "false") << " }";
+		}
+		file << "\n  ],\n  \"self_tests\": [";
+
+		for (size_t index = 0; index < selfTestResults.size(); index++) {
+			const SELF_TEST_RESULT& result = selfTestResults[index];
+			file << (index ? ",\n" : "\n")
+				<< "    { \"name\": " << quoteJson(result.name)
+				<< ", \"checks\": " << result.checks
+				<< ", \"failures\": " << result.failures
+				<< ", \"passed\": " << (result.passed ? "true" : "false") << " }";
+		}
+		file << "\n  ]\n}\n";
+
+		return bool(file.flush());
+	}
+}
+
+/// <summary>
+/// Check whether a case should run
+/// </summary>
+/// <param name="name">Case name</param>
+/// <returns>True if the name matches the filter</returns>
+bool isBenchmarkSelected(const string& name) {
+	return nameFilter.empty() || name.find(nameFilter) != string::npos;
+}
+
+/// <summary>
+/// Keep a result for the JSON output
+/// </summary>
+/// <param name="result">Benchmark result</param>
+void recordResult(const BENCHMARK_RESULT& result) {
+	results.push_back(result);
+}
+
+/// <summary>
+/// Keep a budget check result for the JSON output and the exit code
+/// </summary>
+/// <param name="result">Budget check result</param>
+void recordBudgetResult(const ALLOCATION_BUDGET_RESULT& result) {
+	budgetResults.push_back(result);
+}
+
+/// <summary>
+/// Keep a self test result for the JSON output and the exit code
+/// </summary>
+/// <param name="result">Self test result</param>
+void recordSelfTestResult(const SELF_TEST_RESULT& result) {
+	selfTestResults.push_back(result);
+}
+
+int main(int argc, char* argv[]) {
+
+	// Parse options
+	string jsonPathname;
+	bool budgetsOnly = false;
+	bool selfTestsOnly = false;
+	for (int argIndex = 1; argIndex < argc; argIndex++) {
+		if (strcmp(argv[argIndex], "--filter") == 0 && argIndex + 1 < argc) {
+			nameFilter = argv[++argIndex];
+		}
+		else if (strcmp(argv[argIndex], "--json") == 0 && argIndex + 1 < argc) {
+			jsonPathname = argv[++argIndex];
+		}
+		else if (strcmp(argv[argIndex], "--budgets") == 0) {
+			budgetsOnly = true;
+		}
+		else if (strcmp(argv[argIndex], "--selftest") == 0) {
+			selfTestsOnly = true;
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--filter text] [--json pathname] [--budgets] [--selftest]" << endl;
+			return 2;
+		}
+	}
+
+	// Run all benchmark groups
+	if (!budgetsOnly && !selfTestsOnly) {
+		runTagDispatchBenchmarks();
+		runFloatDecodeBenchmarks();
+		runPolygonParseBenchmarks();
+		runObjectLoadBenchmarks();
+		runContentHashBenchmarks();
+		runHotPathBenchmarks();
+	}
+	if (!selfTestsOnly) {
+		runAllocationBudgets();
+	}
+	if (!budgetsOnly) {
+		runSurfaceSelfTests();
+		runObjectReaderSelfTests();
+		runSpscQueueSelfTests();
+		runObjectLoaderSelfTests();
+	}
+
+	// Save results for comparison
+	if (!jsonPathname.empty() && !writeJson(jsonPathname)) {
+		cerr << "Could not write " << jsonPathname << endl;
+		return 1;
+	}
+
+	// Fail the run if any hot path allocates more than it should
+	for (const ALLOCATION_BUDGET_RESULT& result : budgetResults) {
+		if (!result.passed) return 1;
+	}
+
+	// And if any self test fails
+	for (const SELF_TEST_RESULT& result : selfTestResults) {
+		if (!result.passed) return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,254 @@
+//
+// Benchmark objects
+//
+#include <string.h>
+#include <string>
+
+#include "BenchmarkObjects.h"
+
+using namespace std;
+
+/// <summary>
+/// Append a big-endian value of the given width
+/// </summary>
+/// <param name="buffer">Buffer to append to</param>
+/// <param name="value">Value</param>
+/// <param name="width">Width in bytes</param>
+void appendBE(vector<char>& buffer, uint32_t value, int width) {
+	for (int shift = (width - 1) * 8; shift >= 0; shift -= 8) {
+		buffer.push_back(char(value >> shift));
+	}
+}
+
+/// <summary>
+/// Append a big-endian float
+/// </summary>
+/// <param name="buffer">Buffer to append to</param>
+/// <param name="value">Value</param>
+void appendFloat(vector<char>& buffer, float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, 4);
+	appendBE(buffer, bits, 4);
+}
+
+/// <summary>
+/// Append a variable-length index
+/// </summary>
+/// <param name="buffer">Buffer to append to</param>
+/// <param name="index">Index</param>
+void appendVx(vector<char>& buffer, uint32_t index) {
+	if (index < 0xff00) appendBE(buffer, index, 2);
+	else appendBE(buffer, index | 0xff000000, 4);
+}
+
+/// <summary>
+/// Append a chunk with its header and pad byte
+/// </summary>
+/// <param name="buffer">Buffer to append to</param>
+/// <param name="tag">Chunk tag</param>
+/// <param name="payload">Chunk payload</param>
+void appendChunk(vector<char>& buffer, const char tag[], const vector<char>& payload) {
+	buffer.insert(buffer.end(), tag, tag + 4);
+	appendBE(buffer, uint32_t(payload.size()), 4);
+	buffer.insert(buffer.end(), payload.begin(), payload.end());
+	if (payload.size() % 2) buffer.push_back(0);
+}
+
+/// <summary>
+/// Build a standalone chunk, including its header
+/// </summary>
+/// <param name="tag">Chunk tag</param>
+/// <param name="payload">Chunk payload</param>
+/// <returns>Raw chunk bytes</returns>
+vector<char> makeChunk(const char tag[], const vector<char>& payload) {
+	vector<char> chunk;
+	appendChunk(chunk, tag, payload);
+	return chunk;
+}
+
+/// <summary>
+/// Build a PNTS payload for a grid of points
+/// </summary>
+/// <param name="gridSize">Quads along each side of the grid</param>
+/// <param name="z">Z coordinate of every point</param>
+/// <returns>Payload bytes</returns>
+vector<char> makeGridPoints(unsigned gridSize, float z) {
+	vector<char> points;
+	points.reserve(size_t(gridSize + 1) * (gridSize + 1) * 12);
+	for (unsigned y = 0; y <= gridSize; y++) {
+		for (unsigned x = 0; x <= gridSize; x++) {
+			appendFloat(points, float(x));
+			appendFloat(points, float(y));
+			appendFloat(points, z);
+		}
+	}
+	return points;
+}
+
+/// <summary>
+/// Build a POLS payload of quads covering a grid of points
+/// </summary>
+/// <param name="gridSize">Quads along each side of the grid</param>
+/// <returns>Payload bytes</returns>
+vector<char> makeGridPolygons(unsigned gridSize) {
+	vector<char> polygons = { 'F', 'A', 'C', 'E' };
+	for (unsigned y = 0; y < gridSize; y++) {
+		for (unsigned x = 0; x < gridSize; x++) {
+			uint32_t corner = y * (gridSize + 1) + x;
+			appendBE(polygons, 4, 2);
+			appendVx(polygons, corner);
+			appendVx(polygons, corner + 1);
+			appendVx(polygons, corner + gridSize + 2);
+			appendVx(polygons, corner + gridSize + 1);
+		}
+	}
+	return polygons;
+}
+
+/// <summary>
+/// Build a SURF payload
+/// </summary>
+/// <param name="numSubChunks">Number of sub-chunks after the color, cycling through the scalar ones</param>
+/// <param name="name">Surface name</param>
+/// <param name="source">Name of the surface this one derives from, or an empty string</param>
+/// <returns>Payload bytes</returns>
+vector<char> makeSurface(unsigned numSubChunks, const char name[], const char source[]) {
+
+	// Name and source, each zero terminated and padded to an even length
+	vector<char> surface(name, name + strlen(name));
+	surface.push_back(0);
+	if (surface.size() % 2 != 0) surface.push_back(0);
+	surface.insert(surface.end(), source, source + strlen(source));
+	surface.push_back(0);
+	if (surface.size() % 2 != 0) surface.push_back(0);
+
+	// Base color with an envelope index
+	surface.insert(surface.end(), { 'C', 'O', 'L', 'R' });
+	appendBE(surface, 14, 2);
+	for (int channel = 0; channel < 3; channel++) appendFloat(surface, 0.5f);
+	appendVx(surface, 0);
+
+	// Scalar sub-chunks, each a float with an envelope index
+	const char* tags[] = { "DIFF", "LUMI", "SPEC", "REFL", "TRAN", "TRNL", "GLOS" };
+	for (unsigned index = 0; index < numSubChunks; index++) {
+		const char* tag = tags[index % (sizeof(tags) / sizeof(tags[0]))];
+		surface.insert(surface.end(), tag, tag + 4);
+		appendBE(surface, 6, 2);
+		appendFloat(surface, 0.25f);
+		appendVx(surface, 0);
+	}
+
+	return surface;
+}
+
+/// <summary>
+/// Build a TAGS payload of surface names
+/// </summary>
+/// <param name="numTags">Number of names</param>
+/// <returns>Chunk payload</returns>
+vector<char> makeTags(unsigned numTags) {
+
+	vector<char> tags;
+	for (unsigned index = 0; index < numTags; index++) {
+
+		// Each name is zero terminated and padded to an even length
+		string name = "Surface" + to_string(index);
+		tags.insert(tags.end(), name.begin(), name.end());
+		tags.push_back(0);
+		if (tags.size() % 2 != 0) tags.push_back(0);
+	}
+
+	return tags;
+}
+
+/// <summary>
+/// Build a PTAG payload giving each polygon a surface, the surfaces taking
+/// turns so that every surface is spread over the whole polygon list
+/// </summary>
+/// <param name="numPolygons">Number of polygons</param>
+/// <param name="numTags">Number of surface names in the TAGS chunk</param>
+/// <returns>Chunk payload</returns>
+vector<char> makePolygonTags(unsigned numPolygons, unsigned numTags) {
+
+	vector<char> polygonTags = { 'S', 'U', 'R', 'F' };
+	for (unsigned polygonIndex = 0; polygonIndex < numPolygons; polygonIndex++) {
+		appendVx(polygonTags, polygonIndex);
+		appendBE(polygonTags, polygonIndex % numTags, 2);
+	}
+
+	return polygonTags;
+}
+
+/// <summary>
+/// Build a VMAP payload, e.g. UVs for every point or a weight map on a few
+/// </summary>
+/// <param name="type">Map type, e.g. "TXUV"</param>
+/// <param name="dimension">Values per point</param>
+/// <param name="numPoints">Number of points in the layer</param>
+/// <param name="step">Distance between mapped points</param>
+/// <returns>Chunk payload</returns>
+vector<char> makeVertexMap(const char type[], unsigned dimension, unsigned numPoints, unsigned step) {
+
+	vector<char> vertexMap(type, type + 4);
+	appendBE(vertexMap, dimension, 2);
+	vertexMap.insert(vertexMap.end(), { 'M', 'a', 'p', 0 });
+	for (unsigned pointIndex = 0; pointIndex < numPoints; pointIndex += step) {
+		appendVx(vertexMap, pointIndex);
+		for (unsigned component = 0; component < dimension; component++) {
+			appendFloat(vertexMap, float(pointIndex % 1024) / 1024.0f);
+		}
+	}
+
+	return vertexMap;
+}
+
+/// <summary>
+/// Build an object with several layers, each with its own points and polygons
+/// </summary>
+/// <param name="numLayers">Number of layers</param>
+/// <param name="gridSize">Quads along each side of each layer's grid</param>
+/// <param name="numSurfaces">Surfaces the polygons take turns with, or zero for one untagged surface</param>
+/// <returns>Object file bytes</returns>
+vector<char> makeGridObject(unsigned numLayers, unsigned gridSize, unsigned numSurfaces) {
+
+	// Surface names come first, as LightWave writes them
+	vector<char> body;
+	if (numSurfaces == 0) {
+		appendChunk(body, "SURF", makeSurface(1));
+	}
+	else {
+		appendChunk(body, "TAGS", makeTags(numSurfaces));
+	}
+
+	vector<char> polygons = makeGridPolygons(gridSize);
+	for (unsigned layerIndex = 0; layerIndex < numLayers; layerIndex++) {
+
+		// Layer number, flags, pivot and name
+		vector<char> layer;
+		appendBE(layer, layerIndex, 2);
+		appendBE(layer, 0, 2);
+		for (int axis = 0; axis < 3; axis++) appendFloat(layer, 0);
+		layer.insert(layer.end(), { 'L', 0 });
+		appendChunk(body, "LAYR", layer);
+
+		appendChunk(body, "PNTS", makeGridPoints(gridSize, float(layerIndex)));
+		appendChunk(body, "POLS", polygons);
+		if (numSurfaces > 0) {
+			appendChunk(body, "PTAG", makePolygonTags(gridSize * gridSize, numSurfaces));
+		}
+	}
+
+	// Surfaces, after the last layer
+	for (unsigned surfaceIndex = 0; surfaceIndex < numSurfaces; surfaceIndex++) {
+		string name = "Surface" + to_string(surfaceIndex);
+		appendChunk(body, "SURF", makeSurface(1, name.c_str()));
+	}
+
+	// File header
+	vector<char> object = { 'F', 'O', 'R', 'M' };
+	appendBE(object, uint32_t(body.size() + 4), 4);
+	object.insert(object.end(), { 'L', 'W', 'O', '2' });
+	object.insert(object.end(), body.begin(), body.end());
+
+	return object;
+}
@@ -0,0 +1,45 @@
+//
+// Benchmark objects
+//
+// Builders for the chunks and objects the benchmarks parse, so each group
+// times the same shapes at the same sizes.
+//
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Append a big-endian value of the given width
+void appendBE(std::vector<char>& buffer, uint32_t value, int width);
+
+// Append a big-endian float
+void appendFloat(std::vector<char>& buffer, float value);
+
+// Append a variable-length index
+void appendVx(std::vector<char>& buffer, uint32_t index);
+
+// Append a chunk with its header and pad byte
+void appendChunk(std::vector<char>& buffer, const char tag[], const std::vector<char>& payload);
+
+// Build a standalone chunk, including its header, as the chunk parsers expect it
+std::vector<char> makeChunk(const char tag[], const std::vector<char>& payload);
+
+// PNTS payload for a grid of (gridSize + 1)^2 points
+std::vector<char> makeGridPoints(unsigned gridSize, float z = 0.0f);
+
+// POLS payload covering a grid with gridSize^2 quads
+std::vector<char> makeGridPolygons(unsigned gridSize);
+
+// SURF payload with a color and numSubChunks scalar sub-chunks, derived from source if one is named
+std::vector<char> makeSurface(unsigned numSubChunks, const char name[] = "Default", const char source[] = "");
+
+// TAGS payload with numTags short names
+std::vector<char> makeTags(unsigned numTags);
+
+// PTAG payload giving numPolygons polygons surfaces from numTags names in turn
+std::vector<char> makePolygonTags(unsigned numPolygons, unsigned numTags);
+
+// VMAP payload giving every step-th of numPoints points dimension values
+std::vector<char> makeVertexMap(const char type[], unsigned dimension, unsigned numPoints, unsigned step = 1);
+
+// Object with numLayers layers of gridSize^2 quads, and one surface or numSurfaces tagged ones
+std::vector<char> makeGridObject(unsigned numLayers, unsigned gridSize, unsigned numSurfaces = 0);
@@ -0,0 +1,64 @@
+//
+// Content hash benchmarks
+//
+// Measures ContentHash throughput on a large buffer, whole and in pieces,
+// and what hashing chunk payloads adds to LightWaveObject::Read.
+//
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkObjects.h"
+#include "../LightWaveObject/LightWaveObject.h"
+
+namespace {
+
+	// Size of the hashed buffer
+	const size_t BUFFER_SIZE = 256 * 1024 * 1024;
+
+	// Piece size for the incremental case, matching a typical stream window piece
+	const size_t PIECE_SIZE = 64 * 1024;
+
+	// Object shape: NUM_LAYERS layers of GRID_SIZE * GRID_SIZE quads
+	const unsigned NUM_LAYERS = 4;
+	const unsigned GRID_SIZE = 400;
+}
+
+/// <summary>
+/// Run content hash benchmarks
+/// </summary>
+void runContentHashBenchmarks() {
+
+	// Raw throughput
+	vector<char> buffer(BUFFER_SIZE);
+	mt19937 random(7);
+	for (char& byte : buffer) byte = char(random());
+
+	runBenchmark("ContentHash/Whole", BUFFER_SIZE, BUFFER_SIZE, [&]() {
+		keepResult(ContentHash::hash(buffer.data(), buffer.size()));
+	});
+
+	runBenchmark("ContentHash/Pieces/64K", BUFFER_SIZE, BUFFER_SIZE, [&]() {
+		ContentHash hasher;
+		for (size_t offset = 0; offset < buffer.size(); offset += PIECE_SIZE) {
+			hasher.update(buffer.data() + offset, min(PIECE_SIZE, buffer.size() - offset));
+		}
+		keepResult(hasher.digest());
+	});
+
+	// Cost of hashing during a read
+	vector<char> object = makeGridObject(NUM_LAYERS, GRID_SIZE);
+	for (bool parallelParse : { false, true }) {
+		for (bool hashContent : { false, true }) {
+			string name = string("Read/") + (parallelParse ? "Parallel" : "Serial") + (hashContent ? "/Hashed" : "/Unhashed");
+			runBenchmark(name, object.size(), object.size(), [&]() {
+				LightWaveObject lwObject;
+				wstring errorReason;
+				lwObject.SetParallelParse(parallelParse);
+				lwObject.SetHashContent(hashContent);
+				lwObject.Read(object.data(), object.size(), errorReason);
+				keepResult(lwObject.GetContentHash());
+			});
+		}
+	}
+}
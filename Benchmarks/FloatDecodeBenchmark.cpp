@@ -0,0 +1,115 @@
+//
+// Float decode benchmarks
+//
+// Compares decoding a multi-million point PNTS chunk with the scalar
+// conversion macros against Points::parse on each FloatDecoder kernel, and
+// parsing into X, Y and Z component arrays.
+//
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../LightWaveObject/Chunks/Points.h"
+
+namespace {
+
+	// Number of points in the benchmark chunk
+	const size_t NUM_POINTS = 4 * 1024 * 1024;
+
+	/// <summary>
+	/// Build a PNTS chunk of random big-endian coordinates
+	/// </summary>
+	/// <returns>Raw chunk bytes, including the chunk header</returns>
+	vector<char> makePointsChunk() {
+
+		size_t payloadLength = NUM_POINTS * sizeof(VEC12);
+		vector<char> chunk(LWO_CHUNK_DATA_OFFSET + payloadLength);
+
+		// Header
+		memcpy(chunk.data(), "PNTS", 4);
+		chunk[4] = char(payloadLength >> 24);
+		chunk[5] = char(payloadLength >> 16);
+		chunk[6] = char(payloadLength >> 8);
+		chunk[7] = char(payloadLength);
+
+		// Coordinates; decoding only moves bytes, so any bit pattern will do
+		mt19937 random(1234);
+		for (size_t offset = LWO_CHUNK_DATA_OFFSET; offset < chunk.size(); offset++) {
+			chunk[offset] = char(random());
+		}
+
+		return chunk;
+	}
+}
+
+/// <summary>
+/// Run float decode benchmarks
+/// </summary>
+void runFloatDecodeBenchmarks() {
+
+	vector<char> chunk = makePointsChunk();
+	BufferView chunkBuffer(chunk.data(), chunk.size());
+	LWO_CHUNK_HEADER header = LWUtils::parseChunkHeader(chunk.data());
+	size_t payloadLength = header.length;
+
+	// Previous Points::parse loop, kept as the baseline
+	runBenchmark("PNTS/LegacyMacros", NUM_POINTS, payloadLength, [&]() {
+		vector<VEC12> points;
+		for (size_t offset = LWO_CHUNK_DATA_OFFSET; offset < header.length + LWO_CHUNK_DATA_OFFSET; offset += sizeof(VEC12)) {
+			VEC12 point;
+			point.X = CONVERT_LE_FLOAT(chunk.data() + offset);
+			point.Y = CONVERT_LE_FLOAT(chunk.data() + offset + 4);
+			point.Z = CONVERT_LE_FLOAT(chunk.data() + offset + 8);
+			points.push_back(point);
+		}
+		keepResult(points.back());
+	});
+
+	// Every kernel this CPU supports, decoding into a presized array and through Points::parse
+	vector<VEC12> presized(NUM_POINTS);
+	FloatDecoder::Kernel bestKernel = FloatDecoder::getBestKernel();
+	for (FloatDecoder::Kernel kernel : { FloatDecoder::Kernel::Scalar, FloatDecoder::Kernel::SSSE3, FloatDecoder::Kernel::AVX2 }) {
+		if (!FloatDecoder::setKernel(kernel)) continue;
+
+		runBenchmark(string("PNTS/decodeFloats/") + FloatDecoder::getKernelName(kernel), NUM_POINTS, payloadLength, [&]() {
+			FloatDecoder::decodeFloats(chunk.data() + LWO_CHUNK_DATA_OFFSET, &presized[0].X, NUM_POINTS * 3);
+			keepResult(presized.back());
+		});
+
+		runBenchmark(string("PNTS/Points::parse/") + FloatDecoder::getKernelName(kernel), NUM_POINTS, payloadLength, [&]() {
+			Points points;
+			points.parse(chunkBuffer, header);
+			keepResult(points.getPoints().back());
+		});
+	}
+	FloatDecoder::setKernel(bestKernel);
+
+	// Structure-of-arrays output into presized arrays
+	vector<float> x(NUM_POINTS), y(NUM_POINTS), z(NUM_POINTS);
+	runBenchmark(string("PNTS/decodeVec12SoA/") + FloatDecoder::getKernelName(bestKernel), NUM_POINTS, payloadLength, [&]() {
+		FloatDecoder::decodeVec12SoA(chunk.data() + LWO_CHUNK_DATA_OFFSET, NUM_POINTS, x.data(), y.data(), z.data());
+		keepResult(z.back());
+	});
+	runBenchmark(string("PNTS/Points::parse/ComponentArrays/") + FloatDecoder::getKernelName(bestKernel), NUM_POINTS, payloadLength, [&]() {
+		Points points;
+		points.setComponentArrays(true);
+		points.parse(chunkBuffer, header);
+		keepResult(points.getZ().back());
+	});
+
+	// The component arrays hold the same bits as the structures, NaNs included
+	Points structures, components;
+	structures.parse(chunkBuffer, header);
+	components.setComponentArrays(true);
+	components.parse(chunkBuffer, header);
+	bool same = components.size() == structures.size() && components.getPoints().empty();
+	for (size_t index = 0; same && index < structures.size(); index++) {
+		const VEC12& point = structures.getPoints()[index];
+		same = memcmp(&components.getX()[index], &point.X, sizeof(float)) == 0
+			&& memcmp(&components.getY()[index], &point.Y, sizeof(float)) == 0
+			&& memcmp(&components.getZ()[index], &point.Z, sizeof(float)) == 0;
+	}
+	if (!same) {
+		cerr << "PNTS/Points::parse/ComponentArrays: the component arrays differ from the points" << endl;
+	}
+}
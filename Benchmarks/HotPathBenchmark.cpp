@@ -0,0 +1,271 @@
+//
+// Hot path benchmarks
+//
+// Times each stage of loading an object at several mesh sizes: the decode
+// helpers in ChunkDefinitions.h, the PNTS, POLS, PTAG, VMAP and SURF chunk
+// parsers, building the surface table, LightWaveObject::Read end to end, and
+// ObjectReader's mesh extraction from one layer, from several, and with the
+// triangles sorted by surface. Names end in the element count so runs at
+// each size line up.
+//
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkObjects.h"
+#include "../LightWaveObject/LightWaveObject.h"
+#include "../LightWaveObject/Chunks/Points.h"
+#include "../LightWaveObject/Chunks/Polygons.h"
+#include "../LightWaveObject/Chunks/PolygonTags.h"
+#include "../LightWaveObject/Chunks/Surface.h"
+#include "../LightWaveObject/Chunks/Tags.h"
+#include "../LightWaveObject/Chunks/VertexMap.h"
+#include "../LightWaveObject/SurfaceTable.h"
+#include "../ObjectReader.h"
+
+namespace {
+
+	// Grid sizes; a grid of GRID_SIZE quads a side has about GRID_SIZE^2 points and polygons
+	const unsigned GRID_SIZES[] = { 32, 256, 1024 };
+
+	// Layers of the multi-layer extraction benchmark
+	const unsigned NUM_LAYERS = 4;
+
+	// Surfaces the polygons take turns with in the surface extraction benchmark
+	const unsigned NUM_SURFACES = 8;
+
+	// Distance between the points of the sparse weight map
+	const unsigned SPARSE_MAP_STEP = 16;
+
+	// Sub-chunk counts for the surface parser
+	const unsigned SURFACE_SIZES[] = { 16, 256, 4096 };
+
+	// Surface counts for the surface table
+	const unsigned SURFACE_TABLE_SIZES[] = { 16, 256, 4096 };
+
+	/// <summary>
+	/// Format an element count for a case name
+	/// </summary>
+	/// <param name="count">Element count</param>
+	/// <returns>Count with a K or M suffix</returns>
+	string formatCount(size_t count) {
+		if (count >= 1024 * 1024 && count % (1024 * 1024) == 0) return to_string(count / (1024 * 1024)) + "M";
+		if (count >= 1024 && count % 1024 == 0) return to_string(count / 1024) + "K";
+		return to_string(count);
+	}
+
+	/// <summary>
+	/// Time the decode helpers over a buffer of random-looking bytes
+	/// </summary>
+	/// <param name="count">Number of values to decode</param>
+	void runConvertBenchmarks(size_t count) {
+
+		string suffix = "/" + formatCount(count);
+
+		// Enough bytes for count values of the widest type
+		vector<char> data(count * sizeof(VEC12));
+		uint32_t state = 0x2545F491;
+		for (char& byte : data) {
+			state = state * 1664525 + 1013904223;
+			byte = char(state >> 24);
+		}
+
+		// Variable-length indices, mixing both widths
+		vector<char> vxData;
+		vxData.reserve(count * 4);
+		for (size_t index = 0; index < count; index++) {
+			appendVx(vxData, uint32_t(index * 97 % 0x20000));
+		}
+
+		runBenchmark("CONVERT_U2_BYTES_TO_INT" + suffix, count, count * 2, [&]() {
+			int sum = 0;
+			for (size_t offset = 0; offset < count * 2; offset += 2) sum += CONVERT_U2_BYTES_TO_INT((data.data() + offset));
+			keepResult(sum);
+		});
+
+		runBenchmark("CONVERT_U4_BYTES_TO_INT" + suffix, count, count * 4, [&]() {
+			int sum = 0;
+			for (size_t offset = 0; offset < count * 4; offset += 4) sum += CONVERT_U4_BYTES_TO_INT((data.data() + offset));
+			keepResult(sum);
+		});
+
+		runBenchmark("CONVERT_VX_BYTES_TO_INT" + suffix, count, vxData.size(), [&]() {
+			uint32_t sum = 0;
+			for (size_t offset = 0; offset < vxData.size(); offset += CONVERT_VX_BYTES_LENGTH(vxData.data() + offset)) {
+				sum += CONVERT_VX_BYTES_TO_INT(vxData.data() + offset);
+			}
+			keepResult(sum);
+		});
+
+		runBenchmark("CONVERT_FLOAT_BYTES" + suffix, count, count * 4, [&]() {
+			float sum = 0;
+			for (size_t offset = 0; offset < count * 4; offset += 4) sum += CONVERT_FLOAT_BYTES(data.data() + offset);
+			keepResult(sum);
+		});
+
+		runBenchmark("CONVERT_LE_FLOAT" + suffix, count, count * 4, [&]() {
+			float sum = 0;
+			for (size_t offset = 0; offset < count * 4; offset += 4) sum += CONVERT_LE_FLOAT(data.data() + offset);
+			keepResult(sum);
+		});
+
+		runBenchmark("CONVERT_VEC12_BYTES" + suffix, count, count * sizeof(VEC12), [&]() {
+			float sum = 0;
+			for (size_t offset = 0; offset < count * sizeof(VEC12); offset += sizeof(VEC12)) sum += CONVERT_VEC12_BYTES(data.data() + offset).Z;
+			keepResult(sum);
+		});
+	}
+
+	/// <summary>
+	/// Time the geometry parsers, Read and mesh extraction on one grid
+	/// </summary>
+	/// <param name="gridSize">Quads along each side of the grid</param>
+	void runGridBenchmarks(unsigned gridSize) {
+
+		size_t numPoints = size_t(gridSize + 1) * (gridSize + 1);
+		size_t numPolygons = size_t(gridSize) * gridSize;
+		string suffix = "/" + formatCount(numPolygons);
+
+		// Points
+		vector<char> pointsChunk = makeChunk("PNTS", makeGridPoints(gridSize));
+		LWO_CHUNK_HEADER pointsHeader = LWUtils::parseChunkHeader(pointsChunk.data());
+		runBenchmark("Points::parse" + suffix, numPoints, pointsHeader.length, [&]() {
+			Points points;
+			points.parse(BufferView(pointsChunk.data(), pointsChunk.size()), pointsHeader);
+			keepResult(points.getPoints().back());
+		});
+
+		// Polygons, decoded serially
+		vector<char> polygonsChunk = makeChunk("POLS", makeGridPolygons(gridSize));
+		LWO_CHUNK_HEADER polygonsHeader = LWUtils::parseChunkHeader(polygonsChunk.data());
+		runBenchmark("Polygons::parse" + suffix, numPolygons, polygonsHeader.length, [&]() {
+			Polygons polygons;
+			polygons.parse(BufferView(polygonsChunk.data(), polygonsChunk.size()), polygonsHeader);
+			keepResult(polygons.getPolygons().pointIndex.back());
+		});
+
+		// Surface of each polygon
+		vector<char> polygonTagsChunk = makeChunk("PTAG", makePolygonTags(unsigned(numPolygons), NUM_SURFACES));
+		LWO_CHUNK_HEADER polygonTagsHeader = LWUtils::parseChunkHeader(polygonTagsChunk.data());
+		runBenchmark("PolygonTags::parse" + suffix, numPolygons, polygonTagsHeader.length, [&]() {
+			PolygonTags polygonTags;
+			polygonTags.parse(BufferView(polygonTagsChunk.data(), polygonTagsChunk.size()), polygonTagsHeader);
+			keepResult(polygonTags.getTags().back());
+		});
+
+		// UVs for every point, stored densely
+		vector<char> uvMapChunk = makeChunk("VMAP", makeVertexMap("TXUV", 2, unsigned(numPoints)));
+		LWO_CHUNK_HEADER uvMapHeader = LWUtils::parseChunkHeader(uvMapChunk.data());
+		runBenchmark("VertexMap::parse/TXUV" + suffix, numPoints, uvMapHeader.length, [&]() {
+			VertexMap vertexMap;
+			vertexMap.parse(BufferView(uvMapChunk.data(), uvMapChunk.size()), uvMapHeader);
+			keepResult(vertexMap.getChannel(1).back());
+		});
+
+		// Weights for a few points, stored sparsely
+		vector<char> weightMapChunk = makeChunk("VMAP", makeVertexMap("WGHT", 1, unsigned(numPoints), SPARSE_MAP_STEP));
+		LWO_CHUNK_HEADER weightMapHeader = LWUtils::parseChunkHeader(weightMapChunk.data());
+		runBenchmark("VertexMap::parse/sparse WGHT" + suffix, numPoints / SPARSE_MAP_STEP, weightMapHeader.length, [&]() {
+			VertexMap vertexMap;
+			vertexMap.parse(BufferView(weightMapChunk.data(), weightMapChunk.size()), weightMapHeader);
+			keepResult(vertexMap.getChannel(0).back());
+		});
+
+		// Whole object, one layer
+		vector<char> object = makeGridObject(1, gridSize);
+		runBenchmark("LightWaveObject::Read" + suffix, numPolygons, object.size(), [&]() {
+			LightWaveObject lwObject;
+			wstring errorReason;
+			lwObject.Read(object.data(), object.size(), errorReason);
+			keepResult(lwObject.GetNumLayers());
+		});
+
+		// Triangulation from an already parsed object
+		LightWaveObject lwObject;
+		wstring errorReason;
+		if (!lwObject.Read(object.data(), object.size(), errorReason)) return;
+		ObjectReader reader;
+		runBenchmark("ObjectReader::TransferMeshDataFromLWO" + suffix, numPolygons, object.size(), [&]() {
+			reader.TransferMeshDataFromLWO(lwObject, errorReason);
+			keepResult(reader.GetNumTriangles());
+		});
+
+		// Triangulation of several layers, extracted alongside each other
+		vector<char> layeredObject = makeGridObject(NUM_LAYERS, gridSize);
+		LightWaveObject layeredLWObject;
+		if (!layeredLWObject.Read(layeredObject.data(), layeredObject.size(), errorReason)) return;
+		runBenchmark("ObjectReader::TransferMeshDataFromLWO/" + to_string(NUM_LAYERS) + " layers" + suffix, numPolygons * NUM_LAYERS, layeredObject.size(), [&]() {
+			reader.TransferMeshDataFromLWO(layeredLWObject, errorReason);
+			keepResult(reader.GetNumTriangles());
+		});
+
+		// Triangulation of one layer whose polygons take turns with several surfaces
+		vector<char> surfacedObject = makeGridObject(1, gridSize, NUM_SURFACES);
+		LightWaveObject surfacedLWObject;
+		if (!surfacedLWObject.Read(surfacedObject.data(), surfacedObject.size(), errorReason)) return;
+		runBenchmark("ObjectReader::TransferMeshDataFromLWO/" + to_string(NUM_SURFACES) + " surfaces" + suffix, numPolygons, surfacedObject.size(), [&]() {
+			reader.TransferMeshDataFromLWO(surfacedLWObject, errorReason);
+			keepResult(reader.GetNumTriangles());
+		});
+	}
+
+	/// <summary>
+	/// Time building a surface table. Each surface after the first derives
+	/// from the one at half its index, and sets a few sub-chunks of its own,
+	/// so the surfaces resolve to a handful of distinct parameter blocks.
+	/// </summary>
+	/// <param name="numSurfaces">Number of SURF chunks</param>
+	void runSurfaceTableBenchmark(unsigned numSurfaces) {
+
+		vector<Surface> surfaces(numSurfaces);
+		pmr::vector<Surface*> surfacePointers;
+		size_t surfaceBytes = 0;
+		for (unsigned index = 0; index < numSurfaces; index++) {
+			string name = "Surface" + to_string(index);
+			string source = index > 0 ? "Surface" + to_string(index / 2) : "";
+			vector<char> surfaceChunk = makeChunk("SURF", makeSurface(index % 8, name.c_str(), source.c_str()));
+			LWO_CHUNK_HEADER surfaceHeader = LWUtils::parseChunkHeader(surfaceChunk.data());
+			surfaces[index].parse(BufferView(surfaceChunk.data(), surfaceChunk.size()), surfaceHeader);
+			surfacePointers.push_back(&surfaces[index]);
+			surfaceBytes += surfaceHeader.length;
+		}
+
+		vector<char> tagsChunk = makeChunk("TAGS", makeTags(numSurfaces));
+		Tags tags;
+		tags.parse(BufferView(tagsChunk.data(), tagsChunk.size()), LWUtils::parseChunkHeader(tagsChunk.data()));
+
+		runBenchmark("SurfaceTable::build/" + formatCount(numSurfaces), numSurfaces, surfaceBytes, [&]() {
+			SurfaceTable surfaceTable;
+			surfaceTable.build(surfacePointers, tags.getTags());
+			keepResult(surfaceTable.getNumParameterBlocks());
+		});
+	}
+}
+
+/// <summary>
+/// Run hot path benchmarks
+/// </summary>
+void runHotPathBenchmarks() {
+
+	for (unsigned gridSize : GRID_SIZES) {
+		runConvertBenchmarks(size_t(gridSize) * gridSize);
+	}
+
+	for (unsigned gridSize : GRID_SIZES) {
+		runGridBenchmarks(gridSize);
+	}
+
+	// Surface sub-chunks
+	for (unsigned numSubChunks : SURFACE_SIZES) {
+		vector<char> surfaceChunk = makeChunk("SURF", makeSurface(numSubChunks));
+		LWO_CHUNK_HEADER surfaceHeader = LWUtils::parseChunkHeader(surfaceChunk.data());
+		runBenchmark("Surface::parse/" + formatCount(numSubChunks), numSubChunks, surfaceHeader.length, [&]() {
+			Surface surface;
+			surface.parse(BufferView(surfaceChunk.data(), surfaceChunk.size()), surfaceHeader);
+			keepResult(surface.getCol12Color());
+		});
+	}
+
+	for (unsigned numSurfaces : SURFACE_TABLE_SIZES) {
+		runSurfaceTableBenchmark(numSurfaces);
+	}
+}
@@ -0,0 +1,138 @@
+//
+// Object load benchmarks
+//
+// Times LightWaveObject::Read on a multi-layer object in memory, parsing
+// chunks serially, on the shared thread pool, and lazily for metadata only,
+// on a generated object with mixed polygon sizes, surfaces and vertex maps,
+// and on a generated object whose POLS chunk is over 2 GB.
+//
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkObjects.h"
+#include "../Generator/ObjectGenerator.h"
+#include "../LightWaveObject/LightWaveObject.h"
+
+namespace {
+
+	// Object shape: NUM_LAYERS layers of GRID_SIZE * GRID_SIZE quads
+	const unsigned NUM_LAYERS = 8;
+	const unsigned GRID_SIZE = 400;
+
+	// Polygons of LARGE_CHUNK_VERTICES wide indices each, making a POLS chunk
+	// of 2 + LARGE_CHUNK_VERTICES * 4 bytes per polygon after its type, over
+	// 2 GB in all
+	const uint32_t LARGE_CHUNK_POLYGONS = 16600000;
+	const unsigned LARGE_CHUNK_VERTICES = 32;
+
+	/// <summary>
+	/// Time a metadata read of an object whose POLS chunk is 2 GB or more, so
+	/// its length has the top bit set. The object is generated into a
+	/// temporary file, mapped like any other object, and removed afterwards.
+	/// </summary>
+	void runLargeChunkBenchmark() {
+
+		if (!isBenchmarkSelected("Read/Generated/2 GB chunk")) return;
+
+		ObjectGenerator::OPTIONS options;
+		options.seed = 15;
+		options.numPoints = 100000;
+		options.numPolygons = LARGE_CHUNK_POLYGONS;
+		options.triangleWeight = 0;
+		options.quadWeight = 0;
+		options.ngonWeight = 1;
+		options.minNgonVertices = LARGE_CHUNK_VERTICES;
+		options.maxNgonVertices = LARGE_CHUNK_VERTICES;
+		options.wideIndices = true;
+		options.numUVMaps = 0;
+		ObjectGenerator generator(options);
+
+		error_code error;
+		string pathname = (filesystem::temp_directory_path(error) / "LWObjectBenchmarks-2GB.lwo").string();
+		wstring errorReason;
+		if (!generator.WriteFile(pathname, errorReason)) {
+			cerr << "Read/Generated/2 GB chunk: the object could not be generated" << endl;
+			return;
+		}
+
+		// The chunks after the large one are only found if its length was read whole
+		size_t polygonsLength = 4 + size_t(LARGE_CHUNK_POLYGONS) * (2 + LARGE_CHUNK_VERTICES * 4);
+		bool readWhole = true;
+		runBenchmark("Read/Generated/2 GB chunk", 1, size_t(generator.GetSummary().bytes), [&]() {
+			LightWaveObject lwObject;
+			wstring errorReason;
+			lwObject.SetLazyParse(true);
+			readWhole &= lwObject.Read(pathname, errorReason) && lwObject.GetNumLayers() == 1
+				&& lwObject.GetChunkBufferByLayer(0, ChunkTag::POLS).size() == LWO_CHUNK_DATA_OFFSET + polygonsLength
+				&& !lwObject.GetChunkBufferByLayer(0, ChunkTag::PTAG).empty();
+			keepResult(lwObject.GetNumLayers());
+		});
+		if (!readWhole) {
+			cerr << "Read/Generated/2 GB chunk: the chunk lengths were misread" << endl;
+		}
+
+		filesystem::remove(pathname, error);
+	}
+}
+
+/// <summary>
+/// Run object load benchmarks
+/// </summary>
+void runObjectLoadBenchmarks() {
+
+	vector<char> object = makeGridObject(NUM_LAYERS, GRID_SIZE);
+	size_t numPolygons = size_t(NUM_LAYERS) * GRID_SIZE * GRID_SIZE;
+
+	for (bool parallelParse : { false, true }) {
+		string name = parallelParse ? "Read/Parallel/" + to_string(ThreadPool::getShared().getNumThreads()) + " threads" : "Read/Serial";
+		runBenchmark(name, numPolygons, object.size(), [&]() {
+			LightWaveObject lwObject;
+			wstring errorReason;
+			lwObject.SetParallelParse(parallelParse);
+			lwObject.Read(object.data(), object.size(), errorReason);
+			keepResult(lwObject.GetNumLayers());
+		});
+	}
+
+	// Metadata only: names and point counts without parsing geometry, timed per chunk
+	runBenchmark("Read/LazyMetadata", NUM_LAYERS * 3, object.size(), [&]() {
+		LightWaveObject lwObject;
+		wstring errorReason;
+		lwObject.SetLazyParse(true);
+		lwObject.Read(object.data(), object.size(), errorReason);
+		size_t numPoints = 0;
+		for (size_t layerIndex = 0; layerIndex < lwObject.GetNumLayers(); layerIndex++) {
+			numPoints += lwObject.GetNumPointsByLayer(int(layerIndex)) + lwObject.GetLayerName(int(layerIndex)).size();
+		}
+		keepResult(numPoints);
+	});
+
+	// Generated object: triangles, quads and n-gons of up to 32 sides with wide
+	// indices, 16 surfaces and two vertex maps per layer
+	ObjectGenerator::OPTIONS options;
+	options.seed = 14;
+	options.numLayers = 4;
+	options.numPoints = 250000;
+	options.numPolygons = 200000;
+	options.ngonWeight = 1;
+	options.maxNgonVertices = 32;
+	options.wideIndices = true;
+	options.numSurfaces = 16;
+	options.numWeightMaps = 1;
+	ObjectGenerator generator(options);
+	stringstream stream;
+	wstring errorReason;
+	if (!generator.Write(stream, errorReason)) return;
+	string generated = stream.str();
+
+	runBenchmark("Read/Generated/Mixed", generator.GetSummary().polygons, generated.size(), [&]() {
+		LightWaveObject lwObject;
+		wstring errorReason;
+		lwObject.Read(generated.data(), generated.size(), errorReason);
+		keepResult(lwObject.GetNumLayers());
+	});
+
+	runLargeChunkBenchmark();
+}
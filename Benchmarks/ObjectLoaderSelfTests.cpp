@@ -0,0 +1,360 @@
+//
+// Object loader self tests
+//
+// Loads generated objects from temporary files on the loader thread, and
+// checks how requests replace each other: a newer request cancels the load
+// in progress, a failed load leaves the previous mesh published, and the
+// loader can be destroyed in the middle of a load. Progressive loads are
+// checked to hand over batches that add up to the published mesh, and to
+// stop when cancelled while the batch queue is full. Waits for the loader
+// thread to reach a point in a load are bounded, so a load that never gets
+// there fails the test instead of hanging the run.
+//
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkObjects.h"
+#include "SelfTest.h"
+#include "../ObjectLoader.h"
+
+namespace {
+
+	// Longest wait for the loader thread to reach a point a test needs
+	const chrono::seconds LOADER_TIMEOUT { 30 };
+
+	// Completion results of a loader, in the order they were reported
+	class LoadResults {
+	public:
+
+		/// <summary>
+		/// Record a result; called on the loader thread
+		/// </summary>
+		/// <param name="result">How a load ended</param>
+		void add(const ObjectLoader::LOAD_RESULT& result) {
+			lock_guard<mutex> lock(_mutex);
+			_results.push_back(result);
+		}
+
+		/// <summary>
+		/// Get the results reported so far
+		/// </summary>
+		/// <returns>Copy of the results</returns>
+		vector<ObjectLoader::LOAD_RESULT> get() {
+			lock_guard<mutex> lock(_mutex);
+			return _results;
+		}
+
+	private:
+
+		// Private data
+		mutex _mutex;
+		vector<ObjectLoader::LOAD_RESULT> _results;
+	};
+
+	/// <summary>
+	/// Take batches until the loader is idle and none are left
+	/// </summary>
+	/// <param name="loader">Loader running progressive loads</param>
+	/// <param name="batches">Receives the batches</param>
+	/// <returns>False if the loader didn't become idle in time</returns>
+	bool popBatchesUntilIdle(ObjectLoader& loader, vector<MESH_BATCH>& batches) {
+
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + LOADER_TIMEOUT;
+		while (chrono::steady_clock::now() < deadline) {
+			MESH_BATCH batch;
+			if (loader.PopBatch(batch)) {
+				batches.push_back(move(batch));
+				continue;
+			}
+
+			// Every batch is queued before the load is reported, so none follow
+			if (!loader.IsLoading()) {
+				while (loader.PopBatch(batch)) batches.push_back(move(batch));
+				return true;
+			}
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Check two arrays of plain structures hold the same bytes
+	/// </summary>
+	/// <param name="a">First array</param>
+	/// <param name="b">Second array</param>
+	/// <returns>True if the arrays are equal</returns>
+	template<typename T>
+	bool sameElements(const vector<T>& a, const vector<T>& b) {
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	/// <summary>
+	/// A progressive load hands over batches in order, which rebuild the
+	/// mesh it publishes, with layers split across several batches
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkProgressiveBatches(SelfTestChecks& checks) {
+
+		// Each layer's polygons are larger than a batch
+		const unsigned NUM_LAYERS = 3;
+		TemporaryObject object("Progressive", makeGridObject(NUM_LAYERS, 200, 4));
+		LoadResults results;
+		ObjectLoader loader;
+		loader.SetProgressive(true);
+		loader.SetCompletionCallback([&](const ObjectLoader::LOAD_RESULT& result) { results.add(result); });
+
+		uint64_t loadId = loader.Load(object.getPathname());
+		vector<MESH_BATCH> batches;
+		if (!checks.check(popBatchesUntilIdle(loader, batches), "load finished")) {
+			loader.Cancel();
+			popBatchesUntilIdle(loader, batches);
+			return;
+		}
+
+		vector<ObjectLoader::LOAD_RESULT> loadResults = results.get();
+		checks.check(loadResults.size() == 1 && loadResults[0].loaded, "load published");
+		shared_ptr<const ObjectLoader::MESH_SNAPSHOT> mesh = loader.GetMesh();
+		if (!checks.check(mesh && mesh->loadId == loadId && mesh->layers.size() == NUM_LAYERS, "published mesh has every layer")) return;
+		checks.check(batches.size() > NUM_LAYERS, "layers split across batches");
+
+		// Rebuild the mesh from the batches
+		bool ordered = true;
+		bool surfacesFirst = true;
+		vector<MESH_LAYER> layers;
+		vector<MESH_SURFACE> surfaces;
+		vector<MESH_RANGE> ranges;
+		vector<VERTEX> vertices;
+		vector<uint32_t> indices;
+		for (size_t batchIndex = 0; batchIndex < batches.size(); batchIndex++) {
+			MESH_BATCH& batch = batches[batchIndex];
+			ordered &= batch.loadId == loadId && batch.batchIndex == batchIndex && batch.layerIndex < NUM_LAYERS
+				&& (layers.empty() || batch.layerIndex + 1 >= layers.size()) && batch.firstRange <= ranges.size();
+			surfacesFirst &= batchIndex == 0 ? !batch.surfaces.empty() : batch.surfaces.empty();
+			if (!ordered) break;
+
+			if (batchIndex == 0) surfaces = batch.surfaces;
+			layers.resize(batch.layerIndex + 1);
+			layers[batch.layerIndex] = batch.layer;
+			ranges.resize(batch.firstRange);
+			ranges.insert(ranges.end(), batch.ranges.begin(), batch.ranges.end());
+			vertices.insert(vertices.end(), batch.vertices.begin(), batch.vertices.end());
+			indices.insert(indices.end(), batch.indices.begin(), batch.indices.end());
+		}
+		checks.check(ordered, "batches in order, each from the load");
+		checks.check(surfacesFirst, "surfaces in the first batch only");
+		checks.check(sameElements(layers, mesh->layers), "last batch of each layer gives its range");
+		checks.check(sameElements(surfaces, mesh->surfaces), "batch surfaces match the mesh");
+		checks.check(sameElements(ranges, mesh->ranges), "batch draw ranges match the mesh");
+		checks.check(sameElements(vertices, mesh->vertices) && sameElements(indices, mesh->indices), "batch vertices and indices match the mesh");
+	}
+
+	/// <summary>
+	/// Cancelling a progressive load whose batch queue is full stops the
+	/// loader thread's wait to push the next batch. The queued batches stay
+	/// for the consumer, and the next load runs as usual.
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkCancelWhileQueueFull(SelfTestChecks& checks) {
+
+		// One batch per layer, more than the queue holds
+		const size_t CAPACITY = ObjectLoader::BATCH_QUEUE_CAPACITY;
+		TemporaryObject object("Blocked", makeGridObject(unsigned(CAPACITY) + 16, 4));
+		TemporaryObject next("AfterBlocked", makeGridObject(1, 20));
+		LoadResults results;
+		ObjectLoader loader;
+		loader.SetProgressive(true);
+		loader.SetCompletionCallback([&](const ObjectLoader::LOAD_RESULT& result) { results.add(result); });
+
+		// Each batch is reported just before it's pushed, so the report after
+		// the queue's capacity is of a batch that can't be
+		mutex progressMutex;
+		condition_variable changed;
+		size_t numReported = 0;
+		loader.SetProgressCallback([&](uint64_t, LoadPhase phase, double) {
+			if (phase != LoadPhase::Triangulation) return;
+			lock_guard<mutex> lock(progressMutex);
+			numReported++;
+			changed.notify_all();
+		});
+
+		uint64_t loadId = loader.Load(object.getPathname());
+		bool blocked;
+		{
+			unique_lock<mutex> lock(progressMutex);
+			blocked = changed.wait_for(lock, LOADER_TIMEOUT, [&]() { return numReported > CAPACITY; });
+		}
+		checks.check(blocked, "queue filled");
+		this_thread::sleep_for(chrono::milliseconds(10));
+
+		// The loader thread only stops waiting if it sees the cancel
+		loader.Cancel();
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + LOADER_TIMEOUT;
+		while (loader.IsLoading() && chrono::steady_clock::now() < deadline) {
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+		if (!checks.check(!loader.IsLoading(), "cancel stopped the blocked push")) return;
+
+		vector<ObjectLoader::LOAD_RESULT> loadResults = results.get();
+		checks.check(loadResults.size() == 1 && loadResults[0].cancelled && !loadResults[0].loaded, "load cancelled");
+		checks.check(!loader.GetMesh(), "cancelled load not published");
+
+		// The batches queued before the cancel are still there
+		vector<MESH_BATCH> batches;
+		MESH_BATCH batch;
+		while (loader.PopBatch(batch)) batches.push_back(move(batch));
+		bool ordered = batches.size() == CAPACITY;
+		for (size_t batchIndex = 0; ordered && batchIndex < batches.size(); batchIndex++) {
+			ordered = batches[batchIndex].loadId == loadId && batches[batchIndex].batchIndex == batchIndex;
+		}
+		checks.check(ordered, "a full queue of the cancelled load's batches, in order");
+
+		// The loader carries on with the next request
+		uint64_t nextLoadId = loader.Load(next.getPathname());
+		batches.clear();
+		checks.check(popBatchesUntilIdle(loader, batches), "next load finished");
+		bool fromNext = !batches.empty();
+		for (const MESH_BATCH& nextBatch : batches) {
+			fromNext &= nextBatch.loadId == nextLoadId;
+		}
+		checks.check(fromNext, "batches after the cancel all come from the next load");
+		shared_ptr<const ObjectLoader::MESH_SNAPSHOT> mesh = loader.GetMesh();
+		checks.check(mesh && mesh->loadId == nextLoadId, "next load published");
+	}
+
+	/// <summary>
+	/// A newer request cancels the load in progress, which is never
+	/// published, and the newer load is published in its place
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkNewerRequestCancels(SelfTestChecks& checks) {
+
+		TemporaryObject first("Older", makeGridObject(2, 40));
+		TemporaryObject second("Newer", makeGridObject(1, 20));
+		LoadResults results;
+		ObjectLoader loader;
+		loader.SetCompletionCallback([&](const ObjectLoader::LOAD_RESULT& result) { results.add(result); });
+
+		// Hold the first load in its first progress report until the second is requested
+		mutex progressMutex;
+		condition_variable changed;
+		uint64_t firstLoadId = 0;
+		bool started = false;
+		bool released = false;
+		loader.SetProgressCallback([&](uint64_t loadId, LoadPhase, double) {
+			unique_lock<mutex> lock(progressMutex);
+			if (loadId != firstLoadId) return;
+			started = true;
+			changed.notify_all();
+			changed.wait_for(lock, LOADER_TIMEOUT, [&]() { return released; });
+		});
+
+		{
+			lock_guard<mutex> lock(progressMutex);
+			firstLoadId = loader.Load(first.getPathname());
+		}
+		bool firstStarted;
+		{
+			unique_lock<mutex> lock(progressMutex);
+			firstStarted = changed.wait_for(lock, LOADER_TIMEOUT, [&]() { return started; });
+		}
+		checks.check(firstStarted, "older load started");
+		uint64_t secondLoadId = loader.Load(second.getPathname());
+		{
+			lock_guard<mutex> lock(progressMutex);
+			released = true;
+		}
+		changed.notify_all();
+		loader.WaitForIdle();
+
+		vector<ObjectLoader::LOAD_RESULT> loadResults = results.get();
+		if (!checks.check(loadResults.size() == 2, "both loads reported")) return;
+		checks.check(loadResults[0].loadId == firstLoadId && loadResults[0].cancelled && !loadResults[0].loaded, "older load cancelled");
+		checks.check(loadResults[1].loadId == secondLoadId && loadResults[1].loaded && !loadResults[1].cancelled, "newer load published");
+		shared_ptr<const ObjectLoader::MESH_SNAPSHOT> mesh = loader.GetMesh();
+		checks.check(mesh && mesh->loadId == secondLoadId && mesh->pathname == second.getPathname(), "published mesh is the newer one");
+	}
+
+	/// <summary>
+	/// Loads of missing and corrupt files fail without replacing the mesh
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkFailedLoadKeepsMesh(SelfTestChecks& checks) {
+
+		TemporaryObject valid("Valid", makeGridObject(1, 20));
+		TemporaryObject corrupt("Corrupt", { 'F', 'O', 'R', 'M', 0, 0, 0, 4, 'J', 'U', 'N', 'K' });
+		LoadResults results;
+		ObjectLoader loader;
+		loader.SetCompletionCallback([&](const ObjectLoader::LOAD_RESULT& result) { results.add(result); });
+
+		loader.Load(valid.getPathname());
+		loader.WaitForIdle();
+		shared_ptr<const ObjectLoader::MESH_SNAPSHOT> mesh = loader.GetMesh();
+		if (!checks.check(mesh && !mesh->indices.empty(), "valid object loaded")) return;
+
+		loader.Load(valid.getPathname() + ".missing");
+		loader.WaitForIdle();
+		loader.Load(corrupt.getPathname());
+		loader.WaitForIdle();
+
+		vector<ObjectLoader::LOAD_RESULT> loadResults = results.get();
+		if (!checks.check(loadResults.size() == 3, "every load reported")) return;
+		for (size_t index : { 1, 2 }) {
+			const ObjectLoader::LOAD_RESULT& result = loadResults[index];
+			string file = index == 1 ? "missing" : "corrupt";
+			checks.check(!result.loaded && !result.cancelled, file + " file failed");
+			checks.check(!result.errorReason.empty(), file + " file failure has a reason");
+		}
+		checks.check(loader.GetMesh() == mesh, "previous mesh still published");
+	}
+
+	/// <summary>
+	/// Destroying the loader cancels the load in progress and joins the
+	/// loader thread. The load is progressive and nothing takes its batches,
+	/// so it can't finish before the loader is destroyed.
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkDestructorJoinsMidLoad(SelfTestChecks& checks) {
+
+		// A layer is at least one batch, so this is more than the queue holds
+		TemporaryObject object("Unconsumed", makeGridObject(unsigned(ObjectLoader::BATCH_QUEUE_CAPACITY) + 16, 4));
+		LoadResults results;
+		mutex progressMutex;
+		condition_variable changed;
+		bool started = false;
+
+		unique_ptr<ObjectLoader> loader = make_unique<ObjectLoader>();
+		loader->SetProgressive(true);
+		loader->SetCompletionCallback([&](const ObjectLoader::LOAD_RESULT& result) { results.add(result); });
+		loader->SetProgressCallback([&](uint64_t, LoadPhase, double) {
+			lock_guard<mutex> lock(progressMutex);
+			started = true;
+			changed.notify_all();
+		});
+		loader->Load(object.getPathname());
+		{
+			unique_lock<mutex> lock(progressMutex);
+			checks.check(changed.wait_for(lock, LOADER_TIMEOUT, [&]() { return started; }), "load started");
+		}
+		loader.reset();
+
+		vector<ObjectLoader::LOAD_RESULT> loadResults = results.get();
+		checks.check(loadResults.size() == 1 && loadResults[0].cancelled && !loadResults[0].loaded, "load cancelled by the destructor");
+	}
+}
+
+/// <summary>
+/// Run object loader self tests
+/// </summary>
+void runObjectLoaderSelfTests() {
+	runSelfTest("SelfTest ObjectLoader/newer request cancels", checkNewerRequestCancels);
+	runSelfTest("SelfTest ObjectLoader/failed load keeps mesh", checkFailedLoadKeepsMesh);
+	runSelfTest("SelfTest ObjectLoader/destructor mid-load", checkDestructorJoinsMidLoad);
+	runSelfTest("SelfTest ObjectLoader/progressive batches", checkProgressiveBatches);
+	runSelfTest("SelfTest ObjectLoader/cancel while queue full", checkCancelWhileQueueFull);
+}
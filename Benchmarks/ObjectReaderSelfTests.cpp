@@ -0,0 +1,207 @@
+//
+// Object reader self tests
+//
+// Objects whose polygons refer to points their layer doesn't have, read
+// whole and progressively. Such polygons are skipped and counted with the
+// polygons of unsupported sizes, rather than read past the layer's points.
+// Layers with several POLS chunks draw the polygons of every FACE chunk,
+// each with the surfaces of the PTAG chunk that follows it.
+//
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "BenchmarkObjects.h"
+#include "SelfTest.h"
+#include "../ObjectReader.h"
+
+namespace {
+
+	// Grid of the test object: GRID_SIZE^2 quads on (GRID_SIZE + 1)^2 points
+	const unsigned GRID_SIZE = 2;
+	const uint32_t NUM_GRID_POINTS = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+
+	/// <summary>
+	/// Build a one layer object whose grid quads are mixed with polygons
+	/// indexing past the layer's points
+	/// </summary>
+	/// <returns>Object file contents</returns>
+	vector<char> makeMissingPointsObject() {
+
+		// A quad one past the last point and a triangle far past it, with a
+		// four byte index, between the grid's quads
+		vector<char> polygons = makeGridPolygons(GRID_SIZE);
+		appendBE(polygons, 4, 2);
+		for (uint32_t point : { 0u, 1u, NUM_GRID_POINTS, 3u }) appendVx(polygons, point);
+		appendBE(polygons, 3, 2);
+		for (uint32_t point : { 0u, 0x12345u, 1u }) appendVx(polygons, point);
+		vector<char> quad = makeGridPolygons(1);
+		polygons.insert(polygons.end(), quad.begin() + 4, quad.end());
+
+		vector<char> layer;
+		appendBE(layer, 0, 2);
+		appendBE(layer, 0, 2);
+		for (int axis = 0; axis < 3; axis++) appendFloat(layer, 0);
+		layer.insert(layer.end(), { 'L', 0 });
+
+		vector<char> body;
+		appendChunk(body, "SURF", makeSurface(1));
+		appendChunk(body, "LAYR", layer);
+		appendChunk(body, "PNTS", makeGridPoints(GRID_SIZE));
+		appendChunk(body, "POLS", polygons);
+
+		vector<char> object = { 'F', 'O', 'R', 'M' };
+		appendBE(object, uint32_t(body.size() + 4), 4);
+		object.insert(object.end(), { 'L', 'W', 'O', '2' });
+		object.insert(object.end(), body.begin(), body.end());
+		return object;
+	}
+
+	/// <summary>
+	/// Build a SURF payload with only a color, so surfaces can be told apart
+	/// by their color
+	/// </summary>
+	/// <param name="name">Surface name</param>
+	/// <param name="red">Red component of the color</param>
+	/// <returns>Chunk payload</returns>
+	vector<char> makeColorSurface(const string& name, float red) {
+		vector<char> surface(name.begin(), name.end());
+		surface.push_back(0);
+		if (surface.size() % 2 != 0) surface.push_back(0);
+		surface.insert(surface.end(), { 0, 0 });
+		surface.insert(surface.end(), { 'C', 'O', 'L', 'R' });
+		appendBE(surface, 14, 2);
+		appendFloat(surface, red);
+		appendFloat(surface, 0);
+		appendFloat(surface, 0);
+		appendVx(surface, 0);
+		return surface;
+	}
+
+	/// <summary>
+	/// Build a PTAG payload giving every polygon the same surface
+	/// </summary>
+	/// <param name="numPolygons">Number of polygons</param>
+	/// <param name="tag">Index of the surface name in the TAGS chunk</param>
+	/// <returns>Chunk payload</returns>
+	vector<char> makeSurfaceTags(uint32_t numPolygons, uint16_t tag) {
+		vector<char> polygonTags = { 'S', 'U', 'R', 'F' };
+		for (uint32_t polygonIndex = 0; polygonIndex < numPolygons; polygonIndex++) {
+			appendVx(polygonTags, polygonIndex);
+			appendBE(polygonTags, tag, 2);
+		}
+		return polygonTags;
+	}
+
+	/// <summary>
+	/// Build a one layer object whose first POLS chunk holds patches, followed
+	/// by two FACE chunks, each with its own PTAG chunk and surface
+	/// </summary>
+	/// <returns>Object file contents</returns>
+	vector<char> makePolygonChunksObject() {
+
+		vector<char> layer;
+		appendBE(layer, 0, 2);
+		appendBE(layer, 0, 2);
+		for (int axis = 0; axis < 3; axis++) appendFloat(layer, 0);
+		layer.insert(layer.end(), { 'L', 0 });
+
+		// Subdivision patches over the whole grid, which aren't drawn
+		vector<char> patches = makeGridPolygons(GRID_SIZE);
+		memcpy(patches.data(), "PTCH", 4);
+
+		vector<char> body;
+		appendChunk(body, "TAGS", makeTags(3));
+		appendChunk(body, "LAYR", layer);
+		appendChunk(body, "PNTS", makeGridPoints(GRID_SIZE));
+		appendChunk(body, "POLS", patches);
+		appendChunk(body, "PTAG", makeSurfaceTags(GRID_SIZE * GRID_SIZE, 0));
+		appendChunk(body, "POLS", makeGridPolygons(GRID_SIZE));
+		appendChunk(body, "PTAG", makeSurfaceTags(GRID_SIZE * GRID_SIZE, 1));
+		appendChunk(body, "POLS", makeGridPolygons(1));
+		appendChunk(body, "PTAG", makeSurfaceTags(1, 2));
+		appendChunk(body, "SURF", makeColorSurface("Surface0", 0.5f));
+		appendChunk(body, "SURF", makeColorSurface("Surface1", 0.25f));
+		appendChunk(body, "SURF", makeColorSurface("Surface2", 0.75f));
+
+		vector<char> object = { 'F', 'O', 'R', 'M' };
+		appendBE(object, uint32_t(body.size() + 4), 4);
+		object.insert(object.end(), { 'L', 'W', 'O', '2' });
+		object.insert(object.end(), body.begin(), body.end());
+		return object;
+	}
+
+	/// <summary>
+	/// Polygons with missing points are skipped, and the rest drawn, in
+	/// whole and progressive reads
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkMissingPoints(SelfTestChecks& checks) {
+
+		TemporaryObject object("MissingPoints", makeMissingPointsObject());
+		for (bool progressive : { false, true }) {
+			string mode = progressive ? "progressive" : "whole";
+
+			ObjectReader reader;
+			wstring errorReason;
+			if (progressive) reader.SetMeshBatchCallback([](MESH_BATCH&) { return true; });
+			bool loaded = reader.ReadObjectFile(object.getPathname(), errorReason);
+			if (!checks.check(loaded, mode + " read loaded")) continue;
+
+			// Five quads of two triangles each are drawn
+			checks.check(reader.GetNumPolygons() == 7, mode + " read counts every polygon");
+			checks.check(reader.GetNumNonTriangles() == 2, mode + " read skips the polygons with missing points");
+			checks.check(reader.GetNumTriangles() == 10 && reader.GetIndices().size() == 30, mode + " read draws the other polygons");
+			checks.check(!errorReason.empty(), mode + " read warns of the skipped polygons");
+
+			bool finite = reader.GetVertices().size() == 20;
+			for (const VERTEX& vertex : reader.GetVertices()) {
+				finite &= isfinite(vertex.pos.x) && isfinite(vertex.pos.y) && isfinite(vertex.pos.z);
+			}
+			checks.check(finite, mode + " read vertices all come from the layer's points");
+		}
+	}
+
+	/// <summary>
+	/// Every FACE chunk of a layer is drawn, after a chunk of patches, with
+	/// the surfaces of the PTAG chunk that follows it, in whole and
+	/// progressive reads
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkPolygonChunks(SelfTestChecks& checks) {
+
+		TemporaryObject object("PolygonChunks", makePolygonChunksObject());
+		for (bool progressive : { false, true }) {
+			string mode = progressive ? "progressive" : "whole";
+
+			ObjectReader reader;
+			wstring errorReason;
+			if (progressive) reader.SetMeshBatchCallback([](MESH_BATCH&) { return true; });
+			bool loaded = reader.ReadObjectFile(object.getPathname(), errorReason);
+			if (!checks.check(loaded, mode + " read loaded")) continue;
+
+			// Five quads of two triangles each, from the two FACE chunks
+			checks.check(reader.GetNumPolygons() == 5, mode + " read counts the polygons of both FACE chunks");
+			checks.check(reader.GetNumTriangles() == 10 && reader.GetIndices().size() == 30, mode + " read draws the polygons of both FACE chunks");
+			checks.check(errorReason.empty(), mode + " read has no warning");
+
+			// Indices drawn with each surface, told apart by their red component
+			uint32_t indicesBySurface[3] {};
+			for (const MESH_RANGE& range : reader.GetRanges()) {
+				float red = range.surface < reader.GetSurfaces().size() ? reader.GetSurfaces()[range.surface].color.x : 0.0f;
+				indicesBySurface[red == 0.5f ? 0 : red == 0.25f ? 1 : 2] += range.numIndices;
+			}
+			checks.check(indicesBySurface[0] == 0, mode + " read draws nothing with the patches' surface");
+			checks.check(indicesBySurface[1] == 24, mode + " read draws the first FACE chunk with the PTAG after it");
+			checks.check(indicesBySurface[2] == 6, mode + " read draws the second FACE chunk with the PTAG after it");
+		}
+	}
+}
+
+/// <summary>
+/// Run object reader self tests
+/// </summary>
+void runObjectReaderSelfTests() {
+	runSelfTest("SelfTest ObjectReader/missing points", checkMissingPoints);
+	runSelfTest("SelfTest ObjectReader/polygon chunks", checkPolygonChunks);
+}
@@ -0,0 +1,115 @@
+//
+// Polygon parse benchmarks
+//
+// Compares parsing a million-quad POLS chunk into compressed sparse row
+// storage with the one-vector-per-polygon layout it replaced, and serial
+// decoding with parallel segment decoding.
+//
+#include <vector>
+
+#include "Benchmark.h"
+#include "../LightWaveObject/Chunks/Polygons.h"
+
+namespace {
+
+	// Grid size; the chunk holds GRID_SIZE * GRID_SIZE quads
+	const unsigned GRID_SIZE = 1000;
+
+	// Previous polygon layout, kept as the baseline
+	struct LEGACY_POLYGON {
+		int numVertices = 0;
+		vector<int> pointIndex;
+	};
+
+	/// <summary>
+	/// Append a variable-length index
+	/// </summary>
+	void appendVx(vector<char>& chunk, uint32_t index) {
+		if (index < 0xff00) {
+			chunk.push_back(char(index >> 8));
+			chunk.push_back(char(index));
+		}
+		else {
+			chunk.push_back(char(0xff));
+			chunk.push_back(char(index >> 16));
+			chunk.push_back(char(index >> 8));
+			chunk.push_back(char(index));
+		}
+	}
+
+	/// <summary>
+	/// Build a POLS chunk covering a grid of points with quads
+	/// </summary>
+	/// <returns>Raw chunk bytes, including the chunk header</returns>
+	vector<char> makePolygonsChunk() {
+
+		vector<char> chunk(LWO_CHUNK_DATA_OFFSET + 4);
+		memcpy(chunk.data() + LWO_CHUNK_DATA_OFFSET, "FACE", 4);
+
+		// Most indices are past 0xff00, so this mostly exercises 4 byte indices
+		for (uint32_t y = 0; y < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x < GRID_SIZE; x++) {
+				uint32_t corner = y * (GRID_SIZE + 1) + x;
+				chunk.push_back(0);
+				chunk.push_back(4);
+				appendVx(chunk, corner);
+				appendVx(chunk, corner + 1);
+				appendVx(chunk, corner + GRID_SIZE + 2);
+				appendVx(chunk, corner + GRID_SIZE + 1);
+			}
+		}
+
+		// Header
+		size_t payloadLength = chunk.size() - LWO_CHUNK_DATA_OFFSET;
+		memcpy(chunk.data(), "POLS", 4);
+		chunk[4] = char(payloadLength >> 24);
+		chunk[5] = char(payloadLength >> 16);
+		chunk[6] = char(payloadLength >> 8);
+		chunk[7] = char(payloadLength);
+
+		return chunk;
+	}
+}
+
+/// <summary>
+/// Run polygon parse benchmarks
+/// </summary>
+void runPolygonParseBenchmarks() {
+
+	vector<char> chunk = makePolygonsChunk();
+	BufferView chunkBuffer(chunk.data(), chunk.size());
+	LWO_CHUNK_HEADER header = LWUtils::parseChunkHeader(chunk.data());
+	size_t numPolygons = size_t(GRID_SIZE) * GRID_SIZE;
+
+	// Previous Polygons::parsePolygons loop, extended to read VX indices
+	runBenchmark("POLS/LegacyVectorPerPolygon", numPolygons, header.length, [&]() {
+		vector<LEGACY_POLYGON> polygons;
+		size_t offset = LWO_CHUNK_DATA_OFFSET + 4;
+		while (offset < chunk.size()) {
+			LEGACY_POLYGON polygon;
+			unsigned numVertFlags = CONVERT_U2_BYTES_TO_INT(chunkBuffer.data(offset));
+			polygon.numVertices = numVertFlags & 0x03ff;
+			offset += 2;
+			for (int vertIndex = 0; vertIndex < polygon.numVertices; vertIndex++) {
+				polygon.pointIndex.push_back(CONVERT_VX_BYTES_TO_INT(chunkBuffer.data(offset)));
+				offset += CONVERT_VX_BYTES_LENGTH(chunkBuffer.data(offset));
+			}
+			polygons.push_back(polygon);
+		}
+		keepResult(polygons.back().pointIndex.back());
+	});
+
+	runBenchmark("POLS/CompressedSparseRow", numPolygons, header.length, [&]() {
+		Polygons polygons;
+		polygons.parse(chunkBuffer, header);
+		keepResult(polygons.getPolygons().pointIndex.back());
+	});
+
+	ThreadPool& threadPool = ThreadPool::getShared();
+	runBenchmark("POLS/Segmented/" + to_string(threadPool.getNumThreads()) + " threads", numPolygons, header.length, [&]() {
+		Polygons polygons;
+		polygons.setThreadPool(&threadPool);
+		polygons.parse(chunkBuffer, header);
+		keepResult(polygons.getPolygons().pointIndex.back());
+	});
+}
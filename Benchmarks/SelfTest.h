@@ -0,0 +1,130 @@
+//
+// Self tests
+//
+// Functional checks run with --selftest, for behavior a benchmark or budget
+// wouldn't show, such as how the parsers treat corrupt chunks and how the
+// loader's threads hand over work. Each test runs all of its checks, prints
+// those that failed, and is reported as one result.
+//
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+// Outcome of one self test
+struct SELF_TEST_RESULT {
+	std::string name;
+	size_t checks = 0;			// Checks made
+	size_t failures = 0;		// Checks that failed
+	bool passed = false;
+};
+
+// Result recording, defined in BenchmarkMain.cpp
+void recordSelfTestResult(const SELF_TEST_RESULT& result);
+
+// Checks made by the running self test
+class SelfTestChecks {
+public:
+
+	/// <summary>
+	/// Make a check, printing it if it failed
+	/// </summary>
+	/// <param name="condition">True if the check passed</param>
+	/// <param name="description">What was checked</param>
+	/// <returns>The condition</returns>
+	bool check(bool condition, const std::string& description) {
+		_checks++;
+		if (!condition) {
+			_failures++;
+			std::cout << "    failed: " << description << std::endl;
+		}
+		return condition;
+	}
+
+	// Getters
+	size_t getChecks() const { return _checks; }
+	size_t getFailures() const { return _failures; }
+
+private:
+
+	// Private data
+	size_t _checks {};
+	size_t _failures {};
+};
+
+// Object file written for a test, and removed when the test is done
+class TemporaryObject {
+public:
+
+	/// <summary>
+	/// Write an object to a temporary file
+	/// </summary>
+	/// <param name="name">File name, unique among the tests</param>
+	/// <param name="object">Object file contents</param>
+	TemporaryObject(const std::string& name, const std::vector<char>& object) {
+		std::error_code error;
+		_pathname = (std::filesystem::temp_directory_path(error) / ("LWObjectSelfTest-" + name + ".lwo")).string();
+		std::ofstream file(_pathname, std::ios::binary | std::ios::trunc);
+		file.write(object.data(), object.size());
+	}
+
+	/// <summary>
+	/// Remove the file
+	/// </summary>
+	~TemporaryObject() {
+		std::error_code error;
+		std::filesystem::remove(_pathname, error);
+	}
+
+	TemporaryObject(const TemporaryObject&) = delete;
+	TemporaryObject& operator=(const TemporaryObject&) = delete;
+
+	// Getters
+	const std::string& getPathname() const { return _pathname; }
+
+private:
+
+	// Private data
+	std::string _pathname;
+};
+
+/// <summary>
+/// Print a self test result
+/// </summary>
+/// <param name="result">Self test result</param>
+inline void printSelfTestResult(const SELF_TEST_RESULT& result) {
+	std::cout << std::left << std::setw(48) << result.name << std::right
+		<< std::setw(10) << result.checks << " checks"
+		<< (result.passed ? "    ok" : "    FAILED") << std::endl;
+}
+
+/// <summary>
+/// Run a self test
+/// </summary>
+/// <param name="name">Test name</param>
+/// <param name="body">Test, called with the SelfTestChecks to make its checks with</param>
+/// <returns>Test result, passed if the test wasn't selected</returns>
+template<typename Body>
+SELF_TEST_RESULT runSelfTest(const std::string& name, Body body) {
+
+	SELF_TEST_RESULT result;
+	result.name = name;
+	result.passed = true;
+	if (!isBenchmarkSelected(name)) return result;
+
+	SelfTestChecks checks;
+	body(checks);
+
+	result.checks = checks.getChecks();
+	result.failures = checks.getFailures();
+	result.passed = result.failures == 0;
+	printSelfTestResult(result);
+	recordSelfTestResult(result);
+
+	return result;
+}
@@ -0,0 +1,134 @@
+//
+// SpscQueue self tests
+//
+// Checks the queue at its edges: indices wrapping past the end of the slots,
+// pushes into a full queue and pops from an empty one, and the order of
+// elements handed from a producer thread to a consumer thread, with a
+// capacity small enough that both sides keep finding the queue full or empty.
+//
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "SelfTest.h"
+#include "../LightWaveObject/SpscQueue.h"
+
+using namespace std;
+
+namespace {
+
+	// Elements handed between the threads of the ordering test
+	const size_t NUM_THREAD_ELEMENTS = 1 << 20;
+
+	/// <summary>
+	/// Elements keep their order while the indices wrap many times, with the
+	/// queue at every fill level
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkWraparound(SelfTestChecks& checks) {
+
+		SpscQueue<int> queue(4);
+		int nextPush = 0;
+		int nextPop = 0;
+		bool ordered = true;
+		for (int round = 0; round < 100; round++) {
+
+			// Fill to a level that changes each round, then drain all but one
+			int fill = 1 + round % 4;
+			while (nextPush - nextPop < fill) {
+				int value = nextPush;
+				if (!queue.tryPush(move(value))) break;
+				nextPush++;
+			}
+			int value;
+			while (nextPop < nextPush - 1 && queue.tryPop(value)) {
+				ordered &= value == nextPop++;
+			}
+		}
+		int value;
+		while (queue.tryPop(value)) {
+			ordered &= value == nextPop++;
+		}
+
+		checks.check(nextPush > 100, "indices wrapped past the slots many times");
+		checks.check(ordered && nextPop == nextPush, "every element popped once, in order");
+	}
+
+	/// <summary>
+	/// A full queue refuses pushes without taking the element, an empty one
+	/// refuses pops without touching the output, and the capacity is rounded
+	/// up to a power of two
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkFullAndEmpty(SelfTestChecks& checks) {
+
+		SpscQueue<unique_ptr<int>> queue(5);
+		checks.check(queue.getCapacity() == 8, "capacity of 5 rounded up to 8");
+
+		unique_ptr<int> popped = make_unique<int>(-1);
+		checks.check(!queue.tryPop(popped), "new queue is empty");
+		checks.check(popped && *popped == -1, "pop from an empty queue leaves the output");
+
+		bool filled = true;
+		for (int index = 0; index < 8; index++) {
+			filled &= queue.tryPush(make_unique<int>(index));
+		}
+		checks.check(filled, "queue takes its capacity");
+
+		unique_ptr<int> extra = make_unique<int>(8);
+		checks.check(!queue.tryPush(move(extra)), "full queue refuses a push");
+		checks.check(extra && *extra == 8, "refused element isn't moved from");
+
+		checks.check(queue.tryPop(popped) && popped && *popped == 0, "oldest element popped first");
+		checks.check(queue.tryPush(move(extra)) && !extra, "pop makes room for one push");
+
+		bool drained = true;
+		for (int index = 1; index <= 8; index++) {
+			drained &= queue.tryPop(popped) && popped && *popped == index;
+		}
+		checks.check(drained, "remaining elements popped in order");
+		checks.check(!queue.tryPop(popped), "drained queue is empty");
+	}
+
+	/// <summary>
+	/// Elements pushed on one thread are popped on another in the order they
+	/// were pushed, each exactly once
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkThreadOrdering(SelfTestChecks& checks) {
+
+		SpscQueue<size_t> queue(16);
+		thread producer([&]() {
+			for (size_t index = 0; index < NUM_THREAD_ELEMENTS; index++) {
+				size_t value = index;
+				while (!queue.tryPush(move(value))) this_thread::yield();
+			}
+		});
+
+		size_t expected = 0;
+		size_t outOfOrder = 0;
+		while (expected < NUM_THREAD_ELEMENTS) {
+			size_t value;
+			if (!queue.tryPop(value)) {
+				this_thread::yield();
+				continue;
+			}
+			if (value != expected) outOfOrder++;
+			expected = value + 1;
+		}
+		producer.join();
+
+		checks.check(outOfOrder == 0, to_string(outOfOrder) + " elements popped out of order");
+		size_t value;
+		checks.check(!queue.tryPop(value), "nothing left after the last element");
+	}
+}
+
+/// <summary>
+/// Run SpscQueue self tests
+/// </summary>
+void runSpscQueueSelfTests() {
+	runSelfTest("SelfTest SpscQueue/wraparound", checkWraparound);
+	runSelfTest("SelfTest SpscQueue/full and empty", checkFullAndEmpty);
+	runSelfTest("SelfTest SpscQueue/two-thread ordering", checkThreadOrdering);
+}
@@ -0,0 +1,199 @@
+//
+// Surface self tests
+//
+// SURF chunks with corrupt sub-chunk sizes, truncated values and
+// unterminated names, checked through the parser and the surface table
+// built on it. A sub-chunk too short for its value mustn't count as set,
+// or it would hide the value the surface inherits from its source.
+//
+#include <vector>
+
+#include "BenchmarkObjects.h"
+#include "SelfTest.h"
+#include "../LightWaveObject/Chunks/Surface.h"
+#include "../LightWaveObject/SurfaceTable.h"
+
+namespace {
+
+	/// <summary>
+	/// Start a SURF payload
+	/// </summary>
+	/// <param name="name">Surface name</param>
+	/// <param name="source">Name of the surface this one derives from, or an empty string</param>
+	/// <returns>Payload bytes, before the sub-chunks</returns>
+	vector<char> makeSurfaceNames(const string& name, const string& source) {
+		vector<char> surface(name.begin(), name.end());
+		surface.push_back(0);
+		if (surface.size() % 2 != 0) surface.push_back(0);
+		surface.insert(surface.end(), source.begin(), source.end());
+		surface.push_back(0);
+		if (surface.size() % 2 != 0) surface.push_back(0);
+		return surface;
+	}
+
+	/// <summary>
+	/// Append a sub-chunk whose declared size may differ from its data
+	/// </summary>
+	/// <param name="surface">SURF payload</param>
+	/// <param name="tag">Sub-chunk tag</param>
+	/// <param name="size">Declared size</param>
+	/// <param name="data">Sub-chunk data</param>
+	void appendSubChunk(vector<char>& surface, const char tag[], uint32_t size, const vector<char>& data) {
+		surface.insert(surface.end(), tag, tag + 4);
+		appendBE(surface, size, 2);
+		surface.insert(surface.end(), data.begin(), data.end());
+	}
+
+	/// <summary>
+	/// Build the data of a float sub-chunk
+	/// </summary>
+	/// <param name="value">Value</param>
+	/// <returns>Value and a zero envelope index</returns>
+	vector<char> makeFloatValue(float value) {
+		vector<char> data;
+		appendFloat(data, value);
+		appendVx(data, 0);
+		return data;
+	}
+
+	/// <summary>
+	/// Parse a SURF payload as the last chunk of a buffer, so reads past its
+	/// end would run off the buffer
+	/// </summary>
+	/// <param name="surface">Surface to parse into</param>
+	/// <param name="payload">SURF payload</param>
+	/// <param name="declaredLength">Length in the chunk header, or zero for the payload size</param>
+	void parseSurface(Surface& surface, const vector<char>& payload, size_t declaredLength = 0) {
+		vector<char> chunk = makeChunk("SURF", payload);
+		LWO_CHUNK_HEADER header = LWUtils::parseChunkHeader(chunk.data());
+		if (declaredLength) header.length = declaredLength;
+		chunk.resize(LWO_CHUNK_DATA_OFFSET + payload.size());
+		surface.parse(BufferView(chunk.data(), chunk.size()), header);
+	}
+
+	/// <summary>
+	/// Sub-chunk sizes of 0x8000 and over, which once moved the offset
+	/// backwards, and sizes past the end of the chunk
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkSubChunkSizes(SelfTestChecks& checks) {
+
+		for (uint32_t size : { 0x8000u, 0xfffau, 0xfffeu, 0xffffu }) {
+			vector<char> payload = makeSurfaceNames("Corrupt", "");
+			appendSubChunk(payload, "COLR", size, vector<char>(20));
+			Surface surface;
+			parseSurface(surface, payload);
+			checks.check(surface.getName() == "Corrupt", "name read before a sub-chunk of size " + to_string(size));
+			checks.check(!surface.hasParameter(SurfaceParameter::COLR), "sub-chunk of size " + to_string(size) + " skipped");
+		}
+
+		// Sub-chunks before one that runs past the end are kept
+		vector<char> payload = makeSurfaceNames("Cut", "");
+		appendSubChunk(payload, "DIFF", 6, makeFloatValue(0.5f));
+		appendSubChunk(payload, "SPEC", 6, { 0, 0 });
+		Surface surface;
+		parseSurface(surface, payload);
+		checks.check(surface.hasParameter(SurfaceParameter::DIFF) && surface.getParameters().diffuse == 0.5f, "sub-chunk before a truncated one read");
+		checks.check(!surface.hasParameter(SurfaceParameter::SPEC), "sub-chunk past the end of the chunk skipped");
+	}
+
+	/// <summary>
+	/// Sub-chunks whose declared size is too small for their values
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkTruncatedValues(SelfTestChecks& checks) {
+
+		vector<char> payload = makeSurfaceNames("Short", "");
+
+		// Color without its envelope index
+		vector<char> color;
+		for (int channel = 0; channel < 3; channel++) appendFloat(color, 0.25f);
+		appendSubChunk(payload, "COLR", 12, color);
+
+		// Sharpness with a four byte envelope index cut to two
+		vector<char> sharpness;
+		appendFloat(sharpness, 0.5f);
+		appendVx(sharpness, 0x10000);
+		sharpness.resize(6);
+		appendSubChunk(payload, "SHRP", 6, sharpness);
+
+		// Bump too short for its value, then a smoothing angle in full
+		appendSubChunk(payload, "BUMP", 2, { 0, 0 });
+		vector<char> angle;
+		appendFloat(angle, 1.5f);
+		appendSubChunk(payload, "SMAN", 4, angle);
+
+		Surface surface;
+		parseSurface(surface, payload);
+		checks.check(!surface.hasParameter(SurfaceParameter::COLR), "color without an envelope index skipped");
+		checks.check(!surface.hasParameter(SurfaceParameter::SHRP), "sharpness with a cut envelope index skipped");
+		checks.check(!surface.hasParameter(SurfaceParameter::BUMP), "bump too short for its value skipped");
+		checks.check(surface.hasParameter(SurfaceParameter::SMAN) && surface.getParameters().maxSmoothingAngle == 1.5f,
+			"smoothing angle after the short sub-chunks read");
+	}
+
+	/// <summary>
+	/// Names without terminators at the end of the chunk
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkUnterminatedNames(SelfTestChecks& checks) {
+
+		Surface nameOnly;
+		parseSurface(nameOnly, { 'N', 'a', 'm', 'e' });
+		checks.check(nameOnly.getName() == "Name", "unterminated name ends at the end of the chunk");
+		checks.check(nameOnly.getSource().empty(), "missing source is empty");
+
+		Surface sourceOnly;
+		parseSurface(sourceOnly, { 'N', 0, 'B', 'a', 's', 'e' });
+		checks.check(sourceOnly.getSource() == "Base", "unterminated source ends at the end of the chunk");
+
+		// A header claiming more than the buffer holds is bounded by the buffer
+		Surface longHeader;
+		parseSurface(longHeader, { 'L', 'o', 'n', 'g' }, 0x7fffffff);
+		checks.check(longHeader.getName() == "Long", "name bounded by the buffer, not the chunk header");
+	}
+
+	/// <summary>
+	/// Parameters a derived surface sets only in truncated sub-chunks come
+	/// from its source
+	/// </summary>
+	/// <param name="checks">Checks of the test</param>
+	void checkTruncatedInheritance(SelfTestChecks& checks) {
+
+		vector<char> basePayload = makeSurfaceNames("Base", "");
+		appendSubChunk(basePayload, "SHRP", 6, makeFloatValue(0.5f));
+		appendSubChunk(basePayload, "BUMP", 6, makeFloatValue(0.75f));
+
+		vector<char> derivedPayload = makeSurfaceNames("Derived", "Base");
+		appendSubChunk(derivedPayload, "DIFF", 6, makeFloatValue(0.125f));
+		appendSubChunk(derivedPayload, "SHRP", 4, { 0, 0, 0, 0 });
+		appendSubChunk(derivedPayload, "BUMP", 0x8000, makeFloatValue(0.0f));
+
+		vector<Surface> surfaces(2);
+		parseSurface(surfaces[0], basePayload);
+		parseSurface(surfaces[1], derivedPayload);
+		pmr::vector<Surface*> surfacePointers { &surfaces[0], &surfaces[1] };
+		pmr::vector<pmr::string> tags { "Derived", "Base" };
+
+		SurfaceTable surfaceTable;
+		surfaceTable.build(surfacePointers, tags);
+		uint32_t derived = surfaceTable.getSurfaceByTag(0);
+		checks.check(derived == 1 && surfaceTable.getSource(derived) == 0, "derived surface linked to its source");
+		if (derived == SurfaceTable::NO_SURFACE) return;
+
+		const SURFACE_PARAMETERS& parameters = surfaceTable.getParameters(derived);
+		checks.check(parameters.diffuse == 0.125f, "derived surface keeps the value it sets");
+		checks.check(parameters.sharpness == 0.5f, "truncated sharpness inherited from the source");
+		checks.check(parameters.bump == 0.75f, "bump with a corrupt size inherited from the source");
+	}
+}
+
+/// <summary>
+/// Run surface self tests
+/// </summary>
+void runSurfaceSelfTests() {
+	runSelfTest("SelfTest Surface::parse/sub-chunk sizes", checkSubChunkSizes);
+	runSelfTest("SelfTest Surface::parse/truncated values", checkTruncatedValues);
+	runSelfTest("SelfTest Surface::parse/unterminated names", checkUnterminatedNames);
+	runSelfTest("SelfTest SurfaceTable/truncated inheritance", checkTruncatedInheritance);
+}
@@ -0,0 +1,138 @@
+//
+// Tag dispatch benchmarks
+//
+// Compares FourCC switch dispatch of chunk and surface sub-chunk tags with
+// the string comparison chains it replaced.
+//
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../LightWaveObject/LWUtils.h"
+
+namespace {
+
+	// Number of tags dispatched per run
+	const size_t NUM_TAGS = 1 << 16;
+
+	/// <summary>
+	/// Previous chunk tag conversion, kept as the baseline
+	/// </summary>
+	ChunkTag legacyConvertTagStringTagToEnum(string tag) {
+		if (tag == "LAYR") return ChunkTag::LAYR;
+		if (tag == "PNTS") return ChunkTag::PNTS;
+		if (tag == "VMAP") return ChunkTag::VMAP;
+		if (tag == "POLS") return ChunkTag::POLS;
+		if (tag == "TAGS") return ChunkTag::TAGS;
+		if (tag == "PTAG") return ChunkTag::PTAG;
+		if (tag == "VMAD") return ChunkTag::VMAD;
+		if (tag == "VMPA") return ChunkTag::VMPA;
+		if (tag == "ENVL") return ChunkTag::ENVL;
+		if (tag == "CLIP") return ChunkTag::CLIP;
+		if (tag == "SURF") return ChunkTag::SURF;
+		if (tag == "BBOX") return ChunkTag::BBOX;
+		if (tag == "DESC") return ChunkTag::DESC;
+		if (tag == "TEXT") return ChunkTag::TEXT;
+		if (tag == "ICON") return ChunkTag::ICON;
+		return ChunkTag::UNKNOWN;
+	}
+
+	/// <summary>
+	/// Previous surface sub-chunk tag conversion, kept as the baseline
+	/// </summary>
+	SurfaceSubChunkTag legacyConvertSurfaceTagStringToEnum(string tag) {
+		if (tag == "COLR") return SurfaceSubChunkTag::COLR;
+		if (tag == "DIFF") return SurfaceSubChunkTag::DIFF;
+		if (tag == "LUMI") return SurfaceSubChunkTag::LUMI;
+		if (tag == "SPEC") return SurfaceSubChunkTag::SPEC;
+		if (tag == "REFL") return SurfaceSubChunkTag::REFL;
+		if (tag == "TRAN") return SurfaceSubChunkTag::TRAN;
+		if (tag == "TRNL") return SurfaceSubChunkTag::TRNL;
+		if (tag == "GLOS") return SurfaceSubChunkTag::GLOS;
+		if (tag == "BLOK") return SurfaceSubChunkTag::BLOK;
+		if (tag == "SHRP") return SurfaceSubChunkTag::SHRP;
+		if (tag == "BUMP") return SurfaceSubChunkTag::BUMP;
+		if (tag == "SIDE") return SurfaceSubChunkTag::SIDE;
+		if (tag == "SMAN") return SurfaceSubChunkTag::SMAN;
+		if (tag == "RFOP") return SurfaceSubChunkTag::RFOP;
+		if (tag == "RIMG") return SurfaceSubChunkTag::RIMG;
+		if (tag == "RSAN") return SurfaceSubChunkTag::RSAN;
+		if (tag == "RBLR") return SurfaceSubChunkTag::RBLR;
+		if (tag == "RIND") return SurfaceSubChunkTag::RIND;
+		if (tag == "TROP") return SurfaceSubChunkTag::TROP;
+		if (tag == "TIMG") return SurfaceSubChunkTag::TIMG;
+		if (tag == "TBLR") return SurfaceSubChunkTag::TBLR;
+		if (tag == "CLRH") return SurfaceSubChunkTag::CLRH;
+		if (tag == "CLRF") return SurfaceSubChunkTag::CLRF;
+		if (tag == "ADTR") return SurfaceSubChunkTag::ADTR;
+		if (tag == "GLOW") return SurfaceSubChunkTag::GLOW;
+		if (tag == "LINE") return SurfaceSubChunkTag::LINE;
+		if (tag == "ALPH") return SurfaceSubChunkTag::ALPH;
+		if (tag == "VCOL") return SurfaceSubChunkTag::VCOL;
+		return SurfaceSubChunkTag::UNKNOWN;
+	}
+
+	/// <summary>
+	/// Build a buffer of randomly chosen 8-byte tag headers
+	/// </summary>
+	/// <param name="tags">Tags to choose from</param>
+	/// <returns>Raw header bytes</returns>
+	vector<char> makeHeaders(const vector<const char*>& tags) {
+
+		mt19937 random(1234);
+		vector<char> headers(NUM_TAGS * sizeof(LWO_CHUNK_HEADER_RAW));
+		for (size_t index = 0; index < NUM_TAGS; index++) {
+			char* header = headers.data() + index * sizeof(LWO_CHUNK_HEADER_RAW);
+			memcpy(header, tags[random() % tags.size()], 4);
+			memset(header + 4, 0, 4);
+		}
+
+		return headers;
+	}
+}
+
+/// <summary>
+/// Run tag dispatch benchmarks
+/// </summary>
+void runTagDispatchBenchmarks() {
+
+	// Chunk headers, including some tags the parser doesn't know
+	vector<char> chunkHeaders = makeHeaders({
+		"LAYR", "PNTS", "VMAP", "POLS", "TAGS", "PTAG", "VMAD", "VMPA",
+		"ENVL", "CLIP", "SURF", "BBOX", "DESC", "TEXT", "ICON", "VMPX" });
+	size_t headerBytes = chunkHeaders.size();
+
+	runBenchmark("ChunkHeader/LegacyString", NUM_TAGS, headerBytes, [&]() {
+		for (size_t offset = 0; offset < headerBytes; offset += sizeof(LWO_CHUNK_HEADER_RAW)) {
+			ChunkTag tag = legacyConvertTagStringTagToEnum(CONVERT_BYTES_TO_STRING(chunkHeaders.data() + offset, 4));
+			keepResult(tag);
+		}
+	});
+
+	runBenchmark("ChunkHeader/FourCC", NUM_TAGS, headerBytes, [&]() {
+		for (size_t offset = 0; offset < headerBytes; offset += sizeof(LWO_CHUNK_HEADER_RAW)) {
+			LWO_CHUNK_HEADER header = LWUtils::parseChunkHeader(chunkHeaders.data() + offset);
+			keepResult(header.tag);
+		}
+	});
+
+	// Surface sub-chunk headers, weighted towards the ones late in the old chain
+	vector<char> surfaceHeaders = makeHeaders({
+		"COLR", "DIFF", "SPEC", "SMAN", "BLOK", "GLOS", "VCOL", "ALPH",
+		"LINE", "GLOW", "RIND", "TBLR", "XXXX" });
+	size_t surfaceBytes = surfaceHeaders.size();
+
+	runBenchmark("SurfaceSubChunk/LegacyString", NUM_TAGS, surfaceBytes, [&]() {
+		for (size_t offset = 0; offset < surfaceBytes; offset += sizeof(LWO_CHUNK_HEADER_RAW)) {
+			SurfaceSubChunkTag tag = legacyConvertSurfaceTagStringToEnum(CONVERT_BYTES_TO_STRING(surfaceHeaders.data() + offset, 4));
+			keepResult(tag);
+		}
+	});
+
+	runBenchmark("SurfaceSubChunk/FourCC", NUM_TAGS, surfaceBytes, [&]() {
+		for (size_t offset = 0; offset < surfaceBytes; offset += sizeof(LWO_CHUNK_HEADER_RAW)) {
+			SurfaceSubChunkTag tag = LWUtils::convertSurfaceTagToEnum(CONVERT_BYTES_TO_FOURCC(surfaceHeaders.data() + offset));
+			keepResult(tag);
+		}
+	});
+}
@@ -0,0 +1,177 @@
+//
+// LightWave Object generator
+//
+// Writes synthetic objects of any size for benchmarks, soak tests and
+// regression corpora. The same seed and options always give the same file.
+//
+// Usage: LWObjectGenerator [options] output.lwo
+//
+//   --seed N             Seed (1)
+//   --lwo3               Write an LWO3 object instead of LWO2
+//   --layers N           Layers (1)
+//   --points N           Points per layer (100000)
+//   --polygons N         Polygons per layer (100000)
+//   --mix T,Q,N          Relative weights of triangles, quads and n-gons (1,2,0)
+//   --ngon MIN,MAX       N-gon vertex counts (5,16)
+//   --wide-indices       Write every VX index in its 4 byte form
+//   --surfaces N         Surfaces, assigned to polygons at random (1)
+//   --uv-maps N          TXUV vertex maps per layer (1)
+//   --weight-maps N      WGHT vertex maps per layer (0)
+//
+// Uses only the standard library, so on Linux it builds from this file and
+// ObjectGenerator.cpp with -std=c++17.
+//
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+
+#include "ObjectGenerator.h"
+
+using namespace std;
+
+namespace {
+
+	const double MB = 1024.0 * 1024.0;
+
+	/// <summary>
+	/// Print usage
+	/// </summary>
+	void printUsage() {
+		cerr << "Usage: LWObjectGenerator [--seed N] [--lwo3] [--layers N] [--points N] [--polygons N]" << endl
+			<< "                         [--mix T,Q,N] [--ngon MIN,MAX] [--wide-indices] [--surfaces N]" << endl
+			<< "                         [--uv-maps N] [--weight-maps N] output.lwo" << endl;
+	}
+
+	/// <summary>
+	/// Parse an unsigned number
+	/// </summary>
+	/// <param name="text">Decimal text</param>
+	/// <param name="value">Parsed value</param>
+	/// <returns>True if the whole text was a number</returns>
+	bool parseNumber(const char* text, uint64_t& value) {
+		char* end;
+		value = strtoull(text, &end, 10);
+		return *text != 0 && *text != '-' && *end == 0;
+	}
+
+	/// <summary>
+	/// Parse a comma-separated list of unsigned numbers
+	/// </summary>
+	/// <param name="text">List text</param>
+	/// <param name="values">Parsed values</param>
+	/// <param name="count">Number of values expected</param>
+	/// <returns>True if the text held exactly count numbers</returns>
+	bool parseList(const char* text, unsigned* values[], int count) {
+		for (int index = 0; index < count; index++) {
+			char* end;
+			if (*text < '0' || *text > '9') return false;
+			*values[index] = unsigned(strtoul(text, &end, 10));
+			if (*end != (index + 1 < count ? ',' : 0)) return false;
+			text = end + 1;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Parse the command line
+	/// </summary>
+	/// <param name="argc">Argument count</param>
+	/// <param name="argv">Arguments</param>
+	/// <param name="options">Object options</param>
+	/// <param name="pathname">Output pathname</param>
+	/// <returns>False if the command line is invalid</returns>
+	bool parseArguments(int argc, char* argv[], ObjectGenerator::OPTIONS& options, string& pathname) {
+
+		for (int argIndex = 1; argIndex < argc; argIndex++) {
+			string arg = argv[argIndex];
+			const char* value = argIndex + 1 < argc ? argv[argIndex + 1] : nullptr;
+			uint64_t number = 0;
+
+			// Flags
+			if (arg == "--lwo3") {
+				options.format = ObjectGenerator::Format::LWO3;
+				continue;
+			}
+			if (arg == "--wide-indices") {
+				options.wideIndices = true;
+				continue;
+			}
+
+			// Positional output pathname
+			if (arg.size() < 2 || arg[0] != '-') {
+				if (!pathname.empty()) return false;
+				pathname = arg;
+				continue;
+			}
+
+			// Options with a value
+			if (value == nullptr) return false;
+			argIndex++;
+			if (arg == "--mix") {
+				unsigned* weights[] = { &options.triangleWeight, &options.quadWeight, &options.ngonWeight };
+				if (!parseList(value, weights, 3)) return false;
+				continue;
+			}
+			if (arg == "--ngon") {
+				unsigned* sizes[] = { &options.minNgonVertices, &options.maxNgonVertices };
+				if (!parseList(value, sizes, 2)) return false;
+				continue;
+			}
+			if (!parseNumber(value, number)) return false;
+			if (arg == "--seed") options.seed = number;
+			else if (number > 0xffffffff) return false;
+			else if (arg == "--layers") options.numLayers = unsigned(number);
+			else if (arg == "--points") options.numPoints = uint32_t(number);
+			else if (arg == "--polygons") options.numPolygons = uint32_t(number);
+			else if (arg == "--surfaces") options.numSurfaces = unsigned(number);
+			else if (arg == "--uv-maps") options.numUVMaps = unsigned(number);
+			else if (arg == "--weight-maps") options.numWeightMaps = unsigned(number);
+			else return false;
+		}
+
+		return !pathname.empty();
+	}
+
+	/// <summary>
+	/// Convert a message to narrow characters for the console; messages are plain ASCII
+	/// </summary>
+	/// <param name="message">Wide message</param>
+	/// <returns>Narrow message</returns>
+	string narrow(const wstring& message) {
+		string result;
+		result.reserve(message.size());
+		for (wchar_t c : message) {
+			result.push_back(c < 0x80 ? char(c) : '?');
+		}
+		return result;
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	ObjectGenerator::OPTIONS options;
+	string pathname;
+	if (!parseArguments(argc, argv, options, pathname)) {
+		printUsage();
+		return 2;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	ObjectGenerator generator(options);
+	wstring errorReason;
+	if (!generator.WriteFile(pathname, errorReason)) {
+		cerr << pathname << ": " << narrow(errorReason) << endl;
+		return 1;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	const ObjectGenerator::SUMMARY& summary = generator.GetSummary();
+	cout << fixed << setprecision(2)
+		<< pathname << ": " << summary.bytes / MB << " MB, "
+		<< summary.points << " points, " << summary.polygons << " polygons, "
+		<< summary.polygonVertices << " polygon vertices in " << seconds << " s" << endl;
+
+	return 0;
+}
@@ -0,0 +1,452 @@
+//
+// ObjectGenerator class
+//
+// Writes synthetic LightWave objects for benchmarks, soak tests and
+// regression corpora. Every byte comes from a seeded generator with fixed
+// integer arithmetic, so a seed and a set of options always give the same
+// file on every platform.
+//
+// Objects are streamed: chunk payloads go through a fixed buffer and each
+// chunk's length is patched in when the chunk ends, so files of several GB
+// never need to be held in memory. An IFF FORM is limited to 4 GB.
+//
+// Layout, in the order LightWave writes it:
+//   TAGS                      surface names
+//   per layer: LAYR, PNTS, BBOX, VMAP..., POLS, PTAG (SURF)
+//   SURF...                   one per surface
+//
+// LWO3 objects use the same chunk layout as LWO2, with LWO3 in the FORM
+// header; that's the layout the LightWaveObject parser reads for both.
+//
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "ObjectGenerator.h"
+
+using namespace std;
+
+namespace {
+
+	// Largest vertex count a polygon record can hold
+	const unsigned MAX_POLYGON_VERTICES = 1023;
+
+	// Largest payload an IFF chunk length can describe
+	const uint64_t MAX_CHUNK_LENGTH = 0xffffffffull;
+
+	// Points a polygon's first vertex may stray from its place in the point list
+	const uint32_t POLYGON_JITTER = 32;
+
+	/// <summary>
+	/// SplitMix64 generator; fixed arithmetic keeps output identical on every platform
+	/// </summary>
+	class Random {
+	public:
+		explicit Random(uint64_t seed) : _state { seed } { }
+
+		uint64_t next() {
+			uint64_t value = (_state += 0x9E3779B97F4A7C15ull);
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		// Value in [0, limit)
+		uint32_t nextBelow(uint32_t limit) {
+			return uint32_t(((next() >> 32) * limit) >> 32);
+		}
+
+		// Value in [0, 1)
+		float nextFloat() {
+			return float(next() >> 40) * (1.0f / 16777216.0f);
+		}
+
+	private:
+		uint64_t _state;
+	};
+
+	/// <summary>
+	/// Buffered big-endian writer that patches chunk lengths in place
+	/// </summary>
+	class ChunkWriter {
+	public:
+
+		explicit ChunkWriter(ostream& stream) : _stream { stream }, _buffer(BUFFER_SIZE) {
+			_base = _stream.tellp();
+		}
+
+		// Bytes written so far
+		uint64_t position() const {
+			return _flushed + _used;
+		}
+
+		void put(const void* data, size_t length) {
+			if (_used + length > _buffer.size()) flush();
+			if (length > _buffer.size()) {
+				_stream.write((const char*)data, length);
+				_flushed += length;
+				return;
+			}
+			memcpy(_buffer.data() + _used, data, length);
+			_used += length;
+		}
+
+		void putU2(uint32_t value) {
+			char bytes[2] = { char(value >> 8), char(value) };
+			put(bytes, sizeof(bytes));
+		}
+
+		void putU4(uint32_t value) {
+			char bytes[4] = { char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+			put(bytes, sizeof(bytes));
+		}
+
+		void putF4(float value) {
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			putU4(bits);
+		}
+
+		void putId(const char id[]) {
+			put(id, 4);
+		}
+
+		// Variable-length index, in its 4 byte form when wide or too large for 2 bytes
+		void putVx(uint32_t index, bool wide) {
+			if (wide || index >= 0xff00) putU4(index | 0xff000000);
+			else putU2(index);
+		}
+
+		// Zero-terminated string padded to an even length
+		void putString(const string& text) {
+			put(text.c_str(), text.size() + 1);
+			if (text.size() % 2 == 0) put("", 1);
+		}
+
+		// Start a chunk; returns its offset for endChunk
+		uint64_t beginChunk(const char tag[]) {
+			uint64_t offset = position();
+			putId(tag);
+			putU4(0);
+			return offset;
+		}
+
+		// Pad the chunk to an even length and fill in its length
+		bool endChunk(uint64_t offset) {
+
+			uint64_t length = position() - offset - 8;
+			if (length > MAX_CHUNK_LENGTH) return false;
+			if (length % 2) put("", 1);
+
+			char bytes[4] = { char(length >> 24), char(length >> 16), char(length >> 8), char(length) };
+			if (offset >= _flushed) {
+
+				// Header is still in the buffer
+				memcpy(_buffer.data() + (offset - _flushed) + 4, bytes, sizeof(bytes));
+			}
+			else {
+
+				// Header has been written out, so seek back to it
+				flush();
+				_stream.seekp(_base + streamoff(offset + 4));
+				_stream.write(bytes, sizeof(bytes));
+				_stream.seekp(_base + streamoff(_flushed));
+			}
+
+			return bool(_stream);
+		}
+
+		bool flush() {
+			_stream.write(_buffer.data(), _used);
+			_flushed += _used;
+			_used = 0;
+			return bool(_stream);
+		}
+
+	private:
+		static const size_t BUFFER_SIZE = 1024 * 1024;
+
+		ostream& _stream;
+		streampos _base;			// Stream position of the first byte
+		vector<char> _buffer;
+		size_t _used {};
+		uint64_t _flushed {};		// Bytes already handed to the stream
+	};
+
+	/// <summary>
+	/// Make a numbered name
+	/// </summary>
+	/// <param name="prefix">Name prefix</param>
+	/// <param name="number">Number</param>
+	/// <returns>Name such as Surface_001</returns>
+	string makeName(const char* prefix, unsigned number) {
+		char name[64];
+		snprintf(name, sizeof(name), "%s_%03u", prefix, number);
+		return name;
+	}
+
+	/// <summary>
+	/// Get the seed for one part of the object, so each part's data doesn't depend on the others
+	/// </summary>
+	/// <param name="seed">Object seed</param>
+	/// <param name="layerIndex">Layer</param>
+	/// <param name="part">Part within the layer</param>
+	/// <returns>Seed for the part</returns>
+	uint64_t partSeed(uint64_t seed, unsigned layerIndex, unsigned part) {
+		Random random(seed ^ (uint64_t(layerIndex) << 32 | part));
+		return random.next();
+	}
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="options">Shape of the object</param>
+ObjectGenerator::ObjectGenerator(const OPTIONS& options) : _options { options } {
+}
+
+/// <summary>
+/// Get what the last write produced
+/// </summary>
+/// <returns>Counts of what was written</returns>
+const ObjectGenerator::SUMMARY& ObjectGenerator::GetSummary() {
+	return _summary;
+}
+
+/// <summary>
+/// Check that options describe an object that can be written
+/// </summary>
+/// <param name="options">Shape of the object</param>
+/// <param name="errorReason">Reason the options are invalid</param>
+/// <returns>True if the options are valid</returns>
+bool ObjectGenerator::ValidateOptions(const OPTIONS& options, wstring& errorReason) {
+
+	if (options.numLayers == 0 || options.numLayers > 0xffff) {
+		errorReason = L"The layer count must be from 1 to 65535";
+		return false;
+	}
+	if (options.numPoints < 3) {
+		errorReason = L"Each layer needs at least three points";
+		return false;
+	}
+	if (options.numPoints > 0xffffff) {
+		errorReason = L"Point indices are limited to 24 bits";
+		return false;
+	}
+	if (options.numPolygons > 0xffffff) {
+		errorReason = L"Polygon indices are limited to 24 bits";
+		return false;
+	}
+	if (options.triangleWeight + options.quadWeight + options.ngonWeight == 0) {
+		errorReason = L"At least one polygon size must have a weight";
+		return false;
+	}
+	if (options.ngonWeight > 0 && (options.minNgonVertices < 3 || options.minNgonVertices > options.maxNgonVertices || options.maxNgonVertices > MAX_POLYGON_VERTICES)) {
+		errorReason = L"N-gon sizes must be from 3 to 1023 vertices";
+		return false;
+	}
+	if (options.numSurfaces == 0 || options.numSurfaces > 0xffff) {
+		errorReason = L"The surface count must be from 1 to 65535";
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Write the object to a file
+/// </summary>
+/// <param name="pathname">Output pathname</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>True if the whole object was written; a partial file is removed</returns>
+bool ObjectGenerator::WriteFile(const string& pathname, wstring& errorReason) {
+
+	bool written;
+	{
+		ofstream file(pathname, ios::binary | ios::trunc);
+		if (!file) {
+			errorReason = L"The file could not be created";
+			return false;
+		}
+		written = Write(file, errorReason);
+		file.close();
+		if (written && !file) {
+			errorReason = L"The file could not be written";
+			written = false;
+		}
+	}
+
+	if (!written) remove(pathname.c_str());
+
+	return written;
+}
+
+/// <summary>
+/// Write the object to a stream
+/// </summary>
+/// <param name="stream">Seekable output stream</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>True if the whole object was written</returns>
+bool ObjectGenerator::Write(ostream& stream, wstring& errorReason) {
+
+	_summary = SUMMARY {};
+	if (!ValidateOptions(_options, errorReason)) return false;
+
+	ChunkWriter writer(stream);
+	const OPTIONS& options = _options;
+	bool fits = true;
+
+	// File header
+	uint64_t form = writer.beginChunk("FORM");
+	writer.putId(options.format == Format::LWO3 ? "LWO3" : "LWO2");
+
+	// Surface names
+	uint64_t chunk = writer.beginChunk("TAGS");
+	for (unsigned surfaceIndex = 0; surfaceIndex < options.numSurfaces; surfaceIndex++) {
+		writer.putString(makeName("Surface", surfaceIndex));
+	}
+	fits &= writer.endChunk(chunk);
+
+	unsigned totalWeight = options.triangleWeight + options.quadWeight + options.ngonWeight;
+	uint32_t numPoints = options.numPoints;
+
+	for (unsigned layerIndex = 0; layerIndex < options.numLayers && fits; layerIndex++) {
+
+		// Layer number, flags, pivot and name
+		chunk = writer.beginChunk("LAYR");
+		writer.putU2(layerIndex);
+		writer.putU2(0);
+		for (int axis = 0; axis < 3; axis++) writer.putF4(0.0f);
+		writer.putString(makeName("Layer", layerIndex + 1));
+		fits &= writer.endChunk(chunk);
+
+		// Points, tracking their bounds
+		Random random(partSeed(options.seed, layerIndex, 0));
+		float bounds[6] = { options.extent, options.extent, options.extent, -options.extent, -options.extent, -options.extent };
+		chunk = writer.beginChunk("PNTS");
+		for (uint32_t pointIndex = 0; pointIndex < numPoints; pointIndex++) {
+			for (int axis = 0; axis < 3; axis++) {
+				float value = (random.nextFloat() - 0.5f) * options.extent;
+				if (value < bounds[axis]) bounds[axis] = value;
+				if (value > bounds[axis + 3]) bounds[axis + 3] = value;
+				writer.putF4(value);
+			}
+		}
+		fits &= writer.endChunk(chunk);
+
+		chunk = writer.beginChunk("BBOX");
+		for (float bound : bounds) writer.putF4(bound);
+		fits &= writer.endChunk(chunk);
+
+		// Vertex maps covering every point
+		for (unsigned mapIndex = 0; mapIndex < options.numUVMaps + options.numWeightMaps && fits; mapIndex++) {
+			bool isUV = mapIndex < options.numUVMaps;
+			unsigned dimension = isUV ? 2 : 1;
+			random = Random(partSeed(options.seed, layerIndex, 1 + mapIndex));
+
+			chunk = writer.beginChunk("VMAP");
+			writer.putId(isUV ? "TXUV" : "WGHT");
+			writer.putU2(dimension);
+			writer.putString(isUV ? makeName("UV", mapIndex) : makeName("Weight", mapIndex - options.numUVMaps));
+			for (uint32_t pointIndex = 0; pointIndex < numPoints; pointIndex++) {
+				writer.putVx(pointIndex, options.wideIndices);
+				for (unsigned component = 0; component < dimension; component++) {
+					writer.putF4(random.nextFloat());
+				}
+			}
+			fits &= writer.endChunk(chunk);
+		}
+
+		// Polygons; each walks the point list from about its share of it, so
+		// neighboring polygons share points as in a real mesh
+		random = Random(partSeed(options.seed, layerIndex, 0x10000));
+		chunk = writer.beginChunk("POLS");
+		writer.putId("FACE");
+		for (uint32_t polygonIndex = 0; polygonIndex < options.numPolygons; polygonIndex++) {
+
+			// Pick the polygon size
+			unsigned numVertices;
+			uint32_t pick = random.nextBelow(totalWeight);
+			if (pick < options.triangleWeight) {
+				numVertices = 3;
+			}
+			else if (pick < options.triangleWeight + options.quadWeight) {
+				numVertices = 4;
+			}
+			else {
+				numVertices = options.minNgonVertices + random.nextBelow(options.maxNgonVertices - options.minNgonVertices + 1);
+			}
+			if (numVertices > numPoints) numVertices = numPoints;
+
+			uint32_t first = uint32_t((uint64_t(polygonIndex) * numPoints / options.numPolygons + random.nextBelow(POLYGON_JITTER)) % numPoints);
+			writer.putU2(numVertices);
+			for (unsigned vertex = 0; vertex < numVertices; vertex++) {
+				writer.putVx((first + vertex) % numPoints, options.wideIndices);
+			}
+			_summary.polygonVertices += numVertices;
+		}
+		fits &= writer.endChunk(chunk);
+
+		// Surface of each polygon
+		random = Random(partSeed(options.seed, layerIndex, 0x10001));
+		chunk = writer.beginChunk("PTAG");
+		writer.putId("SURF");
+		for (uint32_t polygonIndex = 0; polygonIndex < options.numPolygons; polygonIndex++) {
+			writer.putVx(polygonIndex, options.wideIndices);
+			writer.putU2(random.nextBelow(options.numSurfaces));
+		}
+		fits &= writer.endChunk(chunk);
+
+		_summary.points += numPoints;
+		_summary.polygons += options.numPolygons;
+
+		// Stop as soon as the object can't fit
+		if (writer.position() - form - 8 > MAX_CHUNK_LENGTH) fits = false;
+	}
+
+	// Surfaces, each with its own color
+	Random random(partSeed(options.seed, 0xffffffff, 0));
+	for (unsigned surfaceIndex = 0; surfaceIndex < options.numSurfaces && fits; surfaceIndex++) {
+		chunk = writer.beginChunk("SURF");
+		writer.putString(makeName("Surface", surfaceIndex));
+		writer.putString("");
+
+		writer.putId("COLR");
+		writer.putU2(14);
+		for (int channel = 0; channel < 3; channel++) writer.putF4(random.nextFloat());
+		writer.putVx(0, false);
+
+		writer.putId("DIFF");
+		writer.putU2(6);
+		writer.putF4(1.0f);
+		writer.putVx(0, false);
+
+		writer.putId("SPEC");
+		writer.putU2(6);
+		writer.putF4(random.nextFloat());
+		writer.putVx(0, false);
+
+		fits &= writer.endChunk(chunk);
+	}
+
+	// A chunk or the object outgrew its 4 byte length
+	if (!fits || !writer.endChunk(form)) {
+		if (stream) {
+			errorReason = L"The object is larger than the 4 GB an IFF FORM can hold";
+		}
+		else {
+			errorReason = L"The object could not be written";
+		}
+		return false;
+	}
+
+	if (!writer.flush()) {
+		errorReason = L"The object could not be written";
+		return false;
+	}
+
+	_summary.bytes = writer.position();
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <ostream>
+#include <stdint.h>
+#include <string>
+
+class ObjectGenerator {
+public:
+
+	// Object file type written in the FORM header
+	enum class Format { LWO2, LWO3 };
+
+	// Shape of the generated object. Counts are per layer.
+	struct OPTIONS {
+		uint64_t seed = 1;					// Same seed and options give the same bytes
+		Format format = Format::LWO2;
+		unsigned numLayers = 1;
+		uint32_t numPoints = 100000;
+		uint32_t numPolygons = 100000;
+		unsigned triangleWeight = 1;		// Relative share of triangles, quads and n-gons
+		unsigned quadWeight = 2;
+		unsigned ngonWeight = 0;
+		unsigned minNgonVertices = 5;
+		unsigned maxNgonVertices = 16;		// At most 1023
+		bool wideIndices = false;			// Write every VX index in its 4 byte form
+		unsigned numSurfaces = 1;			// Assigned to polygons through PTAG
+		unsigned numUVMaps = 1;				// TXUV vertex maps
+		unsigned numWeightMaps = 0;			// WGHT vertex maps
+		float extent = 100.0f;				// Points lie in a cube this wide around the origin
+	};
+
+	// What was written
+	struct SUMMARY {
+		uint64_t bytes = 0;
+		uint64_t points = 0;
+		uint64_t polygons = 0;
+		uint64_t polygonVertices = 0;
+	};
+
+	// Constructor
+	explicit ObjectGenerator(const OPTIONS& options);
+
+	// Getters
+	const SUMMARY& GetSummary();
+
+	// Public methods
+	bool Write(std::ostream& stream, std::wstring& errorReason);
+	bool WriteFile(const std::string& pathname, std::wstring& errorReason);
+
+	// Static methods
+	static bool ValidateOptions(const OPTIONS& options, std::wstring& errorReason);
+
+private:
+
+	// Private data
+	OPTIONS _options;
+	SUMMARY _summary;
+};
@@ -39,17 +39,37 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
 	HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_LWOBJECTVIEWER));
 
+	// Record a timeline of loads and frames if LWO_TRACE names a trace file
+	TraceRecorder& traceRecorder = TraceRecorder::getShared();
+	std::string tracePathname;
+	traceRecorder.setThreadName("Main");
+	bool tracing = traceRecorder.startFromEnvironment(tracePathname);
+
 	// Initialize renderer
 	if (!renderer.Initialize(_renderWindow, RENDER_WINDOW_WIDTH, RENDER_WINDOW_HEIGHT)) return 0;
 
-	// Load object if specified on command line
-	if (lstrcmpi(lpCmdLine, L"") != 0) {
-		if (!LoadObject(lpCmdLine)) {
+	// Objects load on a loader thread, which reports back through window messages.
+	// Progress is only posted when the percentage changes, so it can't flood the queue.
+	std::atomic<int> lastProgress { -1 };
+	renderer.SetLoadCallbacks(
+		[&lastProgress](uint64_t loadId, LoadPhase phase, double fraction) {
+			int percent = int(fraction * 100.0);
+			int progress = int(phase) * 101 + percent;
+			if (lastProgress.exchange(progress) != progress) {
+				PostMessage(_mainWindow, WM_LOAD_PROGRESS, MAKEWPARAM(percent, int(phase)), (LPARAM)loadId);
+			}
+		},
+		[](const ObjectLoader::LOAD_RESULT& result) {
+			ObjectLoader::LOAD_RESULT* message = new ObjectLoader::LOAD_RESULT(result);
+			if (!PostMessage(_mainWindow, WM_LOAD_COMPLETE, 0, (LPARAM)message)) {
+				delete message;
+			}
+		});
 
-			// If not loaded correctly from the command line 
-			// then quit immediately
-			PostQuitMessage(0);
-		}
+	// Load object if specified on command line; if it can't
+	// be loaded, the completion handler quits
+	if (lstrcmpi(lpCmdLine, L"") != 0) {
+		_commandLineLoadId = LoadObject(lpCmdLine);
 	}
 
 	// Peek at initial message in queue
@@ -73,8 +93,12 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 		}
 		else {
 
+			// Show a progressive load as its batches arrive
+			if (renderer.UpdateStreamedMesh()) _objectLoaded = true;
+
 			// No message, so process the scene if an object is loaded
 			if (_objectLoaded) {
+				TraceScope frameTrace("Frame");
 
 				// Update scene
 				renderer.Update();
@@ -88,6 +112,15 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 		}
 	}
 
+	// Write the timeline
+	if (tracing) {
+		traceRecorder.stop();
+		std::wstring errorReason;
+		if (!traceRecorder.writeFile(tracePathname, errorReason)) {
+			PrintMessage(L"%s: %hs\n", errorReason.c_str(), tracePathname.c_str());
+		}
+	}
+
 	return (int)msg.wParam;
 }
 
@@ -167,6 +200,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow) {
 //  PURPOSE: Processes messages for the main window.
 //
 //  WM_COMMAND  - process the application menu
+//  WM_CHAR     - show or hide layers
 //  WM_PAINT    - Paint the main window
 //  WM_DESTROY  - post a quit message and return
 //
@@ -196,6 +230,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 		case WM_DROPFILES:
 			HandleDroppedFile((HDROP)wParam);
 			break;
+		case WM_CHAR:
+			HandleLayerKey((WCHAR)wParam);
+			break;
+		case WM_LOAD_PROGRESS:
+			HandleLoadProgress((uint64_t)lParam, (LoadPhase)HIWORD(wParam), LOWORD(wParam));
+			break;
+		case WM_LOAD_COMPLETE:
+			HandleLoadComplete((ObjectLoader::LOAD_RESULT*)lParam);
+			break;
 		case WM_LBUTTONDOWN:
 			HandleMouseDragging(hWnd, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 			break;
@@ -366,6 +409,78 @@ void HandleDroppedFile(HDROP dropInfo) {
 	}
 }
 
+/// <summary>
+/// Show or hide a layer of the object with the number keys, 1 for the first layer
+/// </summary>
+/// <param name="key">Character typed</param>
+void HandleLayerKey(WCHAR key) {
+	if (key < L'1' || key > L'9') return;
+	int layerIndex = key - L'1';
+	renderer.SetLayerVisible(layerIndex, !renderer.GetLayerVisible(layerIndex));
+}
+
+/// <summary>
+/// Handle the end of a background load
+/// </summary>
+/// <param name="result">How the load ended, posted by the loader thread and deleted here</param>
+void HandleLoadComplete(ObjectLoader::LOAD_RESULT* result) {
+
+	std::unique_ptr<ObjectLoader::LOAD_RESULT> loadResult(result);
+
+	// Ignore loads that a newer drop replaced
+	if (loadResult->loadId != _latestLoadId) return;
+	SetWindowText(_mainWindow, szTitle);
+	if (loadResult->cancelled) return;
+
+	// Swap the new mesh in, or keep showing the old one
+	wstring errorReason = loadResult->errorReason;
+	if (!loadResult->loaded || !renderer.UpdateMesh(errorReason)) {
+
+		// The old buffers are gone if the new ones couldn't be created,
+		// and the old object if part of the new one streamed in
+		if (renderer.DiscardStreamedMesh() || loadResult->loaded) _objectLoaded = false;
+
+		// Error loading the object
+		MessageBox(_mainWindow, errorReason.c_str(), L"Couldn't Load the Object", MB_ICONERROR | MB_OK);
+
+		// If not loaded correctly from the command line
+		// then quit immediately
+		if (loadResult->loadId == _commandLineLoadId) {
+			PostQuitMessage(0);
+		}
+		return;
+	}
+
+	// Object loaded
+	_objectLoaded = true;
+
+	// Set object info
+	_objectInfo = renderer.GetObjectInfo();
+	SetFieldValue(_infoVertices, _objectInfo.numVertices);
+	SetFieldValue(_infoTriangles, _objectInfo.numTriangles);
+	SetFieldValue(_infoNonTriangles, _objectInfo.numNonTriangles);
+	SetFieldValue(_infoLayers, _objectInfo.numLayers);
+
+	// Where the load spent its time
+	PrintMessage(L"%hs", renderer.GetLoadStatistics().getReport().c_str());
+}
+
+/// <summary>
+/// Show how far the latest load has got in the title bar
+/// </summary>
+/// <param name="loadId">Load reporting progress</param>
+/// <param name="phase">Phase in progress</param>
+/// <param name="percent">Share of the phase done</param>
+void HandleLoadProgress(uint64_t loadId, LoadPhase phase, int percent) {
+
+	// Loads that a newer drop replaced may still report
+	if (loadId != _latestLoadId) return;
+
+	wchar_t title[MAX_LOADSTRING * 2];
+	swprintf_s(title, L"%s - %hs %d%%", szTitle, LOAD_STATISTICS::getPhaseName(phase), percent);
+	SetWindowText(_mainWindow, title);
+}
+
 /// <summary>
 /// Handle mouse dragging on render window
 /// </summary>
@@ -416,10 +531,11 @@ void HandleMouseWheel(short wheelDelta) {
 }
 
 /// <summary>
-/// Load object using filename
+/// Start loading an object using filename, replacing any load in progress
 /// </summary>
 /// <param name="pathname">Path and filename of object</param>
-bool LoadObject(LPWSTR pathname) {
+/// <returns>Identifier of the load</returns>
+uint64_t LoadObject(LPWSTR pathname) {
 
 	// Convert pathname
 	int numChars = lstrlen(pathname);
@@ -432,28 +548,11 @@ bool LoadObject(LPWSTR pathname) {
 		objectPathname = objectPathname.substr(1, numChars - 2);
 	}
 
-	// Load the object file
-	wstring errorReason;
-	if (renderer.LoadObject(objectPathname, errorReason)) {
-
-		// Object loaded
-		_objectLoaded = true;
+	// Load the object file in the background; the current object keeps
+	// rendering until the new one streams in or HandleLoadComplete swaps it in
+	_latestLoadId = renderer.LoadObject(objectPathname);
 
-		// Set object info
-		_objectInfo = renderer.GetObjectInfo();
-		SetFieldValue(_infoVertices, _objectInfo.numVertices);
-		SetFieldValue(_infoTriangles, _objectInfo.numTriangles);
-		SetFieldValue(_infoNonTriangles, _objectInfo.numNonTriangles);
-		SetFieldValue(_infoLayers, _objectInfo.numLayers);
-
-		return true;
-	}
-	else {
-
-		// Error loeading the object
-		MessageBox(_mainWindow, errorReason.c_str(), L"Couldn't Load the Object", MB_ICONERROR | MB_OK);
-		return false;
-	}
+	return _latestLoadId;
 }
 
 /// <summary>
@@ -14,6 +14,9 @@ INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
 
 // Event handlers
 void	HandleDroppedFile(HDROP dropInfo);
+void	HandleLayerKey(WCHAR key);
+void	HandleLoadComplete(ObjectLoader::LOAD_RESULT* result);
+void	HandleLoadProgress(uint64_t loadId, LoadPhase phase, int percent);
 void	HandleMouseDragging(HWND hwnd, long x, long y);
 void	HandleMouseWheel(short wheelDelta);
 
@@ -23,7 +26,7 @@ HWND	CreateField(HWND parent, int x, int y, LPCWSTR labelText);
 void	SetFieldValue(HWND field, int value);
 
 // Methods
-bool	LoadObject(LPWSTR pathname);
+uint64_t	LoadObject(LPWSTR pathname);
 
 // Debug functions
 void	PrintMessage(const wchar_t* format, ...);
@@ -38,6 +41,8 @@ Renderer::ObjectInfo _objectInfo;
 
 // States
 bool _objectLoaded = false;
+uint64_t _latestLoadId = 0;				// Only the latest load is reported
+uint64_t _commandLineLoadId = 0;		// Load of the object named on the command line
 bool _isDragging = false;
 bool _tumbling = true;
 POINT _dragOrigin;
@@ -46,4 +51,8 @@ POINT _dragOrigin;
 Renderer renderer;
 
 // Control IDs
-#define IDC_RESET_OBJECT WM_USER + 1
\ No newline at end of file
+#define IDC_RESET_OBJECT WM_USER + 1
+
+// Messages posted by the loader thread
+#define WM_LOAD_PROGRESS WM_APP + 1
+#define WM_LOAD_COMPLETE WM_APP + 2
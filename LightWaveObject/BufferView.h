@@ -0,0 +1,51 @@
+//
+// BufferView class
+//
+// Non-owning, bounds-carrying view over a range of raw object file bytes.
+// The underlying memory belongs to an ObjectInput (or the caller) and must
+// outlive the view.
+//
+#pragma once
+#include <assert.h>
+#include <stddef.h>
+
+class BufferView {
+public:
+
+	// Constructors
+	BufferView() { }
+	BufferView(const char* data, size_t length) : _data { data }, _length { length } { }
+
+	// Getters
+	const char* data(size_t offset = 0) const { assert(offset <= _length); return _data + offset; }
+	size_t size() const { return _length; }
+	bool empty() const { return _length == 0; }
+
+	/// <summary>
+	/// Check whether a range lies entirely within the view
+	/// </summary>
+	/// <param name="offset">Start of range</param>
+	/// <param name="count">Number of bytes in range</param>
+	/// <returns>True if the range is readable</returns>
+	bool contains(size_t offset, size_t count) const {
+		return offset <= _length && count <= _length - offset;
+	}
+
+	/// <summary>
+	/// Get a narrower view, clamped to the bounds of this view
+	/// </summary>
+	/// <param name="offset">Start of the sub-view</param>
+	/// <param name="count">Requested number of bytes</param>
+	/// <returns>Sub-view</returns>
+	BufferView subview(size_t offset, size_t count) const {
+		if (offset > _length) offset = _length;
+		if (count > _length - offset) count = _length - offset;
+		return BufferView(_data + offset, count);
+	}
+
+private:
+
+	// Private data
+	const char* _data {};
+	size_t _length {};
+};
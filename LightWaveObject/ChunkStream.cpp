@@ -0,0 +1,216 @@
+//
+// ChunkStream class
+//
+// Generates the chunks of an object file one at a time through a fixed-size
+// sliding window, so that peak memory is set by the window size rather than
+// the file size. Chunks that fit in the window can be read whole; larger
+// payloads are consumed in pieces using peekPayload() and consumePayload().
+//
+#include <algorithm>
+#include <cstring>
+
+#include "ChunkStream.h"
+#include "LWUtils.h"
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="windowSize">Size of the sliding window in bytes</param>
+ChunkStream::ChunkStream(size_t windowSize) {
+
+	// The window must at least hold a file or chunk header
+	_windowSize = max(windowSize, sizeof(LWO_FILE_HEADER_RAW));
+	_window = unique_ptr<char[]>(new char[_windowSize]);
+}
+
+/// <summary>
+/// Open an object file and read its header
+/// </summary>
+/// <param name="filename">Object filename to stream</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>Open success</returns>
+bool ChunkStream::open(const string& filename, wstring& errorReason) {
+
+	// Open the file
+	_file.open(filename, ios::binary);
+	if (!_file.is_open()) {
+		errorReason = L"Couldn't read the file";
+		return false;
+	}
+
+	// Read the file header
+	_formRemaining = sizeof(LWO_FILE_HEADER_RAW);
+	if (fill(sizeof(LWO_FILE_HEADER_RAW)) < sizeof(LWO_FILE_HEADER_RAW)) {
+		errorReason = L"File is not a valid LightWave object file";
+		return false;
+	}
+	_fileHeader = LWUtils::parseFileHeader(_window.get() + _begin);
+	_begin += sizeof(LWO_FILE_HEADER_RAW);
+
+	// The FORM length counts the ID but not the FORM tag and length fields
+	_formRemaining = _fileHeader.fileLength >= 4 ? _fileHeader.fileLength - 4 : 0;
+
+	return true;
+}
+
+/// <summary>
+/// Advance to the next chunk, skipping anything left of the current one
+/// </summary>
+/// <param name="header">Header of the next chunk</param>
+/// <returns>False when there are no more chunks</returns>
+bool ChunkStream::next(LWO_CHUNK_HEADER& header) {
+
+	// Discard the rest of the current chunk
+	skipChunk();
+
+	// Read the next chunk header
+	const size_t CHUNK_HEADER_SIZE = sizeof(LWO_CHUNK_HEADER_RAW);
+	if (fill(CHUNK_HEADER_SIZE) < CHUNK_HEADER_SIZE) {
+		return false;
+	}
+	header = LWUtils::parseChunkHeader(_window.get() + _begin);
+
+	// Header stays in the window until the chunk is read
+	_headerPending = true;
+	_payloadRemaining = header.length;
+	_padding = header.length % 2;
+
+	return true;
+}
+
+/// <summary>
+/// Read the whole current chunk, including its header
+/// </summary>
+/// <param name="chunkBuffer">View of the chunk, valid until the stream next moves</param>
+/// <returns>False if the chunk doesn't fit in the window or was partly consumed</returns>
+bool ChunkStream::readChunk(BufferView& chunkBuffer) {
+
+	const size_t CHUNK_HEADER_SIZE = sizeof(LWO_CHUNK_HEADER_RAW);
+	size_t chunkSize = CHUNK_HEADER_SIZE + _payloadRemaining;
+
+	// Only untouched chunks that fit can be returned whole
+	if (!_headerPending || chunkSize > _windowSize) {
+		return false;
+	}
+
+	// Buffer the whole chunk; a truncated file yields a short view
+	size_t available = min(fill(chunkSize), chunkSize);
+	chunkBuffer = BufferView(_window.get() + _begin, available);
+
+	// Consume the chunk
+	_begin += available;
+	_headerPending = false;
+	_payloadRemaining -= available - CHUNK_HEADER_SIZE;
+
+	return true;
+}
+
+/// <summary>
+/// Get as much of the current payload as the window holds
+/// </summary>
+/// <returns>View of unconsumed payload bytes, valid until the stream next moves</returns>
+BufferView ChunkStream::peekPayload() {
+
+	// Step past the header
+	if (_headerPending) {
+		_begin += sizeof(LWO_CHUNK_HEADER_RAW);
+		_headerPending = false;
+	}
+
+	// Top up the window
+	size_t available = min(fill(min(_payloadRemaining, _windowSize)), _payloadRemaining);
+
+	return BufferView(_window.get() + _begin, available);
+}
+
+/// <summary>
+/// Mark payload bytes returned by peekPayload() as consumed
+/// </summary>
+/// <param name="length">Number of bytes consumed</param>
+void ChunkStream::consumePayload(size_t length) {
+
+	assert(!_headerPending && length <= _end - _begin && length <= _payloadRemaining);
+
+	_begin += length;
+	_payloadRemaining -= length;
+}
+
+/// <summary>
+/// Get the object file header
+/// </summary>
+/// <returns>Cooked file header</returns>
+const LWO_FILE_HEADER& ChunkStream::getFileHeader() {
+	return _fileHeader;
+}
+
+/// <summary>
+/// Get the number of payload bytes not yet consumed
+/// </summary>
+/// <returns>Remaining payload bytes of the current chunk</returns>
+size_t ChunkStream::getPayloadRemaining() {
+	return _payloadRemaining;
+}
+
+/// <summary>
+/// Get the sliding window size
+/// </summary>
+/// <returns>Window size in bytes</returns>
+size_t ChunkStream::getWindowSize() {
+	return _windowSize;
+}
+
+/// <summary>
+/// Make sure the window holds at least the requested number of bytes
+/// </summary>
+/// <param name="required">Number of bytes required from the front of the window</param>
+/// <returns>Number of bytes buffered, which is short only at the end of the FORM</returns>
+size_t ChunkStream::fill(size_t required) {
+
+	// Already buffered
+	if (_end - _begin >= required) {
+		return _end - _begin;
+	}
+
+	// Slide unconsumed bytes to the front of the window
+	if (_begin > 0) {
+		memmove(_window.get(), _window.get() + _begin, _end - _begin);
+		_end -= _begin;
+		_begin = 0;
+	}
+
+	// Read as much as the window and FORM allow
+	size_t toRead = min(_windowSize - _end, _formRemaining);
+	if (toRead > 0) {
+		_file.read(_window.get() + _end, toRead);
+		size_t bytesRead = (size_t)_file.gcount();
+		_end += bytesRead;
+		_formRemaining = bytesRead < toRead ? 0 : _formRemaining - bytesRead;
+	}
+
+	return _end - _begin;
+}
+
+/// <summary>
+/// Discard whatever is left of the current chunk
+/// </summary>
+void ChunkStream::skipChunk() {
+
+	// Bytes left in the current chunk
+	size_t remaining = _payloadRemaining + _padding;
+	if (_headerPending) remaining += sizeof(LWO_CHUNK_HEADER_RAW);
+	_headerPending = false;
+	_payloadRemaining = 0;
+	_padding = 0;
+
+	// Drop buffered bytes first
+	size_t buffered = min(remaining, _end - _begin);
+	_begin += buffered;
+	remaining -= buffered;
+
+	// Seek past the rest
+	if (remaining > 0) {
+		remaining = min(remaining, _formRemaining);
+		_file.seekg(remaining, ios::cur);
+		_formRemaining -= remaining;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "BufferView.h"
+#include "Chunks/ChunkDefinitions.h"
+
+class ChunkStream {
+public:
+
+	// Default sliding window size
+	static const size_t DEFAULT_WINDOW_SIZE = 4 * 1024 * 1024;
+
+	// Constructor
+	ChunkStream(size_t windowSize = DEFAULT_WINDOW_SIZE);
+
+	// Public methods
+	bool open(const std::string& filename, std::wstring& errorReason);
+	bool next(LWO_CHUNK_HEADER& header);
+	bool readChunk(BufferView& chunkBuffer);
+	BufferView peekPayload();
+	void consumePayload(size_t length);
+
+	// Getters
+	const LWO_FILE_HEADER& getFileHeader();
+	size_t getPayloadRemaining();
+	size_t getWindowSize();
+
+private:
+
+	// Private methods
+	size_t fill(size_t required);
+	void skipChunk();
+
+	// Private data
+	std::ifstream _file;
+	LWO_FILE_HEADER _fileHeader;
+	size_t _formRemaining {};		// Bytes of the FORM not yet read from the file
+
+	// Sliding window
+	std::unique_ptr<char[]> _window;
+	size_t _windowSize;
+	size_t _begin {};				// First unconsumed byte in the window
+	size_t _end {};					// One past the last buffered byte
+
+	// Current chunk
+	bool _headerPending {};			// Header bytes are still at the front of the window
+	size_t _payloadRemaining {};	// Payload bytes not yet consumed
+	size_t _padding {};				// Pad byte following an odd-length payload
+};
@@ -3,5 +3,5 @@
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void BoundingBox::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void BoundingBox::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 }
@@ -3,11 +3,14 @@
 class BoundingBox : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::BBOX;
+
 	// Constructor
-	BoundingBox() : Chunk(ChunkTag::BBOX) { }
+	explicit BoundingBox(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 
 private:
 
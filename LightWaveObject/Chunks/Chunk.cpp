@@ -16,45 +16,68 @@
 #include "VertexMapDiscontinuous.h"
 #include "VertexMapParameter.h"
 
+namespace {
+
+	/// <summary>
+	/// Construct a chunk in memory from a resource
+	/// </summary>
+	/// <param name="memory">Resource for the chunk and everything it holds</param>
+	/// <returns>Chunk owned by a deleter that returns it to the resource</returns>
+	template <typename T>
+	ChunkPtr makeChunk(pmr::memory_resource* memory) {
+		void* storage = memory->allocate(sizeof(T), alignof(T));
+		try {
+			return ChunkPtr(new (storage) T(memory), ChunkDeleter { memory, sizeof(T), alignof(T) });
+		}
+		catch (...) {
+			memory->deallocate(storage, sizeof(T), alignof(T));
+			throw;
+		}
+	}
+}
+
 /// <summary>
 /// Factory method for Chunks
 /// </summary>
 /// <param name="chunkType">Chunk type enum</param>
+/// <param name="memory">Resource for the chunk and everything it holds</param>
 /// <returns>Instantiated chunk object</returns>
-unique_ptr<Chunk> Chunk::create(ChunkTag chunkType) {
+ChunkPtr Chunk::create(ChunkTag chunkType, pmr::memory_resource* memory) {
 
 	// Instantiate chunk
 	switch (chunkType) {
 		case ChunkTag::LAYR:
-			return unique_ptr<Chunk>(new Layer {});
+			return makeChunk<Layer>(memory);
 		case ChunkTag::PNTS:
-			return unique_ptr<Chunk>(new Points {});
+			return makeChunk<Points>(memory);
 		case ChunkTag::VMAP:
-			return unique_ptr<Chunk>(new VertexMap {});
+			return makeChunk<VertexMap>(memory);
 		case ChunkTag::POLS:
-			return unique_ptr<Chunk>(new Polygons {});
+			return makeChunk<Polygons>(memory);
 		case ChunkTag::TAGS:
-			return unique_ptr<Chunk>(new Tags {});
+			return makeChunk<Tags>(memory);
 		case ChunkTag::PTAG:
-			return unique_ptr<Chunk>(new PolygonTags {});
+			return makeChunk<PolygonTags>(memory);
 		case ChunkTag::VMAD:
-			return unique_ptr<Chunk>(new VertexMapDiscontinuous {});
+			return makeChunk<VertexMapDiscontinuous>(memory);
 		case ChunkTag::VMPA:
-			return unique_ptr<Chunk>(new VertexMapParameter {});
+			return makeChunk<VertexMapParameter>(memory);
 		case ChunkTag::ENVL:
-			return unique_ptr<Chunk>(new Envelope {});
+			return makeChunk<Envelope>(memory);
 		case ChunkTag::CLIP:
-			return unique_ptr<Chunk>(new Clip {});
+			return makeChunk<Clip>(memory);
 		case ChunkTag::SURF:
-			return unique_ptr<Chunk>(new Surface {});
+			return makeChunk<Surface>(memory);
 		case ChunkTag::BBOX:
-			return unique_ptr<Chunk>(new BoundingBox {});
+			return makeChunk<BoundingBox>(memory);
 		case ChunkTag::DESC:
-			return unique_ptr<Chunk>(new Description {});
+			return makeChunk<Description>(memory);
 		case ChunkTag::TEXT:
-			return unique_ptr<Chunk>(new Text {});
+			return makeChunk<Text>(memory);
 		case ChunkTag::ICON:
-			return unique_ptr<Chunk>(new Icon {});
+			return makeChunk<Icon>(memory);
+		case ChunkTag::UNKNOWN:
+			break;
 	}
 
 	// Unhandled chunk
@@ -62,6 +85,31 @@ unique_ptr<Chunk> Chunk::create(ChunkTag chunkType) {
 }
 
 
+/// <summary>
+/// Destroy a chunk and free its memory
+/// </summary>
+/// <param name="chunk">Chunk to destroy</param>
+void ChunkDeleter::operator()(Chunk* chunk) const {
+	chunk->~Chunk();
+	memory->deallocate(chunk, size, alignment);
+}
+
+/// <summary>
+/// Get the hash of the chunk payload taken when the chunk was read
+/// </summary>
+/// <returns>ContentHash of the payload, or zero if the payload wasn't hashed</returns>
+uint64_t Chunk::getContentHash() {
+	return _contentHash;
+}
+
+/// <summary>
+/// Get the resource the chunk's arrays and strings are allocated from
+/// </summary>
+/// <returns>Memory resource</returns>
+pmr::memory_resource* Chunk::getMemoryResource() {
+	return _memory;
+}
+
 /// <summary>
 /// Get chunk tag
 /// </summary>
@@ -71,20 +119,19 @@ ChunkTag Chunk::getTag() {
 }
 
 /// <summary>
-/// Read the raw chunk data
+/// Record the hash of the chunk payload
 /// </summary>
-/// <param name="rawBuffer">Raw file buffer</param>
-/// <param name="header">Cooked chunk header</param>
-/// <returns>Raw chunk data buffer</returns>
-unique_ptr<char[]> Chunk::read(char rawBuffer[], LWO_CHUNK_HEADER header) {
+/// <param name="contentHash">ContentHash of the payload</param>
+void Chunk::setContentHash(uint64_t contentHash) {
+	_contentHash = contentHash;
+}
 
-	// Instantiate the chunk buffer
-	unique_ptr<char[]> rawChunkBuffer = unique_ptr<char[]>(new char[header.length]);
-	
-	// Read the raw chunk data from the buffer
-	memcpy(rawBuffer, rawChunkBuffer.get(), header.length);
+/// <summary>
+/// Finish a chunk parsed in pieces, once no more pieces will come
+/// </summary>
+void Chunk::finishPieces() {
 
-	return rawChunkBuffer;
+	// Override in derived chunk classes that hold pieces until they're finished
 }
 
 /// <summary>
@@ -97,9 +144,30 @@ string Chunk::getDescription() {
 /// <summary>
 /// Default parser
 /// </summary>
-/// <param name="rawBuffer"></param>
-/// <param name="header"></param>
-void Chunk::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+/// <param name="chunkBuffer">View of the chunk, including its header</param>
+/// <param name="header">Cooked chunk header</param>
+void Chunk::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 
 	// Override in derived chunk classes
 }
+
+/// <summary>
+/// Default piecewise parser
+/// </summary>
+/// <param name="payloadPiece">Next unconsumed part of the chunk payload</param>
+/// <param name="payloadOffset">Offset of the piece within the payload</param>
+/// <returns>Number of bytes consumed, where zero means pieces aren't supported</returns>
+size_t Chunk::parsePiece(BufferView, size_t) {
+
+	// Override in derived chunk classes that can be streamed
+	return 0;
+}
+
+/// <summary>
+/// Prepare a chunk to be parsed in pieces, before the first piece comes
+/// </summary>
+/// <param name="payloadLength">Length of the whole payload</param>
+void Chunk::startPieces(size_t) {
+
+	// Override in derived chunk classes that can size themselves up front
+}
@@ -1,27 +1,53 @@
 #pragma once
 #include <memory>
+#include <memory_resource>
 
 #include "ChunkDefinitions.h"
+#include "../BufferView.h"
+
+class Chunk;
+
+// Destroys a chunk and returns its memory to the resource it came from
+struct ChunkDeleter {
+	pmr::memory_resource* memory = nullptr;
+	size_t size = 0;
+	size_t alignment = 0;
+
+	void operator()(Chunk* chunk) const;
+};
+
+// Owning pointer to a chunk allocated by Chunk::create
+typedef unique_ptr<Chunk, ChunkDeleter> ChunkPtr;
 
 class Chunk {
 public:
 	// Constructor
-	Chunk(ChunkTag tag = ChunkTag::UNKNOWN) : _tag { tag } { }
+	explicit Chunk(ChunkTag tag = ChunkTag::UNKNOWN, pmr::memory_resource* memory = pmr::get_default_resource()) : _tag { tag }, _memory { memory } { }
+
+	// Destructor
+	virtual ~Chunk() = default;
 
 	// Static factory methods
-	static unique_ptr<Chunk> create(ChunkTag chunkType);
+	static ChunkPtr create(ChunkTag chunkType, pmr::memory_resource* memory = pmr::get_default_resource());
 	
 	// Public methods
+	uint64_t getContentHash();
+	pmr::memory_resource* getMemoryResource();
 	ChunkTag getTag();
-	unique_ptr<char[]> read(char rawBuffer[], LWO_CHUNK_HEADER header);
+	void setContentHash(uint64_t contentHash);
 
 	// Virtual methods
+	virtual void finishPieces();
 	virtual string getDescription();
-	virtual void parse(char rawBuffer[], LWO_CHUNK_HEADER header);
+	virtual void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header);
+	virtual size_t parsePiece(BufferView payloadPiece, size_t payloadOffset);
+	virtual void startPieces(size_t payloadLength);
 
 private:
 
 	// Private data
 	ChunkTag _tag {};
+	pmr::memory_resource* _memory;		// Resource for the chunk's arrays and strings
+	uint64_t _contentHash {};			// Hash of the payload, or zero if it wasn't hashed
 };
 
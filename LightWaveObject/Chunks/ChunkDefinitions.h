@@ -4,10 +4,17 @@
 // Definitions of data chunks within the object file
 //
 #pragma once
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
+#include <memory_resource>
+#include <stdint.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
+#include "../FloatDecoder.h"
+
 using namespace std;
 
 /////////////////////////////////////////////////
@@ -19,6 +26,25 @@ struct COL12 {
 	float g;
 	float b;
 };
+static_assert(sizeof(COL12) == 12, "COL12 must be decodable as three packed floats");
+
+
+/////////////////////////////////////////////////
+// Four-character codes
+
+// Tag ID packed big-endian into 32 bits, so that it
+// compares equal to the raw bytes read from the file
+typedef uint32_t FOURCC;
+
+// Build a four-character code at compile time, e.g. MAKE_FOURCC("PNTS")
+constexpr FOURCC MAKE_FOURCC(const char (&id)[5]) {
+	return FOURCC(uint8_t(id[0])) << 24 | FOURCC(uint8_t(id[1])) << 16 | FOURCC(uint8_t(id[2])) << 8 | FOURCC(uint8_t(id[3]));
+}
+
+// Convert four raw tag bytes to a four-character code
+inline FOURCC CONVERT_BYTES_TO_FOURCC(const char bytes[]) {
+	return FOURCC(uint8_t(bytes[0])) << 24 | FOURCC(uint8_t(bytes[1])) << 16 | FOURCC(uint8_t(bytes[2])) << 8 | FOURCC(uint8_t(bytes[3]));
+}
 
 
 /////////////////////////////////////////////////
@@ -26,6 +52,9 @@ struct COL12 {
 
 enum class ChunkTag { LAYR, PNTS, VMAP, POLS, TAGS, PTAG, VMAD, VMPA, ENVL, CLIP, SURF, BBOX, DESC, TEXT, ICON, UNKNOWN };
 
+// Number of chunk tags, including UNKNOWN
+const size_t NUM_CHUNK_TAGS = size_t(ChunkTag::UNKNOWN) + 1;
+
 
 /////////////////////////////////////////////////
 // File header
@@ -39,9 +68,9 @@ struct LWO_FILE_HEADER_RAW {
 
 // Cooked file header
 struct LWO_FILE_HEADER {
-	string form; // FORM
+	FOURCC form {}; // FORM
 	size_t fileLength = 0;
-	string id; // ID
+	FOURCC id {}; // ID
 };
 
 
@@ -63,6 +92,13 @@ struct LWO_CHUNK_HEADER {
 // Offset into chunk data
 const size_t LWO_CHUNK_DATA_OFFSET = 8;
 
+// Chunk located by walking the chunk headers
+struct LWO_CHUNK_DIRECTORY_ENTRY {
+	LWO_CHUNK_HEADER header; // Cooked chunk header
+	size_t offset = 0; // Offset of the chunk header in the file
+	size_t layerIndex = 0; // Layer the chunk belongs to
+};
+
 
 /////////////////////////////////////////////////
 // Points
@@ -72,6 +108,7 @@ struct VEC12 {
 	float Y;
 	float Z;
 };
+static_assert(sizeof(VEC12) == 12, "VEC12 must be decodable as three packed floats");
 
 
 /////////////////////////////////////////////////
@@ -102,11 +139,52 @@ struct LWO_CHUNK_LAYER {
 /////////////////////////////////////////////////
 // Polygon
 
+// Polygon types
+enum class PolygonType { FACE, CURV, PTCH, MBAL, BONE, SUBD, UNKNOWN };
+
+// Polygon, viewed in place within a polygon list
 struct POLYGON {
-	int numVertices = 0; // Number of vertices in the polygon
-	vector<int> pointIndex; // Vertex indices into PNTS chunk
+	unsigned numVertices; // Number of vertices in the polygon
+	unsigned flags; // High 6 bits of the vertex count field
+	const uint32_t* pointIndex; // Vertex indices into PNTS chunk
 };
 
+// Polygons in compressed sparse row form. The point indices of polygon n
+// are pointIndex[offsets[n]] up to, but not including, pointIndex[offsets[n + 1]]
+struct POLYGON_LIST {
+	pmr::vector<uint32_t> offsets; // Start of each polygon's indices, plus the end of the last
+	pmr::vector<uint32_t> pointIndex; // Vertex indices into PNTS chunk, for all polygons
+	pmr::vector<uint8_t> flags; // Flags for each polygon
+
+	explicit POLYGON_LIST(pmr::memory_resource* memory = pmr::get_default_resource())
+		: offsets(1, 0, memory), pointIndex(memory), flags(memory) { }
+
+	// Number of polygons
+	size_t size() const {
+		return flags.size();
+	}
+
+	// View of a single polygon
+	POLYGON operator[](size_t polygonIndex) const {
+		uint32_t start = offsets[polygonIndex];
+		return POLYGON { offsets[polygonIndex + 1] - start, flags[polygonIndex], pointIndex.data() + start };
+	}
+};
+
+
+/////////////////////////////////////////////////
+// Polygon tags
+
+// Polygon tag types
+enum class PolygonTagType { SURF, PART, SMGP, COLR, UNKNOWN };
+
+
+/////////////////////////////////////////////////
+// Vertex map
+
+// Vertex map types
+enum class VertexMapType { PICK, WGHT, MNVW, TXUV, RGB, RGBA, MORF, SPOT, NORM, UNKNOWN };
+
 
 /////////////////////////////////////////////////
 // Surface
@@ -114,6 +192,26 @@ struct POLYGON {
 // Surface Sub-Chunk tags
 enum class SurfaceSubChunkTag { COLR, DIFF, LUMI, SPEC, REFL, TRAN, TRNL, GLOS, BLOK, SHRP, BUMP, SIDE, SMAN, RFOP, RIMG, RSAN, RBLR, RIND, TROP, TIMG, TBLR, CLRH, CLRF, ADTR, GLOW, LINE, ALPH, VCOL, UNKNOWN };
 
+// Surface parameters a surface sets itself, rather than taking from its source
+enum class SurfaceParameter { COLR, DIFF, LUMI, SPEC, REFL, TRAN, TRNL, GLOS, SHRP, BUMP, SMAN };
+
+// Basic surface parameters, with the defaults of a surface that sets none.
+// Every field is four bytes, so equal blocks compare equal byte for byte
+struct SURFACE_PARAMETERS {
+	COL12 color {};
+	unsigned colorEnvelope {};
+	float diffuse {1.0f};
+	float luminosity {};
+	float specularity {};
+	float reflection {};
+	float transparency {};
+	float translucency {};
+	float glossiness {};
+	float sharpness {};
+	float bump {};
+	float maxSmoothingAngle {-1.0f};
+};
+
 
 /////////////////////////////////////////////////
 // Helper functions and macros
@@ -124,16 +222,17 @@ enum class SurfaceSubChunkTag { COLR, DIFF, LUMI, SPEC, REFL, TRAN, TRNL, GLOS,
             (unsigned char)(twobytes[1]) \
         );
 
-// Convert U4 bytes to int
-#define CONVERT_U4_BYTES_TO_INT(quadbytes) int( \
-            (unsigned char)(quadbytes[0]) << 24 | \
-            (unsigned char)(quadbytes[1]) << 16 | \
-            (unsigned char)(quadbytes[2]) << 8 | \
-            (unsigned char)(quadbytes[3]) \
+// Convert U4 bytes to an unsigned int, so lengths of 2 GB and over don't
+// sign extend when they're widened to size_t
+#define CONVERT_U4_BYTES_TO_INT(quadbytes) uint32_t( \
+            uint32_t((unsigned char)(quadbytes[0])) << 24 | \
+            uint32_t((unsigned char)(quadbytes[1])) << 16 | \
+            uint32_t((unsigned char)(quadbytes[2])) << 8 | \
+            uint32_t((unsigned char)(quadbytes[3])) \
         );
 
 // Convert 4 byte floats
-inline float CONVERT_FLOAT_BYTES(char bytes[]) {
+inline float CONVERT_FLOAT_BYTES(const char bytes[]) {
 	float val;
 	memcpy(&val, bytes, 4);
 	return val;
@@ -145,8 +244,22 @@ inline float CONVERT_FLOAT_BYTES(char bytes[]) {
 // Variable-length index is either 2 or 4 bytes
 #define CONVERT_VX_LENGTH(index) unsigned(index < 0xff00 ? 2 : 4);
 
+// Length of the variable-length index starting at these bytes
+// A leading 0xff byte marks a 4 byte index
+inline unsigned CONVERT_VX_BYTES_LENGTH(const char vxBytes[]) {
+	return uint8_t(vxBytes[0]) == 0xff ? 4 : 2;
+}
+
+// Convert variable-length index bytes to an index
+inline uint32_t CONVERT_VX_BYTES_TO_INT(const char vxBytes[]) {
+	if (uint8_t(vxBytes[0]) == 0xff) {
+		return uint32_t(uint8_t(vxBytes[1])) << 16 | uint32_t(uint8_t(vxBytes[2])) << 8 | uint32_t(uint8_t(vxBytes[3]));
+	}
+	return uint32_t(uint8_t(vxBytes[0])) << 8 | uint32_t(uint8_t(vxBytes[1]));
+}
+
 // Convert little-endian float bytes to big-endian
-inline float CONVERT_LE_FLOAT(char* quadBytes) {
+inline float CONVERT_LE_FLOAT(const char* quadBytes) {
 
 	// Set up char pointers to each float
 	float srcFloat;
@@ -167,32 +280,21 @@ inline float CONVERT_LE_FLOAT(char* quadBytes) {
 };
 
 // Convet COL12 bytes to COL12
-inline COL12 CONVERT_COL12_BYTES(char col12bytes[]) {
+inline COL12 CONVERT_COL12_BYTES(const char col12bytes[]) {
 	COL12 col;
-	col.r = CONVERT_LE_FLOAT(col12bytes);
-	col.g = CONVERT_LE_FLOAT(col12bytes + 4);
-	col.b = CONVERT_LE_FLOAT(col12bytes + 8);
+	FloatDecoder::decodeFloats(col12bytes, &col.r, 3);
 	return col;
 };
 
 // Convet VEC12 bytes to VEC12
-inline VEC12 CONVERT_VEC12_BYTES(char vec12bytes[]) {
+inline VEC12 CONVERT_VEC12_BYTES(const char vec12bytes[]) {
 	VEC12 vec;
-	vec.X = CONVERT_LE_FLOAT(vec12bytes);
-	vec.Y = CONVERT_LE_FLOAT(vec12bytes + 4);
-	vec.Z = CONVERT_LE_FLOAT(vec12bytes + 8);
+	FloatDecoder::decodeFloats(vec12bytes, &vec.X, 3);
 	return vec;
 };
 
-// Convert fixed array of bytes to a string
-inline string CONVERT_BYTES_TO_STRING(char rawString[], unsigned fixedSize = 0) {
-	int len = 0;
-	if (fixedSize == 0) {
-		while (rawString[len] != 0) len++;
-		len++;
-	}
-	else {
-		len = fixedSize;
-	}
-	return string(rawString, len);
+// Convert fixed array of bytes to a string. Zero-terminated strings are
+// read with LWUtils::parseString, which stops at the end of the buffer
+inline string CONVERT_BYTES_TO_STRING(const char rawString[], unsigned fixedSize) {
+	return string(rawString, fixedSize);
 };
@@ -3,11 +3,14 @@
 class Clip : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::CLIP;
+
 	// Constructor
-	Clip() : Chunk(ChunkTag::CLIP) { }
+	explicit Clip(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 
 private:
 
@@ -3,5 +3,5 @@
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Description::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Description::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 }
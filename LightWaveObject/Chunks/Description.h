@@ -3,11 +3,14 @@
 class Description : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::DESC;
+
 	// Constructor
-	Description() : Chunk(ChunkTag::DESC) { }
+	explicit Description(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 
 private:
 
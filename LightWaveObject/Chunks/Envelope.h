@@ -2,11 +2,14 @@
 #include "Chunk.h"
 class Envelope : public Chunk {public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::ENVL;
+
 	// Constructor
-	Envelope() : Chunk(ChunkTag::ENVL) { }
+	explicit Envelope(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 
 private:
 
@@ -3,5 +3,5 @@
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Icon::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Icon::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 }
@@ -1,54 +1,149 @@
 #include "Layer.h"
+#include "Points.h"
+
+/// <summary>
+/// Create an empty layer
+/// </summary>
+/// <param name="memory">Resource for the layer's chunk lists and name</param>
+Layer::Layer(pmr::memory_resource* memory) : Chunk(TAG, memory), _chunks(memory), _chunksByTag(NUM_CHUNK_TAGS, memory), _name(memory) {
+}
 
 /// <summary>
 /// Add a new chunk to the layer
 /// </summary>
-/// <param name="chunk"></param>
-void Layer::addChunk(unique_ptr<Chunk> chunk) {
+/// <param name="chunk">Parsed chunk</param>
+void Layer::addChunk(ChunkPtr chunk) {
+
+	LAYER_CHUNK layerChunk;
+	layerChunk.header.tag = chunk->getTag();
+	layerChunk.header.length = 0;
+	layerChunk.chunk = move(chunk);
+
+	_chunksByTag[size_t(layerChunk.header.tag)].push_back(_chunks.size());
+	_chunks.push_back(move(layerChunk));
+}
+
+/// <summary>
+/// Add a chunk to the layer without parsing it. The chunk is parsed the
+/// first time it's asked for, so the buffer must outlive the layer.
+/// </summary>
+/// <param name="header">Cooked chunk header</param>
+/// <param name="chunkBuffer">View of the chunk, including its header</param>
+void Layer::addChunk(LWO_CHUNK_HEADER header, BufferView chunkBuffer) {
+
+	LAYER_CHUNK layerChunk;
+	layerChunk.header = header;
+	layerChunk.chunkBuffer = chunkBuffer;
+
+	_chunksByTag[size_t(layerChunk.header.tag)].push_back(_chunks.size());
+	_chunks.push_back(move(layerChunk));
+}
+
+/// <summary>
+/// Start of the chunks in this layer
+/// </summary>
+/// <returns>Iterator at the first chunk</returns>
+Layer::ChunkIterator Layer::begin() {
+	return ChunkIterator(this, 0);
+}
+
+/// <summary>
+/// End of the chunks in this layer
+/// </summary>
+/// <returns>Iterator past the last chunk</returns>
+Layer::ChunkIterator Layer::end() {
+	return ChunkIterator(this, _chunks.size());
+}
+
+/// <summary>
+/// Return a chunk matching a tag
+/// </summary>
+/// <param name="tag">Chunk tag to find</param>
+/// <param name="index">Which of the matching chunks to return, in file order</param>
+/// <returns>Matching chunk, or null if there are not enough matches</returns>
+Chunk* Layer::getChunk(ChunkTag tag, size_t index) {
 
-	_chunks.push_back(move(chunk));
+	// Look up the chunks with this tag
+	const pmr::vector<size_t>& matches = _chunksByTag[size_t(tag)];
+	if (index >= matches.size()) {
+		return nullptr;
+	}
+
+	// Return a pointer to the internal Chunk, parsing it if needed
+	return materialize(_chunks[matches[index]]);
 }
 
 /// <summary>
-/// Return chunk at specified index
+/// Get the raw bytes of a chunk that was added unparsed, without parsing it,
+/// e.g. to decode a large chunk a piece at a time
 /// </summary>
-/// <param name="chunk">Matching chunk if found</param>
-/// <param name="chunkIndex">Index of chunk to return</param>
-/// <returns>True if a match was found</returns>
-bool Layer::getChunk(Chunk& chunk, unsigned chunkIndex) {
+/// <param name="tag">Chunk tag to find</param>
+/// <param name="index">Which of the matching chunks to use, in file order</param>
+/// <returns>Chunk header and payload, or empty if there's no such chunk or it was added parsed</returns>
+BufferView Layer::getChunkBuffer(ChunkTag tag, size_t index) {
 
-	// Validate index
-	if (chunkIndex >= _chunks.size()) {
-		return false;
+	const pmr::vector<size_t>& matches = _chunksByTag[size_t(tag)];
+	if (index >= matches.size()) {
+		return BufferView();
 	}
 
-	// Return chunk reference
-	chunk = *_chunks[chunkIndex].get();
-	return true;
+	return _chunks[matches[index]].chunkBuffer;
 }
 
 /// <summary>
-/// Return first chunk matching tag
+/// Get the content hash of a chunk's payload. Chunks added unparsed are
+/// hashed the first time this is called, without parsing them.
 /// </summary>
-/// <param name="chunk">Matching chunk if found</param>
 /// <param name="tag">Chunk tag to find</param>
-/// <returns>True if a match was found</returns>
-Chunk* Layer::getChunk(ChunkTag tag) {
+/// <param name="index">Which of the matching chunks to use, in file order</param>
+/// <returns>ContentHash of the payload, or zero if there's no such chunk or it wasn't hashed</returns>
+uint64_t Layer::getChunkHash(ChunkTag tag, size_t index) {
 
-	// Search for the matching tag
-	for (auto&& prospective : _chunks) {
+	const pmr::vector<size_t>& matches = _chunksByTag[size_t(tag)];
+	if (index >= matches.size()) {
+		return 0;
+	}
 
-		// Return first match
-		ChunkTag prospectiveTag = prospective->getTag();
-		if (prospectiveTag == tag) {
+	lock_guard<mutex> lock(_materializeMutex);
+	LAYER_CHUNK& layerChunk = _chunks[matches[index]];
 
-			// Return a pointer to the internal Chunk
-			return prospective.get();
-		}
+	// Hashed when the object was read
+	if (layerChunk.chunk != nullptr && layerChunk.chunk->getContentHash() != 0) {
+		return layerChunk.chunk->getContentHash();
+	}
+
+	// Hash the raw payload
+	if (layerChunk.contentHash == 0 && !layerChunk.chunkBuffer.empty()) {
+		layerChunk.contentHash = ContentHash::hash(layerChunk.chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, layerChunk.header.length));
+		if (layerChunk.chunk != nullptr) layerChunk.chunk->setContentHash(layerChunk.contentHash);
+	}
+
+	return layerChunk.contentHash;
+}
+
+/// <summary>
+/// Get where a chunk lies among all the layer's chunks, e.g. to pair a
+/// chunk with those that follow it
+/// </summary>
+/// <param name="tag">Chunk tag to find</param>
+/// <param name="index">Which of the matching chunks to use, in file order</param>
+/// <returns>Position of the chunk in file order, or the number of chunks in the layer if there's no such chunk</returns>
+size_t Layer::getChunkPosition(ChunkTag tag, size_t index) {
+
+	const pmr::vector<size_t>& matches = _chunksByTag[size_t(tag)];
+	if (index >= matches.size()) {
+		return _chunks.size();
 	}
 
-	// No matching chunk found
-	return nullptr;
+	return matches[index];
+}
+
+/// <summary>
+/// Get layer flags
+/// </summary>
+/// <returns>Flags; the lowest bit marks a hidden layer</returns>
+unsigned Layer::getFlags() {
+	return _flags;
 }
 
 /// <summary>
@@ -56,40 +151,102 @@ Chunk* Layer::getChunk(ChunkTag tag) {
 /// </summary>
 /// <returns>Layer name</returns>
 string Layer::getName() {
-	return _name;
+	return string(_name.data(), _name.size());
+}
+
+/// <summary>
+/// Get number of chunks with a tag
+/// </summary>
+/// <param name="tag">Chunk tag</param>
+/// <returns>Number of matching chunks</returns>
+size_t Layer::getNumChunks(ChunkTag tag) {
+	return _chunksByTag[size_t(tag)].size();
+}
+
+/// <summary>
+/// Get number of points in the layer, without parsing them if they haven't been
+/// </summary>
+/// <returns>Number of points in the first PNTS chunk</returns>
+size_t Layer::getNumPoints() {
+
+	const pmr::vector<size_t>& matches = _chunksByTag[size_t(ChunkTag::PNTS)];
+	if (matches.empty()) {
+		return 0;
+	}
+
+	// Points are fixed size, so the count follows from the chunk length
+	lock_guard<mutex> lock(_materializeMutex);
+	LAYER_CHUNK& layerChunk = _chunks[matches[0]];
+	if (layerChunk.chunk == nullptr) {
+		return layerChunk.header.length / sizeof(VEC12);
+	}
+	return static_cast<Points*>(layerChunk.chunk.get())->getPoints().size();
+}
+
+/// <summary>
+/// Get layer number
+/// </summary>
+/// <returns>Number the object file gives the layer</returns>
+unsigned Layer::getNumber() {
+	return _number;
+}
+
+/// <summary>
+/// Get the number of the layer's parent
+/// </summary>
+/// <returns>Parent layer number, or -1 if the layer has no parent</returns>
+int Layer::getParent() {
+	return _parent;
+}
+
+/// <summary>
+/// Get layer pivot
+/// </summary>
+/// <returns>Origin the layer rotates about, in object coordinates</returns>
+VEC12 Layer::getPivot() {
+	return _pivot;
 }
 
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Layer::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Layer::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 
 	LWO_CHUNK_LAYER_RAW rawChunk;
 	LWO_CHUNK_LAYER cookedChunk;
 
-	// Copy non-variable parts of chunk
-	memcpy(&rawChunk, rawBuffer, sizeof(LWO_CHUNK_LAYER_RAW));
+	// Copy non-variable parts of chunk, which a truncated chunk may not have
+	BufferView chunk = chunkBuffer.subview(0, LWO_CHUNK_DATA_OFFSET + header.length);
+	if (!chunk.contains(0, offsetof(LWO_CHUNK_LAYER_RAW, name))) return;
+	memcpy(&rawChunk, chunk.data(), offsetof(LWO_CHUNK_LAYER_RAW, name));
 
 	// Parse fields
-	cookedChunk.tag = LWUtils::convertTagStringTagToEnum(CONVERT_BYTES_TO_STRING(rawChunk.tag));
-	cookedChunk.length = CONVERT_U4_BYTES_TO_INT(rawChunk.length);
+	cookedChunk.tag = header.tag;
+	cookedChunk.length = header.length;
 	cookedChunk.number = CONVERT_U2_BYTES_TO_INT(rawChunk.number);
 	cookedChunk.flags = CONVERT_U2_BYTES_TO_INT(rawChunk.flags);
 	cookedChunk.pivot = CONVERT_VEC12_BYTES(rawChunk.pivot);
-	cookedChunk.name = CONVERT_BYTES_TO_STRING(rawChunk.name);
-	
+
+	// Name ends at the end of the chunk if it's unterminated
+	size_t offset = offsetof(LWO_CHUNK_LAYER_RAW, name);
+	string_view name;
+	LWUtils::parseString(chunk, offset, name);
+	cookedChunk.name.assign(name.data(), name.size());
+
 	// Parent field is optional
-	unsigned adjustedStringLen = CONVERT_STRING_LENGTH(cookedChunk.name.length());
-	size_t offsetToParent = sizeof(LWO_CHUNK_LAYER_RAW) - 1 + adjustedStringLen;
-	if (offsetToParent < cookedChunk.length + LWO_CHUNK_DATA_OFFSET) {
-		cookedChunk.parent = CONVERT_U2_BYTES_TO_INT((rawBuffer + offsetToParent));
+	if (chunk.contains(offset, 2)) {
+		cookedChunk.parent = CONVERT_U2_BYTES_TO_INT(chunk.data(offset));
 	}
 	else {
 		cookedChunk.parent = -1;
 	}
 
 	// Save some fields to instance
-	_name = cookedChunk.name;
+	_name.assign(cookedChunk.name.data(), cookedChunk.name.size());
+	_number = cookedChunk.number;
+	_flags = cookedChunk.flags;
+	_pivot = cookedChunk.pivot;
+	_parent = cookedChunk.parent == unsigned(-1) ? -1 : int(cookedChunk.parent);
 }
 
 /// <summary>
@@ -99,3 +256,26 @@ void Layer::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
 size_t Layer::size() {
 	return _chunks.size();
 }
+
+/// <summary>
+/// Parse a chunk the first time it is used
+/// </summary>
+/// <param name="layerChunk">Chunk to parse</param>
+/// <returns>Parsed chunk, or null if the tag isn't supported</returns>
+Chunk* Layer::materialize(LAYER_CHUNK& layerChunk) {
+
+	// Several threads may ask for the same chunk
+	lock_guard<mutex> lock(_materializeMutex);
+
+	if (layerChunk.chunk == nullptr) {
+		layerChunk.chunk = Chunk::create(layerChunk.header.tag, getMemoryResource());
+		if (layerChunk.chunk != nullptr) {
+			layerChunk.chunk->parse(layerChunk.chunkBuffer, layerChunk.header);
+			layerChunk.chunk->setContentHash(layerChunk.contentHash);
+		}
+
+		// The raw chunk stays referenced so it can still be hashed
+	}
+
+	return layerChunk.chunk.get();
+}
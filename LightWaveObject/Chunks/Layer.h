@@ -1,28 +1,83 @@
 #pragma once
+#include <mutex>
 #include <vector>
 
 #include "Chunk.h"
 
+#include "../ContentHash.h"
 #include "../LWUtils.h"
 
+class Layer;
+
+// Owning pointer to a layer allocated by Chunk::create
+typedef unique_ptr<Layer, ChunkDeleter> LayerPtr;
+
 class Layer : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::LAYR;
+
 	// Constructor
-	Layer() : Chunk(ChunkTag::LAYR) { }
+	explicit Layer(pmr::memory_resource* memory = pmr::get_default_resource());
+
+	// Iterates over the layer's chunks in file order, parsing each when it's reached
+	class ChunkIterator {
+	public:
+		ChunkIterator(Layer* layer, size_t chunkIndex) : _layer { layer }, _chunkIndex { chunkIndex } { }
+		Chunk& operator*() const { return *_layer->materialize(_layer->_chunks[_chunkIndex]); }
+		ChunkIterator& operator++() { _chunkIndex++; return *this; }
+		bool operator!=(const ChunkIterator& other) const { return _chunkIndex != other._chunkIndex; }
+	private:
+		Layer* _layer;
+		size_t _chunkIndex;
+	};
 
 	// Public methods
-	void addChunk(unique_ptr<Chunk> chunk);
-	bool getChunk(Chunk& chunk, unsigned chunkIndex);
-	Chunk* getChunk(ChunkTag tag);
+	void addChunk(ChunkPtr chunk);
+	void addChunk(LWO_CHUNK_HEADER header, BufferView chunkBuffer);
+	ChunkIterator begin();
+	ChunkIterator end();
+	Chunk* getChunk(ChunkTag tag, size_t index = 0);
+	BufferView getChunkBuffer(ChunkTag tag, size_t index = 0);
+	uint64_t getChunkHash(ChunkTag tag, size_t index = 0);
+	size_t getChunkPosition(ChunkTag tag, size_t index = 0);
+	unsigned getFlags();
 	string getName();
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	size_t getNumChunks(ChunkTag tag);
+	size_t getNumPoints();
+	unsigned getNumber();
+	int getParent();
+	VEC12 getPivot();
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 	size_t size();
 
+	// Get a chunk of a given class, e.g. getChunk<Points>()
+	template <typename T>
+	T* getChunk(size_t index = 0) {
+		return static_cast<T*>(getChunk(T::TAG, index));
+	}
+
 private:
 
+	// Chunk in this layer, which may not have been parsed yet
+	struct LAYER_CHUNK {
+		LWO_CHUNK_HEADER header;
+		BufferView chunkBuffer;		// Raw chunk, for chunks added unparsed
+		ChunkPtr chunk;				// Parsed chunk, or null
+		uint64_t contentHash {};	// Payload hash taken before the chunk was parsed
+	};
+
+	// Private methods
+	Chunk* materialize(LAYER_CHUNK& layerChunk);
+
 	// Private data
-	vector<unique_ptr<Chunk>> _chunks;
-	string _name;
+	pmr::vector<LAYER_CHUNK> _chunks;
+	pmr::vector<pmr::vector<size_t>> _chunksByTag;	// Positions in _chunks of each tag's chunks
+	mutex _materializeMutex;
+	pmr::string _name;
+	unsigned _number {};
+	unsigned _flags {};				// The lowest bit hides the layer
+	VEC12 _pivot {};				// Origin the layer rotates about, in object coordinates
+	int _parent = -1;				// Parent layer number, or -1 for none
 };
-
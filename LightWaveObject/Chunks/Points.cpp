@@ -7,40 +7,95 @@
 /// </summary>
 /// <returns>Description</returns>
 string Points::getDescription() {
-	return "Vertices: " + to_string(_points.size());
+	return "Vertices: " + to_string(size());
 }
 
 /// <summary>
 /// Get points vector
 /// </summary>
 /// <returns>Vector of points</returns>
-vector<VEC12>& Points::getPoints() {
+pmr::vector<VEC12>& Points::getPoints() {
 	return _points;
 }
 
+/// <summary>
+/// Get the X components of the points parsed into component arrays
+/// </summary>
+/// <returns>X of each point, or empty if the points were parsed as structures</returns>
+const pmr::vector<float>& Points::getX() {
+	return _x;
+}
+
+/// <summary>
+/// Get the Y components of the points parsed into component arrays
+/// </summary>
+/// <returns>Y of each point, or empty if the points were parsed as structures</returns>
+const pmr::vector<float>& Points::getY() {
+	return _y;
+}
+
+/// <summary>
+/// Get the Z components of the points parsed into component arrays
+/// </summary>
+/// <returns>Z of each point, or empty if the points were parsed as structures</returns>
+const pmr::vector<float>& Points::getZ() {
+	return _z;
+}
+
 /// <summary>
 /// Get number of vertices
 /// </summary>
 /// <returns></returns>
 unsigned Points::length() {
-	return _points.size();
+	return unsigned(size());
 }
 
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Points::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Points::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 
 	// Read all points starting after chunk header
-	unsigned stride = sizeof(VEC12);
-	for (unsigned offset = LWO_CHUNK_DATA_OFFSET; offset < header.length + LWO_CHUNK_DATA_OFFSET; offset += stride) {
+	parsePiece(chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length), 0);
+}
 
-		// Read and parse coordinate
-		VEC12 point = CONVERT_VEC12_BYTES(rawBuffer + offset);
+/// <summary>
+/// Parse whole points from part of the chunk payload
+/// </summary>
+/// <param name="payloadPiece">Next unconsumed part of the chunk payload</param>
+/// <param name="payloadOffset">Offset of the piece within the payload</param>
+/// <returns>Number of bytes consumed</returns>
+size_t Points::parsePiece(BufferView payloadPiece, size_t) {
 
-		// Store coordinate
-		_points.push_back(point);
+	// Size the arrays for all complete points in this piece
+	size_t numPoints = payloadPiece.size() / sizeof(VEC12);
+	size_t firstPoint = size();
+	if (numPoints == 0) return 0;
+
+	// Decode coordinates straight into the arrays
+	if (_componentArrays) {
+		_x.resize(firstPoint + numPoints);
+		_y.resize(firstPoint + numPoints);
+		_z.resize(firstPoint + numPoints);
+		FloatDecoder::decodeVec12SoA(payloadPiece.data(), numPoints, &_x[firstPoint], &_y[firstPoint], &_z[firstPoint]);
+	}
+	else {
+		_points.resize(firstPoint + numPoints);
+		FloatDecoder::decodeFloats(payloadPiece.data(), &_points[firstPoint].X, numPoints * 3);
 	}
+
+	return numPoints * sizeof(VEC12);
+}
+
+/// <summary>
+/// Choose whether the points are parsed into separate X, Y and Z arrays,
+/// read with getX, getY and getZ, rather than VEC12 structures. Code that
+/// works a component at a time, such as bounds or transforms, can then
+/// use wide loads. Set before parsing; getPoints is left empty.
+/// </summary>
+/// <param name="componentArrays">True to parse into component arrays</param>
+void Points::setComponentArrays(bool componentArrays) {
+	_componentArrays = componentArrays;
 }
 
 /// <summary>
@@ -48,5 +103,23 @@ void Points::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
 /// </summary>
 /// <returns>Number of vertices in this chunk</returns>
 size_t Points::size() {
-	return _points.size();
+	return _componentArrays ? _x.size() : _points.size();
+}
+
+/// <summary>
+/// Size the arrays for the whole payload before it's parsed in pieces, so
+/// they aren't regrown and the outgrown buffers left in the chunk's resource
+/// </summary>
+/// <param name="payloadLength">Length of the whole payload</param>
+void Points::startPieces(size_t payloadLength) {
+
+	size_t numPoints = payloadLength / sizeof(VEC12);
+	if (_componentArrays) {
+		_x.reserve(numPoints);
+		_y.reserve(numPoints);
+		_z.reserve(numPoints);
+	}
+	else {
+		_points.reserve(numPoints);
+	}
 }
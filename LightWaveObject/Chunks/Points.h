@@ -6,19 +6,33 @@
 class Points : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::PNTS;
+
 	// Constructor
-	Points() : Chunk(ChunkTag::PNTS) { }
+	explicit Points(pmr::memory_resource* memory = pmr::get_default_resource())
+		: Chunk(TAG, memory), _points(memory), _x(memory), _y(memory), _z(memory) { }
 
 	// Public methods
 	string getDescription() override;
-	vector<VEC12>& getPoints();
+	pmr::vector<VEC12>& getPoints();
+	const pmr::vector<float>& getX();
+	const pmr::vector<float>& getY();
+	const pmr::vector<float>& getZ();
 	unsigned length();
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+	size_t parsePiece(BufferView payloadPiece, size_t payloadOffset) override;
+	void setComponentArrays(bool componentArrays);
 	size_t size();
+	void startPieces(size_t payloadLength) override;
 
 private:
 
 	// Private data
-	vector<VEC12> _points;
+	pmr::vector<VEC12> _points;			// Points as structures, unless parsed into component arrays
+	bool _componentArrays {};
+	pmr::vector<float> _x;				// Component arrays, filled instead of _points if chosen before parsing
+	pmr::vector<float> _y;
+	pmr::vector<float> _z;
 };
 
@@ -1,7 +1,64 @@
 #include "PolygonTags.h"
 
+/// <summary>
+/// Get chunk description
+/// </summary>
+/// <returns>Description</returns>
+string PolygonTags::getDescription() {
+	return "Polygon tags: " + to_string(_tags.size());
+}
+
+/// <summary>
+/// Get the tag of each polygon, indexed by the polygon's position in the
+/// layer's polygon list. Polygons past the end of the list, or set to
+/// NO_TAG, aren't tagged by this chunk.
+/// </summary>
+/// <returns>Index into the TAGS strings of each polygon</returns>
+const pmr::vector<uint16_t>& PolygonTags::getTags() {
+	return _tags;
+}
+
+/// <summary>
+/// Get what the tags mean, e.g. the surface of each polygon
+/// </summary>
+/// <returns>Tag type</returns>
+PolygonTagType PolygonTags::getType() {
+	return _type;
+}
+
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void PolygonTags::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void PolygonTags::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Payload starts with the tag type
+	BufferView payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length);
+	if (!payload.contains(0, 4)) return;
+	_type = LWUtils::convertPolygonTagTypeToEnum(CONVERT_BYTES_TO_FOURCC(payload.data()));
+
+	// Find the highest tagged polygon first, so the tag array is allocated once
+	uint32_t numPolygons = 0;
+	size_t offset = 4;
+	while (payload.contains(offset, 2)) {
+
+		// Each record is a variable-length polygon index and a U2 tag
+		size_t recordLength = CONVERT_VX_BYTES_LENGTH(payload.data(offset)) + 2;
+		if (!payload.contains(offset, recordLength)) break;
+
+		uint32_t polygonIndex = CONVERT_VX_BYTES_TO_INT(payload.data(offset));
+		if (polygonIndex >= numPolygons) numPolygons = polygonIndex + 1;
+		offset += recordLength;
+	}
+	size_t length = offset;
+	_tags.assign(numPolygons, uint16_t(NO_TAG));
+
+	// Polygon index and tag pairs, usually in polygon order
+	offset = 4;
+	while (offset < length) {
+		uint32_t polygonIndex = CONVERT_VX_BYTES_TO_INT(payload.data(offset));
+		offset += CONVERT_VX_BYTES_LENGTH(payload.data(offset));
+		int tag = CONVERT_U2_BYTES_TO_INT(payload.data(offset));
+		_tags[polygonIndex] = uint16_t(tag);
+		offset += 2;
+	}
 }
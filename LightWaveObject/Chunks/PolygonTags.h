@@ -1,17 +1,30 @@
 #pragma once
 #include "Chunk.h"
+#include "../LWUtils.h"
+
 class PolygonTags : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::PTAG;
+
+	// Tag of polygons the chunk doesn't tag
+	static const uint16_t NO_TAG = 0xffff;
+
 	// Constructor
-	PolygonTags() : Chunk(ChunkTag::PTAG) { }
+	explicit PolygonTags(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory), _tags(memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	string getDescription() override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+
+	// Getters
+	const pmr::vector<uint16_t>& getTags();
+	PolygonTagType getType();
 
 private:
 
 	// Private data
-
+	PolygonTagType _type = PolygonTagType::UNKNOWN;
+	pmr::vector<uint16_t> _tags;	// Index into the TAGS strings of each polygon, by polygon index
 };
-
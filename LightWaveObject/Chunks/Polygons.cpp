@@ -1,5 +1,34 @@
 #include "Polygons.h"
 
+namespace {
+
+	/// <summary>
+	/// Make room for more elements, growing geometrically so that
+	/// a chunk parsed in many pieces still reallocates rarely
+	/// </summary>
+	template <typename T>
+	void reserveMore(pmr::vector<T>& list, size_t additional) {
+		size_t required = list.size() + additional;
+		if (required > list.capacity()) {
+			list.reserve(max(required, list.capacity() + list.capacity() / 2));
+		}
+	}
+}
+
+/// <summary>
+/// Move a list parsed in pieces into the chunk's resource, at its final
+/// size, and free the buffers it grew in
+/// </summary>
+void Polygons::finishPieces() {
+
+	if (!_growingPolygons) return;
+
+	_polygons.offsets.assign(_growingPolygons->offsets.begin(), _growingPolygons->offsets.end());
+	_polygons.pointIndex.assign(_growingPolygons->pointIndex.begin(), _growingPolygons->pointIndex.end());
+	_polygons.flags.assign(_growingPolygons->flags.begin(), _growingPolygons->flags.end());
+	_growingPolygons.reset();
+}
+
 /// <summary>
 /// Get chunk description
 /// </summary>
@@ -11,58 +40,213 @@ string Polygons::getDescription() {
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Polygons::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Polygons::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Parse the whole payload as a single piece
+	parsePiece(chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length), 0);
+}
+
+/// <summary>
+/// Parse whole polygons from part of the chunk payload
+/// </summary>
+/// <param name="payloadPiece">Next unconsumed part of the chunk payload</param>
+/// <param name="payloadOffset">Offset of the piece within the payload</param>
+/// <returns>Number of bytes consumed</returns>
+size_t Polygons::parsePiece(BufferView payloadPiece, size_t payloadOffset) {
 
-	// Parse by polygon type
-	unsigned offset = LWO_CHUNK_DATA_OFFSET;
-	string polygonType = CONVERT_BYTES_TO_STRING(rawBuffer + offset, 4);
-	if (polygonType == "FACE") {
-		_polygons = parsePolygons(rawBuffer + offset, header.length);
+	size_t offset = 0;
+
+	// Payload starts with the polygon type
+	if (payloadOffset == 0) {
+		if (!payloadPiece.contains(0, 4)) return 0;
+		_isFace = LWUtils::convertPolygonTypeToEnum(CONVERT_BYTES_TO_FOURCC(payloadPiece.data())) == PolygonType::FACE;
+		offset += 4;
+
+		// A list that grows piece by piece grows outside the chunk's
+		// resource, which may never free the buffers it outgrows
+		if (_growthResource && _isFace) {
+			_growingPolygons = make_unique<POLYGON_LIST>(_growthResource);
+		}
+	}
+
+	// Only faces are parsed, so skip anything else
+	if (!_isFace) {
+		return payloadPiece.size();
 	}
+
+	POLYGON_LIST& polygons = _growingPolygons ? *_growingPolygons : _polygons;
+	return offset + parsePolygons(polygons, payloadPiece.subview(offset, payloadPiece.size()));
 }
 
 /// <summary>
 /// Get polygons vector
 /// </summary>
 /// <returns>Vector of polygons</returns>
-vector<POLYGON>& Polygons::getPolygons() {
+const POLYGON_LIST& Polygons::getPolygons() {
 	return _polygons;
 }
 
 /// <summary>
-/// Parse polygons from raw data
+/// Grow the polygon list in another resource while the chunk is parsed in
+/// pieces, e.g. the upstream of an arena that never frees. The list is
+/// moved into the chunk's resource by finishPieces, and is empty until then.
 /// </summary>
-/// <param name="rawBuffer">Raw buffer</param>
-/// <returns>Vector of polygons</returns>
-vector<POLYGON> Polygons::parsePolygons(char rawBuffer[], unsigned chunkLength) {
+/// <param name="growthResource">Resource to grow the list in, or null to grow it in place</param>
+void Polygons::setGrowthResource(pmr::memory_resource* growthResource) {
+	_growthResource = growthResource;
+}
 
-	vector<POLYGON> polygons;
+/// <summary>
+/// Set the control checked between segments decoded in parallel; once it's
+/// cancelled the remaining segments are skipped, leaving the list incomplete
+/// </summary>
+/// <param name="loadControl">Control of the load, or null</param>
+void Polygons::setLoadControl(const LoadControl* loadControl) {
+	_loadControl = loadControl;
+}
 
-	// Parse all polygons
-	unsigned offset = 4;
-	while (offset < chunkLength) {
+/// <summary>
+/// Decode polygon segments on a thread pool; without a pool they are decoded serially
+/// </summary>
+/// <param name="threadPool">Pool to use, or null</param>
+void Polygons::setThreadPool(ThreadPool* threadPool) {
+	_threadPool = threadPool;
+}
 
-		POLYGON polygon;
+/// <summary>
+/// Decode a segment of polygon records into its preallocated place in the polygon list
+/// </summary>
+/// <param name="polygons">Polygon list</param>
+/// <param name="polygonData">Polygon records, already measured</param>
+/// <param name="segment">Segment to decode</param>
+void Polygons::decodeSegment(POLYGON_LIST& polygons, const char polygonData[], const SEGMENT& segment) {
+
+	uint32_t* pointIndex = polygons.pointIndex.data() + segment.indexStart;
+	uint32_t* offsets = polygons.offsets.data() + segment.polygonStart + 1;
+	uint8_t* flags = polygons.flags.data() + segment.polygonStart;
+	uint32_t indexOffset = uint32_t(segment.indexStart);
+
+	size_t offset = segment.byteOffset;
+	for (size_t polygonIndex = 0; polygonIndex < segment.numPolygons; polygonIndex++) {
 
 		// Get number of vertices in this polygon (could be n-sided)
-		unsigned numVertFlags = CONVERT_U2_BYTES_TO_INT((rawBuffer + offset));
-		unsigned numVerts = numVertFlags & 0x00ff;
-		unsigned flags = (numVertFlags & 0xff00) >> 8;
+		const char* polygonRecord = polygonData + offset;
+		unsigned numVertFlags = CONVERT_U2_BYTES_TO_INT(polygonRecord);
+		unsigned numVerts = numVertFlags & 0x03ff;
 		offset += 2;
 
 		// Read vertices
-		polygon.numVertices = numVerts;
 		for (unsigned vertIndex = 0; vertIndex < numVerts; vertIndex++) {
 
 			// Get the index into the PNTS chunk
-			unsigned pointIndex = CONVERT_U2_BYTES_TO_INT((rawBuffer + offset));
-			polygon.pointIndex.push_back(pointIndex);
-			offset += 2;
+			*pointIndex++ = CONVERT_VX_BYTES_TO_INT(polygonData + offset);
+			offset += CONVERT_VX_BYTES_LENGTH(polygonData + offset);
 		}
 
 		// Store polygon
-		polygons.push_back(polygon);
+		indexOffset += numVerts;
+		offsets[polygonIndex] = indexOffset;
+		flags[polygonIndex] = uint8_t(numVertFlags >> 10);
+	}
+}
+
+/// <summary>
+/// Find the complete polygons at the start of raw data, split into segments.
+/// Only the vertex counts and the first byte of each index are read.
+/// </summary>
+/// <param name="polygonBuffer">View of polygon records</param>
+/// <param name="segmentBytes">Approximate length of each segment</param>
+/// <param name="segments">Segments found, with their polygon and index counts</param>
+/// <returns>Number of bytes spanned by the complete polygons</returns>
+size_t Polygons::measurePolygons(BufferView polygonBuffer, size_t segmentBytes, vector<SEGMENT>& segments) {
+
+	SEGMENT segment;
+
+	size_t offset = 0;
+	while (polygonBuffer.contains(offset, 2)) {
+
+		// Vertex count is the low 10 bits
+		unsigned numVertFlags = CONVERT_U2_BYTES_TO_INT(polygonBuffer.data(offset));
+		unsigned numVerts = numVertFlags & 0x03ff;
+
+		// Step over the variable-length vertex indices
+		size_t polygonEnd = offset + 2;
+		unsigned vertIndex = 0;
+		for (; vertIndex < numVerts && polygonBuffer.contains(polygonEnd, 2); vertIndex++) {
+			polygonEnd += CONVERT_VX_BYTES_LENGTH(polygonBuffer.data(polygonEnd));
+		}
+
+		// Stop at a polygon that isn't wholly in the buffer
+		if (vertIndex < numVerts || polygonEnd > polygonBuffer.size()) break;
+
+		segment.numPolygons++;
+		segment.numIndices += numVerts;
+		offset = polygonEnd;
+
+		// Close the segment once it is long enough
+		if (offset - segment.byteOffset >= segmentBytes) {
+			segment.byteLength = offset - segment.byteOffset;
+			segments.push_back(segment);
+			segment = SEGMENT();
+			segment.byteOffset = offset;
+		}
+	}
+
+	// Last partial segment
+	if (segment.numPolygons > 0) {
+		segment.byteLength = offset - segment.byteOffset;
+		segments.push_back(segment);
+	}
+
+	return offset;
+}
+
+/// <summary>
+/// Parse complete polygons from raw data
+/// </summary>
+/// <param name="polygons">Polygon list to append to</param>
+/// <param name="polygonBuffer">View of polygon records</param>
+/// <returns>Number of bytes consumed</returns>
+size_t Polygons::parsePolygons(POLYGON_LIST& polygons, BufferView polygonBuffer) {
+
+	// Find the complete polygons first, so each array grows at most once.
+	// Without a pool the records are decoded as a single segment
+	bool parallel = _threadPool != nullptr && polygonBuffer.size() >= SEGMENT_BYTES * 2;
+	vector<SEGMENT> segments;
+	size_t length = measurePolygons(polygonBuffer, parallel ? SEGMENT_BYTES : SIZE_MAX, segments);
+
+	// Prefix sum of the segment counts gives each segment's place in the list
+	size_t numPolygons = polygons.flags.size();
+	size_t numIndices = polygons.pointIndex.size();
+	for (SEGMENT& segment : segments) {
+		segment.polygonStart = numPolygons;
+		segment.indexStart = numIndices;
+		numPolygons += segment.numPolygons;
+		numIndices += segment.numIndices;
+	}
+
+	// Size the list for the new polygons
+	reserveMore(polygons.offsets, numPolygons + 1 - polygons.offsets.size());
+	reserveMore(polygons.flags, numPolygons - polygons.flags.size());
+	reserveMore(polygons.pointIndex, numIndices - polygons.pointIndex.size());
+	polygons.offsets.resize(numPolygons + 1);
+	polygons.flags.resize(numPolygons);
+	polygons.pointIndex.resize(numIndices);
+
+	// Decode the segments, which write to separate parts of the list
+	const char* polygonData = polygonBuffer.data();
+	if (parallel && segments.size() > 1) {
+		_threadPool->parallelFor(segments.size(), [&](size_t segmentIndex) {
+			if (_loadControl && _loadControl->isCancelled()) return;
+			TraceScope trace("Decode POLS segment", "polygons", int64_t(segments[segmentIndex].numPolygons));
+			decodeSegment(polygons, polygonData, segments[segmentIndex]);
+		});
+	}
+	else {
+		for (const SEGMENT& segment : segments) {
+			decodeSegment(polygons, polygonData, segment);
+		}
 	}
 
-	return polygons;
+	return length;
 }
@@ -2,25 +2,60 @@
 #include "Chunk.h"
 #include "ChunkDefinitions.h"
 
+#include "../LoadControl.h"
+#include "../LWUtils.h"
+#include "../ThreadPool.h"
+#include "../TraceRecorder.h"
+
 class Polygons : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::POLS;
+
 	// Constructor
-	Polygons() : Chunk(ChunkTag::POLS) { }
+	explicit Polygons(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory), _polygons(memory) { }
 
 	// Public methods
+	void finishPieces() override;
 	string getDescription();
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+	size_t parsePiece(BufferView payloadPiece, size_t payloadOffset) override;
 
 	// Getters
-	vector<POLYGON>& getPolygons();
+	const POLYGON_LIST& getPolygons();
+
+	// Setters
+	void setGrowthResource(pmr::memory_resource* growthResource);
+	void setLoadControl(const LoadControl* loadControl);
+	void setThreadPool(ThreadPool* threadPool);
+
+	// Polygon records are decoded in segments of about this many bytes
+	static const size_t SEGMENT_BYTES = 256 * 1024;
 
 private:
 
+	// Run of whole polygon records, decoded as one unit
+	struct SEGMENT {
+		size_t byteOffset = 0;		// Start of the first record in the polygon buffer
+		size_t byteLength = 0;		// Length of the records
+		size_t numPolygons = 0;
+		size_t numIndices = 0;
+		size_t polygonStart = 0;	// Index of the first polygon in the polygon list
+		size_t indexStart = 0;		// Index of the first point index in the polygon list
+	};
+
 	// Private methods
-	vector<POLYGON> parsePolygons(char rawBuffer[], unsigned chunkLength);
+	void decodeSegment(POLYGON_LIST& polygons, const char polygonData[], const SEGMENT& segment);
+	size_t measurePolygons(BufferView polygonBuffer, size_t segmentBytes, vector<SEGMENT>& segments);
+	size_t parsePolygons(POLYGON_LIST& polygons, BufferView polygonBuffer);
 
 	// Private data
-	vector<POLYGON> _polygons;
+	POLYGON_LIST _polygons;
+	pmr::memory_resource* _growthResource {};	// Resource the list grows in while parsed in pieces, or null
+	unique_ptr<POLYGON_LIST> _growingPolygons;	// List being parsed in pieces, until they're finished
+	bool _isFace {};
+	ThreadPool* _threadPool {};		// Pool for decoding segments in parallel, or null for serial
+	const LoadControl* _loadControl {};	// Checked between parallel segments, or null
 };
 
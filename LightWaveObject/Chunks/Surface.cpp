@@ -6,9 +6,9 @@
 /// <returns>Color data</returns>
 Surface::COLOR Surface::getColor() {
 	COLOR col;
-	col.r = _color.r;
-	col.g = _color.g;
-	col.b = _color.b;
+	col.r = _parameters.color.r;
+	col.g = _parameters.color.g;
+	col.b = _parameters.color.b;
 	return col;
 }
 
@@ -17,74 +17,164 @@ Surface::COLOR Surface::getColor() {
 /// </summary>
 /// <returns>Color data</returns>
 COL12 Surface::getCol12Color() {
-	return _color;
+	return _parameters.color;
 }
 
 /// <summary>
-/// Parse the raw chunk data
+/// Get the surface name
+/// </summary>
+/// <returns>Name, as the TAGS strings give it</returns>
+const pmr::string& Surface::getName() {
+	return _name;
+}
+
+/// <summary>
+/// Get the parameters read from the chunk, without any from the source surface
 /// </summary>
-void Surface::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+/// <returns>Parameters, with defaults for those the chunk doesn't set</returns>
+const SURFACE_PARAMETERS& Surface::getParameters() {
+	return _parameters;
+}
 
-	// Skip the chunk header
-	unsigned offset = LWO_CHUNK_DATA_OFFSET;
+/// <summary>
+/// Get the name of the surface this one derives from
+/// </summary>
+/// <returns>Source surface name, or an empty string</returns>
+const pmr::string& Surface::getSource() {
+	return _source;
+}
 
-	// Get name
-	string name = CONVERT_BYTES_TO_STRING(rawBuffer + offset);
-	offset = offset + CONVERT_STRING_LENGTH(name.length());
+/// <summary>
+/// Check whether the chunk sets a parameter
+/// </summary>
+/// <param name="parameter">Surface parameter</param>
+/// <returns>True if the chunk sets it, false if it comes from the source or the defaults</returns>
+bool Surface::hasParameter(SurfaceParameter parameter) {
+	return (_parameterMask & (1u << unsigned(parameter))) != 0;
+}
+
+/// <summary>
+/// Apply the parameters this surface sets over those of its source surface
+/// </summary>
+/// <param name="sourceParameters">Resolved parameters of the source surface, or the defaults</param>
+/// <returns>Resolved parameters of this surface</returns>
+SURFACE_PARAMETERS Surface::inheritParameters(const SURFACE_PARAMETERS& sourceParameters) {
+
+	SURFACE_PARAMETERS parameters = sourceParameters;
+	if (hasParameter(SurfaceParameter::COLR)) {
+		parameters.color = _parameters.color;
+		parameters.colorEnvelope = _parameters.colorEnvelope;
+	}
+	if (hasParameter(SurfaceParameter::DIFF)) parameters.diffuse = _parameters.diffuse;
+	if (hasParameter(SurfaceParameter::LUMI)) parameters.luminosity = _parameters.luminosity;
+	if (hasParameter(SurfaceParameter::SPEC)) parameters.specularity = _parameters.specularity;
+	if (hasParameter(SurfaceParameter::REFL)) parameters.reflection = _parameters.reflection;
+	if (hasParameter(SurfaceParameter::TRAN)) parameters.transparency = _parameters.transparency;
+	if (hasParameter(SurfaceParameter::TRNL)) parameters.translucency = _parameters.translucency;
+	if (hasParameter(SurfaceParameter::GLOS)) parameters.glossiness = _parameters.glossiness;
+	if (hasParameter(SurfaceParameter::SHRP)) parameters.sharpness = _parameters.sharpness;
+	if (hasParameter(SurfaceParameter::BUMP)) parameters.bump = _parameters.bump;
+	if (hasParameter(SurfaceParameter::SMAN)) parameters.maxSmoothingAngle = _parameters.maxSmoothingAngle;
+
+	return parameters;
+}
+
+/// <summary>
+/// Parse the raw chunk data
+/// </summary>
+void Surface::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Names end at the end of the chunk if they're unterminated
+	BufferView payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length);
+	size_t offset = 0;
+	string_view name;
+	LWUtils::parseString(payload, offset, name);
+	_name.assign(name.data(), name.size());
 
 	// Get source
-	string source = CONVERT_BYTES_TO_STRING(rawBuffer + offset);
-	offset = offset + CONVERT_STRING_LENGTH(source.length());
+	string_view source;
+	LWUtils::parseString(payload, offset, source);
+	_source.assign(source.data(), source.size());
 
 	// Read sub-chunks
 	unsigned vxValue = 0; // Placeholder for unhandled vx values
-	while (offset <= header.length) {
+	while (payload.contains(offset, 6)) {
 
 		// Read sub-chunk tag
-		string subChunkTagName = CONVERT_BYTES_TO_STRING(rawBuffer + offset, 4);
-		SurfaceSubChunkTag subChunkTag = LWUtils::convertSurfaceTagStringToEnum(subChunkTagName);
-		offset += 4;
+		SurfaceSubChunkTag subChunkTag = LWUtils::convertSurfaceTagToEnum(CONVERT_BYTES_TO_FOURCC(payload.data(offset)));
 
-		// Read sub-chunk size
-		short subChunkSize = CONVERT_U2_BYTES_TO_INT((rawBuffer + offset));
-		offset += 2;
+		// Read sub-chunk size; a sub-chunk running past the end of the chunk is
+		// truncated, so it and anything after it are skipped
+		uint16_t subChunkSize = CONVERT_U2_BYTES_TO_INT(payload.data(offset + 4));
+		size_t start = offset + 6;
+		if (!payload.contains(start, subChunkSize)) break;
 
-		// Handle sub-chunks
+		// Values are read from within the sub-chunk, and the next sub-chunk
+		// follows from the size whatever was read, padded to even length
+		BufferView subChunk = payload.subview(start, subChunkSize);
+		offset = start + subChunkSize + subChunkSize % 2;
+		unsigned position = 0;
+
+		// Handle sub-chunks; those too short for their values are skipped
 		switch (subChunkTag) {
 			case SurfaceSubChunkTag::COLR: // Base color
-				LWUtils::parseCol12Value(rawBuffer + offset, offset, _color);
-				LWUtils::parseVxValues(rawBuffer + offset, offset, _envIndex);
+				if (!containsValue(subChunk, sizeof(COL12))) break;
+				LWUtils::parseCol12Value(subChunk.data(position), position, _parameters.color);
+				LWUtils::parseVxValues(subChunk.data(position), position, _parameters.colorEnvelope);
+				setParameter(SurfaceParameter::COLR);
 				break;
 			case SurfaceSubChunkTag::DIFF: // Diffuse
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _diff, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.diffuse, vxValue);
+				setParameter(SurfaceParameter::DIFF);
 				break;
 			case SurfaceSubChunkTag::LUMI: // Luminosity
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _lumi, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.luminosity, vxValue);
+				setParameter(SurfaceParameter::LUMI);
 				break;
 			case SurfaceSubChunkTag::SPEC: // Specular
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _spec, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.specularity, vxValue);
+				setParameter(SurfaceParameter::SPEC);
 				break;
 			case SurfaceSubChunkTag::REFL: // Reflection
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _refl, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.reflection, vxValue);
+				setParameter(SurfaceParameter::REFL);
 				break;
 			case SurfaceSubChunkTag::TRAN: // Transparency
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _tran, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.transparency, vxValue);
+				setParameter(SurfaceParameter::TRAN);
 				break;
 			case SurfaceSubChunkTag::TRNL: // Translucency
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _trnl, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.translucency, vxValue);
+				setParameter(SurfaceParameter::TRNL);
 				break;
 			case SurfaceSubChunkTag::GLOS: // Specular glossiness
-				LWUtils::parseFloatVxValues(rawBuffer + offset, offset, _glossiness, vxValue);
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.glossiness, vxValue);
+				setParameter(SurfaceParameter::GLOS);
+				break;
+			case SurfaceSubChunkTag::SHRP: // Diffuse sharpness
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.sharpness, vxValue);
+				setParameter(SurfaceParameter::SHRP);
+				break;
+			case SurfaceSubChunkTag::BUMP: // Bump intensity
+				if (!containsValue(subChunk, sizeof(float))) break;
+				LWUtils::parseFloatVxValues(subChunk.data(position), position, _parameters.bump, vxValue);
+				setParameter(SurfaceParameter::BUMP);
 				break;
 			case SurfaceSubChunkTag::SMAN: // Max smoothing angle
-				LWUtils::parseFloatValue(rawBuffer + offset, offset, _maxSmoothingAngle);
+				if (!subChunk.contains(0, sizeof(float))) break;
+				LWUtils::parseFloatValue(subChunk.data(position), position, _parameters.maxSmoothingAngle);
+				setParameter(SurfaceParameter::SMAN);
 				break;
 			//case SurfaceSubChunkTag::BLOK:
 			//	break;
-			//case SurfaceSubChunkTag::SHRP:
-			//	break;
-			//case SurfaceSubChunkTag::BUMP:
-			//	break;
 			//case SurfaceSubChunkTag::SIDE:
 			//	break;
 			//case SurfaceSubChunkTag::RFOP:
@@ -118,11 +208,27 @@ void Surface::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
 			//case SurfaceSubChunkTag::VCOL:
 			//	break;
 			case SurfaceSubChunkTag::UNKNOWN:
-				offset += subChunkSize;
 				break;
 			default:
-				offset += subChunkSize;
 				break;
 		}
 	}
 }
+
+/// <summary>
+/// Check that a sub-chunk holds a value and the envelope index after it
+/// </summary>
+/// <param name="subChunk">Sub-chunk data, after its tag and size</param>
+/// <param name="valueLength">Bytes in the value</param>
+/// <returns>True if both can be read</returns>
+bool Surface::containsValue(BufferView subChunk, size_t valueLength) {
+	return subChunk.contains(valueLength, 2) && subChunk.contains(valueLength, CONVERT_VX_BYTES_LENGTH(subChunk.data(valueLength)));
+}
+
+/// <summary>
+/// Record that the chunk sets a parameter
+/// </summary>
+/// <param name="parameter">Surface parameter</param>
+void Surface::setParameter(SurfaceParameter parameter) {
+	_parameterMask |= 1u << unsigned(parameter);
+}
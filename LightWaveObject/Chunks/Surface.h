@@ -13,32 +13,34 @@ public:
 		float b;
 	};
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::SURF;
+
 	// Constructor
-	Surface() : Chunk(ChunkTag::SURF) { }
+	explicit Surface(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory), _name(memory), _source(memory) { }
 
 	// Getters
 	COLOR getColor();
 	COL12 getCol12Color();
+	const pmr::string& getName();
+	const SURFACE_PARAMETERS& getParameters();
+	const pmr::string& getSource();
+	bool hasParameter(SurfaceParameter parameter);
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	SURFACE_PARAMETERS inheritParameters(const SURFACE_PARAMETERS& sourceParameters);
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
 
 private:
 
 	// Private methods
+	static bool containsValue(BufferView subChunk, size_t valueLength);
+	void setParameter(SurfaceParameter parameter);
 
 	// Private data
-	COL12 _color {};
-	float _diff {1.0f};
-	float _lumi {};
-	float _spec {};
-	float _refl {};
-	float _tran {};
-	float _trnl {};
-	float _glossiness {};
-	float _sharpness {};
-	float _bump {};
-	float _maxSmoothingAngle {-1.0f};
-	unsigned _envIndex {};
+	pmr::string _name;				// Name the TAGS strings refer to the surface by
+	pmr::string _source;			// Name of the surface this one derives from, or empty
+	SURFACE_PARAMETERS _parameters;	// Values read from the chunk, or the defaults
+	unsigned _parameterMask {};		// Bit per SurfaceParameter the chunk sets
 };
 
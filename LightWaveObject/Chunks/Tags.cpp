@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "Tags.h"
 
 /// <summary>
@@ -6,27 +8,44 @@
 /// <returns>Description</returns>
 string Tags::getDescription() {
 	string desc = "";
-	for (string tag : tags_) {
-		desc = desc + tag + ", ";
+	for (const pmr::string& tag : tags_) {
+		desc = desc + tag.c_str() + ", ";
 	}
 	return desc;
 }
 
+/// <summary>
+/// Get the tag strings, which polygon tags refer to by index
+/// </summary>
+/// <returns>Tag strings, in file order</returns>
+const pmr::vector<pmr::string>& Tags::getTags() {
+	return tags_;
+}
+
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Tags::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Tags::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Count the strings first, so the list is allocated once
+	size_t numTags = 0;
+	for (size_t offset = LWO_CHUNK_DATA_OFFSET; offset < chunkBuffer.size(); numTags++) {
+		size_t stringLen = strnlen(chunkBuffer.data(offset), chunkBuffer.size() - offset) + 1;
+		offset += stringLen % 2 == 0 ? stringLen : stringLen + 1;
+	}
+	tags_.reserve(tags_.size() + numTags);
 
 	// Extract strings
 	size_t offset = LWO_CHUNK_DATA_OFFSET;
-	while (offset <= header.length) {
+	while (offset < chunkBuffer.size()) {
 
-		// Extract and store current string
-		string tag = string(rawBuffer + offset);
-		tags_.push_back(tag);
+		// Extract and store current string, which may be unterminated at the end of the chunk
+		const char* tag = chunkBuffer.data(offset);
+		size_t tagLength = strnlen(tag, chunkBuffer.size() - offset);
+		tags_.emplace_back(tag, tagLength);
 
 		// Seek to next string
-		unsigned stringLen = tag.length() + 1;
+		size_t stringLen = tagLength + 1;
 		offset += stringLen % 2 == 0 ? stringLen : stringLen + 1;
 	}
 }
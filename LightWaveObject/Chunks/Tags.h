@@ -6,16 +6,22 @@
 class Tags : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::TAGS;
+
 	// Constructor
-	Tags() : Chunk(ChunkTag::TAGS) { }
+	explicit Tags(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory), tags_(memory) { }
 
 	// Public methods
 	string getDescription();
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+
+	// Getters
+	const pmr::vector<pmr::string>& getTags();
 
 private:
 
 	// Private data
-	vector<string> tags_;
+	pmr::vector<pmr::string> tags_;
 };
 
@@ -3,5 +3,5 @@
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void Text::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void Text::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 }
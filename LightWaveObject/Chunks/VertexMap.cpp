@@ -1,7 +1,280 @@
+#include <algorithm>
+
 #include "VertexMap.h"
 
+/// <summary>
+/// Get chunk description
+/// </summary>
+/// <returns>Description</returns>
+string VertexMap::getDescription() {
+	return "Vertex map " + string(_name.data(), _name.size()) + ": " + to_string(_numMapped) + (_dense ? " dense" : " sparse");
+}
+
+/// <summary>
+/// Get the values of one point, looked up directly in a dense map or by
+/// binary search in a sparse one
+/// </summary>
+/// <param name="pointIndex">Point index in the layer</param>
+/// <param name="values">Receives getDimension() values</param>
+/// <returns>True if the map gives the point values</returns>
+bool VertexMap::getValue(uint32_t pointIndex, float values[]) {
+
+	size_t slot;
+	if (_dense) {
+		if (pointIndex >= getNumPoints()) return false;
+		if (!_mapped.empty() && !_mapped[pointIndex]) return false;
+		slot = pointIndex;
+	}
+	else {
+		auto found = lower_bound(_pointIndices.begin(), _pointIndices.end(), pointIndex);
+		if (found == _pointIndices.end() || *found != pointIndex) return false;
+		slot = size_t(found - _pointIndices.begin());
+	}
+
+	for (unsigned channel = 0; channel < _dimension; channel++) {
+		values[channel] = _channels[channel][slot];
+	}
+
+	return true;
+}
+
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void VertexMap::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void VertexMap::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Payload starts with the map type, the values per point and the map name
+	BufferView payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length);
+	if (!payload.contains(0, 6)) return;
+	_type = LWUtils::convertVertexMapTypeToEnum(CONVERT_BYTES_TO_FOURCC(payload.data()));
+	int dimension = CONVERT_U2_BYTES_TO_INT(payload.data(4));
+	_dimension = unsigned(dimension);
+	size_t nameLength = strnlen(payload.data(6), payload.size() - 6);
+	_name.assign(payload.data(6), nameLength);
+	size_t offset = 6 + nameLength + 1;
+	if (offset % 2 != 0) offset++;
+	if (_dimension > MAX_DIMENSION) return;
+
+	// Count the records and find the highest point first, so the map is allocated once
+	size_t valueLength = _dimension * 4;
+	size_t firstRecord = offset;
+	size_t numRecords = 0;
+	uint32_t numPoints = 0;
+	bool ascending = true;				// Each point follows the one before, so none repeats
+	while (payload.contains(offset, 2)) {
+
+		// Each record is a variable-length point index and the point's values
+		size_t recordLength = CONVERT_VX_BYTES_LENGTH(payload.data(offset)) + valueLength;
+		if (!payload.contains(offset, recordLength)) break;
+
+		uint32_t pointIndex = CONVERT_VX_BYTES_TO_INT(payload.data(offset));
+		if (pointIndex < numPoints) {
+			ascending = false;
+		}
+		else {
+			numPoints = pointIndex + 1;
+		}
+		numRecords++;
+		offset += recordLength;
+	}
+	if (numRecords == 0) return;
+
+	// Keep whichever layout is smaller: values for every point up to the
+	// highest mapped, or the mapped points and their values. A dense map is
+	// never larger than the sparse one would be, so either way the memory
+	// grows with the number of mapped points rather than the size of the layer
+	bool complete = ascending && numRecords == numPoints;
+	size_t denseBytes = size_t(numPoints) * valueLength + (complete ? 0 : numPoints / 8);
+	size_t sparseBytes = numRecords * (sizeof(uint32_t) + valueLength);
+	_dense = denseBytes <= sparseBytes;
+
+	_channels.resize(_dimension);
+	if (_dense) {
+		_numPoints = numPoints;
+		for (pmr::vector<float>& channel : _channels) {
+			channel.assign(numPoints, 0.0f);
+		}
+		if (!complete) {
+			_mapped.assign(numPoints, false);
+		}
+	}
+	else {
+		for (pmr::vector<float>& channel : _channels) {
+			channel.resize(numRecords);
+		}
+		_pointIndices.resize(numRecords);
+	}
+
+	decodeValues(payload, firstRecord, offset);
+
+	// Sparse values must be in point order to be searched
+	if (!_dense && !ascending) {
+		sortSparseValues();
+	}
+	if (complete) {
+		_numMapped = numPoints;
+	}
+	else if (!_dense) {
+		_numMapped = _pointIndices.size();
+	}
+}
+
+/// <summary>
+/// Get the number of points the map gives values
+/// </summary>
+/// <returns>Number of mapped points</returns>
+size_t VertexMap::size() {
+	return _numMapped;
+}
+
+/// <summary>
+/// Get one of the map's values for every mapped point, e.g. channel 1 of a
+/// TXUV map is V. A dense map's channels are indexed by point index, and a
+/// sparse map's by position in getPointIndices().
+/// </summary>
+/// <param name="channel">Channel, less than getDimension()</param>
+/// <returns>Channel values</returns>
+const pmr::vector<float>& VertexMap::getChannel(unsigned channel) {
+	return _channels[channel];
+}
+
+/// <summary>
+/// Get the number of values per point
+/// </summary>
+/// <returns>Dimension, e.g. 2 for a TXUV map</returns>
+unsigned VertexMap::getDimension() {
+	return _dimension;
+}
+
+/// <summary>
+/// Get the map name
+/// </summary>
+/// <returns>Name</returns>
+const pmr::string& VertexMap::getName() {
+	return _name;
+}
+
+/// <summary>
+/// Get the number of points a dense map has room for
+/// </summary>
+/// <returns>One past the highest mapped point, or zero for a sparse map</returns>
+size_t VertexMap::getNumPoints() {
+	return _numPoints;
+}
+
+/// <summary>
+/// Get the mapped points of a sparse map
+/// </summary>
+/// <returns>Point indices in ascending order, or an empty list for a dense map</returns>
+const pmr::vector<uint32_t>& VertexMap::getPointIndices() {
+	return _pointIndices;
+}
+
+/// <summary>
+/// Get the map type
+/// </summary>
+/// <returns>Type, e.g. TXUV</returns>
+VertexMapType VertexMap::getType() {
+	return _type;
+}
+
+/// <summary>
+/// Check how the map is stored
+/// </summary>
+/// <returns>True if the channels are indexed by point index</returns>
+bool VertexMap::isDense() {
+	return _dense;
+}
+
+/// <summary>
+/// Decode the records into the channels. Values are copied out of a block
+/// of records at a time, decoded in one run, then spread over the channels.
+/// </summary>
+/// <param name="payload">Chunk payload</param>
+/// <param name="offset">Offset of the first record</param>
+/// <param name="length">End of the last whole record</param>
+void VertexMap::decodeValues(BufferView payload, size_t offset, size_t length) {
+
+	const size_t BLOCK_FLOATS = 512;
+	char rawValues[BLOCK_FLOATS * 4];
+	float values[BLOCK_FLOATS];
+	uint32_t pointIndices[BLOCK_FLOATS];
+
+	float* channels[MAX_DIMENSION] {};
+	for (unsigned channel = 0; channel < _dimension; channel++) {
+		channels[channel] = _channels[channel].data();
+	}
+
+	size_t valueLength = _dimension * 4;
+	size_t recordsPerBlock = _dimension > 0 ? BLOCK_FLOATS / _dimension : BLOCK_FLOATS;
+	size_t position = 0;
+	while (offset < length) {
+
+		// Gather a block of records
+		size_t numBlockRecords = 0;
+		for (; offset < length && numBlockRecords < recordsPerBlock; numBlockRecords++) {
+			pointIndices[numBlockRecords] = CONVERT_VX_BYTES_TO_INT(payload.data(offset));
+			offset += CONVERT_VX_BYTES_LENGTH(payload.data(offset));
+			memcpy(rawValues + numBlockRecords * valueLength, payload.data(offset), valueLength);
+			offset += valueLength;
+		}
+		FloatDecoder::decodeFloats(rawValues, values, numBlockRecords * _dimension);
+
+		// Dense maps place values by point, sparse maps in file order
+		for (size_t record = 0; record < numBlockRecords; record++) {
+			uint32_t pointIndex = pointIndices[record];
+			size_t slot = pointIndex;
+			if (_dense) {
+				if (!_mapped.empty() && !_mapped[pointIndex]) {
+					_mapped[pointIndex] = true;
+					_numMapped++;
+				}
+			}
+			else {
+				slot = position++;
+				_pointIndices[slot] = pointIndex;
+			}
+			for (unsigned channel = 0; channel < _dimension; channel++) {
+				channels[channel][slot] = values[record * _dimension + channel];
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Put a sparse map's values in point order. Of several values for one
+/// point, the last in the file is kept, as in a dense map.
+/// </summary>
+void VertexMap::sortSparseValues() {
+
+	pmr::memory_resource* memory = getMemoryResource();
+	pmr::vector<uint32_t> order(_pointIndices.size(), memory);
+	for (size_t position = 0; position < order.size(); position++) {
+		order[position] = uint32_t(position);
+	}
+	stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return _pointIndices[a] < _pointIndices[b];
+	});
+
+	// Keep the last of each run of one point
+	size_t numUnique = 0;
+	for (size_t position = 0; position < order.size(); position++) {
+		bool last = position + 1 == order.size() || _pointIndices[order[position + 1]] != _pointIndices[order[position]];
+		if (last) order[numUnique++] = order[position];
+	}
+	order.resize(numUnique);
+
+	pmr::vector<uint32_t> pointIndices(numUnique, memory);
+	for (size_t position = 0; position < numUnique; position++) {
+		pointIndices[position] = _pointIndices[order[position]];
+	}
+	_pointIndices.swap(pointIndices);
+
+	for (pmr::vector<float>& channel : _channels) {
+		pmr::vector<float> sorted(numUnique, memory);
+		for (size_t position = 0; position < numUnique; position++) {
+			sorted[position] = channel[order[position]];
+		}
+		channel.swap(sorted);
+	}
 }
@@ -1,17 +1,49 @@
 #pragma once
 #include "Chunk.h"
+#include "../LWUtils.h"
+
 class VertexMap : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::VMAP;
+
+	// Most values per point decoded, e.g. 4 for RGBA; maps with more are skipped
+	static const unsigned MAX_DIMENSION = 4;
+
 	// Constructor
-	VertexMap() : Chunk(ChunkTag::VMAP) { }
+	explicit VertexMap(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory), _name(memory),
+		_channels(memory), _pointIndices(memory), _mapped(memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	string getDescription() override;
+	bool getValue(uint32_t pointIndex, float values[]);
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+	size_t size();
+
+	// Getters
+	const pmr::vector<float>& getChannel(unsigned channel);
+	unsigned getDimension();
+	const pmr::string& getName();
+	size_t getNumPoints();
+	const pmr::vector<uint32_t>& getPointIndices();
+	VertexMapType getType();
+	bool isDense();
 
 private:
 
-	// Private data
+	// Private methods
+	void decodeValues(BufferView payload, size_t offset, size_t length);
+	void sortSparseValues();
 
+	// Private data
+	VertexMapType _type = VertexMapType::UNKNOWN;
+	unsigned _dimension {};				// Values per point, e.g. 2 for UVs
+	pmr::string _name;
+	bool _dense {};						// Channels are indexed by point rather than by position in _pointIndices
+	size_t _numMapped {};				// Points the map gives values
+	size_t _numPoints {};				// Dense maps only: one past the highest mapped point
+	pmr::vector<pmr::vector<float>> _channels;	// One array per value, e.g. U and V
+	pmr::vector<uint32_t> _pointIndices;	// Sparse maps only: point of each value, ascending
+	pmr::vector<bool> _mapped;			// Dense maps only: whether each point has values, or empty if all do
 };
-
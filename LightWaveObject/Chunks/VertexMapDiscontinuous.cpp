@@ -3,5 +3,5 @@
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void VertexMapDiscontinuous::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void VertexMapDiscontinuous::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
 }
@@ -1,7 +1,29 @@
 #include "VertexMapParameter.h"
 
+/// <summary>
+/// Get the color the map is drawn in
+/// </summary>
+/// <returns>Sketch color index</returns>
+int VertexMapParameter::getSketchColor() {
+	return _sketchColor;
+}
+
+/// <summary>
+/// Get how subdivision surfaces interpolate the preceding UV map
+/// </summary>
+/// <returns>UV subdivision type</returns>
+int VertexMapParameter::getUVSubdivisionType() {
+	return _uvSubdivisionType;
+}
+
 /// <summary>
 /// Parse the raw chunk data
 /// </summary>
-void VertexMapParameter::parse(char rawBuffer[], LWO_CHUNK_HEADER header) {
+void VertexMapParameter::parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) {
+
+	// Two I4 values
+	BufferView payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length);
+	if (!payload.contains(0, 8)) return;
+	_uvSubdivisionType = CONVERT_U4_BYTES_TO_INT(payload.data(0));
+	_sketchColor = CONVERT_U4_BYTES_TO_INT(payload.data(4));
 }
@@ -3,15 +3,23 @@
 class VertexMapParameter : public Chunk {
 public:
 
+	// Chunk type tag
+	static constexpr ChunkTag TAG = ChunkTag::VMPA;
+
 	// Constructor
-	VertexMapParameter() : Chunk(ChunkTag::VMPA) { }
+	explicit VertexMapParameter(pmr::memory_resource* memory = pmr::get_default_resource()) : Chunk(TAG, memory) { }
 
 	// Public methods
-	void parse(char rawBuffer[], LWO_CHUNK_HEADER header) override;
+	void parse(BufferView chunkBuffer, LWO_CHUNK_HEADER header) override;
+
+	// Getters
+	int getSketchColor();
+	int getUVSubdivisionType();
 
 private:
 
 	// Private data
-
+	int _uvSubdivisionType {};		// How subdivision interpolates the UVs of the preceding map
+	int _sketchColor {};			// Index of the color the map is drawn in
 };
 
@@ -0,0 +1,200 @@
+//
+// ContentHash class
+//
+// 64-bit non-cryptographic hash of object file contents, used to identify
+// files and chunks for caching, duplicate detection and change detection.
+// The algorithm is XXH64, so hashes are stable across runs, builds and
+// platforms and match other XXH64 implementations. Input can be hashed in
+// one call or fed in pieces, giving the same result either way.
+//
+#include <string.h>
+
+#include "ContentHash.h"
+
+namespace {
+
+	// XXH64 primes
+	const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+	const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+	const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+	const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+	inline uint64_t rotateLeft(uint64_t value, int bits) {
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	// Little-endian loads; every supported platform is little-endian
+	inline uint64_t read64(const char* data) {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t read32(const char* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Mix eight bytes of input into a lane
+	inline uint64_t mixLane(uint64_t lane, uint64_t input) {
+		lane += input * PRIME2;
+		lane = rotateLeft(lane, 31);
+		return lane * PRIME1;
+	}
+
+	// Fold a lane into the final hash
+	inline uint64_t mergeRound(uint64_t hash, uint64_t lane) {
+		hash ^= mixLane(0, lane);
+		return hash * PRIME1 + PRIME4;
+	}
+}
+
+/// <summary>
+/// Start an empty hash
+/// </summary>
+/// <param name="seed">Seed, giving an independent family of hashes</param>
+ContentHash::ContentHash(uint64_t seed) : _seed { seed } {
+	_lanes[0] = seed + PRIME1 + PRIME2;
+	_lanes[1] = seed + PRIME2;
+	_lanes[2] = seed;
+	_lanes[3] = seed - PRIME1;
+}
+
+/// <summary>
+/// Hash a block of bytes
+/// </summary>
+/// <param name="data">Bytes to hash</param>
+/// <param name="length">Number of bytes</param>
+/// <param name="seed">Seed</param>
+/// <returns>64-bit hash</returns>
+uint64_t ContentHash::hash(const void* data, size_t length, uint64_t seed) {
+	ContentHash hasher(seed);
+	hasher.update(data, length);
+	return hasher.digest();
+}
+
+/// <summary>
+/// Hash the bytes of a view
+/// </summary>
+/// <param name="buffer">Bytes to hash</param>
+/// <param name="seed">Seed</param>
+/// <returns>64-bit hash</returns>
+uint64_t ContentHash::hash(BufferView buffer, uint64_t seed) {
+	return hash(buffer.data(), buffer.size(), seed);
+}
+
+/// <summary>
+/// Get the hash of everything added so far. More input can still be added.
+/// </summary>
+/// <returns>64-bit hash</returns>
+uint64_t ContentHash::digest() const {
+
+	// Combine the lanes, or start from the seed if a full stripe was never seen
+	uint64_t hash;
+	if (_totalLength >= STRIPE_SIZE) {
+		hash = rotateLeft(_lanes[0], 1) + rotateLeft(_lanes[1], 7) + rotateLeft(_lanes[2], 12) + rotateLeft(_lanes[3], 18);
+		for (uint64_t lane : _lanes) {
+			hash = mergeRound(hash, lane);
+		}
+	}
+	else {
+		hash = _seed + PRIME5;
+	}
+	hash += _totalLength;
+
+	// Remaining input, eight, four and then one byte at a time
+	const char* data = _stripe;
+	const char* end = _stripe + _stripeLength;
+	for (; data + 8 <= end; data += 8) {
+		hash ^= mixLane(0, read64(data));
+		hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+	}
+	if (data + 4 <= end) {
+		hash ^= uint64_t(read32(data)) * PRIME1;
+		hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+		data += 4;
+	}
+	for (; data < end; data++) {
+		hash ^= uint64_t((unsigned char)*data) * PRIME5;
+		hash = rotateLeft(hash, 11) * PRIME1;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+/// <summary>
+/// Add bytes to the hash
+/// </summary>
+/// <param name="data">Bytes to add</param>
+/// <param name="length">Number of bytes</param>
+void ContentHash::update(const void* data, size_t length) {
+
+	const char* input = (const char*)data;
+	const char* end = input + length;
+	_totalLength += length;
+
+	// Top up a partial stripe left by the previous call
+	if (_stripeLength > 0) {
+		size_t count = STRIPE_SIZE - _stripeLength;
+		if (count > length) count = length;
+		memcpy(_stripe + _stripeLength, input, count);
+		_stripeLength += count;
+		input += count;
+
+		if (_stripeLength < STRIPE_SIZE) return;
+		consumeStripes(_stripe, _stripe + STRIPE_SIZE);
+		_stripeLength = 0;
+	}
+
+	// Whole stripes straight from the input
+	input = consumeStripes(input, end);
+
+	// Keep the tail for the next call or the digest
+	_stripeLength = size_t(end - input);
+	if (_stripeLength > 0) memcpy(_stripe, input, _stripeLength);
+}
+
+/// <summary>
+/// Add a 64-bit value to the hash, in little-endian byte order
+/// </summary>
+/// <param name="value">Value to add</param>
+void ContentHash::update(uint64_t value) {
+	char bytes[sizeof(value)];
+	for (size_t index = 0; index < sizeof(value); index++) {
+		bytes[index] = char(value >> (index * 8));
+	}
+	update(bytes, sizeof(bytes));
+}
+
+/// <summary>
+/// Mix whole stripes into the lanes
+/// </summary>
+/// <param name="data">Start of input</param>
+/// <param name="end">End of input</param>
+/// <returns>Start of the input left over after the last whole stripe</returns>
+const char* ContentHash::consumeStripes(const char* data, const char* end) {
+
+	// Work on locals so the lanes stay in registers
+	uint64_t lane0 = _lanes[0], lane1 = _lanes[1], lane2 = _lanes[2], lane3 = _lanes[3];
+	for (; end - data >= ptrdiff_t(STRIPE_SIZE); data += STRIPE_SIZE) {
+		lane0 = mixLane(lane0, read64(data));
+		lane1 = mixLane(lane1, read64(data + 8));
+		lane2 = mixLane(lane2, read64(data + 16));
+		lane3 = mixLane(lane3, read64(data + 24));
+	}
+	_lanes[0] = lane0;
+	_lanes[1] = lane1;
+	_lanes[2] = lane2;
+	_lanes[3] = lane3;
+
+	return data;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BufferView.h"
+
+class ContentHash {
+public:
+
+	// Constructor
+	explicit ContentHash(uint64_t seed = 0);
+
+	// Static methods
+	static uint64_t hash(const void* data, size_t length, uint64_t seed = 0);
+	static uint64_t hash(BufferView buffer, uint64_t seed = 0);
+
+	// Public methods
+	uint64_t digest() const;
+	void update(const void* data, size_t length);
+	void update(uint64_t value);
+
+private:
+
+	// Bytes consumed by one pass over the four lanes
+	static const size_t STRIPE_SIZE = 32;
+
+	// Private methods
+	const char* consumeStripes(const char* data, const char* end);
+
+	// Private data
+	uint64_t _seed;
+	uint64_t _lanes[4];
+	uint64_t _totalLength {};
+	char _stripe[STRIPE_SIZE];			// Input not yet consumed by the lanes
+	size_t _stripeLength {};
+};
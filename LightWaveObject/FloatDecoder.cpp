@@ -0,0 +1,229 @@
+//
+// FloatDecoder class
+//
+// Converts runs of big-endian IEEE floats from the object file to native
+// floats. The widest kernel the CPU supports is picked at runtime:
+//
+// - AVX2: 32 bytes per shuffle
+// - SSSE3: 16 bytes per shuffle
+// - Scalar: one float at a time, also used for the tail of each run
+//
+#include <stdint.h>
+#include <string.h>
+
+#include "FloatDecoder.h"
+
+// SIMD kernels are only available on x86 and x64
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FLOAT_DECODER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need per-function target attributes for the wider kernels
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+	/// <summary>
+	/// Decode floats one at a time
+	/// </summary>
+	void decodeScalar(const char source[], float* destination, size_t count) {
+		for (size_t index = 0; index < count; index++) {
+			uint32_t value;
+			memcpy(&value, source + index * 4, 4);
+			value = (value >> 24) | ((value >> 8) & 0x0000ff00) | ((value << 8) & 0x00ff0000) | (value << 24);
+			memcpy(destination + index, &value, 4);
+		}
+	}
+
+#ifdef FLOAT_DECODER_X86
+
+	/// <summary>
+	/// Decode four floats per shuffle
+	/// </summary>
+	TARGET_SSSE3 void decodeSSSE3(const char source[], float* destination, size_t count) {
+
+		const __m128i swapMask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+		size_t index = 0;
+		for (; index + 4 <= count; index += 4) {
+			__m128i value = _mm_loadu_si128((const __m128i*)(source + index * 4));
+			_mm_storeu_si128((__m128i*)(destination + index), _mm_shuffle_epi8(value, swapMask));
+		}
+
+		// Remaining floats
+		decodeScalar(source + index * 4, destination + index, count - index);
+	}
+
+	/// <summary>
+	/// Decode sixteen floats per loop using two shuffles
+	/// </summary>
+	TARGET_AVX2 void decodeAVX2(const char source[], float* destination, size_t count) {
+
+		const __m256i swapMask = _mm256_setr_epi8(
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+		size_t index = 0;
+		for (; index + 16 <= count; index += 16) {
+			__m256i value1 = _mm256_loadu_si256((const __m256i*)(source + index * 4));
+			__m256i value2 = _mm256_loadu_si256((const __m256i*)(source + index * 4 + 32));
+			_mm256_storeu_si256((__m256i*)(destination + index), _mm256_shuffle_epi8(value1, swapMask));
+			_mm256_storeu_si256((__m256i*)(destination + index + 8), _mm256_shuffle_epi8(value2, swapMask));
+		}
+
+		// Remaining floats
+		decodeSSSE3(source + index * 4, destination + index, count - index);
+	}
+
+	/// <summary>
+	/// Check whether the CPU and OS support AVX2
+	/// </summary>
+	bool cpuHasAVX2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// OS must save YMM registers
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	/// <summary>
+	/// Check whether the CPU supports SSSE3
+	/// </summary>
+	bool cpuHasSSSE3() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+#else
+		return __builtin_cpu_supports("ssse3");
+#endif
+	}
+
+#endif
+
+	/// <summary>
+	/// Kernel in use, initialized to the best one available
+	/// </summary>
+	FloatDecoder::Kernel& currentKernel() {
+		static FloatDecoder::Kernel kernel = FloatDecoder::getBestKernel();
+		return kernel;
+	}
+}
+
+/// <summary>
+/// Decode a run of big-endian floats
+/// </summary>
+/// <param name="source">Raw big-endian floats</param>
+/// <param name="destination">Native floats, which must not overlap the source</param>
+/// <param name="count">Number of floats</param>
+void FloatDecoder::decodeFloats(const char source[], float* destination, size_t count) {
+	switch (currentKernel()) {
+#ifdef FLOAT_DECODER_X86
+		case Kernel::AVX2:
+			decodeAVX2(source, destination, count);
+			return;
+		case Kernel::SSSE3:
+			decodeSSSE3(source, destination, count);
+			return;
+#endif
+		default:
+			decodeScalar(source, destination, count);
+			return;
+	}
+}
+
+/// <summary>
+/// Decode a run of big-endian VEC12 values into separate X, Y and Z arrays
+/// </summary>
+/// <param name="source">Raw big-endian VEC12 values</param>
+/// <param name="count">Number of VEC12 values</param>
+/// <param name="x">X components</param>
+/// <param name="y">Y components</param>
+/// <param name="z">Z components</param>
+void FloatDecoder::decodeVec12SoA(const char source[], size_t count, float* x, float* y, float* z) {
+
+	// Decode a cache-sized block at a time, then split the components
+	const size_t BLOCK_SIZE = 256;
+	float block[BLOCK_SIZE * 3];
+
+	for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+		size_t blockCount = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+		decodeFloats(source + start * 12, block, blockCount * 3);
+
+		for (size_t index = 0; index < blockCount; index++) {
+			x[start + index] = block[index * 3 + 0];
+			y[start + index] = block[index * 3 + 1];
+			z[start + index] = block[index * 3 + 2];
+		}
+	}
+}
+
+/// <summary>
+/// Get the fastest kernel this CPU supports
+/// </summary>
+/// <returns>Best kernel</returns>
+FloatDecoder::Kernel FloatDecoder::getBestKernel() {
+#ifdef FLOAT_DECODER_X86
+	if (cpuHasAVX2()) return Kernel::AVX2;
+	if (cpuHasSSSE3()) return Kernel::SSSE3;
+#endif
+	return Kernel::Scalar;
+}
+
+/// <summary>
+/// Get the kernel in use
+/// </summary>
+/// <returns>Current kernel</returns>
+FloatDecoder::Kernel FloatDecoder::getKernel() {
+	return currentKernel();
+}
+
+/// <summary>
+/// Get a kernel's display name
+/// </summary>
+/// <param name="kernel">Kernel</param>
+/// <returns>Kernel name</returns>
+const char* FloatDecoder::getKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::AVX2: return "AVX2";
+		case Kernel::SSSE3: return "SSSE3";
+		default: return "Scalar";
+	}
+}
+
+/// <summary>
+/// Force a kernel, e.g. for benchmarking; not thread safe while decoding
+/// </summary>
+/// <param name="kernel">Kernel to use</param>
+/// <returns>False if the CPU doesn't support the kernel</returns>
+bool FloatDecoder::setKernel(Kernel kernel) {
+
+	// Kernels are ordered, so anything up to the best one is supported
+	if ((int)kernel > (int)getBestKernel()) {
+		return false;
+	}
+
+	currentKernel() = kernel;
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+
+class FloatDecoder {
+public:
+
+	// Decode kernels, from slowest to fastest
+	enum class Kernel { Scalar, SSSE3, AVX2 };
+
+	// Static methods
+	static void decodeFloats(const char source[], float* destination, size_t count);
+	static void decodeVec12SoA(const char source[], size_t count, float* x, float* y, float* z);
+
+	// Kernel selection
+	static Kernel getBestKernel();
+	static Kernel getKernel();
+	static const char* getKernelName(Kernel kernel);
+	static bool setKernel(Kernel kernel);
+};
@@ -0,0 +1,151 @@
+//
+// HardwareCounters class
+//
+// Counts cycles, instructions, cache misses and branch misses on the calling
+// thread, to tell whether a load phase is bound by memory, branches or plain
+// work. The counters run as one perf_event_open group so they cover the same
+// intervals; if the kernel multiplexes the group, counts are scaled up by the
+// share of time it ran.
+//
+#include "HardwareCounters.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+namespace {
+
+	// Hardware events, in the order of the HARDWARE_COUNTS fields
+	const uint64_t EVENT_CONFIGS[] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES,
+	};
+
+	/// <summary>
+	/// Explain why a counter couldn't be opened
+	/// </summary>
+	/// <param name="error">errno from perf_event_open</param>
+	/// <returns>Reason for the failure</returns>
+	wstring getOpenErrorReason(int error) {
+		switch (error) {
+			case EACCES:
+			case EPERM:
+				return L"Hardware counters aren't permitted; lower /proc/sys/kernel/perf_event_paranoid or run with CAP_PERFMON";
+			case ENOENT:
+			case EOPNOTSUPP:
+			case EINVAL:
+				return L"Hardware counters aren't supported by this CPU or virtual machine";
+			case ENOSYS:
+				return L"The kernel doesn't support perf events";
+		}
+		return L"Couldn't open the hardware counters";
+	}
+}
+#endif
+
+/// <summary>
+/// Close the counters
+/// </summary>
+HardwareCounters::~HardwareCounters() {
+	close();
+}
+
+/// <summary>
+/// Stop counting and release the counters
+/// </summary>
+void HardwareCounters::close() {
+#ifdef __linux__
+	for (int& file : _files) {
+		if (file >= 0) ::close(file);
+		file = -1;
+	}
+#endif
+}
+
+/// <summary>
+/// Start counting on the calling thread. Either every counter opens or none do.
+/// </summary>
+/// <param name="errorReason">Reason the counters are unavailable</param>
+/// <returns>True if the counters are running</returns>
+bool HardwareCounters::open(wstring& errorReason) {
+
+	close();
+
+#ifdef __linux__
+	for (size_t counter = 0; counter < NUM_COUNTERS; counter++) {
+
+		// User-space events of this thread on any CPU, read through the leader
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = EVENT_CONFIGS[counter];
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		_files[counter] = int(syscall(SYS_perf_event_open, &attributes, 0, -1, counter == 0 ? -1 : _files[0], 0));
+		if (_files[counter] < 0) {
+			errorReason = getOpenErrorReason(errno);
+			close();
+			return false;
+		}
+	}
+
+	return true;
+#else
+	errorReason = L"Hardware counters are only supported on Linux";
+	return false;
+#endif
+}
+
+/// <summary>
+/// Read the counts so far; subtract two reads to count an interval
+/// </summary>
+/// <returns>Counts since the counters were opened, or zero if they aren't open</returns>
+HARDWARE_COUNTS HardwareCounters::read() const {
+
+	HARDWARE_COUNTS counts;
+
+#ifdef __linux__
+	if (!isOpen()) return counts;
+
+	// Group read: number of counters, times enabled and running, then each value
+	uint64_t values[3 + NUM_COUNTERS];
+	if (::read(_files[0], values, sizeof(values)) != ssize_t(sizeof(values)) || values[0] != NUM_COUNTERS) {
+		return counts;
+	}
+
+	// Scale up counts from a multiplexed group
+	uint64_t enabled = values[1];
+	uint64_t running = values[2];
+	auto scale = [&](uint64_t value) {
+		if (running == 0) return uint64_t(0);
+		return running < enabled ? uint64_t(double(value) * enabled / running) : value;
+	};
+
+	counts.cycles = scale(values[3]);
+	counts.instructions = scale(values[4]);
+	counts.cacheMisses = scale(values[5]);
+	counts.branchMisses = scale(values[6]);
+#endif
+
+	return counts;
+}
+
+/// <summary>
+/// Check whether the counters are running
+/// </summary>
+/// <returns>True once opened successfully</returns>
+bool HardwareCounters::isOpen() const {
+	return _files[0] >= 0;
+}
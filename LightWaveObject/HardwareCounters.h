@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+// Counts of CPU events on one thread
+struct HARDWARE_COUNTS {
+	uint64_t cycles = 0;
+	uint64_t instructions = 0;
+	uint64_t cacheMisses = 0;			// Last level cache
+	uint64_t branchMisses = 0;
+};
+
+// Reads the CPU's performance counters for the thread that opened them.
+// Only available on Linux, through perf_event_open; elsewhere, and where the
+// kernel or container doesn't allow it, opening fails and reads give zero.
+class HardwareCounters {
+public:
+
+	// Constructor
+	HardwareCounters() = default;
+	~HardwareCounters();
+
+	HardwareCounters(const HardwareCounters&) = delete;
+	HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+	// Public methods
+	void close();
+	bool open(std::wstring& errorReason);
+	HARDWARE_COUNTS read() const;
+
+	// Getters
+	bool isOpen() const;
+
+private:
+
+	// Counters read together as one group
+	static const size_t NUM_COUNTERS = 4;
+
+	// Private data
+	int _files[NUM_COUNTERS] { -1, -1, -1, -1 };		// Group leader first
+};
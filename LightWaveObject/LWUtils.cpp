@@ -1,26 +1,28 @@
 #include "LWUtils.h"
 
 /// <summary>
-/// Convert chunk tag string to equivalent enum
+/// Convert chunk tag to equivalent enum
 /// </summary>
 /// <param name="tag">Tag ID</param>
 /// <returns>Tag enum</returns>
-ChunkTag LWUtils::convertTagStringTagToEnum(string tag) {
-	if(tag=="LAYR") return ChunkTag::LAYR; // 0
-	if(tag=="PNTS") return ChunkTag::PNTS; // 1
-	if(tag=="VMAP") return ChunkTag::VMAP; // 2
-	if(tag=="POLS") return ChunkTag::POLS; // 3
-	if(tag=="TAGS") return ChunkTag::TAGS; // 4
-	if(tag=="PTAG") return ChunkTag::PTAG; // 5
-	if(tag=="VMAD") return ChunkTag::VMAD; // 6
-	if(tag=="VMPA") return ChunkTag::VMPA; // 7
-	if(tag=="ENVL") return ChunkTag::ENVL; // 8
-	if(tag=="CLIP") return ChunkTag::CLIP; // 9
-	if(tag=="SURF") return ChunkTag::SURF; // 10
-	if(tag=="BBOX") return ChunkTag::BBOX; // 11
-	if(tag=="DESC") return ChunkTag::DESC; // 12
-	if(tag=="TEXT") return ChunkTag::TEXT; // 13
-	if(tag=="ICON") return ChunkTag::ICON; // 14
+ChunkTag LWUtils::convertChunkTagToEnum(FOURCC tag) {
+	switch (tag) {
+		case MAKE_FOURCC("LAYR"): return ChunkTag::LAYR; // 0
+		case MAKE_FOURCC("PNTS"): return ChunkTag::PNTS; // 1
+		case MAKE_FOURCC("VMAP"): return ChunkTag::VMAP; // 2
+		case MAKE_FOURCC("POLS"): return ChunkTag::POLS; // 3
+		case MAKE_FOURCC("TAGS"): return ChunkTag::TAGS; // 4
+		case MAKE_FOURCC("PTAG"): return ChunkTag::PTAG; // 5
+		case MAKE_FOURCC("VMAD"): return ChunkTag::VMAD; // 6
+		case MAKE_FOURCC("VMPA"): return ChunkTag::VMPA; // 7
+		case MAKE_FOURCC("ENVL"): return ChunkTag::ENVL; // 8
+		case MAKE_FOURCC("CLIP"): return ChunkTag::CLIP; // 9
+		case MAKE_FOURCC("SURF"): return ChunkTag::SURF; // 10
+		case MAKE_FOURCC("BBOX"): return ChunkTag::BBOX; // 11
+		case MAKE_FOURCC("DESC"): return ChunkTag::DESC; // 12
+		case MAKE_FOURCC("TEXT"): return ChunkTag::TEXT; // 13
+		case MAKE_FOURCC("ICON"): return ChunkTag::ICON; // 14
+	}
 
 	return ChunkTag::UNKNOWN;
 }
@@ -50,53 +52,150 @@ string LWUtils::convertTagEnumToString(ChunkTag tagEnum) {
 	return "UNKNOWN";
 }
 
+/// <summary>
+/// Convert polygon type to equivalent enum
+/// </summary>
+/// <param name="type">Polygon type ID</param>
+/// <returns>Polygon type enum</returns>
+PolygonType LWUtils::convertPolygonTypeToEnum(FOURCC type) {
+	switch (type) {
+		case MAKE_FOURCC("FACE"): return PolygonType::FACE; // 0
+		case MAKE_FOURCC("CURV"): return PolygonType::CURV; // 1
+		case MAKE_FOURCC("PTCH"): return PolygonType::PTCH; // 2
+		case MAKE_FOURCC("MBAL"): return PolygonType::MBAL; // 3
+		case MAKE_FOURCC("BONE"): return PolygonType::BONE; // 4
+		case MAKE_FOURCC("SUBD"): return PolygonType::SUBD; // 5
+	}
+
+	return PolygonType::UNKNOWN;
+}
+
+/// <summary>
+/// Convert polygon tag type to equivalent enum
+/// </summary>
+/// <param name="type">Polygon tag type ID</param>
+/// <returns>Polygon tag type enum</returns>
+PolygonTagType LWUtils::convertPolygonTagTypeToEnum(FOURCC type) {
+	switch (type) {
+		case MAKE_FOURCC("SURF"): return PolygonTagType::SURF; // 0
+		case MAKE_FOURCC("PART"): return PolygonTagType::PART; // 1
+		case MAKE_FOURCC("SMGP"): return PolygonTagType::SMGP; // 2
+		case MAKE_FOURCC("COLR"): return PolygonTagType::COLR; // 3
+	}
+
+	return PolygonTagType::UNKNOWN;
+}
+
 /// <summary>
 /// Convert surface sub-chunk tag to equivalent enum
 /// </summary>
-/// <param name="tag">Tag string</param>
+/// <param name="tag">Tag ID</param>
 /// <returns>Tag enum</returns>
-SurfaceSubChunkTag LWUtils::convertSurfaceTagStringToEnum(string tag) {
-
-	if (tag == "COLR") return SurfaceSubChunkTag::COLR; // 0
-	if (tag == "DIFF") return SurfaceSubChunkTag::DIFF; // 1
-	if (tag == "LUMI") return SurfaceSubChunkTag::LUMI; // 2
-	if (tag == "SPEC") return SurfaceSubChunkTag::SPEC; // 3
-	if (tag == "REFL") return SurfaceSubChunkTag::REFL; // 4
-	if (tag == "TRAN") return SurfaceSubChunkTag::TRAN; // 5
-	if (tag == "TRNL") return SurfaceSubChunkTag::TRNL; // 6
-	if (tag == "GLOS") return SurfaceSubChunkTag::GLOS; // 7
-	if (tag == "BLOK") return SurfaceSubChunkTag::BLOK; // 8
-	if (tag == "SHRP") return SurfaceSubChunkTag::SHRP; // 9
-	if (tag == "BUMP") return SurfaceSubChunkTag::BUMP; // 10
-	if (tag == "SIDE") return SurfaceSubChunkTag::SIDE; // 11
-	if (tag == "SMAN") return SurfaceSubChunkTag::SMAN; // 12
-	if (tag == "RFOP") return SurfaceSubChunkTag::RFOP; // 13
-	if (tag == "RIMG") return SurfaceSubChunkTag::RIMG; // 14
-	if (tag == "RSAN") return SurfaceSubChunkTag::RSAN; // 15
-	if (tag == "RBLR") return SurfaceSubChunkTag::RBLR; // 16
-	if (tag == "RIND") return SurfaceSubChunkTag::RIND; // 17
-	if (tag == "TROP") return SurfaceSubChunkTag::TROP; // 18
-	if (tag == "TIMG") return SurfaceSubChunkTag::TIMG; // 19
-	if (tag == "TBLR") return SurfaceSubChunkTag::TBLR; // 20
-	if (tag == "CLRH") return SurfaceSubChunkTag::CLRH; // 21
-	if (tag == "CLRF") return SurfaceSubChunkTag::CLRF; // 22
-	if (tag == "ADTR") return SurfaceSubChunkTag::ADTR; // 23
-	if (tag == "GLOW") return SurfaceSubChunkTag::GLOW; // 24
-	if (tag == "LINE") return SurfaceSubChunkTag::LINE; // 25
-	if (tag == "ALPH") return SurfaceSubChunkTag::ALPH; // 26
-	if (tag == "VCOL") return SurfaceSubChunkTag::VCOL; // 27
+SurfaceSubChunkTag LWUtils::convertSurfaceTagToEnum(FOURCC tag) {
+	switch (tag) {
+		case MAKE_FOURCC("COLR"): return SurfaceSubChunkTag::COLR; // 0
+		case MAKE_FOURCC("DIFF"): return SurfaceSubChunkTag::DIFF; // 1
+		case MAKE_FOURCC("LUMI"): return SurfaceSubChunkTag::LUMI; // 2
+		case MAKE_FOURCC("SPEC"): return SurfaceSubChunkTag::SPEC; // 3
+		case MAKE_FOURCC("REFL"): return SurfaceSubChunkTag::REFL; // 4
+		case MAKE_FOURCC("TRAN"): return SurfaceSubChunkTag::TRAN; // 5
+		case MAKE_FOURCC("TRNL"): return SurfaceSubChunkTag::TRNL; // 6
+		case MAKE_FOURCC("GLOS"): return SurfaceSubChunkTag::GLOS; // 7
+		case MAKE_FOURCC("BLOK"): return SurfaceSubChunkTag::BLOK; // 8
+		case MAKE_FOURCC("SHRP"): return SurfaceSubChunkTag::SHRP; // 9
+		case MAKE_FOURCC("BUMP"): return SurfaceSubChunkTag::BUMP; // 10
+		case MAKE_FOURCC("SIDE"): return SurfaceSubChunkTag::SIDE; // 11
+		case MAKE_FOURCC("SMAN"): return SurfaceSubChunkTag::SMAN; // 12
+		case MAKE_FOURCC("RFOP"): return SurfaceSubChunkTag::RFOP; // 13
+		case MAKE_FOURCC("RIMG"): return SurfaceSubChunkTag::RIMG; // 14
+		case MAKE_FOURCC("RSAN"): return SurfaceSubChunkTag::RSAN; // 15
+		case MAKE_FOURCC("RBLR"): return SurfaceSubChunkTag::RBLR; // 16
+		case MAKE_FOURCC("RIND"): return SurfaceSubChunkTag::RIND; // 17
+		case MAKE_FOURCC("TROP"): return SurfaceSubChunkTag::TROP; // 18
+		case MAKE_FOURCC("TIMG"): return SurfaceSubChunkTag::TIMG; // 19
+		case MAKE_FOURCC("TBLR"): return SurfaceSubChunkTag::TBLR; // 20
+		case MAKE_FOURCC("CLRH"): return SurfaceSubChunkTag::CLRH; // 21
+		case MAKE_FOURCC("CLRF"): return SurfaceSubChunkTag::CLRF; // 22
+		case MAKE_FOURCC("ADTR"): return SurfaceSubChunkTag::ADTR; // 23
+		case MAKE_FOURCC("GLOW"): return SurfaceSubChunkTag::GLOW; // 24
+		case MAKE_FOURCC("LINE"): return SurfaceSubChunkTag::LINE; // 25
+		case MAKE_FOURCC("ALPH"): return SurfaceSubChunkTag::ALPH; // 26
+		case MAKE_FOURCC("VCOL"): return SurfaceSubChunkTag::VCOL; // 27
+	}
 
 	return SurfaceSubChunkTag::UNKNOWN;
 }
 
+/// <summary>
+/// Convert vertex map type to equivalent enum
+/// </summary>
+/// <param name="type">Vertex map type ID</param>
+/// <returns>Vertex map type enum</returns>
+VertexMapType LWUtils::convertVertexMapTypeToEnum(FOURCC type) {
+	switch (type) {
+		case MAKE_FOURCC("PICK"): return VertexMapType::PICK; // 0
+		case MAKE_FOURCC("WGHT"): return VertexMapType::WGHT; // 1
+		case MAKE_FOURCC("MNVW"): return VertexMapType::MNVW; // 2
+		case MAKE_FOURCC("TXUV"): return VertexMapType::TXUV; // 3
+		case MAKE_FOURCC("RGB "): return VertexMapType::RGB;  // 4
+		case MAKE_FOURCC("RGBA"): return VertexMapType::RGBA; // 5
+		case MAKE_FOURCC("MORF"): return VertexMapType::MORF; // 6
+		case MAKE_FOURCC("SPOT"): return VertexMapType::SPOT; // 7
+		case MAKE_FOURCC("NORM"): return VertexMapType::NORM; // 8
+	}
+
+	return VertexMapType::UNKNOWN;
+}
+
+/// <summary>
+/// Parse chunk header
+/// </summary>
+/// <param name="rawBuffer">Raw file buffer</param>
+/// <returns>Cooked header</returns>
+LWO_CHUNK_HEADER LWUtils::parseChunkHeader(const char rawBuffer[]) {
+
+	LWO_CHUNK_HEADER_RAW rawHeader;
+	LWO_CHUNK_HEADER cookedHeader;
+
+	// Copy raw header
+	memcpy(&rawHeader, rawBuffer, sizeof(LWO_CHUNK_HEADER_RAW));
+
+	// Parse fields
+	cookedHeader.tag = LWUtils::convertChunkTagToEnum(CONVERT_BYTES_TO_FOURCC(rawHeader.tag));
+	cookedHeader.length = CONVERT_U4_BYTES_TO_INT(rawHeader.length);
+
+	return cookedHeader;
+}
+
+/// <summary>
+/// Parse object file header
+/// </summary>
+/// <param name="rawBuffer">Raw file buffer</param>
+/// <returns>Cooked header</returns>
+LWO_FILE_HEADER LWUtils::parseFileHeader(const char rawBuffer[]) {
+
+	LWO_FILE_HEADER_RAW rawHeader;
+	LWO_FILE_HEADER cookedHeader;
+
+	// Copy raw header
+	memcpy(&rawHeader, rawBuffer, sizeof(LWO_FILE_HEADER_RAW));
+
+	// Parse fields
+	cookedHeader.form = CONVERT_BYTES_TO_FOURCC(rawHeader.form);
+	cookedHeader.fileLength = CONVERT_U4_BYTES_TO_INT(rawHeader.fileLength);
+	cookedHeader.id = CONVERT_BYTES_TO_FOURCC(rawHeader.id);
+
+	return cookedHeader;
+}
+
 /// <summary>
 /// Parse float value from buffer and advance offset
 /// </summary>
 /// <param name="buffer">Raw buffer</param>
 /// <param name="offset">Current offset</param>
 /// <returns>Retrieved float</returns>
-void LWUtils::parseFloatValue(char buffer[], unsigned& offset, float& fval) {
-	fval = CONVERT_FLOAT_BYTES(buffer);
+void LWUtils::parseFloatValue(const char buffer[], unsigned& offset, float& fval) {
+	fval = CONVERT_LE_FLOAT(buffer);
 	offset += 4;
 }
 
@@ -106,7 +205,7 @@ void LWUtils::parseFloatValue(char buffer[], unsigned& offset, float& fval) {
 /// <param name="buffer">Raw buffer</param>
 /// <param name="offset">Current offset</param>
 /// <returns>Retrieved COL12 value</returns>
-void LWUtils::parseCol12Value(char buffer[], unsigned& offset, COL12& col) {
+void LWUtils::parseCol12Value(const char buffer[], unsigned& offset, COL12& col) {
 	col = CONVERT_COL12_BYTES(buffer);
 	offset += sizeof(COL12);
 }
@@ -117,10 +216,10 @@ void LWUtils::parseCol12Value(char buffer[], unsigned& offset, COL12& col) {
 /// <param name="buffer">Raw buffer</param>
 /// <param name="offset">Current offset</param>
 /// <returns>Retrieved unsigned int</returns>
-void LWUtils::parseFloatVxValues(char buffer[], unsigned& offset, float& fval, unsigned& vx) {
+void LWUtils::parseFloatVxValues(const char buffer[], unsigned& offset, float& fval, unsigned& vx) {
 
 	// Float value
-	fval = CONVERT_FLOAT_BYTES(buffer);
+	fval = CONVERT_LE_FLOAT(buffer);
 	offset += sizeof(float);
 
 	// VX value
@@ -134,16 +233,34 @@ void LWUtils::parseFloatVxValues(char buffer[], unsigned& offset, float& fval, u
 /// <param name="offset">Current offset</param>
 /// <param name="vx"></param>
 /// <returns></returns>
-void LWUtils::parseVxValues(char buffer[], unsigned& offset, unsigned& uval) {
+void LWUtils::parseVxValues(const char buffer[], unsigned& offset, unsigned& uval) {
 
-	if (buffer[0] == 255) {
-		// Four byte index
-		uval = CONVERT_U4_BYTES_TO_INT(buffer);
-		offset += 4;
-	}
-	else {
-		// Two byte index
-		uval = CONVERT_U2_BYTES_TO_INT(buffer);
-		offset += 2;
+	// Two or four byte index
+	uval = CONVERT_VX_BYTES_TO_INT(buffer);
+	offset += CONVERT_VX_BYTES_LENGTH(buffer);
+}
+
+/// <summary>
+/// Parse a zero-terminated string, padded to even length, from buffer and
+/// advance offset. A string missing its terminator ends at the end of the
+/// buffer rather than being scanned for past it.
+/// </summary>
+/// <param name="buffer">Bounded raw buffer</param>
+/// <param name="offset">Current offset, left past the padding or at the end of the buffer</param>
+/// <param name="str">Retrieved string, without the terminator</param>
+void LWUtils::parseString(BufferView buffer, size_t& offset, string_view& str) {
+
+	if (offset >= buffer.size()) {
+		str = string_view();
+		offset = buffer.size();
+		return;
 	}
-}
\ No newline at end of file
+
+	size_t length = strnlen(buffer.data(offset), buffer.size() - offset);
+	str = string_view(buffer.data(offset), length);
+
+	// Terminator and padding, which a truncated buffer may be missing
+	size_t stringLength = length + 1;
+	offset += stringLength % 2 == 0 ? stringLength : stringLength + 1;
+	if (offset > buffer.size()) offset = buffer.size();
+}
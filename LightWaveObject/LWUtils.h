@@ -1,16 +1,26 @@
 #pragma once
+#include <string_view>
+
+#include "BufferView.h"
 #include "Chunks/ChunkDefinitions.h"
 
 class LWUtils {
 public:
-	static ChunkTag convertTagStringTagToEnum(string tag);
+	static ChunkTag convertChunkTagToEnum(FOURCC tag);
 	static string convertTagEnumToString(ChunkTag tagEnum);
 
-	static SurfaceSubChunkTag convertSurfaceTagStringToEnum(string tag);
+	static PolygonType convertPolygonTypeToEnum(FOURCC type);
+	static PolygonTagType convertPolygonTagTypeToEnum(FOURCC type);
+	static SurfaceSubChunkTag convertSurfaceTagToEnum(FOURCC tag);
+	static VertexMapType convertVertexMapTypeToEnum(FOURCC type);
+
+	static LWO_CHUNK_HEADER parseChunkHeader(const char rawBuffer[]);
+	static LWO_FILE_HEADER parseFileHeader(const char rawBuffer[]);
 
-	static void parseCol12Value(char buffer[], unsigned& offset, COL12& col);
-	static void parseFloatValue(char buffer[], unsigned& offset, float& fval);
-	static void parseFloatVxValues(char buffer[], unsigned& offset, float& fval, unsigned& vx);
-	static void parseVxValues(char buffer[], unsigned& offset, unsigned& uval);
+	static void parseCol12Value(const char buffer[], unsigned& offset, COL12& col);
+	static void parseFloatValue(const char buffer[], unsigned& offset, float& fval);
+	static void parseFloatVxValues(const char buffer[], unsigned& offset, float& fval, unsigned& vx);
+	static void parseVxValues(const char buffer[], unsigned& offset, unsigned& uval);
+	static void parseString(BufferView buffer, size_t& offset, string_view& str);
 };
 
@@ -5,10 +5,41 @@
 // 
 // - LWO2
 // 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 
 #include "LightWaveObject.h"
 
+namespace {
+
+	/// <summary>
+	/// Get the trace event name for parsing a chunk
+	/// </summary>
+	/// <param name="tag">Chunk tag</param>
+	/// <returns>Event name, e.g. "Parse PNTS"</returns>
+	const char* getParseEventName(ChunkTag tag) {
+
+		// Interned once, on the first traced parse
+		static const vector<const char*> names = []() {
+			vector<const char*> tagNames(NUM_CHUNK_TAGS);
+			for (size_t tagIndex = 0; tagIndex < NUM_CHUNK_TAGS; tagIndex++) {
+				tagNames[tagIndex] = TraceRecorder::getShared().internName("Parse " + LWUtils::convertTagEnumToString(ChunkTag(tagIndex)));
+			}
+			return tagNames;
+		}();
+
+		return names[size_t(tag)];
+	}
+}
+
+/// <summary>
+/// Create an empty object
+/// </summary>
+/// <param name="upstream">Resource the object's arena takes its blocks from</param>
+LightWaveObject::LightWaveObject(pmr::memory_resource* upstream) : _arena { upstream }, _layers { &_arena }, _surfaceTable { &_arena } {
+}
+
 /// <summary>
 /// Read and parse a LightWave object
 /// </summary>
@@ -16,101 +47,347 @@
 /// <returns>Read success</returns>
 bool LightWaveObject::Read(string lwObjectFilename, wstring& errorReason) {
 
-	unique_ptr<char[]> fileBuffer;	// Memory buffer
-
-	// Read the file into memory
-	fileBuffer = readFile(lwObjectFilename);
-	if (fileBuffer == nullptr) {
+	// Map the file, or read it into memory if it can't be mapped
+	PhaseTimer readTimer(_statistics, LoadPhase::FileRead);
+	TraceScope readTrace("File read");
+	unique_ptr<ObjectInput> input = ObjectInput::open(lwObjectFilename);
+	readTrace.stop();
+	readTimer.stop();
+	if (input == nullptr) {
 
 		// Couldn't read the file
 		errorReason = L"Couldn't read the file";
 		return false;
 	}
+	if (_statistics) {
+		_statistics->phaseElements[size_t(LoadPhase::FileRead)] += input->view().size() / 1024;
+	}
 
-	// Read file header
-	LWO_FILE_HEADER fileHeader = parseFileHeader(fileBuffer.get());
+	if (!Read(*input, errorReason)) {
+		return false;
+	}
 
-	// Not a valid LightWave object
-	if (fileHeader.form != "FORM") {
+	// Unparsed chunks still refer to the file data
+	if (_lazyParse) {
+		_input = move(input);
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parse a LightWave object from a caller-owned buffer, which must outlive
+/// this object when chunks are parsed lazily
+/// </summary>
+/// <param name="buffer">Object file contents</param>
+/// <param name="length">Length of buffer in bytes</param>
+/// <returns>Read success</returns>
+bool LightWaveObject::Read(const char* buffer, size_t length, wstring& errorReason) {
+
+	unique_ptr<ObjectInput> input = ObjectInput::fromMemory(buffer, length);
+
+	return Read(*input, errorReason);
+}
+
+/// <summary>
+/// Parse a LightWave object from an input, which must outlive this object
+/// when chunks are parsed lazily
+/// </summary>
+/// <param name="input">Object file input</param>
+/// <returns>Read success</returns>
+bool LightWaveObject::Read(const ObjectInput& input, wstring& errorReason) {
+
+	// Discard any previously read object
+	reset();
+
+	BufferView fileBuffer = input.view();
+
+	// Must at least hold a file header
+	if (!fileBuffer.contains(0, sizeof(LWO_FILE_HEADER_RAW))) {
 		errorReason = L"File is not a valid LightWave object file";
 		return false;
 	}
 
-	// Not a supported format
-	if (!(fileHeader.id == "LWO2" || fileHeader.id == "LWO3")) {
-		errorReason = L"LightWave object format is not supported";
+	// Read file header
+	LWO_FILE_HEADER fileHeader = LWUtils::parseFileHeader(fileBuffer.data());
+	if (!validateFileHeader(fileHeader, errorReason)) {
 		return false;
 	}
 
-	// Set up to read remaining chunks in file
-	size_t offset = sizeof(LWO_FILE_HEADER_RAW);
-	size_t fileLength = fileHeader.fileLength;
-	size_t CHUNK_HEADER_SIZE = sizeof(LWO_CHUNK_HEADER);
-	vector<unique_ptr<Chunk>> orphanedChunks;	// Temporarily hold chunks with no assigned layer
+	// First pass: find every chunk by walking the headers
+	TraceScope readTrace("Read object", "bytes", int64_t(fileBuffer.size()));
+	PhaseTimer walkTimer(_statistics, LoadPhase::HeaderWalk);
+	TraceScope walkTrace("Header walk");
+	vector<LWO_CHUNK_DIRECTORY_ENTRY> directory = buildChunkDirectory(fileBuffer, fileHeader);
+	walkTrace.stop();
+	walkTimer.stop();
+	if (isCancelled(errorReason)) {
+		return false;
+	}
 
-	// Parse all chunks
-	unique_ptr<Layer> currentLayer;
-	while (offset <= fileLength) {
+	if (_statistics) {
+		_statistics->fileBytes += fileBuffer.size();
+		_statistics->numChunks += directory.size();
+		_statistics->phaseElements[size_t(LoadPhase::HeaderWalk)] += directory.size();
+		for (const LWO_CHUNK_DIRECTORY_ENTRY& entry : directory) {
+			_statistics->tags[size_t(entry.header.tag)].numChunks++;
+			_statistics->tags[size_t(entry.header.tag)].bytes += entry.header.length;
+		}
+	}
 
-		// Get chunk header
-		LWO_CHUNK_HEADER chunkHeader = parseChunkHeader(fileBuffer.get() + offset);
-		//cout << "Chunk: " << LWUtils::convertTagEnumToString(chunkHeader.tag) << " (Offset " << offset << ")" << endl;
+	// Leave chunks unparsed until they're used
+	if (_lazyParse) {
+		storeDirectory(fileBuffer, directory);
+		_fileBuffer = fileBuffer;
+		_directory = move(directory);
+		return true;
+	}
 
-		// If it's a new layer then replace the older layer
-		if (chunkHeader.tag == ChunkTag::LAYR) {
+	// Instantiate a new chunk object of the appropriate type for each entry
+	PhaseTimer parseTimer(_statistics, LoadPhase::ChunkParse);
+	bool parallel = _parallelParse && fileBuffer.size() >= PARALLEL_PARSE_MIN_BYTES;
+	vector<ChunkPtr> chunks(directory.size());
+	vector<uint64_t> chunkHashes(directory.size());
+	vector<size_t> parseOrder;
+	vector<size_t> splitChunks;
+	vector<bool> isSplit(directory.size());
+	for (size_t entryIndex = 0; entryIndex < directory.size(); entryIndex++) {
+		const LWO_CHUNK_HEADER& header = directory[entryIndex].header;
+		chunks[entryIndex] = Chunk::create(header.tag, &_arena);
+
+		// Huge polygon chunks are decoded in parallel segments instead
+		if (parallel && header.tag == ChunkTag::POLS && header.length >= PARALLEL_SPLIT_MIN_BYTES) {
+			Polygons* polygons = static_cast<Polygons*>(chunks[entryIndex].get());
+			polygons->setThreadPool(&ThreadPool::getShared());
+			polygons->setLoadControl(_loadControl);
+			splitChunks.push_back(entryIndex);
+			isSplit[entryIndex] = true;
+		}
 
-			// First, save the old layer if there is one
-			if (currentLayer != nullptr) {
+		// Unsupported chunks are only hashed
+		if (chunks[entryIndex] != nullptr || _hashContent) {
+			parseOrder.push_back(entryIndex);
+		}
+	}
 
-				// Save the old layer
-				_layers.push_back(move(currentLayer));
-			}
+	// Start the largest chunks first so that one big chunk doesn't finish last
+	sort(parseOrder.begin(), parseOrder.end(), [&](size_t a, size_t b) {
+		return directory[a].header.length > directory[b].header.length;
+	});
+
+	// Per-chunk times, each written by the one task that handles the chunk
+	using Clock = chrono::steady_clock;
+	vector<double> parseSeconds(_statistics ? directory.size() : 0);
+	vector<double> hashSeconds(_statistics ? directory.size() : 0);
+
+	// Progress is the share of the file parsed so far
+	atomic<size_t> parsedBytes {};
+	auto reportParsed = [&](size_t entryIndex) {
+		if (!_loadControl) return;
+		size_t bytes = parsedBytes.fetch_add(directory[entryIndex].header.length, memory_order_relaxed) + directory[entryIndex].header.length;
+		_loadControl->reportProgress(LoadPhase::ChunkParse, double(bytes) / fileBuffer.size());
+	};
+
+	// Second pass: hash and parse the chunks, which are independent of each other
+	auto getChunkBuffer = [&](size_t entryIndex) {
+		const LWO_CHUNK_DIRECTORY_ENTRY& entry = directory[entryIndex];
+		return fileBuffer.subview(entry.offset, sizeof(LWO_CHUNK_HEADER_RAW) + entry.header.length);
+	};
+	auto parseEntry = [&](size_t entryIndex) {
+		if (_loadControl && _loadControl->isCancelled()) return;
+
+		// Hash the payload just ahead of parsing it, so the parse mostly reads it from cache
+		const LWO_CHUNK_HEADER& header = directory[entryIndex].header;
+		TraceScope trace(isSplit[entryIndex] ? "Hash chunk" : getParseEventName(header.tag), "bytes", int64_t(header.length));
+		BufferView chunkBuffer = getChunkBuffer(entryIndex);
+		Clock::time_point start;
+		if (_statistics) start = Clock::now();
+		if (_hashContent) {
+			chunkHashes[entryIndex] = ContentHash::hash(chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length));
+		}
+		if (_statistics) {
+			Clock::time_point hashed = Clock::now();
+			hashSeconds[entryIndex] = chrono::duration<double>(hashed - start).count();
+			start = hashed;
+		}
+
+		// Split chunks were parsed before the batch
+		Chunk* chunk = chunks[entryIndex].get();
+		if (chunk != nullptr && !isSplit[entryIndex]) {
+			chunk->parse(chunkBuffer, header);
+			if (_statistics) parseSeconds[entryIndex] = chrono::duration<double>(Clock::now() - start).count();
+		}
+		if (!isSplit[entryIndex]) reportParsed(entryIndex);
+	};
+
+	// Split chunks each use the whole pool in turn
+	for (size_t entryIndex : splitChunks) {
+		if (_loadControl && _loadControl->isCancelled()) break;
+		TraceScope trace(getParseEventName(ChunkTag::POLS), "bytes", int64_t(directory[entryIndex].header.length));
+		Clock::time_point start;
+		if (_statistics) start = Clock::now();
+		chunks[entryIndex]->parse(getChunkBuffer(entryIndex), directory[entryIndex].header);
+		if (_statistics) parseSeconds[entryIndex] = chrono::duration<double>(Clock::now() - start).count();
+		reportParsed(entryIndex);
+	}
 
-			// Instantiate and parse the new layer
-			unique_ptr<Layer> newLayer = unique_ptr<Layer>(new Layer {});
-			newLayer->parse(fileBuffer.get() + offset, chunkHeader);
+	// Other chunks are spread across the pool a chunk at a time
+	if (parallel) {
+		ThreadPool::getShared().parallelFor(parseOrder.size(), [&](size_t orderIndex) {
+			parseEntry(parseOrder[orderIndex]);
+		});
+	}
+	else {
+		for (size_t entryIndex : parseOrder) {
+			parseEntry(entryIndex);
+		}
+	}
 
-			// Set new layer as current layer
-			currentLayer = move(newLayer);
+	// A cancelled object is incomplete, so its chunks are dropped
+	if (isCancelled(errorReason)) {
+		return false;
+	}
 
-			// Add any orphaned chunks to the layer
-			for (unique_ptr<Chunk>& orphanChunk : orphanedChunks) {
-				currentLayer->addChunk(move(orphanChunk));
-			}
+	// The object's hash follows from its chunk hashes
+	if (_hashContent) {
+		_contentHash = hashDirectory(fileBuffer, directory, chunkHashes);
+	}
+
+	// Add up the chunk times by tag
+	if (_statistics) {
+		for (size_t entryIndex = 0; entryIndex < directory.size(); entryIndex++) {
+			LOAD_TAG_STATISTICS& tagStatistics = _statistics->tags[size_t(directory[entryIndex].header.tag)];
+			tagStatistics.parseSeconds += parseSeconds[entryIndex];
+			tagStatistics.hashSeconds += hashSeconds[entryIndex];
 		}
-		else {
+	}
 
-			// Instantiate a new chunk object of the appropriate type
-			unique_ptr<Chunk> chunk = Chunk::create(chunkHeader.tag);
-			if (chunk != nullptr) {
+	// Save chunks to their layers in file order
+	vector<ChunkPtr> orphanedChunks;	// Temporarily hold chunks with no assigned layer
+	for (size_t entryIndex = 0; entryIndex < chunks.size(); entryIndex++) {
+		if (chunks[entryIndex] != nullptr) {
+			chunks[entryIndex]->setContentHash(chunkHashes[entryIndex]);
+			storeChunk(move(chunks[entryIndex]), orphanedChunks);
+		}
+	}
+	buildSurfaceTable();
+	parseTimer.stop();
 
-				// Parse the chunk
-				chunk->parse(fileBuffer.get() + offset, chunkHeader);
+	if (_statistics) {
+		_statistics->phaseElements[size_t(LoadPhase::ChunkParse)] += countElements();
+		_statistics->arenaAllocations += _arena.getNumAllocations();
+		_statistics->arenaBytes += _arena.getBytesAllocated();
+	}
+	TraceRecorder::getShared().counter("Arena bytes", int64_t(_arena.getBytesAllocated()));
 
-				// Save chunk to current layer
-				if (currentLayer != nullptr) {
-					currentLayer->addChunk(move(chunk));
-				}
-				else {
+	return true;
+}
 
-					// No current layer yet, so save to the temp chunk list
-					orphanedChunks.push_back(move(chunk));
-				}
-			}
+/// <summary>
+/// Read and parse a LightWave object through a fixed-size sliding window.
+/// Chunks larger than the window that can't be parsed in pieces are left
+/// out of the object, and named in a warning.
+/// </summary>
+/// <param name="lwObjectFilename">Object filename to read</param>
+/// <param name="errorReason">Reason for a failure, or a warning of skipped chunks if the read succeeded</param>
+/// <param name="windowSize">Window size, which bounds the memory used for file data</param>
+/// <returns>Read success</returns>
+bool LightWaveObject::ReadStreaming(std::string lwObjectFilename, wstring& errorReason, size_t windowSize) {
+
+	// Discard any previously read object
+	reset();
+
+	// Open the file and read its header
+	ChunkStream stream(windowSize);
+	if (!stream.open(lwObjectFilename, errorReason)) {
+		return false;
+	}
+
+	// Validate file header
+	if (!validateFileHeader(stream.getFileHeader(), errorReason)) {
+		return false;
+	}
+
+	// Parse chunks as they are generated
+	vector<ChunkPtr> orphanedChunks;	// Temporarily hold chunks with no assigned layer
+	vector<bool> skippedTags(NUM_CHUNK_TAGS);	// Tags of the chunks too large to parse
+	LWO_CHUNK_HEADER chunkHeader;
+	while (stream.next(chunkHeader)) {
+		if (isCancelled(errorReason)) {
+			return false;
 		}
 
-		// Calculate next offset
-		if (chunkHeader.length % 2 == 0) {
-			offset = offset + CHUNK_HEADER_SIZE + chunkHeader.length;
+		// Instantiate a new chunk object of the appropriate type
+		ChunkPtr chunk = Chunk::create(chunkHeader.tag, &_arena);
+		if (chunk == nullptr) {
+			continue;
+		}
+
+		// Parse the chunk whole if it fits in the window, otherwise in pieces
+		PhaseTimer parseTimer(_statistics, LoadPhase::ChunkParse);
+		TraceScope trace(getParseEventName(chunkHeader.tag), "bytes", int64_t(chunkHeader.length));
+		chrono::steady_clock::time_point start;
+		if (_statistics) start = chrono::steady_clock::now();
+		BufferView chunkBuffer;
+		ContentHash payloadHash;
+		if (stream.readChunk(chunkBuffer)) {
+			if (_hashContent) {
+				BufferView payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, chunkHeader.length);
+				payloadHash.update(payload.data(), payload.size());
+			}
+			chunk->parse(chunkBuffer, chunkHeader);
 		}
 		else {
-			offset = offset + CHUNK_HEADER_SIZE + chunkHeader.length + 1;
+
+			// Polygon lists grow as pieces arrive; grow them outside the
+			// arena, which would keep every buffer they outgrow
+			if (chunkHeader.tag == ChunkTag::POLS) {
+				static_cast<Polygons*>(chunk.get())->setGrowthResource(_arena.getUpstream());
+			}
+			if (!parseChunkPieces(stream, *chunk, payloadHash)) {
+
+				// Chunk is too large for the window and can't be parsed in pieces
+				skippedTags[size_t(chunkHeader.tag)] = true;
+				continue;
+			}
 		}
+
+		// A chunk left partly unread has no meaningful hash
+		if (_hashContent && stream.getPayloadRemaining() == 0) {
+			chunk->setContentHash(payloadHash.digest());
+		}
+
+		// Streamed chunks are read, hashed and parsed together, so it's all parse time
+		if (_statistics) {
+			LOAD_TAG_STATISTICS& tagStatistics = _statistics->tags[size_t(chunkHeader.tag)];
+			tagStatistics.numChunks++;
+			tagStatistics.bytes += chunkHeader.length;
+			tagStatistics.parseSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			_statistics->numChunks++;
+			_statistics->fileBytes += sizeof(LWO_CHUNK_HEADER_RAW) + chunkHeader.length;
+		}
+
+		// Save chunk to its layer
+		storeChunk(move(chunk), orphanedChunks);
 	}
+	buildSurfaceTable();
 
-	// Save the last layer if there was one
-	if (currentLayer != nullptr) {
-		_layers.push_back(move(currentLayer));
+	if (_statistics) {
+		_statistics->phaseElements[size_t(LoadPhase::ChunkParse)] += countElements();
+		_statistics->arenaAllocations += _arena.getNumAllocations();
+		_statistics->arenaBytes += _arena.getBytesAllocated();
+	}
+	TraceRecorder::getShared().counter("Arena bytes", int64_t(_arena.getBytesAllocated()));
+
+	// The object is usable without the skipped chunks, so they're only a warning
+	wstring skipped;
+	for (size_t tagIndex = 0; tagIndex < NUM_CHUNK_TAGS; tagIndex++) {
+		if (!skippedTags[tagIndex]) continue;
+		string tag = LWUtils::convertTagEnumToString(ChunkTag(tagIndex));
+		skipped += (skipped.empty() ? L"" : L", ") + wstring(tag.begin(), tag.end());
+	}
+	if (!skipped.empty()) {
+		errorReason = L"Skipped chunks larger than the stream window: " + skipped;
 	}
 
 	return true;
@@ -120,16 +397,11 @@ bool LightWaveObject::Read(string lwObjectFilename, wstring& errorReason) {
 /// Display object statistics for debugging
 /// </summary>
 void LightWaveObject::displayStatistics() {
-	for (unique_ptr<Layer>& layer : _layers) {
+	for (LayerPtr& layer : _layers) {
 		cout << "Layer" << endl;
 
 		// Read each chunk in this layer
-		unsigned numChunksInLayer = layer->size();
-		for (unsigned chunkIndex = 0; chunkIndex < numChunksInLayer; chunkIndex++) {
-
-			// Get chunk from layer
-			Chunk chunk;
-			layer->getChunk(chunk, chunkIndex);
+		for (Chunk& chunk : *layer) {
 
 			// Chunk Tag
 			string tagString = LWUtils::convertTagEnumToString(chunk.getTag());
@@ -143,6 +415,164 @@ void LightWaveObject::displayStatistics() {
 	}
 }
 
+/// <summary>
+/// Choose whether chunk payloads are hashed as they're parsed
+/// </summary>
+/// <param name="hashContent">False to skip hashing, leaving chunk and object hashes zero</param>
+void LightWaveObject::SetHashContent(bool hashContent) {
+	_hashContent = hashContent;
+}
+
+/// <summary>
+/// Choose whether large objects are parsed on the shared thread pool
+/// </summary>
+/// <param name="parallelParse">False to parse every chunk on the calling thread</param>
+void LightWaveObject::SetParallelParse(bool parallelParse) {
+	_parallelParse = parallelParse;
+}
+
+/// <summary>
+/// Set where reads record their timings and counters, which are added to
+/// what's already there
+/// </summary>
+/// <param name="statistics">Statistics to add to, or nullptr to record nothing</param>
+void LightWaveObject::SetStatistics(LOAD_STATISTICS* statistics) {
+	_statistics = statistics;
+}
+
+/// <summary>
+/// Set the control checked between chunks, which can cancel a read from
+/// another thread and is told how much of the file has been parsed
+/// </summary>
+/// <param name="loadControl">Control of the load, or nullptr</param>
+void LightWaveObject::SetLoadControl(const LoadControl* loadControl) {
+	_loadControl = loadControl;
+}
+
+/// <summary>
+/// Choose whether chunks are parsed when the object is read, or the first time
+/// they are used. Lazy parsing doesn't apply to streaming reads.
+/// </summary>
+/// <param name="lazyParse">True to defer parsing chunks until they're used</param>
+void LightWaveObject::SetLazyParse(bool lazyParse) {
+	_lazyParse = lazyParse;
+}
+
+/// <summary>
+/// Get a layer's name
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Layer name</returns>
+string LightWaveObject::GetLayerName(int layerIndex) {
+	return _layers[layerIndex]->getName();
+}
+
+/// <summary>
+/// Get the flags of a layer
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Layer flags; the lowest bit marks a hidden layer</returns>
+unsigned LightWaveObject::GetLayerFlags(int layerIndex) {
+	return _layers[layerIndex]->getFlags();
+}
+
+/// <summary>
+/// Get the number the object file gives a layer, which needn't match its index
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Layer number</returns>
+unsigned LightWaveObject::GetLayerNumber(int layerIndex) {
+	return _layers[layerIndex]->getNumber();
+}
+
+/// <summary>
+/// Get the number of a layer's parent
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Parent layer number, or -1 if the layer has no parent</returns>
+int LightWaveObject::GetLayerParent(int layerIndex) {
+	return _layers[layerIndex]->getParent();
+}
+
+/// <summary>
+/// Get the pivot of a layer
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Origin the layer rotates about, in object coordinates</returns>
+VEC12 LightWaveObject::GetLayerPivot(int layerIndex) {
+	return _layers[layerIndex]->getPivot();
+}
+
+/// <summary>
+/// Get the number of allocations made from the object's arena
+/// </summary>
+/// <returns>Allocations made for the parsed object</returns>
+size_t LightWaveObject::GetArenaAllocations() {
+	return _arena.getNumAllocations();
+}
+
+/// <summary>
+/// Get the number of bytes the object's arena has handed out
+/// </summary>
+/// <returns>Bytes allocated for the parsed object</returns>
+size_t LightWaveObject::GetArenaBytes() {
+	return _arena.getBytesAllocated();
+}
+
+/// <summary>
+/// Get the raw bytes of a chunk left unparsed by a lazy read. They stay
+/// valid for as long as the object does.
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <param name="tag">Chunk tag</param>
+/// <param name="index">Which of the layer's chunks with this tag, in file order</param>
+/// <returns>Chunk header and payload, or empty if there's no such chunk or it was parsed when read</returns>
+BufferView LightWaveObject::GetChunkBufferByLayer(int layerIndex, ChunkTag tag, size_t index) {
+	return _layers[layerIndex]->getChunkBuffer(tag, index);
+}
+
+/// <summary>
+/// Get the content hash of a chunk's payload, e.g. to find geometry shared between objects
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <param name="tag">Chunk tag</param>
+/// <param name="index">Which of the layer's chunks with this tag, in file order</param>
+/// <returns>Payload hash, or zero if there's no such chunk or it wasn't hashed</returns>
+uint64_t LightWaveObject::GetChunkHashByLayer(int layerIndex, ChunkTag tag, size_t index) {
+	return _layers[layerIndex]->getChunkHash(tag, index);
+}
+
+/// <summary>
+/// Get the content hash of the object, which identifies the file contents.
+/// It's derived from the chunk hashes, so it costs nothing extra after a read
+/// that hashed its chunks. Lazily parsed objects are hashed on the first call.
+/// </summary>
+/// <returns>Object hash, or zero if an object read whole wasn't hashed, or the object was streamed</returns>
+uint64_t LightWaveObject::GetContentHash() {
+
+	if (_contentHash == 0 && !_directory.empty()) {
+
+		// Hash every chunk, including those that were never parsed
+		vector<uint64_t> chunkHashes(_directory.size());
+		auto hashEntry = [&](size_t entryIndex) {
+			const LWO_CHUNK_DIRECTORY_ENTRY& entry = _directory[entryIndex];
+			chunkHashes[entryIndex] = ContentHash::hash(_fileBuffer.subview(entry.offset + LWO_CHUNK_DATA_OFFSET, entry.header.length));
+		};
+		if (_parallelParse && _fileBuffer.size() >= PARALLEL_PARSE_MIN_BYTES) {
+			ThreadPool::getShared().parallelFor(_directory.size(), hashEntry);
+		}
+		else {
+			for (size_t entryIndex = 0; entryIndex < _directory.size(); entryIndex++) {
+				hashEntry(entryIndex);
+			}
+		}
+
+		_contentHash = hashDirectory(_fileBuffer, _directory, chunkHashes);
+	}
+
+	return _contentHash;
+}
+
 /// <summary>
 /// Get the number of parsed layers
 /// </summary>
@@ -151,38 +581,100 @@ size_t LightWaveObject::GetNumLayers() {
 	return _layers.size();
 }
 
+/// <summary>
+/// Get the number of points in a layer, without parsing them
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Number of points</returns>
+size_t LightWaveObject::GetNumPointsByLayer(int layerIndex) {
+	return _layers[layerIndex]->getNumPoints();
+}
+
+/// <summary>
+/// Get the number of POLS chunks in a layer, without parsing them. Each
+/// chunk holds polygons of one type, and a layer may have several.
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>Number of POLS chunks</returns>
+size_t LightWaveObject::GetNumPolsByLayer(int layerIndex) {
+	return _layers[layerIndex]->getNumChunks(ChunkTag::POLS);
+}
+
 /// <summary>
 /// Get list of LightWave points for a layer
 /// </summary>
 /// <param name="layer">Layer index</param>
 /// <returns>List of points</returns>
-const vector<VEC12>& LightWaveObject::GetPointsByLayer(int layerIndex) {
+const pmr::vector<VEC12>& LightWaveObject::GetPointsByLayer(int layerIndex) {
 
 	// Get reference to target layer
 	Layer& layer = *_layers[layerIndex].get();
 
 	// Get PNTS chunk
-	Points* points = (Points*)layer.getChunk(ChunkTag::PNTS);
+	Points* points = layer.getChunk<Points>();
+	if (points == nullptr) {
+		static const pmr::vector<VEC12> noPoints;
+		return noPoints;
+	}
 
 	return points->getPoints();
 }
 
 /// <summary>
-/// Get list of LightWave polygons for a layer
+/// Get list of LightWave polygons for a layer. Only FACE chunks are parsed,
+/// so chunks of other polygon types have an empty list.
 /// </summary>
 /// <param name="layerIndex">Layer index</param>
-/// <returns>List of polygons</returns>
-const vector<POLYGON>& LightWaveObject::GetPolsByLayer(int layerIndex) {
+/// <param name="polsIndex">Which of the layer's POLS chunks, in file order</param>
+/// <returns>Polygons in compressed sparse row form</returns>
+const POLYGON_LIST& LightWaveObject::GetPolsByLayer(int layerIndex, size_t polsIndex) {
 
 	// Get reference to target layer
 	Layer& layer = *_layers[layerIndex].get();
 
 	// Get POLS chunk
-	Polygons* pols = (Polygons*)layer.getChunk(ChunkTag::POLS);
+	Polygons* pols = layer.getChunk<Polygons>(polsIndex);
+	if (pols == nullptr) {
+		static const POLYGON_LIST noPolygons;
+		return noPolygons;
+	}
 
 	return pols->getPolygons();
 }
 
+/// <summary>
+/// Get the polygon tags of one type for a POLS chunk of a layer, e.g. the
+/// surface of each polygon. A PTAG chunk tags the polygons of the POLS chunk
+/// it follows.
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <param name="type">Tag type</param>
+/// <param name="polsIndex">Which of the layer's POLS chunks, in file order</param>
+/// <returns>PTAG chunk with this type between the POLS chunk and the next, or nullptr if there's none</returns>
+PolygonTags* LightWaveObject::GetPolygonTagsByLayer(int layerIndex, PolygonTagType type, size_t polsIndex) {
+
+	// Get reference to target layer
+	Layer& layer = *_layers[layerIndex].get();
+
+	// Chunks between the POLS chunk and the next belong to it
+	size_t polsPosition = layer.getChunkPosition(ChunkTag::POLS, polsIndex);
+	size_t nextPolsPosition = layer.getChunkPosition(ChunkTag::POLS, polsIndex + 1);
+
+	// Each PTAG chunk holds one type of tag
+	size_t numPolygonTags = layer.getNumChunks(ChunkTag::PTAG);
+	for (size_t index = 0; index < numPolygonTags; index++) {
+		size_t position = layer.getChunkPosition(ChunkTag::PTAG, index);
+		if (position < polsPosition) continue;
+		if (position > nextPolsPosition) break;
+		PolygonTags* polygonTags = layer.getChunk<PolygonTags>(index);
+		if (polygonTags && polygonTags->getType() == type) {
+			return polygonTags;
+		}
+	}
+
+	return nullptr;
+}
+
 /// <summary>
 /// Get LightWave surface description for this layer
 /// </summary>
@@ -194,101 +686,304 @@ Surface* LightWaveObject::GetSurfaceByLayer(int layerIndex) {
 	Layer& layer = *_layers[layerIndex].get();
 
 	// Get SURF chunk
-	Surface* surf = (Surface*)layer.getChunk(ChunkTag::SURF);
+	Surface* surf = layer.getChunk<Surface>();
 
 	return surf;
 }
 
 /// <summary>
-/// Read an LightWave object file
+/// Get every surface of the object, indexed by name and by tag. A lazily
+/// parsed object builds the table, and parses its surfaces, when it's
+/// first asked for.
 /// </summary>
-/// <param name="lwObjectFilename">Object filename to read</param>
-/// <returns>Smart pointer to file contents</returns>
-unique_ptr<char[]> LightWaveObject::readFile(std::string lwObjectFilename) {
-
-	unique_ptr<char[]> fileBuffer = nullptr;	// Memory buffer
-	ifstream objectFile;	// File stream
+/// <returns>Surface table</returns>
+SurfaceTable& LightWaveObject::GetSurfaceTable() {
+	if (!_surfaceTableBuilt) {
+		buildSurfaceTable();
+	}
+	return _surfaceTable;
+}
 
-	// Read object file into memory
-	try {
+/// <summary>
+/// Get the object's tag strings, which name its surfaces and parts. The TAGS
+/// chunk usually comes before the first layer, so every layer is searched.
+/// </summary>
+/// <returns>Strings of the first TAGS chunk, or an empty list if there's none</returns>
+const pmr::vector<pmr::string>& LightWaveObject::GetTags() {
 
-		// The file must exist
-		if (!filesystem::exists(lwObjectFilename)) {
-			cerr << "Could not find the file " << lwObjectFilename << "!" << endl;
-			return nullptr;
+	for (LayerPtr& layer : _layers) {
+		Tags* tags = layer->getChunk<Tags>();
+		if (tags) {
+			return tags->getTags();
 		}
+	}
+
+	static const pmr::vector<pmr::string> noTags;
+	return noTags;
+}
 
-		// Get the file size
-		size_t bufferSize = (size_t)filesystem::file_size(lwObjectFilename);
+/// <summary>
+/// Get a vertex map of a layer, e.g. its UVs or a weight map
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <param name="type">Map type</param>
+/// <param name="name">Map name, or an empty string for the first map of the type</param>
+/// <returns>Vertex map, or nullptr if the layer has none that matches</returns>
+VertexMap* LightWaveObject::GetVertexMapByLayer(int layerIndex, VertexMapType type, const string& name) {
 
-		// Open the file for reading
-		objectFile.open(lwObjectFilename, ios::binary);
+	// Get reference to target layer
+	Layer& layer = *_layers[layerIndex].get();
 
-		// Allocate the buffer
-		fileBuffer = unique_ptr<char[]>(new char[bufferSize]);
-		assert(fileBuffer != nullptr);
+	// A layer has a VMAP chunk for each map
+	size_t numVertexMaps = layer.getNumChunks(ChunkTag::VMAP);
+	for (size_t index = 0; index < numVertexMaps; index++) {
+		VertexMap* vertexMap = layer.getChunk<VertexMap>(index);
+		if (vertexMap && vertexMap->getType() == type && (name.empty() || vertexMap->getName() == name.c_str())) {
+			return vertexMap;
+		}
+	}
 
-		// Read file into memory
-		objectFile.read(fileBuffer.get(), bufferSize);
+	return nullptr;
+}
 
-		// Close file
-		objectFile.close();
+/// <summary>
+/// Build the surface table from the SURF chunks of every layer, in file
+/// order, and the object's tag strings
+/// </summary>
+void LightWaveObject::buildSurfaceTable() {
+
+	pmr::vector<Surface*> surfaces(&_arena);
+	for (LayerPtr& layer : _layers) {
+		size_t numSurfaces = layer->getNumChunks(ChunkTag::SURF);
+		for (size_t index = 0; index < numSurfaces; index++) {
+			Surface* surface = layer->getChunk<Surface>(index);
+			if (surface) {
+				surfaces.push_back(surface);
+			}
+		}
 	}
-	catch (filesystem::filesystem_error ex) {
-		// Couldn't get the file size
-		cerr << "EXCEPTION: Couldn't read the file size" << endl;
+
+	_surfaceTable.build(surfaces, GetTags());
+	_surfaceTableBuilt = true;
+}
+
+/// <summary>
+/// Walk the chunk headers of an object without parsing any payloads
+/// </summary>
+/// <param name="fileBuffer">Whole object file</param>
+/// <param name="fileHeader">Cooked file header</param>
+/// <returns>Chunks in file order</returns>
+vector<LWO_CHUNK_DIRECTORY_ENTRY> LightWaveObject::buildChunkDirectory(BufferView fileBuffer, const LWO_FILE_HEADER& fileHeader) {
+
+	// The FORM length excludes the FORM tag and length fields
+	size_t offset = sizeof(LWO_FILE_HEADER_RAW);
+	size_t formEnd = min(fileHeader.fileLength + 8, fileBuffer.size());
+	size_t CHUNK_HEADER_SIZE = sizeof(LWO_CHUNK_HEADER_RAW);
+	size_t numLayers = 0;
+
+	vector<LWO_CHUNK_DIRECTORY_ENTRY> directory;
+	while (offset + CHUNK_HEADER_SIZE <= formEnd) {
+
+		// Get chunk header
+		LWO_CHUNK_DIRECTORY_ENTRY entry;
+		entry.header = LWUtils::parseChunkHeader(fileBuffer.data(offset));
+		entry.offset = offset;
+		//cout << "Chunk: " << LWUtils::convertTagEnumToString(entry.header.tag) << " (Offset " << offset << ")" << endl;
+
+		// Chunks before the first layer are attached to it
+		if (entry.header.tag == ChunkTag::LAYR) numLayers++;
+		entry.layerIndex = numLayers > 0 ? numLayers - 1 : 0;
+
+		directory.push_back(entry);
+
+		// Calculate next offset
+		if (entry.header.length % 2 == 0) {
+			offset = offset + CHUNK_HEADER_SIZE + entry.header.length;
+		}
+		else {
+			offset = offset + CHUNK_HEADER_SIZE + entry.header.length + 1;
+		}
 	}
-	catch (ifstream::failure ex) {
-		// Couldn't read the file
-		cerr << "EXCEPTION: Couldn't read the file contents" << endl;
+
+	return directory;
+}
+
+/// <summary>
+/// Count the points and polygons of every layer, as the elements of the parse phase
+/// </summary>
+/// <returns>Points plus polygons</returns>
+uint64_t LightWaveObject::countElements() {
+
+	uint64_t numElements = 0;
+	for (size_t layerIndex = 0; layerIndex < _layers.size(); layerIndex++) {
+		numElements += GetPointsByLayer(int(layerIndex)).size();
+		size_t numPolygonChunks = GetNumPolsByLayer(int(layerIndex));
+		for (size_t polsIndex = 0; polsIndex < numPolygonChunks; polsIndex++) {
+			numElements += GetPolsByLayer(int(layerIndex), polsIndex).size();
+		}
 	}
-	catch (...) {
-		// Mystery error
-		cerr << "EXCEPTION: An unknown error occured attempting to read the file" << endl;
+
+	return numElements;
+}
+
+/// <summary>
+/// Combine chunk hashes into the object hash. The object hash covers the file
+/// header, each chunk header and each chunk's payload hash, in file order.
+/// </summary>
+/// <param name="fileBuffer">Whole object file</param>
+/// <param name="directory">Chunks in file order</param>
+/// <param name="chunkHashes">Payload hash of each chunk</param>
+/// <returns>Object hash</returns>
+uint64_t LightWaveObject::hashDirectory(BufferView fileBuffer, const vector<LWO_CHUNK_DIRECTORY_ENTRY>& directory, const vector<uint64_t>& chunkHashes) {
+
+	ContentHash objectHash;
+	objectHash.update(fileBuffer.data(), sizeof(LWO_FILE_HEADER_RAW));
+	for (size_t entryIndex = 0; entryIndex < directory.size(); entryIndex++) {
+		objectHash.update(fileBuffer.data(directory[entryIndex].offset), sizeof(LWO_CHUNK_HEADER_RAW));
+		objectHash.update(chunkHashes[entryIndex]);
 	}
 
-	// Finished
-	return fileBuffer;
+	return objectHash.digest();
+}
+
+/// <summary>
+/// Check whether the read has been cancelled
+/// </summary>
+/// <param name="errorReason">Set to the reason for the failure if it has</param>
+/// <returns>True if the read should stop</returns>
+bool LightWaveObject::isCancelled(wstring& errorReason) {
+	if (!_loadControl || !_loadControl->isCancelled()) return false;
+	errorReason = L"Load cancelled";
+	return true;
 }
 
 /// <summary>
-/// Parse chunk header
+/// Feed a chunk's payload to the chunk a piece at a time
 /// </summary>
-/// <param name="rawBuffer">Raw file buffer</param>
-/// <returns>Cooked header</returns>
-LWO_CHUNK_HEADER LightWaveObject::parseChunkHeader(char rawBuffer[]) {
+/// <param name="stream">Stream positioned at the chunk</param>
+/// <param name="chunk">Chunk to parse into</param>
+/// <param name="payloadHash">Hash the consumed pieces are added to</param>
+/// <returns>False if the chunk doesn't support parsing in pieces</returns>
+bool LightWaveObject::parseChunkPieces(ChunkStream& stream, Chunk& chunk, ContentHash& payloadHash) {
 
-	LWO_CHUNK_HEADER_RAW rawHeader;
-	LWO_CHUNK_HEADER cookedHeader;
+	chunk.startPieces(stream.getPayloadRemaining());
 
-	// Copy raw header
-	memcpy(&rawHeader, rawBuffer, sizeof(LWO_CHUNK_HEADER_RAW));
+	size_t payloadOffset = 0;
+	while (stream.getPayloadRemaining() > 0) {
 
-	// Parse fields
-	string chunkTag = CONVERT_BYTES_TO_STRING(rawHeader.tag, 4);
-	cookedHeader.tag = LWUtils::convertTagStringTagToEnum(chunkTag);
-	cookedHeader.length = CONVERT_U4_BYTES_TO_INT(rawHeader.length);
+		// Let the chunk consume as many whole records as the window holds
+		BufferView piece = stream.peekPayload();
+		size_t consumed = chunk.parsePiece(piece, payloadOffset);
 
-	return cookedHeader;
+		// Nothing consumed means the chunk doesn't support pieces,
+		// or a single record is larger than the window
+		if (consumed == 0) {
+			break;
+		}
+
+		if (_hashContent) payloadHash.update(piece.data(), consumed);
+		stream.consumePayload(consumed);
+		payloadOffset += consumed;
+	}
+
+	chunk.finishPieces();
+	return payloadOffset > 0;
 }
 
 /// <summary>
-/// Parse object file header
+/// Destroy the parsed object and release its arena in one step
 /// </summary>
-/// <param name="rawBuffer">Raw file buffer</param>
-/// <returns>Cooked header</returns>
-LWO_FILE_HEADER LightWaveObject::parseFileHeader(char rawBuffer[]) {
+void LightWaveObject::reset() {
+
+	// Destroy the layers and their chunks, and the layer list's own storage
+	pmr::vector<LayerPtr>(&_arena).swap(_layers);
+	_surfaceTable.clear();
+	_surfaceTableBuilt = false;
+	_input.reset();
+	_fileBuffer = BufferView();
+	_directory.clear();
+	_contentHash = 0;
+
+	_arena.release();
+}
+
+/// <summary>
+/// Save a parsed chunk to the layer it belongs to
+/// </summary>
+/// <param name="chunk">Parsed chunk</param>
+/// <param name="orphanedChunks">Chunks seen before the first layer</param>
+void LightWaveObject::storeChunk(ChunkPtr chunk, vector<ChunkPtr>& orphanedChunks) {
+
+	// A new layer becomes the current layer
+	if (chunk->getTag() == ChunkTag::LAYR) {
+		ChunkDeleter deleter = chunk.get_deleter();
+		_layers.push_back(LayerPtr(static_cast<Layer*>(chunk.release()), deleter));
+
+		// Add any orphaned chunks to the layer
+		for (ChunkPtr& orphanChunk : orphanedChunks) {
+			_layers.back()->addChunk(move(orphanChunk));
+		}
+		orphanedChunks.clear();
+	}
+	else if (!_layers.empty()) {
+
+		// Save chunk to current layer
+		_layers.back()->addChunk(move(chunk));
+	}
+	else {
 
-	LWO_FILE_HEADER_RAW rawHeader;
-	LWO_FILE_HEADER cookedHeader;
+		// No current layer yet, so save to the temp chunk list
+		orphanedChunks.push_back(move(chunk));
+	}
+}
 
-	// Copy raw header
-	memcpy(&rawHeader, rawBuffer, sizeof(LWO_FILE_HEADER_RAW));
+/// <summary>
+/// Create the layers in a chunk directory, and add every other chunk to
+/// its layer without parsing it
+/// </summary>
+/// <param name="fileBuffer">Whole object file</param>
+/// <param name="directory">Chunks in file order</param>
+void LightWaveObject::storeDirectory(BufferView fileBuffer, const vector<LWO_CHUNK_DIRECTORY_ENTRY>& directory) {
+
+	// Layer chunks are small and are needed to place everything else
+	for (const LWO_CHUNK_DIRECTORY_ENTRY& entry : directory) {
+		if (entry.header.tag == ChunkTag::LAYR) {
+			ChunkPtr layer = Chunk::create(ChunkTag::LAYR, &_arena);
+			layer->parse(fileBuffer.subview(entry.offset, sizeof(LWO_CHUNK_HEADER_RAW) + entry.header.length), entry.header);
+			ChunkDeleter deleter = layer.get_deleter();
+			_layers.push_back(LayerPtr(static_cast<Layer*>(layer.release()), deleter));
+		}
+	}
 
-	// Parse fields
-	cookedHeader.form = CONVERT_BYTES_TO_STRING(rawHeader.form, 4);
-	cookedHeader.fileLength = CONVERT_U4_BYTES_TO_INT(rawHeader.fileLength);
-	cookedHeader.id = CONVERT_BYTES_TO_STRING(rawHeader.id, 4);
+	// Other supported chunks; those before the first layer belong to it
+	for (const LWO_CHUNK_DIRECTORY_ENTRY& entry : directory) {
+		if (entry.header.tag == ChunkTag::LAYR || entry.header.tag == ChunkTag::UNKNOWN) continue;
+		if (entry.layerIndex >= _layers.size()) continue;
 
-	return cookedHeader;
+		BufferView chunkBuffer = fileBuffer.subview(entry.offset, sizeof(LWO_CHUNK_HEADER_RAW) + entry.header.length);
+		_layers[entry.layerIndex]->addChunk(entry.header, chunkBuffer);
+	}
+}
+
+/// <summary>
+/// Check that a file header describes a supported object
+/// </summary>
+/// <param name="fileHeader">Cooked file header</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>True if the object can be parsed</returns>
+bool LightWaveObject::validateFileHeader(const LWO_FILE_HEADER& fileHeader, wstring& errorReason) {
+
+	// Not a valid LightWave object
+	if (fileHeader.form != MAKE_FOURCC("FORM")) {
+		errorReason = L"File is not a valid LightWave object file";
+		return false;
+	}
+
+	// Not a supported format
+	if (!(fileHeader.id == MAKE_FOURCC("LWO2") || fileHeader.id == MAKE_FOURCC("LWO3"))) {
+		errorReason = L"LightWave object format is not supported";
+		return false;
+	}
+
+	return true;
 }
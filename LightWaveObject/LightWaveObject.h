@@ -2,38 +2,115 @@
 #include <assert.h>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+#include "ChunkStream.h"
+#include "ContentHash.h"
+#include "LoadControl.h"
+#include "LoadStatistics.h"
 #include "LWUtils.h"
+#include "ObjectArena.h"
+#include "ObjectInput.h"
+#include "SurfaceTable.h"
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
 #include "Chunks/ChunkDefinitions.h"
 #include "Chunks/Chunk.h"
 #include "Chunks/Layer.h"
 #include "Chunks/Points.h"
 #include "Chunks/Polygons.h"
+#include "Chunks/PolygonTags.h"
 #include "Chunks/Surface.h"
+#include "Chunks/Tags.h"
+#include "Chunks/VertexMap.h"
 
 class LightWaveObject {
 
 public:
 
+	// Constructor
+	explicit LightWaveObject(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	LightWaveObject(const LightWaveObject&) = delete;
+	LightWaveObject& operator=(const LightWaveObject&) = delete;
+
 	// Public methods
 	bool Read(std::string lwObjectFilename, wstring& errorReason);
+	bool Read(const char* buffer, size_t length, wstring& errorReason);
+	bool Read(const ObjectInput& input, wstring& errorReason);
+	bool ReadStreaming(std::string lwObjectFilename, wstring& errorReason, size_t windowSize = ChunkStream::DEFAULT_WINDOW_SIZE);
 	void displayStatistics();
+	void SetHashContent(bool hashContent);
+	void SetLazyParse(bool lazyParse);
+	void SetLoadControl(const LoadControl* loadControl);
+	void SetParallelParse(bool parallelParse);
+	void SetStatistics(LOAD_STATISTICS* statistics);
+
+	// Objects smaller than this are parsed on the calling thread
+	static const size_t PARALLEL_PARSE_MIN_BYTES = 256 * 1024;
+
+	// Polygon chunks at least this large are decoded in parallel segments
+	static const size_t PARALLEL_SPLIT_MIN_BYTES = 4 * 1024 * 1024;
 
 	// Getters
+	unsigned GetLayerFlags(int layerIndex);
+	string GetLayerName(int layerIndex);
+	unsigned GetLayerNumber(int layerIndex);
+	int GetLayerParent(int layerIndex);
+	VEC12 GetLayerPivot(int layerIndex);
+	size_t GetArenaAllocations();
+	size_t GetArenaBytes();
+	BufferView GetChunkBufferByLayer(int layerIndex, ChunkTag tag, size_t index = 0);
+	uint64_t GetChunkHashByLayer(int layerIndex, ChunkTag tag, size_t index = 0);
+	uint64_t GetContentHash();
 	size_t GetNumLayers();
-	const vector<VEC12>& GetPointsByLayer(int layerIndex);
-	const vector<POLYGON>& GetPolsByLayer(int layerIndex);
+	size_t GetNumPointsByLayer(int layerIndex);
+	size_t GetNumPolsByLayer(int layerIndex);
+	const pmr::vector<VEC12>& GetPointsByLayer(int layerIndex);
+	const POLYGON_LIST& GetPolsByLayer(int layerIndex, size_t polsIndex = 0);
+	PolygonTags* GetPolygonTagsByLayer(int layerIndex, PolygonTagType type, size_t polsIndex = 0);
 	Surface* GetSurfaceByLayer(int layerIndex);
+	SurfaceTable& GetSurfaceTable();
+	const pmr::vector<pmr::string>& GetTags();
+	VertexMap* GetVertexMapByLayer(int layerIndex, VertexMapType type, const string& name = "");
 
 private:
 	// Private methods
-	std::unique_ptr<char[]> readFile(std::string lwObjectFilename);
+	std::vector<LWO_CHUNK_DIRECTORY_ENTRY> buildChunkDirectory(BufferView fileBuffer, const LWO_FILE_HEADER& fileHeader);
+	uint64_t countElements();
+	uint64_t hashDirectory(BufferView fileBuffer, const std::vector<LWO_CHUNK_DIRECTORY_ENTRY>& directory, const std::vector<uint64_t>& chunkHashes);
+	void buildSurfaceTable();
+	bool isCancelled(wstring& errorReason);
+	bool parseChunkPieces(ChunkStream& stream, Chunk& chunk, ContentHash& payloadHash);
+	void reset();
+	void storeChunk(ChunkPtr chunk, std::vector<ChunkPtr>& orphanedChunks);
+	void storeDirectory(BufferView fileBuffer, const std::vector<LWO_CHUNK_DIRECTORY_ENTRY>& directory);
+	bool validateFileHeader(const LWO_FILE_HEADER& fileHeader, wstring& errorReason);
 
-	LWO_CHUNK_HEADER parseChunkHeader(char rawBuffer[]);
-	LWO_FILE_HEADER parseFileHeader(char rawBuffer[]);
+	// Arena for everything parsed from the object; declared first so it is destroyed last
+	ObjectArena _arena;
 
 	// Object layers
-	std::vector<std::unique_ptr<Layer>> _layers;
+	std::pmr::vector<LayerPtr> _layers;
+
+	// Every surface of the object, built once the surfaces have been read
+	SurfaceTable _surfaceTable;
+	bool _surfaceTableBuilt = false;
+
+	// Input kept alive for chunks that haven't been parsed yet
+	std::unique_ptr<ObjectInput> _input;
+
+	// Chunks of a lazily parsed object, kept so the object can be hashed on demand
+	BufferView _fileBuffer;
+	std::vector<LWO_CHUNK_DIRECTORY_ENTRY> _directory;
+	uint64_t _contentHash {};
+
+	// Options
+	bool _hashContent = true;
+	bool _lazyParse = false;
+	bool _parallelParse = true;
+	LOAD_STATISTICS* _statistics {};		// Where to record timings and counters, or null
+	const LoadControl* _loadControl {};		// Checked between chunks, or null
 };
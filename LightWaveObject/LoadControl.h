@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <functional>
+
+#include "LoadStatistics.h"
+
+// Lets another thread cancel a load and follow its progress. Loaders check
+// for cancellation between chunks and polygon batches, so a cancelled load
+// stops soon after whatever the size of the object.
+class LoadControl {
+public:
+
+	// Called with a phase and how much of it is done, from 0 to 1. Parallel
+	// phases call it from pool threads, possibly at the same time.
+	using ProgressCallback = std::function<void(LoadPhase phase, double fraction)>;
+
+	// Constructor
+	LoadControl() = default;
+	explicit LoadControl(ProgressCallback progressCallback) : _progressCallback { std::move(progressCallback) } { }
+
+	LoadControl(const LoadControl&) = delete;
+	LoadControl& operator=(const LoadControl&) = delete;
+
+	// Public methods
+	void cancel() {
+		_cancelled.store(true, std::memory_order_relaxed);
+	}
+
+	void reportProgress(LoadPhase phase, double fraction) const {
+		if (_progressCallback) _progressCallback(phase, fraction);
+	}
+
+	// Getters
+	bool isCancelled() const {
+		return _cancelled.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	// Private data
+	std::atomic<bool> _cancelled {};
+	ProgressCallback _progressCallback;
+};
@@ -0,0 +1,160 @@
+//
+// Load statistics
+//
+// Timings and counters gathered while an object is loaded, to show which
+// phase dominates for each kind of object. Collection is opt-in: loaders
+// take a LOAD_STATISTICS pointer and skip all of it when that's null.
+//
+#include <iomanip>
+#include <sstream>
+
+#include "LoadStatistics.h"
+#include "LWUtils.h"
+
+/// <summary>
+/// Add another load's statistics to these
+/// </summary>
+/// <param name="other">Statistics to add</param>
+void LOAD_STATISTICS::add(const LOAD_STATISTICS& other) {
+
+	for (size_t phase = 0; phase < NUM_LOAD_PHASES; phase++) {
+		phaseSeconds[phase] += other.phaseSeconds[phase];
+	}
+	totalSeconds += other.totalSeconds;
+
+	for (size_t tag = 0; tag < NUM_CHUNK_TAGS; tag++) {
+		tags[tag].numChunks += other.tags[tag].numChunks;
+		tags[tag].bytes += other.tags[tag].bytes;
+		tags[tag].parseSeconds += other.tags[tag].parseSeconds;
+		tags[tag].hashSeconds += other.tags[tag].hashSeconds;
+	}
+
+	numLoads += other.numLoads;
+	fileBytes += other.fileBytes;
+	numChunks += other.numChunks;
+	for (size_t arity = 0; arity <= MAX_ARITY; arity++) {
+		polygonsByArity[arity] += other.polygonsByArity[arity];
+	}
+	arenaAllocations += other.arenaAllocations;
+	arenaBytes += other.arenaBytes;
+	meshBytes += other.meshBytes;
+	meshCacheHits += other.meshCacheHits;
+	for (size_t phase = 0; phase < NUM_LOAD_PHASES; phase++) {
+		phaseCounts[phase].cycles += other.phaseCounts[phase].cycles;
+		phaseCounts[phase].instructions += other.phaseCounts[phase].instructions;
+		phaseCounts[phase].cacheMisses += other.phaseCounts[phase].cacheMisses;
+		phaseCounts[phase].branchMisses += other.phaseCounts[phase].branchMisses;
+		phaseElements[phase] += other.phaseElements[phase];
+	}
+}
+
+/// <summary>
+/// Format the statistics as a multi-line report
+/// </summary>
+/// <returns>Report text</returns>
+string LOAD_STATISTICS::getReport() const {
+
+	const double MB = 1024.0 * 1024.0;
+	ostringstream report;
+	report << fixed << setprecision(3);
+
+	report << "Loads: " << numLoads << " (" << meshCacheHits << " from mesh cache), "
+		<< setprecision(2) << fileBytes / MB << " MB, " << numChunks << " chunks" << endl;
+
+	// Phases, with their share of the total
+	report << setprecision(3) << "Total: " << totalSeconds * 1000.0 << " ms" << endl;
+	for (size_t phase = 0; phase < NUM_LOAD_PHASES; phase++) {
+		if (phaseSeconds[phase] == 0) continue;
+		report << "  " << left << setw(18) << getPhaseName(LoadPhase(phase)) << right
+			<< setw(12) << phaseSeconds[phase] * 1000.0 << " ms"
+			<< setw(8) << setprecision(1) << (totalSeconds > 0 ? phaseSeconds[phase] * 100.0 / totalSeconds : 0) << "%"
+			<< setprecision(3) << endl;
+	}
+
+	// Chunks by tag
+	for (size_t tag = 0; tag < NUM_CHUNK_TAGS; tag++) {
+		const LOAD_TAG_STATISTICS& tagStatistics = tags[tag];
+		if (tagStatistics.numChunks == 0) continue;
+		report << "  " << LWUtils::convertTagEnumToString(ChunkTag(tag))
+			<< setw(8) << tagStatistics.numChunks << " chunks"
+			<< setw(12) << setprecision(2) << tagStatistics.bytes / MB << " MB"
+			<< setw(12) << setprecision(3) << tagStatistics.parseSeconds * 1000.0 << " ms parse"
+			<< setw(12) << tagStatistics.hashSeconds * 1000.0 << " ms hash" << endl;
+	}
+
+	// Polygons by number of vertices
+	report << "Polygons by vertex count:";
+	for (size_t arity = 0; arity <= MAX_ARITY; arity++) {
+		if (polygonsByArity[arity] == 0) continue;
+		report << " " << arity << (arity == MAX_ARITY ? "+" : "") << ":" << polygonsByArity[arity];
+	}
+	report << endl;
+
+	report << setprecision(2) << "Memory: " << arenaAllocations << " arena allocations, "
+		<< arenaBytes / MB << " MB arena, " << meshBytes / MB << " MB mesh" << endl;
+
+	// Hardware counts, when they were sampled
+	bool hasCounts = false;
+	for (const HARDWARE_COUNTS& counts : phaseCounts) {
+		hasCounts = hasCounts || counts.cycles > 0;
+	}
+	if (hasCounts) {
+		report << "Hardware counters:" << setw(10) << "Mcycles" << setw(8) << "IPC"
+			<< setw(18) << "cache misses/el" << setw(18) << "branch misses/el" << "  element" << endl;
+		for (size_t phase = 0; phase < NUM_LOAD_PHASES; phase++) {
+			const HARDWARE_COUNTS& counts = phaseCounts[phase];
+			if (counts.cycles == 0) continue;
+			double elements = double(phaseElements[phase]);
+			report << "  " << left << setw(18) << getPhaseName(LoadPhase(phase)) << right
+				<< setw(8) << setprecision(2) << counts.cycles / 1e6
+				<< setw(8) << double(counts.instructions) / counts.cycles
+				<< setprecision(3);
+			if (elements > 0) {
+				report << setw(18) << counts.cacheMisses / elements << setw(18) << counts.branchMisses / elements
+					<< "  " << getPhaseElementName(LoadPhase(phase));
+			}
+			else {
+				report << setw(18) << counts.cacheMisses << setw(18) << counts.branchMisses << "  (total)";
+			}
+			report << endl;
+		}
+	}
+
+	return report.str();
+}
+
+/// <summary>
+/// Get what a load phase counts as one element when counts are given per element
+/// </summary>
+/// <param name="phase">Load phase</param>
+/// <returns>Element name</returns>
+const char* LOAD_STATISTICS::getPhaseElementName(LoadPhase phase) {
+	switch (phase) {
+		case LoadPhase::FileRead: return "KB";
+		case LoadPhase::HeaderWalk: return "chunk";
+		case LoadPhase::ChunkParse: return "point or polygon";
+		case LoadPhase::MeshCache: return "vertex";
+		case LoadPhase::Triangulation: return "polygon";
+		case LoadPhase::NormalGeneration: return "polygon";
+		case LoadPhase::BufferCreation: return "vertex";
+	}
+	return "element";
+}
+
+/// <summary>
+/// Get the display name of a load phase
+/// </summary>
+/// <param name="phase">Load phase</param>
+/// <returns>Phase name</returns>
+const char* LOAD_STATISTICS::getPhaseName(LoadPhase phase) {
+	switch (phase) {
+		case LoadPhase::FileRead: return "File read";
+		case LoadPhase::HeaderWalk: return "Header walk";
+		case LoadPhase::ChunkParse: return "Chunk parse";
+		case LoadPhase::MeshCache: return "Mesh cache";
+		case LoadPhase::Triangulation: return "Triangulation";
+		case LoadPhase::NormalGeneration: return "Normal generation";
+		case LoadPhase::BufferCreation: return "Buffer creation";
+	}
+	return "Unknown";
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+#include "HardwareCounters.h"
+#include "Chunks/ChunkDefinitions.h"
+
+// Stages of loading an object, in the order they run
+enum class LoadPhase { FileRead, HeaderWalk, ChunkParse, MeshCache, Triangulation, NormalGeneration, BufferCreation };
+
+// Number of load phases
+const size_t NUM_LOAD_PHASES = size_t(LoadPhase::BufferCreation) + 1;
+
+// Counters for the chunks with one tag
+struct LOAD_TAG_STATISTICS {
+	uint64_t numChunks = 0;
+	uint64_t bytes = 0;				// Payload bytes
+	double parseSeconds = 0;		// Summed over the threads that parsed them
+	double hashSeconds = 0;
+};
+
+// Counters and timings for one object load. Phases are wall-clock times;
+// ChunkParse includes the per-tag parse and hash times, which are summed
+// over threads and so can exceed it. Hardware counts only cover the thread
+// that ran the phase, not the pool threads it shared the work with.
+struct LOAD_STATISTICS {
+
+	// Polygons with at least this many vertices share the last arity bucket
+	static const size_t MAX_ARITY = 16;
+
+	double phaseSeconds[NUM_LOAD_PHASES] {};
+	double totalSeconds = 0;
+	LOAD_TAG_STATISTICS tags[NUM_CHUNK_TAGS] {};
+	uint64_t numLoads = 0;				// Loads added together
+	uint64_t fileBytes = 0;
+	uint64_t numChunks = 0;
+	uint64_t polygonsByArity[MAX_ARITY + 1] {};
+	uint64_t arenaAllocations = 0;		// Allocations from the object's arena
+	uint64_t arenaBytes = 0;
+	uint64_t meshBytes = 0;				// Vertex and index streams
+	uint64_t meshCacheHits = 0;
+	HARDWARE_COUNTS phaseCounts[NUM_LOAD_PHASES] {};
+	uint64_t phaseElements[NUM_LOAD_PHASES] {};		// What each phase worked on, see getPhaseElementName
+
+	// Counters sampled around each phase while set; not added or reported
+	const HardwareCounters* hardwareCounters = nullptr;
+
+	// Public methods
+	void add(const LOAD_STATISTICS& other);
+	std::string getReport() const;
+
+	// Static methods
+	static const char* getPhaseElementName(LoadPhase phase);
+	static const char* getPhaseName(LoadPhase phase);
+};
+
+// Adds the time, and the hardware counts if they're being sampled, until it
+// stops or goes out of scope to a load phase. Does nothing, not even read
+// the clock, without statistics.
+class PhaseTimer {
+public:
+
+	// Constructor
+	PhaseTimer(LOAD_STATISTICS* statistics, LoadPhase phase) : _statistics { statistics }, _phase { phase } {
+		if (_statistics == nullptr) return;
+		if (_statistics->hardwareCounters) _startCounts = _statistics->hardwareCounters->read();
+		_start = Clock::now();
+	}
+
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+	// Destructor
+	~PhaseTimer() {
+		stop();
+	}
+
+	// Public methods
+	void stop() {
+		if (_statistics == nullptr) return;
+		_statistics->phaseSeconds[size_t(_phase)] += std::chrono::duration<double>(Clock::now() - _start).count();
+		if (_statistics->hardwareCounters) {
+			HARDWARE_COUNTS counts = _statistics->hardwareCounters->read();
+			HARDWARE_COUNTS& phaseCounts = _statistics->phaseCounts[size_t(_phase)];
+			phaseCounts.cycles += counts.cycles - _startCounts.cycles;
+			phaseCounts.instructions += counts.instructions - _startCounts.instructions;
+			phaseCounts.cacheMisses += counts.cacheMisses - _startCounts.cacheMisses;
+			phaseCounts.branchMisses += counts.branchMisses - _startCounts.branchMisses;
+		}
+		_statistics = nullptr;
+	}
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	// Private data
+	LOAD_STATISTICS* _statistics;
+	LoadPhase _phase;
+	Clock::time_point _start;
+	HARDWARE_COUNTS _startCounts;
+};
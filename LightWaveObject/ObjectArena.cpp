@@ -0,0 +1,78 @@
+//
+// ObjectArena class
+//
+// Monotonic memory resource that holds everything parsed from an object:
+// layers, chunks, and the arrays and strings inside them. Nothing is freed
+// until the whole arena is released, so teardown is a single step. Blocks
+// come from an upstream resource, which callers can supply.
+//
+#include "ObjectArena.h"
+
+using namespace std;
+
+/// <summary>
+/// Create an empty arena
+/// </summary>
+/// <param name="upstream">Resource the arena's blocks are allocated from</param>
+ObjectArena::ObjectArena(pmr::memory_resource* upstream) : _arena { INITIAL_BLOCK_SIZE, upstream } {
+}
+
+/// <summary>
+/// Return all blocks to the upstream resource. Anything allocated from the
+/// arena must already have been destroyed.
+/// </summary>
+void ObjectArena::release() {
+	lock_guard<mutex> lock(_mutex);
+	_arena.release();
+	_bytesAllocated = 0;
+	_numAllocations = 0;
+}
+
+/// <summary>
+/// Get the number of bytes handed out since the arena was last released
+/// </summary>
+/// <returns>Bytes allocated</returns>
+size_t ObjectArena::getBytesAllocated() {
+	lock_guard<mutex> lock(_mutex);
+	return _bytesAllocated;
+}
+
+/// <summary>
+/// Get the number of allocations made since the arena was last released
+/// </summary>
+/// <returns>Allocation count</returns>
+size_t ObjectArena::getNumAllocations() {
+	lock_guard<mutex> lock(_mutex);
+	return _numAllocations;
+}
+
+/// <summary>
+/// Get the resource the arena's blocks come from
+/// </summary>
+/// <returns>Upstream resource</returns>
+pmr::memory_resource* ObjectArena::getUpstream() {
+	return _arena.upstream_resource();
+}
+
+/// <summary>
+/// Allocate from the current block, or a new one
+/// </summary>
+void* ObjectArena::do_allocate(size_t bytes, size_t alignment) {
+	lock_guard<mutex> lock(_mutex);
+	_bytesAllocated += bytes;
+	_numAllocations++;
+	return _arena.allocate(bytes, alignment);
+}
+
+/// <summary>
+/// Individual allocations aren't freed; see release()
+/// </summary>
+void ObjectArena::do_deallocate(void*, size_t, size_t) {
+}
+
+/// <summary>
+/// Arenas are only interchangeable with themselves
+/// </summary>
+bool ObjectArena::do_is_equal(const pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
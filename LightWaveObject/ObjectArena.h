@@ -0,0 +1,37 @@
+#pragma once
+#include <memory_resource>
+#include <mutex>
+
+class ObjectArena : public std::pmr::memory_resource {
+public:
+
+	// Constructor
+	explicit ObjectArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	ObjectArena(const ObjectArena&) = delete;
+	ObjectArena& operator=(const ObjectArena&) = delete;
+
+	// Public methods
+	void release();
+
+	// Getters
+	size_t getBytesAllocated();
+	size_t getNumAllocations();
+	std::pmr::memory_resource* getUpstream();
+
+	// Size of the first block requested from the upstream resource
+	static const size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+private:
+
+	// memory_resource overrides
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	// Private data
+	std::mutex _mutex;								// Chunks are parsed on several threads
+	std::pmr::monotonic_buffer_resource _arena;
+	size_t _bytesAllocated {};
+	size_t _numAllocations {};
+};
@@ -0,0 +1,212 @@
+//
+// ObjectInput class
+//
+// Provides the raw bytes of an object file to the parser without copying
+// them more than necessary. Input can come from:
+//
+// - A read-only memory mapping of the file (preferred)
+// - A buffer owned by the caller
+// - A buffered read of the whole file into memory (fallback)
+//
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ObjectInput.h"
+
+using namespace std;
+
+/// <summary>
+/// Release the backing store
+/// </summary>
+ObjectInput::~ObjectInput() {
+
+	// Buffered and caller-owned inputs need no cleanup
+	if (_source != Source::MemoryMapped) return;
+
+#ifdef _WIN32
+	if (_mappedAddress) UnmapViewOfFile(_mappedAddress);
+	if (_mappingHandle) CloseHandle(_mappingHandle);
+	if (_fileHandle) CloseHandle(_fileHandle);
+#else
+	if (_mappedAddress) munmap(_mappedAddress, _mappedLength);
+#endif
+}
+
+/// <summary>
+/// Wrap a buffer owned by the caller
+/// </summary>
+/// <param name="buffer">Object file contents</param>
+/// <param name="length">Length of buffer in bytes</param>
+/// <returns>Input referencing the caller's buffer</returns>
+unique_ptr<ObjectInput> ObjectInput::fromMemory(const char* buffer, size_t length) {
+
+	unique_ptr<ObjectInput> input = unique_ptr<ObjectInput>(new ObjectInput { Source::CallerBuffer });
+	input->_view = BufferView(buffer, length);
+
+	return input;
+}
+
+/// <summary>
+/// Map an object file read-only into memory
+/// </summary>
+/// <param name="filename">Object filename to map</param>
+/// <returns>Mapped input, or nullptr if the file couldn't be mapped</returns>
+unique_ptr<ObjectInput> ObjectInput::mapFile(const string& filename) {
+
+	unique_ptr<ObjectInput> input = unique_ptr<ObjectInput>(new ObjectInput { Source::MemoryMapped });
+
+#ifdef _WIN32
+	// Open the file, hinting that it will be read front to back
+	HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return nullptr;
+	input->_fileHandle = fileHandle;
+
+	// Empty files can't be mapped
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) return nullptr;
+	input->_mappedLength = (size_t)fileSize.QuadPart;
+
+	// Map the whole file
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) return nullptr;
+	input->_mappingHandle = mappingHandle;
+
+	input->_mappedAddress = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (input->_mappedAddress == nullptr) return nullptr;
+
+	// Ask the OS to start paging the file in
+	WIN32_MEMORY_RANGE_ENTRY range { input->_mappedAddress, input->_mappedLength };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// Open the file
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return nullptr;
+
+	// Empty files can't be mapped
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+	input->_mappedLength = (size_t)fileStat.st_size;
+
+	// Map the whole file; the mapping stays valid after the descriptor is closed
+	void* address = mmap(nullptr, input->_mappedLength, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED) return nullptr;
+	input->_mappedAddress = address;
+
+	// Chunks are walked front to back and every page will be touched
+	madvise(address, input->_mappedLength, MADV_SEQUENTIAL);
+	madvise(address, input->_mappedLength, MADV_WILLNEED);
+#endif
+
+	input->_view = BufferView((const char*)input->_mappedAddress, input->_mappedLength);
+
+	return input;
+}
+
+/// <summary>
+/// Open an object file, preferring a memory mapping over a buffered read
+/// </summary>
+/// <param name="filename">Object filename to open</param>
+/// <returns>Input, or nullptr if the file couldn't be read</returns>
+unique_ptr<ObjectInput> ObjectInput::open(const string& filename) {
+
+	// Try to map the file first
+	unique_ptr<ObjectInput> input = mapFile(filename);
+	if (input != nullptr) {
+		return input;
+	}
+
+	// Fall back to reading the file into memory
+	return readFile(filename);
+}
+
+/// <summary>
+/// Read a whole object file into memory
+/// </summary>
+/// <param name="filename">Object filename to read</param>
+/// <returns>Buffered input, or nullptr if the file couldn't be read</returns>
+unique_ptr<ObjectInput> ObjectInput::readFile(const string& filename) {
+
+	unique_ptr<ObjectInput> input = unique_ptr<ObjectInput>(new ObjectInput { Source::Buffered });
+	ifstream objectFile;	// File stream
+
+	// A failed open or a short read throws, rather than leaving part of the buffer unfilled
+	objectFile.exceptions(ifstream::failbit | ifstream::badbit);
+
+	// Read object file into memory
+	try {
+
+		// The file must exist
+		if (!filesystem::exists(filename)) {
+			cerr << "Could not find the file " << filename << "!" << endl;
+			return nullptr;
+		}
+
+		// Get the file size
+		size_t bufferSize = (size_t)filesystem::file_size(filename);
+
+		// Open the file for reading
+		objectFile.open(filename, ios::binary);
+
+		// Allocate the buffer
+		input->_buffer = unique_ptr<char[]>(new char[bufferSize]);
+		assert(input->_buffer != nullptr);
+
+		// Read file into memory
+		objectFile.read(input->_buffer.get(), bufferSize);
+
+		// Close file
+		objectFile.close();
+
+		input->_view = BufferView(input->_buffer.get(), bufferSize);
+	}
+	catch (const filesystem::filesystem_error&) {
+		// Couldn't get the file size
+		cerr << "EXCEPTION: Couldn't read the file size" << endl;
+		return nullptr;
+	}
+	catch (const ifstream::failure&) {
+		// Couldn't read the file
+		cerr << "EXCEPTION: Couldn't read the file contents" << endl;
+		return nullptr;
+	}
+	catch (...) {
+		// Mystery error
+		cerr << "EXCEPTION: An unknown error occured attempting to read the file" << endl;
+		return nullptr;
+	}
+
+	// Finished
+	return input;
+}
+
+/// <summary>
+/// Get the backing store type
+/// </summary>
+/// <returns>Input source</returns>
+ObjectInput::Source ObjectInput::getSource() const {
+	return _source;
+}
+
+/// <summary>
+/// Get a view over the whole input
+/// </summary>
+/// <returns>View of the input bytes</returns>
+BufferView ObjectInput::view() const {
+	return _view;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "BufferView.h"
+
+class ObjectInput {
+public:
+
+	// Backing store for the input bytes
+	enum class Source { MemoryMapped, CallerBuffer, Buffered };
+
+	// Destructor
+	~ObjectInput();
+
+	// Inputs own OS handles so they can't be copied
+	ObjectInput(const ObjectInput&) = delete;
+	ObjectInput& operator=(const ObjectInput&) = delete;
+
+	// Static factory methods
+	static std::unique_ptr<ObjectInput> fromMemory(const char* buffer, size_t length);
+	static std::unique_ptr<ObjectInput> mapFile(const std::string& filename);
+	static std::unique_ptr<ObjectInput> open(const std::string& filename);
+	static std::unique_ptr<ObjectInput> readFile(const std::string& filename);
+
+	// Getters
+	Source getSource() const;
+	BufferView view() const;
+
+private:
+
+	// Constructor
+	ObjectInput(Source source) : _source { source } { }
+
+	// Private data
+	Source _source;
+	BufferView _view;
+
+	// Buffered input
+	std::unique_ptr<char[]> _buffer;
+
+	// Memory-mapped input
+	void* _mappedAddress {};
+	size_t _mappedLength {};
+#ifdef _WIN32
+	void* _fileHandle {};
+	void* _mappingHandle {};
+#endif
+};
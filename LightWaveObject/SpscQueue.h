@@ -0,0 +1,108 @@
+//
+// SpscQueue class
+//
+// Bounded queue between exactly one producer thread and one consumer thread,
+// without locks. Each side writes only its own index and reads the other's
+// with acquire ordering, so an element is completely written before it can
+// be popped, and completely moved out before its slot is reused. Each side
+// also keeps a copy of the other's index and only rereads it when the queue
+// looks full or empty, so the indices' cache lines rarely move between cores.
+//
+#pragma once
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+
+template <typename T>
+class SpscQueue {
+public:
+
+	// Constructor
+	explicit SpscQueue(size_t capacity);
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Public methods
+	bool tryPop(T& value);
+	bool tryPush(T&& value);
+
+	// Getters
+	size_t getCapacity() const;
+
+private:
+
+	// Producer and consumer state on separate cache lines
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	// Private data
+	std::unique_ptr<T[]> _slots;
+	size_t _mask;								// Capacity - 1, the capacity being a power of two
+
+	// Consumer side
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head {};		// Next element to pop
+	size_t _cachedTail {};										// Last tail the consumer read
+
+	// Producer side
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail {};		// Next slot to push into
+	size_t _cachedHead {};										// Last head the producer read
+};
+
+/// <summary>
+/// Create an empty queue
+/// </summary>
+/// <param name="capacity">Most elements held at once, rounded up to a power of two</param>
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity) {
+	size_t slots = 1;
+	while (slots < capacity) slots *= 2;
+	_slots = std::make_unique<T[]>(slots);
+	_mask = slots - 1;
+}
+
+/// <summary>
+/// Get how many elements the queue can hold
+/// </summary>
+/// <returns>Capacity</returns>
+template <typename T>
+size_t SpscQueue<T>::getCapacity() const {
+	return _mask + 1;
+}
+
+/// <summary>
+/// Take the oldest element; consumer thread only
+/// </summary>
+/// <param name="value">Receives the element</param>
+/// <returns>False if the queue was empty</returns>
+template <typename T>
+bool SpscQueue<T>::tryPop(T& value) {
+
+	size_t head = _head.load(std::memory_order_relaxed);
+	if (head == _cachedTail) {
+		_cachedTail = _tail.load(std::memory_order_acquire);
+		if (head == _cachedTail) return false;
+	}
+
+	value = std::move(_slots[head & _mask]);
+	_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+/// <summary>
+/// Add an element; producer thread only
+/// </summary>
+/// <param name="value">Element, moved from only if it was added</param>
+/// <returns>False if the queue was full</returns>
+template <typename T>
+bool SpscQueue<T>::tryPush(T&& value) {
+
+	size_t tail = _tail.load(std::memory_order_relaxed);
+	if (tail - _cachedHead > _mask) {
+		_cachedHead = _head.load(std::memory_order_acquire);
+		if (tail - _cachedHead > _mask) return false;
+	}
+
+	_slots[tail & _mask] = std::move(value);
+	_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,228 @@
+//
+// SurfaceTable class
+//
+// Every SURF chunk of an object, wherever it appears, indexed by name. A
+// surface's source inheritance is resolved once when the table is built,
+// and surfaces that resolve to the same parameters share one parameter
+// block. The TAGS strings are mapped to surfaces up front, so a PTAG
+// surface index is looked up without searching.
+//
+#include <cstring>
+
+#include "SurfaceTable.h"
+#include "ContentHash.h"
+
+using namespace std;
+
+/// <summary>
+/// Create an empty table
+/// </summary>
+/// <param name="memory">Resource the table's arrays are allocated from</param>
+SurfaceTable::SurfaceTable(pmr::memory_resource* memory) : _memory { memory }, _surfaces { memory }, _surfaceByName { memory },
+	_parameterBlocks { memory }, _surfaceByTag { memory } {
+}
+
+/// <summary>
+/// Get the number of distinct resolved parameter blocks
+/// </summary>
+/// <returns>Number of parameter blocks</returns>
+size_t SurfaceTable::getNumParameterBlocks() {
+	return _parameterBlocks.size();
+}
+
+/// <summary>
+/// Get the number of surfaces
+/// </summary>
+/// <returns>Number of SURF chunks in the object</returns>
+size_t SurfaceTable::getNumSurfaces() {
+	return _surfaces.size();
+}
+
+/// <summary>
+/// Get a surface's name
+/// </summary>
+/// <param name="surfaceIndex">Surface index</param>
+/// <returns>Name, as the TAGS strings give it</returns>
+const pmr::string& SurfaceTable::getName(uint32_t surfaceIndex) {
+	return _surfaces[surfaceIndex].surface->getName();
+}
+
+/// <summary>
+/// Get a parameter block
+/// </summary>
+/// <param name="blockIndex">Parameter block index</param>
+/// <returns>Resolved parameters</returns>
+const SURFACE_PARAMETERS& SurfaceTable::getParameterBlock(uint32_t blockIndex) {
+	return _parameterBlocks[blockIndex];
+}
+
+/// <summary>
+/// Get the parameter block a surface resolves to. Surfaces with the same
+/// block look the same, so they can be drawn together.
+/// </summary>
+/// <param name="surfaceIndex">Surface index</param>
+/// <returns>Parameter block index</returns>
+uint32_t SurfaceTable::getParameterBlockIndex(uint32_t surfaceIndex) {
+	return _surfaces[surfaceIndex].parameterBlock;
+}
+
+/// <summary>
+/// Get a surface's parameters, with those it doesn't set taken from its source
+/// </summary>
+/// <param name="surfaceIndex">Surface index</param>
+/// <returns>Resolved parameters</returns>
+const SURFACE_PARAMETERS& SurfaceTable::getParameters(uint32_t surfaceIndex) {
+	return _parameterBlocks[_surfaces[surfaceIndex].parameterBlock];
+}
+
+/// <summary>
+/// Get the surface a surface derives from
+/// </summary>
+/// <param name="surfaceIndex">Surface index</param>
+/// <returns>Source surface index, or NO_SURFACE if the source is missing or closes a cycle</returns>
+uint32_t SurfaceTable::getSource(uint32_t surfaceIndex) {
+	return _surfaces[surfaceIndex].source;
+}
+
+/// <summary>
+/// Get a surface's chunk
+/// </summary>
+/// <param name="surfaceIndex">Surface index</param>
+/// <returns>SURF chunk</returns>
+Surface* SurfaceTable::getSurface(uint32_t surfaceIndex) {
+	return _surfaces[surfaceIndex].surface;
+}
+
+/// <summary>
+/// Get the surface a TAGS string names, e.g. for a PTAG surface index
+/// </summary>
+/// <param name="tagIndex">Index into the TAGS strings</param>
+/// <returns>Surface index, or NO_SURFACE if the tag names no surface</returns>
+uint32_t SurfaceTable::getSurfaceByTag(size_t tagIndex) {
+	return tagIndex < _surfaceByTag.size() ? _surfaceByTag[tagIndex] : NO_SURFACE;
+}
+
+/// <summary>
+/// Build the table, replacing any built before
+/// </summary>
+/// <param name="surfaces">SURF chunks in file order, which must outlive the table's contents</param>
+/// <param name="tags">TAGS strings, which PTAG surface indices refer to</param>
+void SurfaceTable::build(const pmr::vector<Surface*>& surfaces, const pmr::vector<pmr::string>& tags) {
+
+	clear();
+
+	// Index the surfaces by name; of several with one name, the first is found
+	_surfaces.reserve(surfaces.size());
+	_surfaceByName.reserve(surfaces.size());
+	for (Surface* surface : surfaces) {
+		const pmr::string& name = surface->getName();
+		_surfaceByName.emplace(string_view(name.data(), name.size()), uint32_t(_surfaces.size()));
+		_surfaces.push_back(SURFACE_ENTRY { surface, NO_SURFACE, 0 });
+	}
+
+	// Link each surface to its source
+	for (SURFACE_ENTRY& entry : _surfaces) {
+		const pmr::string& source = entry.surface->getSource();
+		if (!source.empty()) {
+			entry.source = findSurface(string_view(source.data(), source.size()));
+		}
+	}
+
+	resolveSources();
+
+	// Surface of each tag; tags that aren't surface names, such as part names, have none
+	_surfaceByTag.resize(tags.size());
+	for (size_t tagIndex = 0; tagIndex < tags.size(); tagIndex++) {
+		_surfaceByTag[tagIndex] = findSurface(string_view(tags[tagIndex].data(), tags[tagIndex].size()));
+	}
+}
+
+/// <summary>
+/// Empty the table and release its arrays
+/// </summary>
+void SurfaceTable::clear() {
+	pmr::vector<SURFACE_ENTRY>(_memory).swap(_surfaces);
+	pmr::unordered_map<string_view, uint32_t>(_memory).swap(_surfaceByName);
+	pmr::vector<SURFACE_PARAMETERS>(_memory).swap(_parameterBlocks);
+	pmr::vector<uint32_t>(_memory).swap(_surfaceByTag);
+}
+
+/// <summary>
+/// Find a surface by name
+/// </summary>
+/// <param name="name">Surface name</param>
+/// <returns>Surface index, or NO_SURFACE if there's none with the name</returns>
+uint32_t SurfaceTable::findSurface(string_view name) {
+	auto found = _surfaceByName.find(name);
+	return found != _surfaceByName.end() ? found->second : NO_SURFACE;
+}
+
+/// <summary>
+/// Find a parameter block equal to some parameters, adding one if there's none
+/// </summary>
+/// <param name="parameters">Resolved parameters</param>
+/// <param name="blockByHash">First block with each parameter hash</param>
+/// <returns>Parameter block index</returns>
+uint32_t SurfaceTable::addParameterBlock(const SURFACE_PARAMETERS& parameters, pmr::unordered_map<uint64_t, uint32_t>& blockByHash) {
+
+	// Blocks are compared byte for byte, since they have no padding
+	uint64_t hash = ContentHash::hash(&parameters, sizeof(parameters));
+	auto found = blockByHash.find(hash);
+	if (found != blockByHash.end() && memcmp(&_parameterBlocks[found->second], &parameters, sizeof(parameters)) == 0) {
+		return found->second;
+	}
+
+	// A block whose hash collides with another's is kept apart from it
+	uint32_t blockIndex = uint32_t(_parameterBlocks.size());
+	_parameterBlocks.push_back(parameters);
+	if (found == blockByHash.end()) {
+		blockByHash.emplace(hash, blockIndex);
+	}
+
+	return blockIndex;
+}
+
+/// <summary>
+/// Resolve each surface's parameters over those of its source, and share
+/// a parameter block between surfaces that resolve alike. Each surface is
+/// resolved once, after its source. Working arrays come from the table's
+/// memory resource too, so an object's arena holds them.
+/// </summary>
+void SurfaceTable::resolveSources() {
+
+	enum class State : uint8_t { PENDING, CHAINED, RESOLVED };
+	pmr::vector<State> states(_surfaces.size(), State::PENDING, _memory);
+	pmr::vector<uint32_t> chain(_memory);
+	pmr::unordered_map<uint64_t, uint32_t> blockByHash(_memory);
+	for (uint32_t surfaceIndex = 0; surfaceIndex < uint32_t(_surfaces.size()); surfaceIndex++) {
+
+		// Follow the sources to a resolved surface, a surface without one, or
+		// back to a surface already on the chain
+		chain.clear();
+		uint32_t index = surfaceIndex;
+		while (index != NO_SURFACE && states[index] == State::PENDING) {
+			states[index] = State::CHAINED;
+			chain.push_back(index);
+			index = _surfaces[index].source;
+		}
+
+		// A cycle is broken where it closes, so that surface derives from the defaults
+		SURFACE_PARAMETERS parameters {};
+		if (index != NO_SURFACE) {
+			if (states[index] == State::RESOLVED) {
+				parameters = _parameterBlocks[_surfaces[index].parameterBlock];
+			}
+			else {
+				_surfaces[chain.back()].source = NO_SURFACE;
+			}
+		}
+
+		// Resolve the chain from its root
+		for (size_t chainIndex = chain.size(); chainIndex-- > 0;) {
+			SURFACE_ENTRY& entry = _surfaces[chain[chainIndex]];
+			parameters = entry.surface->inheritParameters(parameters);
+			entry.parameterBlock = addParameterBlock(parameters, blockByHash);
+			states[chain[chainIndex]] = State::RESOLVED;
+		}
+	}
+}
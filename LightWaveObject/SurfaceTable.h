@@ -0,0 +1,54 @@
+#pragma once
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunks/ChunkDefinitions.h"
+#include "Chunks/Surface.h"
+
+class SurfaceTable {
+public:
+
+	// Index of a surface that isn't in the table
+	static const uint32_t NO_SURFACE = 0xffffffff;
+
+	// Constructor
+	explicit SurfaceTable(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+	// Getters
+	size_t getNumParameterBlocks();
+	size_t getNumSurfaces();
+	const std::pmr::string& getName(uint32_t surfaceIndex);
+	const SURFACE_PARAMETERS& getParameterBlock(uint32_t blockIndex);
+	uint32_t getParameterBlockIndex(uint32_t surfaceIndex);
+	const SURFACE_PARAMETERS& getParameters(uint32_t surfaceIndex);
+	uint32_t getSource(uint32_t surfaceIndex);
+	Surface* getSurface(uint32_t surfaceIndex);
+	uint32_t getSurfaceByTag(size_t tagIndex);
+
+	// Public methods
+	void build(const std::pmr::vector<Surface*>& surfaces, const std::pmr::vector<std::pmr::string>& tags);
+	void clear();
+	uint32_t findSurface(std::string_view name);
+
+private:
+
+	// Surface in the table
+	struct SURFACE_ENTRY {
+		Surface* surface;
+		uint32_t source;			// Surface this one derives from, or NO_SURFACE
+		uint32_t parameterBlock;	// Resolved parameters, shared with identical surfaces
+	};
+
+	// Private methods
+	uint32_t addParameterBlock(const SURFACE_PARAMETERS& parameters, std::pmr::unordered_map<uint64_t, uint32_t>& blockByHash);
+	void resolveSources();
+
+	// Private data
+	std::pmr::memory_resource* _memory;
+	std::pmr::vector<SURFACE_ENTRY> _surfaces;					// In file order
+	std::pmr::unordered_map<std::string_view, uint32_t> _surfaceByName;	// Names point into the surfaces
+	std::pmr::vector<SURFACE_PARAMETERS> _parameterBlocks;		// Distinct resolved parameters
+	std::pmr::vector<uint32_t> _surfaceByTag;					// Surface each TAGS string names, or NO_SURFACE
+};
@@ -0,0 +1,167 @@
+//
+// ThreadPool class
+//
+// Fixed set of worker threads that run the items of a parallel loop. The
+// calling thread works on the loop too, so a pool of N threads has N - 1
+// workers. Loops started from a worker, or while another loop is running,
+// run serially on the calling thread instead of waiting for the pool.
+//
+#include <algorithm>
+#include <string>
+
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
+
+using namespace std;
+
+namespace {
+
+	// Set on pool worker threads
+	thread_local bool isWorkerThread = false;
+}
+
+/// <summary>
+/// Start the worker threads
+/// </summary>
+/// <param name="numThreads">Total threads including the caller, or 0 for one per hardware thread</param>
+ThreadPool::ThreadPool(unsigned numThreads) {
+
+	if (numThreads == 0) {
+		numThreads = max(1u, thread::hardware_concurrency());
+	}
+
+	for (unsigned index = 1; index < numThreads; index++) {
+		_workers.emplace_back(&ThreadPool::workerLoop, this, index);
+	}
+}
+
+/// <summary>
+/// Stop and join the worker threads
+/// </summary>
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_batchReady.notify_all();
+
+	for (thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+/// <summary>
+/// Get the pool shared by the parser
+/// </summary>
+/// <returns>Shared pool, sized to the hardware</returns>
+ThreadPool& ThreadPool::getShared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+/// <summary>
+/// Call a function for every index in a range, spread across the pool,
+/// and wait for all calls to finish
+/// </summary>
+/// <param name="count">Number of indices</param>
+/// <param name="body">Function called with each index from 0 to count - 1</param>
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)>& body) {
+
+	// Run serially when there's nothing to share, or the pool is already in use
+	if (count <= 1 || _workers.empty() || isWorkerThread || !_batchMutex.try_lock()) {
+		for (size_t index = 0; index < count; index++) {
+			body(index);
+		}
+		return;
+	}
+	lock_guard<mutex> batchLock(_batchMutex, adopt_lock);
+	TraceScope trace("Parallel for", "items", int64_t(count));
+
+	// Publish the batch and wake the workers
+	{
+		lock_guard<mutex> lock(_mutex);
+		_body = &body;
+		_count = count;
+		_nextItem = 0;
+		_busyWorkers = unsigned(_workers.size());
+		_exception = nullptr;
+		_generation++;
+	}
+	_batchReady.notify_all();
+
+	// Work alongside the workers
+	runItems();
+
+	// Wait for the workers to finish their last items
+	exception_ptr exception;
+	{
+		unique_lock<mutex> lock(_mutex);
+		_batchDone.wait(lock, [this]() { return _busyWorkers == 0; });
+		_body = nullptr;
+		exception = _exception;
+	}
+
+	// Report the first failure to the caller
+	if (exception) {
+		rethrow_exception(exception);
+	}
+}
+
+/// <summary>
+/// Get the number of threads that run a parallel loop
+/// </summary>
+/// <returns>Number of workers plus the calling thread</returns>
+unsigned ThreadPool::getNumThreads() {
+	return unsigned(_workers.size()) + 1;
+}
+
+/// <summary>
+/// Claim and run items of the current batch until none are left
+/// </summary>
+void ThreadPool::runItems() {
+
+	for (size_t index = _nextItem++; index < _count; index = _nextItem++) {
+		try {
+			(*_body)(index);
+		}
+		catch (...) {
+
+			// Keep the first failure and abandon the remaining items
+			lock_guard<mutex> lock(_mutex);
+			if (!_exception) _exception = current_exception();
+			_nextItem = _count;
+		}
+	}
+}
+
+/// <summary>
+/// Worker thread body
+/// </summary>
+/// <param name="workerIndex">Worker number, from 1, to tell the workers apart in a trace</param>
+void ThreadPool::workerLoop(unsigned workerIndex) {
+
+	isWorkerThread = true;
+	TraceRecorder::getShared().setThreadName(("Pool worker " + to_string(workerIndex)).c_str());
+	unsigned seenGeneration = 0;
+
+	while (true) {
+
+		// Wait for a new batch
+		{
+			unique_lock<mutex> lock(_mutex);
+			_batchReady.wait(lock, [&]() { return _stopping || _generation != seenGeneration; });
+			if (_stopping) return;
+			seenGeneration = _generation;
+		}
+
+		TraceScope trace("Pool batch");
+		runItems();
+		trace.stop();
+
+		// Last worker out wakes the caller
+		lock_guard<mutex> lock(_mutex);
+		if (--_busyWorkers == 0) {
+			_batchDone.notify_one();
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+
+	// Constructor
+	explicit ThreadPool(unsigned numThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Static methods
+	static ThreadPool& getShared();
+
+	// Public methods
+	void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+	// Getters
+	unsigned getNumThreads();
+
+private:
+
+	// Private methods
+	void runItems();
+	void workerLoop(unsigned workerIndex);
+
+	// Worker threads
+	std::vector<std::thread> _workers;
+	bool _stopping {};
+
+	// Current batch
+	std::mutex _batchMutex;					// Held by the thread that submitted the batch
+	std::mutex _mutex;						// Guards the batch state below
+	std::condition_variable _batchReady;
+	std::condition_variable _batchDone;
+	const std::function<void(size_t)>* _body {};
+	size_t _count {};
+	std::atomic<size_t> _nextItem {};
+	unsigned _busyWorkers {};
+	unsigned _generation {};
+	std::exception_ptr _exception;
+};
@@ -0,0 +1,262 @@
+//
+// TraceRecorder class
+//
+// Records begin, end and counter events from any thread into a fixed ring
+// and writes them as a Chrome trace-event JSON file, which chrome://tracing
+// and Perfetto display as a timeline per thread. Recording an event is an
+// atomic increment and a store; when the recorder is off it's a single
+// relaxed load, so the trace points can stay in release builds.
+//
+#include <fstream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "TraceRecorder.h"
+
+using namespace std;
+
+const char* const TraceRecorder::ENVIRONMENT_VARIABLE = "LWO_TRACE";
+
+namespace {
+
+	// Source of small thread ids, which read better in a trace than system ids
+	atomic<uint32_t> nextThreadId { 1 };
+
+	/// <summary>
+	/// Get the trace id of the calling thread
+	/// </summary>
+	/// <returns>Thread id, starting from 1 in order of first use</returns>
+	uint32_t getThreadId() {
+		thread_local uint32_t threadId = nextThreadId++;
+		return threadId;
+	}
+
+	/// <summary>
+	/// Write a string as a JSON string literal
+	/// </summary>
+	/// <param name="stream">Output stream</param>
+	/// <param name="text">Text to quote</param>
+	void writeJsonString(ostream& stream, const char* text) {
+		stream << '"';
+		for (const char* c = text; *c != 0; c++) {
+			if (*c == '"' || *c == '\\') stream << '\\' << *c;
+			else if ((unsigned char)*c < 0x20) stream << ' ';
+			else stream << *c;
+		}
+		stream << '"';
+	}
+}
+
+/// <summary>
+/// Get the recorder that the loader, renderer and tools record to
+/// </summary>
+/// <returns>Shared recorder, off until started</returns>
+TraceRecorder& TraceRecorder::getShared() {
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+/// <summary>
+/// Record the start of a span on the calling thread
+/// </summary>
+/// <param name="name">Span name</param>
+/// <param name="argName">Name of a value shown with the span, or nullptr</param>
+/// <param name="value">Value shown with the span</param>
+void TraceRecorder::begin(const char* name, const char* argName, int64_t value) {
+	record('B', name, argName, value);
+}
+
+/// <summary>
+/// Record the current value of a counter, drawn as a graph under the threads
+/// </summary>
+/// <param name="name">Counter name</param>
+/// <param name="value">Counter value</param>
+void TraceRecorder::counter(const char* name, int64_t value) {
+	record('C', name, nullptr, value);
+}
+
+/// <summary>
+/// Record the end of the span most recently begun on the calling thread
+/// </summary>
+/// <param name="name">Span name</param>
+void TraceRecorder::end(const char* name) {
+	record('E', name, nullptr, 0);
+}
+
+/// <summary>
+/// Get a copy of an event name that lives as long as the recorder, for names
+/// that aren't literals. Intern names once, not per event.
+/// </summary>
+/// <param name="name">Event name</param>
+/// <returns>Stable copy of the name</returns>
+const char* TraceRecorder::internName(const string& name) {
+
+	lock_guard<mutex> lock(_namesMutex);
+	unique_ptr<char[]>& copy = _names[name];
+	if (!copy) {
+		copy = make_unique<char[]>(name.size() + 1);
+		name.copy(copy.get(), name.size());
+		copy[name.size()] = 0;
+	}
+
+	return copy.get();
+}
+
+/// <summary>
+/// Name the calling thread in the trace. Names are kept whether or not the
+/// recorder is on, so long-lived threads can name themselves when they start.
+/// </summary>
+/// <param name="name">Thread name</param>
+void TraceRecorder::setThreadName(const char* name) {
+	lock_guard<mutex> lock(_namesMutex);
+	_threadNames[getThreadId()] = name;
+}
+
+/// <summary>
+/// Discard any events and start recording. Call before the work to trace
+/// starts, not while other threads may be recording.
+/// </summary>
+/// <param name="capacity">Events kept, rounded up to a power of two</param>
+void TraceRecorder::start(size_t capacity) {
+
+	_enabled = false;
+
+	size_t ringSize = 1;
+	while (ringSize < capacity) ringSize *= 2;
+	if (ringSize != _capacity) {
+		_events = make_unique<TRACE_EVENT[]>(ringSize);
+		_capacity = ringSize;
+	}
+	_nextEvent = 0;
+	_origin = chrono::steady_clock::now();
+
+	_enabled = true;
+}
+
+/// <summary>
+/// Start recording if the trace environment variable names a file
+/// </summary>
+/// <param name="pathname">Trace file to write when the traced work is done</param>
+/// <returns>True if recording started</returns>
+bool TraceRecorder::startFromEnvironment(string& pathname) {
+
+#ifdef _MSC_VER
+	char* value = nullptr;
+	size_t length = 0;
+	if (_dupenv_s(&value, &length, ENVIRONMENT_VARIABLE) != 0 || value == nullptr) return false;
+	pathname = value;
+	free(value);
+#else
+	const char* value = getenv(ENVIRONMENT_VARIABLE);
+	if (value == nullptr) return false;
+	pathname = value;
+#endif
+
+	if (pathname.empty()) return false;
+	start();
+
+	return true;
+}
+
+/// <summary>
+/// Stop recording, keeping the events recorded so far
+/// </summary>
+void TraceRecorder::stop() {
+	_enabled = false;
+}
+
+/// <summary>
+/// Write the recorded events as a Chrome trace-event JSON file. Call once the
+/// traced work has finished; events recorded meanwhile may be written torn.
+/// </summary>
+/// <param name="pathname">Trace file</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>True if the file was written</returns>
+bool TraceRecorder::writeFile(const string& pathname, wstring& errorReason) {
+
+	ofstream file(pathname, ios::binary);
+	if (!file) {
+		errorReason = L"Couldn't create the trace file";
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << endl;
+	bool first = true;
+	auto separate = [&]() {
+		if (!first) file << "," << endl;
+		first = false;
+	};
+
+	// Thread names
+	{
+		lock_guard<mutex> lock(_namesMutex);
+		for (const auto& threadName : _threadNames) {
+			separate();
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadName.first << ",\"args\":{\"name\":";
+			writeJsonString(file, threadName.second.c_str());
+			file << "}}";
+		}
+	}
+
+	// Events still in the ring, oldest first
+	uint64_t numEvents = _nextEvent.load();
+	uint64_t firstEvent = numEvents > _capacity ? numEvents - _capacity : 0;
+	map<uint32_t, size_t> depths;			// Open spans per thread
+	file << fixed << setprecision(3);
+	for (uint64_t eventIndex = firstEvent; eventIndex < numEvents; eventIndex++) {
+		const TRACE_EVENT& event = _events[eventIndex & (_capacity - 1)];
+
+		// Skip ends whose begins were overwritten
+		size_t& depth = depths[event.threadId];
+		if (event.type == 'B') depth++;
+		else if (event.type == 'E' && depth-- == 0) {
+			depth = 0;
+			continue;
+		}
+
+		separate();
+		file << "{\"name\":";
+		writeJsonString(file, event.name);
+		file << ",\"ph\":\"" << event.type << "\",\"ts\":" << event.time / 1000.0
+			<< ",\"pid\":1,\"tid\":" << event.threadId;
+		if (event.type == 'C') {
+			file << ",\"args\":{\"value\":" << event.value << "}";
+		}
+		else if (event.argName != nullptr) {
+			file << ",\"args\":{";
+			writeJsonString(file, event.argName);
+			file << ":" << event.value << "}";
+		}
+		file << "}";
+	}
+
+	file << endl << "]}" << endl;
+	if (!file) {
+		errorReason = L"Couldn't write the trace file";
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Add an event to the ring, overwriting the oldest once it's full. Writers
+/// only share a slot if more events than the ring holds are recorded at once.
+/// </summary>
+/// <param name="type">Event type</param>
+/// <param name="name">Event name</param>
+/// <param name="argName">Name of value, or nullptr</param>
+/// <param name="value">Event value</param>
+void TraceRecorder::record(char type, const char* name, const char* argName, int64_t value) {
+
+	if (!isEnabled()) return;
+
+	uint64_t eventIndex = _nextEvent.fetch_add(1, memory_order_relaxed);
+	TRACE_EVENT& event = _events[eventIndex & (_capacity - 1)];
+	event.time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _origin).count();
+	event.name = name;
+	event.argName = argName;
+	event.value = value;
+	event.threadId = getThreadId();
+	event.type = type;
+}
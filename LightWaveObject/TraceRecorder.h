@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+// One recorded event. Names aren't copied, so they must outlive the recorder:
+// string literals, or names from TraceRecorder::internName.
+struct TRACE_EVENT {
+	int64_t time;					// Nanoseconds since the recorder started
+	const char* name;
+	const char* argName;			// Name of value, or null when there's none
+	int64_t value;
+	uint32_t threadId;
+	char type;						// 'B' begin, 'E' end or 'C' counter, as in the trace format
+};
+
+class TraceRecorder {
+public:
+
+	// Events kept by default; the oldest are overwritten once it fills
+	static const size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+	// Environment variable holding the trace file to write, which turns tracing on
+	static const char* const ENVIRONMENT_VARIABLE;
+
+	// Constructor
+	TraceRecorder() = default;
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	// Static methods
+	static TraceRecorder& getShared();
+
+	// Public methods
+	void begin(const char* name, const char* argName = nullptr, int64_t value = 0);
+	void counter(const char* name, int64_t value);
+	void end(const char* name);
+	const char* internName(const std::string& name);
+	void setThreadName(const char* name);
+	void start(size_t capacity = DEFAULT_CAPACITY);
+	bool startFromEnvironment(std::string& pathname);
+	void stop();
+	bool writeFile(const std::string& pathname, std::wstring& errorReason);
+
+	// Getters
+	bool isEnabled() const {
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	// Private methods
+	void record(char type, const char* name, const char* argName, int64_t value);
+
+	// Events, used as a ring of a power of two size
+	std::unique_ptr<TRACE_EVENT[]> _events;
+	size_t _capacity {};
+	std::atomic<uint64_t> _nextEvent {};
+	std::atomic<bool> _enabled {};
+	std::chrono::steady_clock::time_point _origin;
+
+	// Thread names and interned event names, which change rarely
+	std::mutex _namesMutex;
+	std::map<uint32_t, std::string> _threadNames;
+	std::map<std::string, std::unique_ptr<char[]>> _names;
+};
+
+// Records a begin event now and the matching end event when it stops or
+// goes out of scope. Does nothing, not even read the clock, when the shared
+// recorder is off.
+class TraceScope {
+public:
+
+	// Constructor
+	explicit TraceScope(const char* name, const char* argName = nullptr, int64_t value = 0) {
+		TraceRecorder& recorder = TraceRecorder::getShared();
+		if (!recorder.isEnabled()) return;
+		recorder.begin(name, argName, value);
+		_name = name;
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+	// Destructor
+	~TraceScope() {
+		stop();
+	}
+
+	// Public methods
+	void stop() {
+		if (_name == nullptr) return;
+		TraceRecorder::getShared().end(_name);
+		_name = nullptr;
+	}
+
+private:
+
+	// Private data
+	const char* _name {};
+};
@@ -0,0 +1,380 @@
+//
+// MeshCache class
+//
+// Keeps the triangulated vertex and index streams of each loaded object in a
+// cache file, so reloading an unchanged object maps the streams back in
+// instead of parsing and triangulating the object again.
+//
+// A cache file is a FILE_HEADER, the source pathname, then the layer, surface
+// and draw range tables and the vertex and index streams, each aligned to
+// STREAM_ALIGNMENT. Values are stored in the native byte order. An entry is
+// used only when its header, version, vertex size and tables check out and
+// its source file hasn't changed; anything else removes the entry so it's
+// rebuilt on the next store. The stream hash is written with every entry but
+// only checked in verify mode, as hashing the streams would cost a warm load
+// about as much as reading them.
+//
+// The source is identified by the object's content hash, the same hash
+// LightWaveObject builds from its chunks, so an entry whose source was only
+// rewritten is checked against a read of the object rather than a hash of
+// the file.
+//
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+#include "LightWaveObject/ContentHash.h"
+#include "MeshCache.h"
+
+using namespace std;
+
+namespace {
+
+	// Cache file signature
+	const char MAGIC[8] = "LWOMESH";
+
+	// Cache file extension
+	const char* EXTENSION = ".lwomesh";
+
+	/// <summary>
+	/// Round an offset up to the stream alignment
+	/// </summary>
+	/// <param name="offset">Offset within the cache file</param>
+	/// <returns>Aligned offset</returns>
+	uint64_t alignOffset(uint64_t offset) {
+		return (offset + MeshCache::STREAM_ALIGNMENT - 1) & ~uint64_t(MeshCache::STREAM_ALIGNMENT - 1);
+	}
+
+	/// <summary>
+	/// Get the absolute, normalized form of a source pathname
+	/// </summary>
+	/// <param name="sourcePathname">Object pathname</param>
+	/// <returns>Pathname used to key the cache</returns>
+	string getSourceKey(const string& sourcePathname) {
+		error_code error;
+		filesystem::path path = filesystem::absolute(sourcePathname, error);
+		if (error) path = sourcePathname;
+		return path.lexically_normal().string();
+	}
+
+	/// <summary>
+	/// Check the layer and draw range tables only refer to elements the
+	/// entry holds, so a corrupt entry can't send its readers out of bounds
+	/// </summary>
+	/// <param name="header">Cache file header, with the streams within the file</param>
+	/// <param name="layers">Layer table</param>
+	/// <param name="ranges">Draw range table</param>
+	/// <returns>True if every range lies within its table or stream</returns>
+	bool checkTables(const MeshCache::FILE_HEADER& header, const MESH_LAYER* layers, const MESH_RANGE* ranges) {
+
+		for (uint64_t layerIndex = 0; layerIndex < header.numMeshLayers; layerIndex++) {
+			const MESH_LAYER& layer = layers[layerIndex];
+			if (uint64_t(layer.firstVertex) + layer.numVertices > header.numVertices
+				|| uint64_t(layer.firstIndex) + layer.numIndices > header.numIndices
+				|| uint64_t(layer.firstRange) + layer.numRanges > header.numRanges) return false;
+		}
+
+		for (uint64_t rangeIndex = 0; rangeIndex < header.numRanges; rangeIndex++) {
+			const MESH_RANGE& range = ranges[rangeIndex];
+			if (range.surface >= header.numSurfaces
+				|| uint64_t(range.firstIndex) + range.numIndices > header.numIndices) return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Get the size and write time of a source file
+	/// </summary>
+	/// <param name="sourcePathname">Object pathname</param>
+	/// <param name="size">File size in bytes</param>
+	/// <param name="modified">Write time in file clock ticks</param>
+	/// <returns>True if the file exists</returns>
+	bool getSourceStatus(const string& sourcePathname, uint64_t& size, int64_t& modified) {
+		error_code error;
+		size = filesystem::file_size(sourcePathname, error);
+		if (error) return false;
+		modified = (int64_t)filesystem::last_write_time(sourcePathname, error).time_since_epoch().count();
+		return !error;
+	}
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="directory">Directory that holds the cache files</param>
+MeshCache::MeshCache(filesystem::path directory) : _directory { move(directory) } {
+}
+
+/// <summary>
+/// Get the default cache directory
+/// </summary>
+/// <returns>Directory under the user's temporary directory</returns>
+filesystem::path MeshCache::GetDefaultDirectory() {
+	error_code error;
+	filesystem::path temp = filesystem::temp_directory_path(error);
+	if (error) temp = ".";
+	return temp / "LWObjectViewer" / "MeshCache";
+}
+
+/// <summary>
+/// Get the cache file used for an object
+/// </summary>
+/// <param name="sourcePathname">Object pathname</param>
+/// <returns>Cache file pathname</returns>
+filesystem::path MeshCache::GetEntryPath(const string& sourcePathname) {
+
+	string key = getSourceKey(sourcePathname);
+	uint64_t hash = ContentHash::hash(key.data(), key.size());
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+	return _directory / (string(name) + EXTENSION);
+}
+
+/// <summary>
+/// Set whether loads check the stream hash, reading every byte of the entry,
+/// rather than only the header and tables
+/// </summary>
+/// <param name="verifyStreams">True to verify the streams on every load</param>
+void MeshCache::SetVerifyStreams(bool verifyStreams) {
+	_verifyStreams = verifyStreams;
+}
+
+/// <summary>
+/// Map the cached mesh of an object
+/// </summary>
+/// <param name="sourcePathname">Object pathname</param>
+/// <param name="vertexSize">Expected size of one vertex in bytes</param>
+/// <param name="entry">Mapped mesh</param>
+/// <returns>True if a valid entry was found; invalid entries are removed</returns>
+bool MeshCache::Load(const string& sourcePathname, size_t vertexSize, ENTRY& entry) {
+
+	entry = ENTRY {};
+
+	// Current state of the source file
+	uint64_t sourceSize;
+	int64_t sourceModified;
+	if (!getSourceStatus(sourcePathname, sourceSize, sourceModified)) return false;
+
+	// Map the cache file
+	filesystem::path entryPath = GetEntryPath(sourcePathname);
+	error_code error;
+	if (!filesystem::exists(entryPath, error)) return false;
+	unique_ptr<ObjectInput> file = ObjectInput::open(entryPath.string());
+	if (file == nullptr) {
+		Remove(sourcePathname);
+		return false;
+	}
+	const char* data = file->view().data();
+	uint64_t fileSize = file->view().size();
+
+	// Check the header
+	FILE_HEADER header;
+	bool valid = fileSize >= sizeof(FILE_HEADER);
+	if (valid) {
+		memcpy(&header, data, sizeof(header));
+		valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+			&& header.version == VERSION
+			&& header.headerSize == sizeof(FILE_HEADER)
+			&& vertexSize > 0
+			&& header.vertexSize == vertexSize;
+	}
+
+	// Check the streams lie within the file without overflowing
+	if (valid) {
+		valid = header.pathLength <= fileSize - sizeof(FILE_HEADER)
+			&& header.layerOffset % STREAM_ALIGNMENT == 0
+			&& header.surfaceOffset % STREAM_ALIGNMENT == 0
+			&& header.rangeOffset % STREAM_ALIGNMENT == 0
+			&& header.vertexOffset % STREAM_ALIGNMENT == 0
+			&& header.indexOffset % STREAM_ALIGNMENT == 0
+			&& header.layerOffset >= sizeof(FILE_HEADER) + header.pathLength
+			&& header.layerOffset <= fileSize
+			&& header.numMeshLayers <= (fileSize - header.layerOffset) / sizeof(MESH_LAYER)
+			&& header.surfaceOffset >= header.layerOffset + header.numMeshLayers * sizeof(MESH_LAYER)
+			&& header.surfaceOffset <= fileSize
+			&& header.numSurfaces <= (fileSize - header.surfaceOffset) / sizeof(MESH_SURFACE)
+			&& header.rangeOffset >= header.surfaceOffset + header.numSurfaces * sizeof(MESH_SURFACE)
+			&& header.rangeOffset <= fileSize
+			&& header.numRanges <= (fileSize - header.rangeOffset) / sizeof(MESH_RANGE)
+			&& header.vertexOffset >= header.rangeOffset + header.numRanges * sizeof(MESH_RANGE)
+			&& header.vertexOffset <= fileSize
+			&& header.numVertices <= (fileSize - header.vertexOffset) / vertexSize
+			&& header.indexOffset >= header.vertexOffset + header.numVertices * vertexSize
+			&& header.indexOffset <= fileSize
+			&& header.numIndices <= (fileSize - header.indexOffset) / sizeof(uint32_t);
+	}
+
+	// Check the entry belongs to this object, rather than one whose path hashes the same
+	string key = getSourceKey(sourcePathname);
+	if (valid) {
+		valid = header.pathLength == key.size() && memcmp(data + sizeof(FILE_HEADER), key.data(), key.size()) == 0;
+	}
+
+	// Check the tables, and in verify mode that the streams weren't corrupted
+	const char* layers = nullptr;
+	const char* surfaces = nullptr;
+	const char* ranges = nullptr;
+	const char* vertices = nullptr;
+	const char* indices = nullptr;
+	if (valid) {
+		layers = data + header.layerOffset;
+		surfaces = data + header.surfaceOffset;
+		ranges = data + header.rangeOffset;
+		vertices = data + header.vertexOffset;
+		indices = data + header.indexOffset;
+		valid = checkTables(header, (const MESH_LAYER*)layers, (const MESH_RANGE*)ranges);
+	}
+	if (valid && _verifyStreams) {
+		ContentHash streamHash;
+		streamHash.update(layers, header.numMeshLayers * sizeof(MESH_LAYER));
+		streamHash.update(surfaces, header.numSurfaces * sizeof(MESH_SURFACE));
+		streamHash.update(ranges, header.numRanges * sizeof(MESH_RANGE));
+		streamHash.update(vertices, header.numVertices * vertexSize);
+		streamHash.update(indices, header.numIndices * sizeof(uint32_t));
+		valid = streamHash.digest() == header.streamHash;
+	}
+
+	// Reject entries that don't match the source file. A changed write time alone
+	// doesn't invalidate the entry if the contents are the same, as after a copy,
+	// but the caller has to check the object's content hash before using it
+	bool sourceChanged = false;
+	if (valid) {
+		valid = header.sourceSize == sourceSize;
+		if (valid && header.sourceModified != sourceModified) {
+			sourceChanged = true;
+			valid = header.sourceHash != 0;
+		}
+	}
+
+	if (!valid) {
+		file.reset();
+		Remove(sourcePathname);
+		return false;
+	}
+
+	// Hand out the mapped streams
+	entry.file = move(file);
+	entry.layers = (const MESH_LAYER*)layers;
+	entry.numMeshLayers = (size_t)header.numMeshLayers;
+	entry.surfaces = (const MESH_SURFACE*)surfaces;
+	entry.numSurfaces = (size_t)header.numSurfaces;
+	entry.ranges = (const MESH_RANGE*)ranges;
+	entry.numRanges = (size_t)header.numRanges;
+	entry.vertices = vertices;
+	entry.numVertices = (size_t)header.numVertices;
+	entry.indices = (const uint32_t*)indices;
+	entry.numIndices = (size_t)header.numIndices;
+	entry.info = header.info;
+	entry.sourceHash = header.sourceHash;
+	entry.sourceChanged = sourceChanged;
+
+	return true;
+}
+
+/// <summary>
+/// Remove the cached mesh of an object
+/// </summary>
+/// <param name="sourcePathname">Object pathname</param>
+void MeshCache::Remove(const string& sourcePathname) {
+	error_code error;
+	filesystem::remove(GetEntryPath(sourcePathname), error);
+}
+
+/// <summary>
+/// Write the mesh of an object to the cache
+/// </summary>
+/// <param name="sourcePathname">Object pathname</param>
+/// <param name="sourceHash">Content hash of the object, or zero if it wasn't hashed</param>
+/// <param name="layers">Layer table</param>
+/// <param name="numMeshLayers">Number of layers in the table</param>
+/// <param name="surfaces">Surface table</param>
+/// <param name="numSurfaces">Number of surfaces in the table</param>
+/// <param name="ranges">Draw range table</param>
+/// <param name="numRanges">Number of draw ranges in the table</param>
+/// <param name="vertices">Vertex stream</param>
+/// <param name="numVertices">Number of vertices</param>
+/// <param name="vertexSize">Size of one vertex in bytes</param>
+/// <param name="indices">Triangle index stream</param>
+/// <param name="numIndices">Number of indices</param>
+/// <param name="info">Object info</param>
+/// <returns>True if the entry was written</returns>
+bool MeshCache::Store(const string& sourcePathname, uint64_t sourceHash, const MESH_LAYER* layers, size_t numMeshLayers, const MESH_SURFACE* surfaces, size_t numSurfaces,
+	const MESH_RANGE* ranges, size_t numRanges, const void* vertices, size_t numVertices, size_t vertexSize, const uint32_t* indices, size_t numIndices, const MESH_INFO& info) {
+
+	// Identify the source file
+	uint64_t sourceSize;
+	int64_t sourceModified;
+	if (!getSourceStatus(sourcePathname, sourceSize, sourceModified)) return false;
+
+	// Lay out the file
+	string key = getSourceKey(sourcePathname);
+	FILE_HEADER header {};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.headerSize = sizeof(FILE_HEADER);
+	header.vertexSize = (uint32_t)vertexSize;
+	header.pathLength = (uint32_t)key.size();
+	header.sourceSize = sourceSize;
+	header.sourceModified = sourceModified;
+	header.sourceHash = sourceHash;
+	header.numMeshLayers = numMeshLayers;
+	header.numSurfaces = numSurfaces;
+	header.numRanges = numRanges;
+	header.numVertices = numVertices;
+	header.numIndices = numIndices;
+	header.layerOffset = alignOffset(sizeof(FILE_HEADER) + key.size());
+	header.surfaceOffset = alignOffset(header.layerOffset + numMeshLayers * sizeof(MESH_LAYER));
+	header.rangeOffset = alignOffset(header.surfaceOffset + numSurfaces * sizeof(MESH_SURFACE));
+	header.vertexOffset = alignOffset(header.rangeOffset + numRanges * sizeof(MESH_RANGE));
+	header.indexOffset = alignOffset(header.vertexOffset + numVertices * vertexSize);
+	ContentHash streamHash;
+	streamHash.update(layers, numMeshLayers * sizeof(MESH_LAYER));
+	streamHash.update(surfaces, numSurfaces * sizeof(MESH_SURFACE));
+	streamHash.update(ranges, numRanges * sizeof(MESH_RANGE));
+	streamHash.update(vertices, numVertices * vertexSize);
+	streamHash.update(indices, numIndices * sizeof(uint32_t));
+	header.streamHash = streamHash.digest();
+	header.info = info;
+
+	// Write to a temporary file so readers never see a partial entry
+	error_code error;
+	filesystem::create_directories(_directory, error);
+	filesystem::path entryPath = GetEntryPath(sourcePathname);
+	filesystem::path tempPath = entryPath;
+	tempPath += ".tmp";
+	{
+		ofstream file(tempPath, ios::binary | ios::trunc);
+		if (!file) return false;
+
+		const char padding[STREAM_ALIGNMENT] {};
+		file.write((const char*)&header, sizeof(header));
+		file.write(key.data(), key.size());
+		file.write(padding, header.layerOffset - sizeof(FILE_HEADER) - key.size());
+		file.write((const char*)layers, numMeshLayers * sizeof(MESH_LAYER));
+		file.write(padding, header.surfaceOffset - header.layerOffset - numMeshLayers * sizeof(MESH_LAYER));
+		file.write((const char*)surfaces, numSurfaces * sizeof(MESH_SURFACE));
+		file.write(padding, header.rangeOffset - header.surfaceOffset - numSurfaces * sizeof(MESH_SURFACE));
+		file.write((const char*)ranges, numRanges * sizeof(MESH_RANGE));
+		file.write(padding, header.vertexOffset - header.rangeOffset - numRanges * sizeof(MESH_RANGE));
+		file.write((const char*)vertices, numVertices * vertexSize);
+		file.write(padding, header.indexOffset - header.vertexOffset - numVertices * vertexSize);
+		file.write((const char*)indices, numIndices * sizeof(uint32_t));
+
+		if (!file.flush()) {
+			file.close();
+			filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	// Replace any previous entry
+	filesystem::rename(tempPath, entryPath, error);
+	if (error) {
+		filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
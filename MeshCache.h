@@ -0,0 +1,92 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include "LightWaveObject/ObjectInput.h"
+#include "MeshDefinitions.h"
+
+class MeshCache {
+public:
+
+	// Bump whenever the file layout or the triangulation changes
+	static const uint32_t VERSION = 7;
+
+	// Tables, vertex and index streams start on this boundary within a cache file
+	static const size_t STREAM_ALIGNMENT = 64;
+
+	// Object info stored with the mesh
+	struct MESH_INFO {
+		int32_t numLayers = 0;
+		int32_t numPolygons = 0;
+		int32_t numTriangles = 0;
+		int32_t numNonTriangles = 0;
+	};
+
+	// Cache file header
+	struct FILE_HEADER {
+		char magic[8];				// "LWOMESH", zero terminated
+		uint32_t version;			// VERSION
+		uint32_t headerSize;		// sizeof(FILE_HEADER)
+		uint32_t vertexSize;		// Size of one vertex in bytes
+		uint32_t pathLength;		// Length of the source path stored after the header
+		uint64_t sourceSize;		// Source file size
+		int64_t sourceModified;		// Source file write time
+		uint64_t sourceHash;		// Content hash of the object the mesh was built from
+		uint64_t numMeshLayers;
+		uint64_t numSurfaces;
+		uint64_t numRanges;
+		uint64_t numVertices;
+		uint64_t numIndices;
+		uint64_t layerOffset;		// Offset of the layer table, aligned to STREAM_ALIGNMENT
+		uint64_t surfaceOffset;		// Offset of the surface table, aligned to STREAM_ALIGNMENT
+		uint64_t rangeOffset;		// Offset of the draw range table, aligned to STREAM_ALIGNMENT
+		uint64_t vertexOffset;		// Offset of the vertex stream, aligned to STREAM_ALIGNMENT
+		uint64_t indexOffset;		// Offset of the 32-bit index stream, aligned to STREAM_ALIGNMENT
+		uint64_t streamHash;		// Hash of the tables and both streams, checked on load in verify mode
+		MESH_INFO info;
+	};
+
+	// Mesh mapped from a cache file
+	struct ENTRY {
+		std::unique_ptr<ObjectInput> file;		// Keeps the streams mapped
+		const MESH_LAYER* layers = nullptr;
+		size_t numMeshLayers = 0;
+		const MESH_SURFACE* surfaces = nullptr;
+		size_t numSurfaces = 0;
+		const MESH_RANGE* ranges = nullptr;
+		size_t numRanges = 0;
+		const void* vertices = nullptr;
+		size_t numVertices = 0;
+		const uint32_t* indices = nullptr;
+		size_t numIndices = 0;
+		MESH_INFO info;
+		uint64_t sourceHash = 0;				// Content hash of the object the mesh was built from
+		bool sourceChanged = false;				// The source was written since, so the mesh holds only if its hash is still sourceHash
+	};
+
+	// Constructor
+	explicit MeshCache(std::filesystem::path directory = GetDefaultDirectory());
+
+	// Static methods
+	static std::filesystem::path GetDefaultDirectory();
+
+	// Setters
+	void SetVerifyStreams(bool verifyStreams);
+
+	// Public methods
+	bool Load(const std::string& sourcePathname, size_t vertexSize, ENTRY& entry);
+	void Remove(const std::string& sourcePathname);
+	bool Store(const std::string& sourcePathname, uint64_t sourceHash, const MESH_LAYER* layers, size_t numMeshLayers, const MESH_SURFACE* surfaces, size_t numSurfaces,
+		const MESH_RANGE* ranges, size_t numRanges, const void* vertices, size_t numVertices, size_t vertexSize, const uint32_t* indices, size_t numIndices, const MESH_INFO& info);
+
+	// Getters
+	std::filesystem::path GetEntryPath(const std::string& sourcePathname);
+
+private:
+
+	// Private data
+	std::filesystem::path _directory;
+	bool _verifyStreams {};					// Hash the tables and streams on every load, not just when storing
+};
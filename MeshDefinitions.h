@@ -0,0 +1,73 @@
+//
+// Mesh Definitions
+//
+// Vertex layout shared by the mesh extraction and the renderer. Kept free
+// of platform headers so meshes can be extracted without Direct3D.
+//
+#pragma once
+#include <stdint.h>
+
+//
+// Vector components
+//
+struct MESH_FLOAT3 {
+	float x;
+	float y;
+	float z;
+};
+
+struct MESH_FLOAT4 {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+//
+// Vertex structure, matching the renderer's input layout. The color comes
+// from the surface of the draw range the vertex is drawn in.
+//
+struct VERTEX {
+	MESH_FLOAT3 pos;
+	MESH_FLOAT3 normal;
+};
+
+//
+// Surface shared by the triangles of draw ranges, held once per surface
+// rather than in every vertex
+//
+struct MESH_SURFACE {
+	MESH_FLOAT4 color;
+};
+
+//
+// Run of a layer's indices whose triangles all have the same surface, so
+// it's drawn with one call. A layer's ranges are contiguous and in index order.
+//
+struct MESH_RANGE {
+	uint32_t surface;			// Index into the mesh's surfaces
+	uint32_t firstIndex;
+	uint32_t numIndices;
+};
+
+//
+// Range of the combined mesh holding one object layer. The layer's vertices
+// are in object coordinates, as in the object file, and its indices index
+// the combined vertex list. Stored as is in mesh cache files.
+//
+struct MESH_LAYER {
+
+	// Flag of layers the object hides
+	static const uint32_t HIDDEN = 1;
+
+	int32_t number;				// Layer number from the object file
+	int32_t parent;				// Parent layer number, or -1 for none
+	uint32_t flags;				// HIDDEN, as set in the object file
+	MESH_FLOAT3 pivot;			// Layer origin in object coordinates
+	uint32_t firstVertex;
+	uint32_t numVertices;
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	uint32_t firstRange;		// The layer's draw ranges, by surface
+	uint32_t numRanges;
+};
@@ -0,0 +1,271 @@
+//
+// ObjectLoader class
+//
+// Loads objects on a background thread so the caller, usually the UI thread,
+// never waits for a parse. Each load has its own LoadControl, which reports
+// progress and is checked between chunks and polygon batches. A new request
+// cancels the load in progress rather than queueing behind it, and only the
+// latest request is kept.
+//
+// A finished load is published as an immutable MESH_SNAPSHOT behind a
+// shared_ptr, swapped in with an atomic store. Readers keep the snapshot
+// they took for as long as they use it, so the previous mesh stays valid
+// until they pick up the new one. Publishing happens under the request
+// mutex, so a load cancelled by a newer request is never published.
+//
+// Progressive loads also hand over each batch of triangulated polygons as
+// it's ready, through a lock-free single-producer single-consumer queue, so
+// the consumer can show a large object long before it finishes loading. The
+// loader thread waits while the queue is full, so the consumer must keep
+// popping batches while progressive loads run.
+//
+// Nothing here depends on the renderer, so loading runs headless as well.
+//
+#include "ObjectLoader.h"
+
+using namespace std;
+
+/// <summary>
+/// Start the loader thread
+/// </summary>
+/// <param name="meshCache">Cache of triangulated meshes, or nullptr to always parse; only used on the loader thread</param>
+ObjectLoader::ObjectLoader(MeshCache* meshCache) : _meshCache { meshCache } {
+	_worker = thread(&ObjectLoader::WorkerLoop, this);
+}
+
+/// <summary>
+/// Cancel any load and stop the loader thread
+/// </summary>
+ObjectLoader::~ObjectLoader() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stopping = true;
+		_pendingLoadId = 0;
+		if (_currentControl) _currentControl->cancel();
+	}
+	_requestReady.notify_all();
+	_worker.join();
+}
+
+/// <summary>
+/// Cancel the load in progress and drop any waiting request. The current
+/// mesh is kept.
+/// </summary>
+void ObjectLoader::Cancel() {
+	lock_guard<mutex> lock(_mutex);
+	_pendingLoadId = 0;
+	if (_currentControl) _currentControl->cancel();
+}
+
+/// <summary>
+/// Get the latest loaded mesh
+/// </summary>
+/// <returns>Mesh, or null if nothing has loaded yet</returns>
+shared_ptr<const ObjectLoader::MESH_SNAPSHOT> ObjectLoader::GetMesh() {
+	return atomic_load(&_mesh);
+}
+
+/// <summary>
+/// Check whether a load is in progress or waiting
+/// </summary>
+/// <returns>True until the loader is idle</returns>
+bool ObjectLoader::IsLoading() {
+	lock_guard<mutex> lock(_mutex);
+	return _pendingLoadId != 0 || _busy;
+}
+
+/// <summary>
+/// Request a load, cancelling the load in progress and replacing any request
+/// that hasn't started. Returns at once; the completion callback reports how
+/// the load ended.
+/// </summary>
+/// <param name="objectPathname">Full path and filename for the object file</param>
+/// <returns>Identifier of the load, passed to the callbacks</returns>
+uint64_t ObjectLoader::Load(const string& objectPathname) {
+
+	uint64_t loadId;
+	{
+		lock_guard<mutex> lock(_mutex);
+		loadId = ++_lastLoadId;
+		_pendingPathname = objectPathname;
+		_pendingLoadId = loadId;
+		if (_currentControl) _currentControl->cancel();
+	}
+	_requestReady.notify_one();
+
+	return loadId;
+}
+
+/// <summary>
+/// Take the next batch of a progressive load. Batches of every started load
+/// come in order, including loads that were later cancelled, so consumers
+/// should check the load identifier. Call from one thread only.
+/// </summary>
+/// <param name="batch">Receives the batch</param>
+/// <returns>False if no batch is waiting</returns>
+bool ObjectLoader::PopBatch(MESH_BATCH& batch) {
+	return _batches.tryPop(batch);
+}
+
+/// <summary>
+/// Choose whether loads record timings and counters in their snapshots
+/// </summary>
+/// <param name="collectStatistics">True to collect load statistics</param>
+void ObjectLoader::SetCollectStatistics(bool collectStatistics) {
+	lock_guard<mutex> lock(_mutex);
+	_collectStatistics = collectStatistics;
+}
+
+/// <summary>
+/// Set the function told how each started load ended, on the loader thread.
+/// Requests replaced before they started aren't reported.
+/// </summary>
+/// <param name="completionCallback">Completion function, or empty for none</param>
+void ObjectLoader::SetCompletionCallback(CompletionCallback completionCallback) {
+	lock_guard<mutex> lock(_mutex);
+	_completionCallback = move(completionCallback);
+}
+
+/// <summary>
+/// Set the function told how far each load has got. It's called from the
+/// threads doing the work, possibly several at once, so it should be quick.
+/// </summary>
+/// <param name="progressCallback">Progress function, or empty for none</param>
+void ObjectLoader::SetProgressCallback(ProgressCallback progressCallback) {
+	lock_guard<mutex> lock(_mutex);
+	_progressCallback = move(progressCallback);
+}
+
+/// <summary>
+/// Choose whether loads hand over batches of polygons as they're
+/// triangulated, to be taken with PopBatch
+/// </summary>
+/// <param name="progressive">True for progressive loads</param>
+void ObjectLoader::SetProgressive(bool progressive) {
+	lock_guard<mutex> lock(_mutex);
+	_progressive = progressive;
+}
+
+/// <summary>
+/// Wait until no load is in progress or waiting, and the last one has
+/// been reported
+/// </summary>
+void ObjectLoader::WaitForIdle() {
+	unique_lock<mutex> lock(_mutex);
+	_idle.wait(lock, [&]() { return _pendingLoadId == 0 && !_busy; });
+}
+
+/// <summary>
+/// Queue a batch for the consumer, waiting while the queue is full
+/// </summary>
+/// <param name="batch">Batch, moved from once it's queued</param>
+/// <param name="loadControl">Control of the load, which stops the wait if it's cancelled</param>
+/// <returns>False if the load was cancelled first</returns>
+bool ObjectLoader::PushBatch(MESH_BATCH& batch, const LoadControl& loadControl) {
+	while (!_batches.tryPush(move(batch))) {
+		if (loadControl.isCancelled()) return false;
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	return true;
+}
+
+/// <summary>
+/// Read an object into a new mesh snapshot
+/// </summary>
+/// <param name="loadId">Identifier of the load</param>
+/// <param name="objectPathname">Full path and filename for the object file</param>
+/// <param name="loadControl">Control of the load</param>
+/// <param name="collectStatistics">True to record timings and counters</param>
+/// <param name="progressive">True to queue batches as they're triangulated</param>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>Mesh, or null if the load failed or was cancelled</returns>
+shared_ptr<ObjectLoader::MESH_SNAPSHOT> ObjectLoader::ReadMesh(uint64_t loadId, const string& objectPathname,
+	const LoadControl& loadControl, bool collectStatistics, bool progressive, wstring& errorReason) {
+
+	ObjectReader reader;
+	reader.SetMeshCache(_meshCache);
+	reader.SetCollectStatistics(collectStatistics);
+	reader.SetLoadControl(&loadControl);
+	if (progressive) {
+		reader.SetMeshBatchCallback([&](MESH_BATCH& batch) {
+			batch.loadId = loadId;
+			return PushBatch(batch, loadControl);
+		});
+	}
+	if (!reader.ReadObjectFile(objectPathname, errorReason)) {
+		if (errorReason.empty()) errorReason = L"The file could not be read";
+		return nullptr;
+	}
+
+	shared_ptr<MESH_SNAPSHOT> mesh = make_shared<MESH_SNAPSHOT>();
+	mesh->loadId = loadId;
+	mesh->pathname = objectPathname;
+	reader.MoveMesh(mesh->layers, mesh->surfaces, mesh->ranges, mesh->vertices, mesh->indices);
+	mesh->numLayers = reader.GetNumLayers();
+	mesh->numPolygons = reader.GetNumPolygons();
+	mesh->numTriangles = reader.GetNumTriangles();
+	mesh->numNonTriangles = reader.GetNumNonTriangles();
+	mesh->statistics = reader.GetLoadStatistics();
+	mesh->warning = errorReason;
+
+	return mesh;
+}
+
+/// <summary>
+/// Run requests until the loader is destroyed
+/// </summary>
+void ObjectLoader::WorkerLoop() {
+
+	TraceRecorder::getShared().setThreadName("Object loader");
+
+	unique_lock<mutex> lock(_mutex);
+	while (true) {
+
+		// Wait for a request
+		_requestReady.wait(lock, [&]() { return _stopping || _pendingLoadId != 0; });
+		if (_stopping) break;
+
+		// Take the request and the options it runs with
+		uint64_t loadId = _pendingLoadId;
+		string objectPathname = move(_pendingPathname);
+		bool collectStatistics = _collectStatistics;
+		bool progressive = _progressive;
+		ProgressCallback progressCallback = _progressCallback;
+		CompletionCallback completionCallback = _completionCallback;
+		_pendingLoadId = 0;
+		_busy = true;
+
+		LoadControl loadControl([&](LoadPhase phase, double fraction) {
+			if (progressCallback) progressCallback(loadId, phase, fraction);
+		});
+		_currentControl = &loadControl;
+		lock.unlock();
+
+		// Load without holding the lock, so newer requests can cancel it
+		LOAD_RESULT result;
+		result.loadId = loadId;
+		shared_ptr<MESH_SNAPSHOT> mesh = ReadMesh(loadId, objectPathname, loadControl, collectStatistics, progressive, result.errorReason);
+
+		// Publish unless a newer request cancelled the load meanwhile
+		lock.lock();
+		result.cancelled = loadControl.isCancelled();
+		if (mesh && !result.cancelled) {
+			result.loaded = true;
+			result.errorReason = mesh->warning;
+			atomic_store(&_mesh, shared_ptr<const MESH_SNAPSHOT>(move(mesh)));
+		}
+		else if (result.cancelled) {
+			result.errorReason = L"Load cancelled";
+		}
+		_currentControl = nullptr;
+		lock.unlock();
+
+		// Report outside the lock, so the callback can make new requests
+		mesh.reset();
+		if (completionCallback) completionCallback(result);
+
+		lock.lock();
+		_busy = false;
+		if (_pendingLoadId == 0) _idle.notify_all();
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LightWaveObject/LoadControl.h"
+#include "LightWaveObject/SpscQueue.h"
+#include "MeshCache.h"
+#include "MeshDefinitions.h"
+#include "ObjectReader.h"
+
+class ObjectLoader {
+public:
+
+	// Triangulated mesh of a loaded object. It's never changed once published,
+	// so any thread holding one can read it while newer meshes are loaded.
+	struct MESH_SNAPSHOT {
+		uint64_t loadId = 0;
+		std::string pathname;
+		std::vector<MESH_LAYER> layers;		// Range of the mesh holding each layer
+		std::vector<MESH_SURFACE> surfaces;	// Surfaces the draw ranges refer to
+		std::vector<MESH_RANGE> ranges;		// Runs of each layer's indices with the same surface
+		std::vector<VERTEX> vertices;
+		std::vector<uint32_t> indices;
+		int numLayers = 0;
+		int numPolygons = 0;
+		int numTriangles = 0;
+		int numNonTriangles = 0;
+		LOAD_STATISTICS statistics;			// All zero unless collection was turned on
+		std::wstring warning;				// Problem that didn't stop the load, or empty
+	};
+
+	// How a load ended
+	struct LOAD_RESULT {
+		uint64_t loadId = 0;
+		bool loaded = false;				// The mesh was published
+		bool cancelled = false;				// Cancelled, or replaced by a newer load
+		std::wstring errorReason;
+	};
+
+	// Batches a progressive load can get ahead of the consumer by
+	static const size_t BATCH_QUEUE_CAPACITY = 64;
+
+	// Called on the loader thread, or the pool threads it parses on
+	using ProgressCallback = std::function<void(uint64_t loadId, LoadPhase phase, double fraction)>;
+	using CompletionCallback = std::function<void(const LOAD_RESULT& result)>;
+
+	// Constructor
+	explicit ObjectLoader(MeshCache* meshCache = nullptr);
+	~ObjectLoader();
+
+	ObjectLoader(const ObjectLoader&) = delete;
+	ObjectLoader& operator=(const ObjectLoader&) = delete;
+
+	// Public methods
+	void Cancel();
+	uint64_t Load(const std::string& objectPathname);
+	bool PopBatch(MESH_BATCH& batch);
+	void WaitForIdle();
+
+	// Getters
+	std::shared_ptr<const MESH_SNAPSHOT> GetMesh();
+	bool IsLoading();
+
+	// Setters
+	void SetCollectStatistics(bool collectStatistics);
+	void SetCompletionCallback(CompletionCallback completionCallback);
+	void SetProgressCallback(ProgressCallback progressCallback);
+	void SetProgressive(bool progressive);
+
+private:
+
+	// Private member functions
+	bool PushBatch(MESH_BATCH& batch, const LoadControl& loadControl);
+	std::shared_ptr<MESH_SNAPSHOT> ReadMesh(uint64_t loadId, const std::string& objectPathname, const LoadControl& loadControl,
+		bool collectStatistics, bool progressive, std::wstring& errorReason);
+	void WorkerLoop();
+
+	// Options, guarded by _mutex and copied at the start of each load
+	MeshCache* _meshCache {};				// Only used on the loader thread
+	bool _collectStatistics {};
+	bool _progressive {};
+	ProgressCallback _progressCallback;
+	CompletionCallback _completionCallback;
+
+	// Requests, guarded by _mutex; only the latest request is kept
+	std::mutex _mutex;
+	std::condition_variable _requestReady;
+	std::condition_variable _idle;
+	std::string _pendingPathname;
+	uint64_t _pendingLoadId {};				// Zero when nothing is waiting
+	uint64_t _lastLoadId {};
+	LoadControl* _currentControl {};		// Control of the load in progress, or null
+	bool _busy {};							// Loading or reporting a load
+	bool _stopping {};
+
+	// Batches of progressive loads, from the loader thread to the one consumer
+	SpscQueue<MESH_BATCH> _batches { BATCH_QUEUE_CAPACITY };
+
+	// Latest mesh, replaced with atomic stores so readers never see it change under them
+	std::shared_ptr<const MESH_SNAPSHOT> _mesh;
+
+	// Loader thread, started last
+	std::thread _worker;
+};
@@ -1,5 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
 #include "ObjectReader.h"
 
+namespace {
+
+	/// <summary>
+	/// Get the unit normal of a triangle
+	/// </summary>
+	/// <param name="point1">First triangle point</param>
+	/// <param name="point2">Second triangle point</param>
+	/// <param name="point3">Third triangle point</param>
+	/// <returns>Unit normal, or zero for a degenerate triangle</returns>
+	MESH_FLOAT3 calculateNormal(const MESH_FLOAT3& point1, const MESH_FLOAT3& point2, const MESH_FLOAT3& point3) {
+
+		// Edges from the first point
+		MESH_FLOAT3 vec1 = { point1.x - point2.x, point1.y - point2.y, point1.z - point2.z };
+		MESH_FLOAT3 vec2 = { point1.x - point3.x, point1.y - point3.y, point1.z - point3.z };
+
+		// Cross product
+		MESH_FLOAT3 normal = {
+			vec1.y * vec2.z - vec1.z * vec2.y,
+			vec1.z * vec2.x - vec1.x * vec2.z,
+			vec1.x * vec2.y - vec1.y * vec2.x,
+		};
+
+		// Normalize
+		float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		if (length == 0.0f) {
+			return MESH_FLOAT3 { 0.0f, 0.0f, 0.0f };
+		}
+		return MESH_FLOAT3 { normal.x / length, normal.y / length, normal.z / length };
+	}
+
+	/// <summary>
+	/// Describe a LightWave surface for the mesh
+	/// </summary>
+	/// <param name="parameters">Resolved surface parameters</param>
+	/// <returns>Surface color</returns>
+	MESH_SURFACE getMeshSurface(const SURFACE_PARAMETERS& parameters) {
+		return MESH_SURFACE { MESH_FLOAT4 { parameters.color.r, parameters.color.g, parameters.color.b, 1.0f } };
+	}
+
+	/// <summary>
+	/// Build the mesh's surface table, with a surface for each distinct
+	/// parameter block of the object, so that surfaces which look the same
+	/// are drawn together. Polygons without a surface, and those whose tag
+	/// names none, take the object's first surface, or white if it has none.
+	/// </summary>
+	/// <param name="obj">LightWave object</param>
+	/// <param name="surfaces">Receives the surface table</param>
+	/// <param name="surfaceByTag">Receives the mesh surface of each TAGS string</param>
+	void getSurfaces(LightWaveObject& obj, vector<MESH_SURFACE>& surfaces, vector<uint32_t>& surfaceByTag) {
+
+		SurfaceTable& surfaceTable = obj.GetSurfaceTable();
+		if (surfaceTable.getNumSurfaces() == 0) {
+			surfaces.assign(1, MESH_SURFACE { MESH_FLOAT4 { 1.0f, 1.0f, 1.0f, 1.0f } });
+			surfaceByTag.clear();
+			return;
+		}
+
+		// Mesh surface 0 is the object's first surface
+		uint32_t defaultBlock = surfaceTable.getParameterBlockIndex(0);
+		surfaces.clear();
+		surfaces.reserve(surfaceTable.getNumParameterBlocks());
+		surfaces.push_back(getMeshSurface(surfaceTable.getParameterBlock(defaultBlock)));
+		for (uint32_t blockIndex = 0; blockIndex < uint32_t(surfaceTable.getNumParameterBlocks()); blockIndex++) {
+			if (blockIndex != defaultBlock) {
+				surfaces.push_back(getMeshSurface(surfaceTable.getParameterBlock(blockIndex)));
+			}
+		}
+
+		// Blocks before the default one move up a place to make room for it
+		size_t numTags = obj.GetTags().size();
+		surfaceByTag.assign(numTags, 0);
+		for (size_t tagIndex = 0; tagIndex < numTags; tagIndex++) {
+			uint32_t surfaceIndex = surfaceTable.getSurfaceByTag(tagIndex);
+			if (surfaceIndex != SurfaceTable::NO_SURFACE) {
+				uint32_t blockIndex = surfaceTable.getParameterBlockIndex(surfaceIndex);
+				surfaceByTag[tagIndex] = blockIndex == defaultBlock ? 0 : blockIndex < defaultBlock ? blockIndex + 1 : blockIndex;
+			}
+		}
+	}
+
+	// Mesh surface of each polygon of a layer, looked up from its surface tag
+	struct POLYGON_SURFACES {
+		const uint16_t* tags = nullptr;			// Surface tag of each polygon, or null if the layer has none
+		size_t numTags = 0;
+		const uint32_t* surfaceByTag = nullptr;	// Mesh surface of each TAGS string
+		size_t numSurfaceTags = 0;
+
+		// Mesh surface of a polygon
+		uint32_t operator[](size_t polIndex) const {
+			if (polIndex >= numTags) return 0;
+			uint16_t tag = tags[polIndex];
+			return tag < numSurfaceTags ? surfaceByTag[tag] : 0;
+		}
+	};
+
+	/// <summary>
+	/// Get the mesh surface of each polygon of a POLS chunk of a layer
+	/// </summary>
+	/// <param name="obj">LightWave object</param>
+	/// <param name="layerIndex">Layer index</param>
+	/// <param name="polsIndex">Which of the layer's POLS chunks</param>
+	/// <param name="surfaceByTag">Mesh surface of each TAGS string, which must outlive the result</param>
+	/// <returns>Surface lookup; every polygon has surface 0 if the chunk has no surface tags</returns>
+	POLYGON_SURFACES getPolygonSurfaces(LightWaveObject& obj, int layerIndex, size_t polsIndex, const vector<uint32_t>& surfaceByTag) {
+		POLYGON_SURFACES polygonSurfaces;
+		PolygonTags* polygonTags = obj.GetPolygonTagsByLayer(layerIndex, PolygonTagType::SURF, polsIndex);
+		if (polygonTags) {
+			polygonSurfaces.tags = polygonTags->getTags().data();
+			polygonSurfaces.numTags = polygonTags->getTags().size();
+			polygonSurfaces.surfaceByTag = surfaceByTag.data();
+			polygonSurfaces.numSurfaceTags = surfaceByTag.size();
+		}
+		return polygonSurfaces;
+	}
+
+	/// <summary>
+	/// Describe a layer, with an empty range of the mesh
+	/// </summary>
+	/// <param name="obj">LightWave object</param>
+	/// <param name="layerIndex">Layer index</param>
+	/// <returns>Layer number, parent, flags and pivot</returns>
+	MESH_LAYER getLayerRange(LightWaveObject& obj, int layerIndex) {
+		VEC12 pivot = obj.GetLayerPivot(layerIndex);
+		MESH_LAYER layer {};
+		layer.number = int32_t(obj.GetLayerNumber(layerIndex));
+		layer.parent = obj.GetLayerParent(layerIndex);
+		layer.flags = obj.GetLayerFlags(layerIndex);
+		layer.pivot = MESH_FLOAT3 { pivot.X, pivot.Y, pivot.Z };
+		return layer;
+	}
+
+	/// <summary>
+	/// Get the points of a layer, in object coordinates
+	/// </summary>
+	/// <param name="obj">LightWave object</param>
+	/// <param name="layerIndex">Layer index</param>
+	/// <param name="layerPoints">Receives the points</param>
+	void getLayerPoints(LightWaveObject& obj, int layerIndex, vector<MESH_FLOAT3>& layerPoints) {
+		const std::pmr::vector<VEC12>& points = obj.GetPointsByLayer(layerIndex);
+		layerPoints.reserve(points.size());
+		for (auto& point : points) {
+			layerPoints.push_back(MESH_FLOAT3 { point.X, point.Y, point.Z });
+		}
+	}
+
+	/// <summary>
+	/// Check the point indices of a run of polygons all lie within the
+	/// layer's points. The run's indices are contiguous, so this is a single
+	/// pass with no branches per index.
+	/// </summary>
+	/// <param name="pols">Layer polygons</param>
+	/// <param name="firstPolygon">First polygon of the run</param>
+	/// <param name="numPolygons">Number of polygons in the run</param>
+	/// <param name="numPoints">Number of points in the layer</param>
+	/// <returns>True if no index is out of range</returns>
+	bool hasPointsInRange(const POLYGON_LIST& pols, size_t firstPolygon, size_t numPolygons, size_t numPoints) {
+		const uint32_t* pointIndex = pols.pointIndex.data();
+		bool outOfRange = false;
+		for (uint32_t index = pols.offsets[firstPolygon]; index < pols.offsets[firstPolygon + numPolygons]; index++) {
+			outOfRange |= pointIndex[index] >= numPoints;
+		}
+		return !outOfRange;
+	}
+
+	/// <summary>
+	/// Check a polygon can be triangulated: it has at least three vertices,
+	/// and each refers to a point of the layer. Only runs that failed
+	/// hasPointsInRange need their polygons' indices checked one by one.
+	/// </summary>
+	/// <param name="pol">Polygon</param>
+	/// <param name="numPoints">Number of points in the layer</param>
+	/// <param name="pointsInRange">True if the polygon's run passed hasPointsInRange</param>
+	/// <returns>True if the polygon is drawn</returns>
+	bool isDrawable(const POLYGON& pol, size_t numPoints, bool pointsInRange) {
+		if (pol.numVertices < 3) return false;
+		if (pointsInRange) return true;
+		for (unsigned corner = 0; corner < pol.numVertices; corner++) {
+			if (pol.pointIndex[corner] >= numPoints) return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Triangulate a polygon as a fan, writing a vertex for each of its
+	/// corners and three indices for each triangle. LightWave polygons have
+	/// CW winding order, so the vertex order is reversed to CCW.
+	/// </summary>
+	/// <param name="pol">Drawable polygon, as checked by isDrawable</param>
+	/// <param name="points">Layer points</param>
+	/// <param name="normal">Face normal, the same for all vertices of the polygon</param>
+	/// <param name="vertexIndex">Index in the mesh of the polygon's first vertex</param>
+	/// <param name="vertices">Receives the polygon's vertices</param>
+	/// <param name="indices">Receives the triangles' indices</param>
+	/// <returns>Number of triangles written</returns>
+	unsigned writePolygon(const POLYGON& pol, const vector<MESH_FLOAT3>& points, const MESH_FLOAT3& normal, uint32_t vertexIndex,
+		VERTEX* vertices, uint32_t* indices) {
+
+		// Vertices, all with the face normal
+		for (unsigned corner = 0; corner < pol.numVertices; corner++) {
+			vertices[corner].pos = points[pol.pointIndex[corner]];
+			vertices[corner].normal = normal;
+		}
+
+		// Initial triangle
+		indices[0] = vertexIndex + 2;
+		indices[1] = vertexIndex + 1;
+		indices[2] = vertexIndex + 0;
+		indices += 3;
+
+		// Each further corner forms a triangle with the previous corner and the first
+		uint32_t midIndex = vertexIndex + 2;
+		for (unsigned corner = 3; corner < pol.numVertices; corner++) {
+			indices[0] = vertexIndex + corner;
+			indices[1] = midIndex;
+			indices[2] = vertexIndex;
+			indices += 3;
+			midIndex = vertexIndex + corner; // Next mid vertex is this triangle's first vertex
+		}
+
+		return pol.numVertices - 2;
+	}
+
+	// Work of extracting one layer
+	struct LAYER_TRANSFER {
+		vector<MESH_FLOAT3> points;			// Layer points, in object coordinates
+		size_t firstBlock = 0;				// The polygon blocks of all the layer's POLS chunks
+		size_t numBlocks = 0;
+	};
+
+	// Polygons of one POLS chunk of a layer, with the surfaces of the PTAG chunk after it
+	struct POLYGON_TRANSFER {
+		size_t layerIndex = 0;
+		size_t polsIndex = 0;				// Which of the layer's POLS chunks
+		const POLYGON_LIST* pols = nullptr;
+		POLYGON_SURFACES surfaces;
+		vector<MESH_FLOAT3> normals;		// Face normal of each polygon
+	};
+
+	// Run of one POLS chunk's polygons, counted and triangulated alongside the other blocks
+	struct TRANSFER_BLOCK {
+		size_t layerIndex = 0;
+		size_t polygonTransfer = 0;			// Which POLYGON_TRANSFER the polygons are in
+		size_t firstPolygon = 0;
+		size_t numPolygons = 0;
+		size_t firstVertex = 0;				// Where the block's vertices go in the mesh
+		size_t numVertices = 0;
+		unsigned numTriangles = 0;
+		unsigned numNonTriangles = 0;		// Includes polygons with points outside the layer
+		bool pointsInRange = true;			// Every point index of the block is valid, so polygons needn't be checked
+		uint64_t polygonsByArity[LOAD_STATISTICS::MAX_ARITY + 1] {};
+	};
+
+	// Polygons transferred between cancellation checks and progress reports
+	const size_t POLYGON_BATCH = 16384;
+
+	// POLS payload decoded and triangulated per batch of a progressive load
+	const size_t PROGRESSIVE_BATCH_BYTES = 256 * 1024;
+}
+
 
 /// <summary>
 /// Read and parse the object file
@@ -10,9 +273,19 @@
 bool ObjectReader::ReadObjectFile(string objectPathname, wstring& errorReason) {
 
 	// Initialize state
+	TraceScope trace("Load object");
 	_objectLoaded = false;
+	_layers.clear();
+	_surfaces.clear();
+	_ranges.clear();
 	_vertices.clear();
 	_indices.clear();
+	_statistics = LOAD_STATISTICS {};
+	_statistics.numLoads = 1;
+	_hardwareCountersError.clear();
+	LOAD_STATISTICS* statistics = GetStatisticsTarget();
+	chrono::steady_clock::time_point start;
+	if (statistics) start = chrono::steady_clock::now();
 
 	// Verify that the file exists
 	if (!std::filesystem::exists(objectPathname)) {
@@ -20,9 +293,39 @@ bool ObjectReader::ReadObjectFile(string objectPathname, wstring& errorReason) {
 		return false;
 	}
 
-	// Read designated object file
+	// Sample the CPU counters of this thread around each phase; the
+	// statistics mustn't keep pointing at them once the load returns
+	HardwareCounters hardwareCounters;
+	if (statistics && _sampleHardwareCounters && hardwareCounters.open(_hardwareCountersError)) {
+		statistics->hardwareCounters = &hardwareCounters;
+	}
+
+	// Reuse the triangulated mesh from the last load if the file hasn't changed
+	PhaseTimer cacheTimer(statistics, LoadPhase::MeshCache);
+	TraceScope cacheTrace("Mesh cache read");
+	bool cached = ReadMeshFromCache(objectPathname);
+	cacheTrace.stop();
+	cacheTimer.stop();
+	if (cached) {
+		_statistics.hardwareCounters = nullptr;
+		if (statistics) {
+			statistics->phaseElements[size_t(LoadPhase::MeshCache)] += _vertices.size();
+			statistics->meshCacheHits = 1;
+			statistics->meshBytes = _vertices.size() * sizeof(VERTEX) + _indices.size() * sizeof(uint32_t);
+			statistics->totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		}
+		_objectLoaded = true;
+		return true;
+	}
+
+	// Read designated object file; progressive loads leave the chunks
+	// unparsed, and decode the polygons themselves a batch at a time
 	std::unique_ptr<LightWaveObject> lwObject = make_unique<LightWaveObject>();
+	lwObject->SetStatistics(statistics);
+	lwObject->SetLoadControl(_loadControl);
+	lwObject->SetLazyParse(bool(_meshBatchCallback));
 	if (!lwObject->Read(objectPathname, errorReason)) {
+		_statistics.hardwareCounters = nullptr;
 
 		// Assign generic error if none returned
 		if (errorReason == L"") {
@@ -34,13 +337,28 @@ bool ObjectReader::ReadObjectFile(string objectPathname, wstring& errorReason) {
 
 	// Transfer mesh data
 	errorReason = L"";
-	if (!TransferMeshDataFromLWO(move(lwObject), errorReason)) {
+	bool transferred = _meshBatchCallback ? StreamMeshDataFromLWO(*lwObject, errorReason) : TransferMeshDataFromLWO(*lwObject, errorReason);
+	if (!transferred) {
+		_statistics.hardwareCounters = nullptr;
 		if (errorReason == L"") {
 			errorReason = L"Could not transfer mesh data from object file";
 		}
 		return false;
 	}
 
+	// Keep the mesh for the next load
+	PhaseTimer storeTimer(statistics, LoadPhase::MeshCache);
+	TraceScope storeTrace("Mesh cache store");
+	StoreMeshInCache(objectPathname, lwObject->GetContentHash());
+	storeTrace.stop();
+	storeTimer.stop();
+
+	_statistics.hardwareCounters = nullptr;
+	if (statistics) {
+		statistics->phaseElements[size_t(LoadPhase::MeshCache)] += _vertices.size();
+		statistics->totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+
 	// Set successful load flag
 	_objectLoaded = true;
 
@@ -48,13 +366,76 @@ bool ObjectReader::ReadObjectFile(string objectPathname, wstring& errorReason) {
 }
 
 /// <summary>
-/// Get a copy of the object's indices
+/// Take the mesh of the last load, leaving the reader without one
+/// </summary>
+/// <param name="layers">Receives the layer table</param>
+/// <param name="surfaces">Receives the surface table</param>
+/// <param name="ranges">Receives the draw ranges</param>
+/// <param name="vertices">Receives the vertices</param>
+/// <param name="indices">Receives the indices</param>
+void ObjectReader::MoveMesh(std::vector<MESH_LAYER>& layers, std::vector<MESH_SURFACE>& surfaces, std::vector<MESH_RANGE>& ranges,
+	std::vector<VERTEX>& vertices, std::vector<uint32_t>& indices) {
+	layers = move(_layers);
+	surfaces = move(_surfaces);
+	ranges = move(_ranges);
+	vertices = move(_vertices);
+	indices = move(_indices);
+	_layers.clear();
+	_surfaces.clear();
+	_ranges.clear();
+	_vertices.clear();
+	_indices.clear();
+	_objectLoaded = false;
+}
+
+/// <summary>
+/// Get the object's indices
 /// </summary>
 /// <returns>Vector of object indices</returns>
-std::vector<WORD> ObjectReader::GetIndices() {
+const std::vector<uint32_t>& ObjectReader::GetIndices() {
 	return _indices;
 }
 
+/// <summary>
+/// Get why the last load couldn't sample the hardware counters
+/// </summary>
+/// <returns>Reason, or empty if they were sampled or not asked for</returns>
+const std::wstring& ObjectReader::GetHardwareCountersError() {
+	return _hardwareCountersError;
+}
+
+/// <summary>
+/// Get the range of the mesh that holds each layer of the object
+/// </summary>
+/// <returns>Layer table, in the object's layer order</returns>
+const std::vector<MESH_LAYER>& ObjectReader::GetLayers() {
+	return _layers;
+}
+
+/// <summary>
+/// Get the timings and counters of the last load
+/// </summary>
+/// <returns>Load statistics, all zero unless collection was turned on</returns>
+const LOAD_STATISTICS& ObjectReader::GetLoadStatistics() {
+	return _statistics;
+}
+
+/// <summary>
+/// Get the draw ranges, runs of each layer's indices whose triangles have the same surface
+/// </summary>
+/// <returns>Draw ranges; each layer's are contiguous and in index order</returns>
+const std::vector<MESH_RANGE>& ObjectReader::GetRanges() {
+	return _ranges;
+}
+
+/// <summary>
+/// Get the surfaces of the mesh, which the draw ranges refer to
+/// </summary>
+/// <returns>Surface table; surface 0 is for polygons without a surface</returns>
+const std::vector<MESH_SURFACE>& ObjectReader::GetSurfaces() {
+	return _surfaces;
+}
+
 /// <summary>
 /// Get number of layers
 /// </summary>
@@ -71,6 +452,14 @@ int ObjectReader::GetNumNonTriangles() {
 	return _numNonTriangles;
 }
 
+/// <summary>
+/// Get number of polygons in the object
+/// </summary>
+/// <returns>Number of polygons, including those that were skipped</returns>
+int ObjectReader::GetNumPolygons() {
+	return _numPolygons;
+}
+
 /// <summary>
 /// Get number of triangles retrieved
 /// </summary>
@@ -80,144 +469,575 @@ int ObjectReader::GetNumTriangles() {
 }
 
 /// <summary>
-/// Get a copy of the object's vertices
+/// Get the object's vertices
 /// </summary>
 /// <returns>Vector of object vertices</returns>
-std::vector<VERTEX> ObjectReader::GetVertices() {
+const std::vector<VERTEX>& ObjectReader::GetVertices() {
 	return _vertices;
 }
 
 /// <summary>
-/// Transfer mesh data from LightWave object to renderer
+/// Choose whether loads record timings and counters. Off by default; when
+/// off, loading doesn't read the clock or count anything.
+/// </summary>
+/// <param name="collectStatistics">True to collect load statistics</param>
+void ObjectReader::SetCollectStatistics(bool collectStatistics) {
+	_collectStatistics = collectStatistics;
+}
+
+/// <summary>
+/// Choose whether loads that collect statistics also sample the CPU's
+/// performance counters around each phase. Where the counters aren't
+/// available the load goes ahead without them.
+/// </summary>
+/// <param name="sampleHardwareCounters">True to sample cycles, instructions and misses</param>
+void ObjectReader::SetSampleHardwareCounters(bool sampleHardwareCounters) {
+	_sampleHardwareCounters = sampleHardwareCounters;
+}
+
+/// <summary>
+/// Set the control checked while loading, which can cancel a load from
+/// another thread and is told how far it has got
+/// </summary>
+/// <param name="loadControl">Control of the load, or nullptr</param>
+void ObjectReader::SetLoadControl(const LoadControl* loadControl) {
+	_loadControl = loadControl;
+}
+
+/// <summary>
+/// Make loads progressive, handing each batch of triangulated polygons to a
+/// callback as soon as it's ready so the object can be shown before it has
+/// finished loading. Loads still produce the whole mesh. Objects found in
+/// the mesh cache are loaded whole, without batches.
+/// </summary>
+/// <param name="meshBatchCallback">Batch function, called on the loading thread, or empty to load whole</param>
+void ObjectReader::SetMeshBatchCallback(MeshBatchCallback meshBatchCallback) {
+	_meshBatchCallback = move(meshBatchCallback);
+}
+
+/// <summary>
+/// Set the cache used to skip parsing objects that were loaded before
+/// </summary>
+/// <param name="meshCache">Mesh cache, or nullptr to always parse</param>
+void ObjectReader::SetMeshCache(MeshCache* meshCache) {
+	_meshCache = meshCache;
+}
+
+/// <summary>
+/// Get where loads record their statistics
+/// </summary>
+/// <returns>Statistics, or nullptr when they aren't collected</returns>
+LOAD_STATISTICS* ObjectReader::GetStatisticsTarget() {
+	return _collectStatistics ? &_statistics : nullptr;
+}
+
+/// <summary>
+/// Check whether the load has been cancelled
+/// </summary>
+/// <param name="errorReason">Set to the reason for the failure if it has</param>
+/// <returns>True if the load should stop</returns>
+bool ObjectReader::IsCancelled(wstring& errorReason) {
+	if (!_loadControl || !_loadControl->isCancelled()) return false;
+	errorReason = L"Load cancelled";
+	return true;
+}
+
+/// <summary>
+/// Read the mesh of an object from the mesh cache
+/// </summary>
+/// <param name="objectPathname">Full path and filename for the object file</param>
+/// <returns>True if the cache held a valid mesh for the object</returns>
+bool ObjectReader::ReadMeshFromCache(const string& objectPathname) {
+
+	if (!_meshCache) return false;
+
+	MeshCache::ENTRY entry;
+	if (!_meshCache->Load(objectPathname, sizeof(VERTEX), entry)) return false;
+
+	// A rewritten source still matches if its contents don't differ; reading
+	// it lazily hashes its chunks without parsing them
+	if (entry.sourceChanged) {
+		LightWaveObject lwObject;
+		wstring errorReason;
+		lwObject.SetLazyParse(true);
+		if (!lwObject.Read(objectPathname, errorReason) || lwObject.GetContentHash() != entry.sourceHash) {
+			entry = MeshCache::ENTRY {};
+			_meshCache->Remove(objectPathname);
+			return false;
+		}
+	}
+
+	// Copy the mapped streams once, so the mesh owns its memory and the entry
+	// is unmapped on return; a mapped entry couldn't be replaced or removed
+	// while the mesh is shown, as Windows won't rename over a mapped file
+	_layers.assign(entry.layers, entry.layers + entry.numMeshLayers);
+	_surfaces.assign(entry.surfaces, entry.surfaces + entry.numSurfaces);
+	_ranges.assign(entry.ranges, entry.ranges + entry.numRanges);
+	const VERTEX* vertices = (const VERTEX*)entry.vertices;
+	_vertices.assign(vertices, vertices + entry.numVertices);
+	_indices.assign(entry.indices, entry.indices + entry.numIndices);
+
+	// Object info
+	_numLayers = entry.info.numLayers;
+	_numPolygons = entry.info.numPolygons;
+	_numTriangles = entry.info.numTriangles;
+	_numNonTriangles = entry.info.numNonTriangles;
+
+	return true;
+}
+
+/// <summary>
+/// Write the mesh of the object to the mesh cache
+/// </summary>
+/// <param name="objectPathname">Full path and filename for the object file</param>
+/// <param name="contentHash">Content hash of the object the mesh was built from</param>
+void ObjectReader::StoreMeshInCache(const string& objectPathname, uint64_t contentHash) {
+
+	if (!_meshCache) return;
+
+	MeshCache::MESH_INFO info;
+	info.numLayers = _numLayers;
+	info.numPolygons = _numPolygons;
+	info.numTriangles = _numTriangles;
+	info.numNonTriangles = _numNonTriangles;
+
+	// A failed store only costs a parse on the next load
+	_meshCache->Store(objectPathname, contentHash, _layers.data(), _layers.size(), _surfaces.data(), _surfaces.size(), _ranges.data(), _ranges.size(),
+		_vertices.data(), _vertices.size(), sizeof(VERTEX), _indices.data(), _indices.size(), info);
+}
+
+/// <summary>
+/// Decode and triangulate the polygons of a lazily read object in batches,
+/// handing each batch to the batch callback. The layers are streamed one
+/// after another, each into its own range of the mesh. A layer's points are
+/// parsed first; each of its FACE chunks is then decoded a fixed number of
+/// payload bytes at a time, with the surface tags of the PTAG chunk after it,
+/// and each batch is triangulated as soon as it's decoded. Triangles are
+/// grouped by surface within each batch, so a layer has at most a draw range
+/// per surface per batch.
+/// </summary>
+/// <param name="obj">LightWave object, read with lazy parsing</param>
+/// <returns>Transfer success</returns>
+bool ObjectReader::StreamMeshDataFromLWO(LightWaveObject& obj, wstring& errorReason) {
+
+	// Replace any mesh from a previous transfer
+	LOAD_STATISTICS* statistics = GetStatisticsTarget();
+	PhaseTimer setupTimer(statistics, LoadPhase::ChunkParse);
+	TraceScope setupTrace("Transfer setup");
+	_layers.clear();
+	_surfaces.clear();
+	_ranges.clear();
+	_vertices.clear();
+	_indices.clear();
+	_numPolygons = 0;
+	_numTriangles = 0;
+	_numNonTriangles = 0;
+	_numLayers = int(obj.GetNumLayers());
+
+	// Validate object layers
+	if (_numLayers == 0) return false;
+
+	// Surfaces, handed over with the first batch
+	vector<uint32_t> surfaceByTag;
+	getSurfaces(obj, _surfaces, surfaceByTag);
+	bool surfacesSent = false;
+
+	// Bounds of every layer, so the consumer can frame the object before the polygons arrive
+	MESH_FLOAT3 boundsMin {};
+	MESH_FLOAT3 boundsMax {};
+	bool hasPoints = false;
+	for (int layerIndex = 0; layerIndex < _numLayers; layerIndex++) {
+		for (const VEC12& point : obj.GetPointsByLayer(layerIndex)) {
+			if (!hasPoints) {
+				boundsMin = boundsMax = MESH_FLOAT3 { point.X, point.Y, point.Z };
+				hasPoints = true;
+			}
+			boundsMin = MESH_FLOAT3 { min(boundsMin.x, point.X), min(boundsMin.y, point.Y), min(boundsMin.z, point.Z) };
+			boundsMax = MESH_FLOAT3 { max(boundsMax.x, point.X), max(boundsMax.y, point.Y), max(boundsMax.z, point.Z) };
+		}
+	}
+	setupTrace.stop();
+	setupTimer.stop();
+
+	size_t batchIndex = 0;
+	vector<uint32_t> surfaceIndices(_surfaces.size());
+	vector<MESH_RANGE> batchRanges;
+	for (int layerIndex = 0; layerIndex < _numLayers; layerIndex++) {
+
+		// The layer's points
+		PhaseTimer layerSetupTimer(statistics, LoadPhase::ChunkParse);
+		MESH_LAYER layer = getLayerRange(obj, layerIndex);
+		layer.firstVertex = uint32_t(_vertices.size());
+		layer.firstIndex = uint32_t(_indices.size());
+		layer.firstRange = uint32_t(_ranges.size());
+		vector<MESH_FLOAT3> points;
+		getLayerPoints(obj, layerIndex, points);
+		layerSetupTimer.stop();
+
+		// Each FACE chunk of the layer in turn, with the surfaces of the PTAG chunk after it
+		size_t numPolygonChunks = obj.GetNumPolsByLayer(layerIndex);
+		for (size_t polsIndex = 0; polsIndex < numPolygonChunks; polsIndex++) {
+
+			// Polygon chunk payload, decoded here rather than by the object
+			PhaseTimer chunkSetupTimer(statistics, LoadPhase::ChunkParse);
+			BufferView chunkBuffer = obj.GetChunkBufferByLayer(layerIndex, ChunkTag::POLS, polsIndex);
+			BufferView payload;
+			if (!chunkBuffer.empty()) {
+				LWO_CHUNK_HEADER header = LWUtils::parseChunkHeader(chunkBuffer.data());
+				payload = chunkBuffer.subview(LWO_CHUNK_DATA_OFFSET, header.length);
+			}
+			bool isFace = payload.contains(0, 4) && LWUtils::convertPolygonTypeToEnum(CONVERT_BYTES_TO_FOURCC(payload.data())) == PolygonType::FACE;
+			POLYGON_SURFACES polygonSurfaces;
+			if (isFace) polygonSurfaces = getPolygonSurfaces(obj, layerIndex, polsIndex, surfaceByTag);
+			chunkSetupTimer.stop();
+			if (!isFace) continue;
+
+			// Decoding is counted as triangulation, since the two are interleaved
+			PhaseTimer triangulationTimer(statistics, LoadPhase::Triangulation);
+			TraceScope triangulationTrace("Progressive triangulation", "bytes", int64_t(payload.size()));
+			Polygons polygons;
+			size_t payloadOffset = 0;
+			while (payloadOffset < payload.size()) {
+				if (IsCancelled(errorReason)) return false;
+
+				// Decode the whole polygons in the next piece of the payload
+				TraceScope batchTrace("Progressive batch");
+				size_t firstPolygon = polygons.getPolygons().size();
+				size_t pieceLength = min(PROGRESSIVE_BATCH_BYTES, payload.size() - payloadOffset);
+				size_t consumed = polygons.parsePiece(payload.subview(payloadOffset, pieceLength), payloadOffset);
+				if (consumed == 0) break;	// Truncated last record
+				payloadOffset += consumed;
+
+				// Count the vertices, and the indices of each surface
+				const POLYGON_LIST& pols = polygons.getPolygons();
+				bool pointsInRange = hasPointsInRange(pols, firstPolygon, pols.size() - firstPolygon, points.size());
+				fill(surfaceIndices.begin(), surfaceIndices.end(), 0);
+				size_t numBatchVertices = 0;
+				for (size_t polIndex = firstPolygon; polIndex < pols.size(); polIndex++) {
+					POLYGON pol = pols[polIndex];
+					if (isDrawable(pol, points.size(), pointsInRange)) {
+						numBatchVertices += pol.numVertices;
+						surfaceIndices[polygonSurfaces[polIndex]] += (pol.numVertices - 2) * 3;
+						_numTriangles += int(pol.numVertices - 2);
+					}
+					else {
+						_numNonTriangles++;
+					}
+					if (statistics) {
+						size_t arity = pol.numVertices < LOAD_STATISTICS::MAX_ARITY ? pol.numVertices : LOAD_STATISTICS::MAX_ARITY;
+						statistics->polygonsByArity[arity]++;
+					}
+				}
+
+				// Group the batch's indices by surface, indexing on from the
+				// vertices and indices of earlier batches
+				uint32_t vertexBase = uint32_t(_vertices.size());
+				uint32_t indexBase = uint32_t(_indices.size());
+				uint32_t numBatchIndices = 0;
+				batchRanges.clear();
+				for (uint32_t surface = 0; surface < uint32_t(surfaceIndices.size()); surface++) {
+					uint32_t numSurfaceIndices = surfaceIndices[surface];
+					surfaceIndices[surface] = numBatchIndices;
+					if (numSurfaceIndices > 0) {
+						batchRanges.push_back(MESH_RANGE { surface, indexBase + numBatchIndices, numSurfaceIndices });
+					}
+					numBatchIndices += numSurfaceIndices;
+				}
+
+				// Triangulate the polygons
+				MESH_BATCH batch;
+				batch.batchIndex = batchIndex++;
+				batch.layerIndex = size_t(layerIndex);
+				batch.boundsMin = boundsMin;
+				batch.boundsMax = boundsMax;
+				batch.vertices.resize(numBatchVertices);
+				batch.indices.resize(numBatchIndices);
+				size_t vertexIndex = 0;
+				for (size_t polIndex = firstPolygon; polIndex < pols.size(); polIndex++) {
+					POLYGON pol = pols[polIndex];
+					if (isDrawable(pol, points.size(), pointsInRange)) {
+						MESH_FLOAT3 normal = calculateNormal(points[pol.pointIndex[0]], points[pol.pointIndex[1]], points[pol.pointIndex[2]]);
+						uint32_t& indexCursor = surfaceIndices[polygonSurfaces[polIndex]];
+						writePolygon(pol, points, normal, vertexBase + uint32_t(vertexIndex), batch.vertices.data() + vertexIndex, batch.indices.data() + indexCursor);
+						vertexIndex += pol.numVertices;
+						indexCursor += (pol.numVertices - 2) * 3;
+					}
+				}
+
+				// Keep the whole mesh as well, for the cache and the final result
+				_vertices.insert(_vertices.end(), batch.vertices.begin(), batch.vertices.end());
+				_indices.insert(_indices.end(), batch.indices.begin(), batch.indices.end());
+
+				// Add the batch's draw ranges to the layer's; the first continues
+				// the layer's last range if they have the same surface
+				batch.firstRange = _ranges.size();
+				for (const MESH_RANGE& range : batchRanges) {
+					if (_ranges.size() > layer.firstRange && _ranges.back().surface == range.surface) {
+						_ranges.back().numIndices += range.numIndices;
+						batch.firstRange = _ranges.size() - 1;
+					}
+					else {
+						_ranges.push_back(range);
+					}
+				}
+				batch.ranges.assign(_ranges.begin() + batch.firstRange, _ranges.end());
+
+				layer.numVertices = uint32_t(_vertices.size()) - layer.firstVertex;
+				layer.numIndices = uint32_t(_indices.size()) - layer.firstIndex;
+				layer.numRanges = uint32_t(_ranges.size()) - layer.firstRange;
+				batch.layer = layer;
+				if (_loadControl) {
+					double layerDone = (polsIndex + double(payloadOffset) / payload.size()) / numPolygonChunks;
+					_loadControl->reportProgress(LoadPhase::Triangulation, (layerIndex + layerDone) / _numLayers);
+				}
+
+				// Hand the batch over; the consumer can stop the load
+				if (batch.indices.empty()) continue;
+				if (!surfacesSent) batch.surfaces = _surfaces;
+				if (!_meshBatchCallback(batch)) {
+					errorReason = L"Load cancelled";
+					return false;
+				}
+				surfacesSent = true;
+			}
+			_numPolygons += int(polygons.getPolygons().size());
+
+			triangulationTrace.stop();
+			triangulationTimer.stop();
+		}
+		_layers.push_back(layer);
+	}
+	TraceRecorder::getShared().counter("Mesh vertices", int64_t(_vertices.size()));
+
+	if (statistics) {
+		statistics->phaseElements[size_t(LoadPhase::Triangulation)] += size_t(_numPolygons);
+		statistics->meshBytes = _vertices.size() * sizeof(VERTEX) + _indices.size() * sizeof(uint32_t);
+	}
+
+	// Display warning about unsupported polygons
+	if (_numNonTriangles > 0) {
+		errorReason = L"Some polygons had an unsupported number of vertices or missing points and were skipped.";
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Transfer mesh data from LightWave object to renderer. Every layer is
+/// extracted into its own range of one combined mesh, with its triangles
+/// grouped by surface so that each surface is one draw range. The polygons
+/// are split into blocks that are counted and triangulated in parallel: a
+/// counting sort, where each block writes its triangles of each surface
+/// after those of the blocks before it.
 /// </summary>
 /// <param name="obj">LightWave object</param>
 /// <returns>Transfer success</returns>
-bool ObjectReader::TransferMeshDataFromLWO(unique_ptr<LightWaveObject> obj, wstring& errorReason) {
+bool ObjectReader::TransferMeshDataFromLWO(LightWaveObject& obj, wstring& errorReason) {
+
+	// Replace any mesh from a previous transfer
+	LOAD_STATISTICS* statistics = GetStatisticsTarget();
+	PhaseTimer setupTimer(statistics, LoadPhase::Triangulation);
+	TraceScope setupTrace("Transfer setup");
+	_vertices.clear();
+	_indices.clear();
+	_layers.clear();
+	_surfaces.clear();
+	_ranges.clear();
 
 	// Record some data on the loaded object
+	_numPolygons = 0;					// Number of polygons in all layers
 	_numTriangles = 0;					// Number of triangles extracted
-	_numNonTriangles = 0;				// Polygons with unsupported number of vertices
-	_numLayers = obj->GetNumLayers();	// Number of LightWave object layers
+	_numNonTriangles = 0;				// Polygons with unsupported number of vertices, or missing points
+	_numLayers = obj.GetNumLayers();	// Number of LightWave object layers
 
 	// Validate object layers
 	if (_numLayers == 0) return false;
 
-	// Get surface for this layer
-	Surface::COLOR col;
-	Surface* surface = obj->GetSurfaceByLayer(0);
-	if (surface) {
-		// If a surface exists, then extract its color
-		col = surface->getColor();
-	}
-	else {
-		// Otherwise assign the default color
-		col = Surface::COLOR { 1.0f, 1.0f, 1.0f };
-	}
-
-	// Initialize vertex color
-	DirectX::XMFLOAT4 color = DirectX::XMFLOAT4(col.r, col.g, col.b, 1.0f);
-
-	// Transfer LightWave vertices to temporary list
-	vector<VERTEX> lwVertices;
-	const vector<VEC12>& points = obj->GetPointsByLayer(0);
-	for (auto& point : points) {
-		VERTEX vertex = { DirectX::XMFLOAT3(point.X, point.Y, point.Z) };
-		lwVertices.push_back(vertex);
-	}
-
-	// Transfer polygon indices
-	const vector<POLYGON>& pols = obj->GetPolsByLayer(0);
-	unsigned targetIndexOffset = 0;
-	for (auto pol : pols) {
-
-		// Note that LightWave polygons have CW winding order
-		// so the vertex order must be reversed to CCW
-		if (pol.numVertices > 2) {
-
-			// Set up initial triangle source indices
-			unsigned sourceIndexOffset = 0;
-			unsigned sourceIndex1 = pol.pointIndex[sourceIndexOffset + 0];
-			unsigned sourceIndex2 = pol.pointIndex[sourceIndexOffset + 1];
-			unsigned sourceIndex3 = pol.pointIndex[sourceIndexOffset + 2];
-			sourceIndexOffset += 3;
-
-			// Get initial source triangle vertices
-			VERTEX vert1 = lwVertices[sourceIndex1];
-			VERTEX vert2 = lwVertices[sourceIndex2];
-			VERTEX vert3 = lwVertices[sourceIndex3];
-
-			// Calculate vertex normal
-			// This should be the same for all vertices of this polygon/face
-			DirectX::XMVECTOR vec1 = {
-				vert1.pos.x - vert2.pos.x,
-				vert1.pos.y - vert2.pos.y,
-				vert1.pos.z - vert2.pos.z,
-			};
-			DirectX::XMVECTOR vec2 = {
-				vert1.pos.x - vert3.pos.x,
-				vert1.pos.y - vert3.pos.y,
-				vert1.pos.z - vert3.pos.z,
-			};
-			DirectX::XMVECTOR normal = DirectX::XMVector3Normalize(DirectX::XMVector3Cross(vec1, vec2));
-
-			// Store initial triangle vertices
-			DirectX::XMStoreFloat3(&vert1.normal, normal);
-			DirectX::XMStoreFloat3(&vert2.normal, normal);
-			DirectX::XMStoreFloat3(&vert3.normal, normal);
-			vert1.color = color;
-			vert2.color = color;
-			vert3.color = color;
-			_vertices.push_back(vert1);
-			_vertices.push_back(vert2);
-			_vertices.push_back(vert3);
-
-			// Store initial triangle indices
-			_indices.push_back(targetIndexOffset + 2); // 2
-			_indices.push_back(targetIndexOffset + 1); // 1
-			_indices.push_back(targetIndexOffset + 0); // 0
-
-			// Set up for next triangle
-			unsigned endTargetIndex = targetIndexOffset + 0;
-			unsigned midTargetIndex = targetIndexOffset + 2;
-			targetIndexOffset += 3;
-			_numTriangles++;
-
-			// Select successive opposite vectors to form each triangle
-			for (unsigned vertexIndex = 3; vertexIndex < (unsigned)pol.numVertices; vertexIndex++) {
-
-				// Get the new source vertex
-				unsigned newVertexIndex = pol.pointIndex[vertexIndex];
-				VERTEX newVertex = lwVertices[newVertexIndex];
-
-				// Assign normal to new vertex
-				DirectX::XMStoreFloat3(&newVertex.normal, normal);
-
-				// Assign color to new vertex
-				newVertex.color = color;
-
-				// Store new vertex and index
-				_vertices.push_back(newVertex);
-				_indices.push_back(targetIndexOffset);
-
-				// Store previous two vertices
-				_indices.push_back(midTargetIndex);
-				_indices.push_back(endTargetIndex);
-
-				// Set up for next triangle
-				midTargetIndex = targetIndexOffset; // Next mid vertex is this triangle's first vertex
-				targetIndexOffset++;
-				_numTriangles++;
+	// Surfaces, the points of each layer, and the polygons and polygon
+	// surfaces of each of the layers' POLS chunks, in file order. Only FACE
+	// chunks are parsed, so chunks of other polygon types have no polygons
+	vector<uint32_t> surfaceByTag;
+	getSurfaces(obj, _surfaces, surfaceByTag);
+	size_t numSurfaces = _surfaces.size();
+	vector<LAYER_TRANSFER> transfers(_numLayers);
+	vector<POLYGON_TRANSFER> polygonTransfers;
+	for (size_t layerIndex = 0; layerIndex < transfers.size(); layerIndex++) {
+		size_t numPolygonChunks = obj.GetNumPolsByLayer(int(layerIndex));
+		for (size_t polsIndex = 0; polsIndex < numPolygonChunks; polsIndex++) {
+			POLYGON_TRANSFER polygonTransfer;
+			polygonTransfer.layerIndex = layerIndex;
+			polygonTransfer.polsIndex = polsIndex;
+			polygonTransfers.push_back(move(polygonTransfer));
+		}
+	}
+	ThreadPool& threadPool = ThreadPool::getShared();
+	threadPool.parallelFor(transfers.size(), [&](size_t layerIndex) {
+		getLayerPoints(obj, int(layerIndex), transfers[layerIndex].points);
+	});
+	threadPool.parallelFor(polygonTransfers.size(), [&](size_t transferIndex) {
+		POLYGON_TRANSFER& polygonTransfer = polygonTransfers[transferIndex];
+		int layerIndex = int(polygonTransfer.layerIndex);
+		polygonTransfer.pols = &obj.GetPolsByLayer(layerIndex, polygonTransfer.polsIndex);
+		polygonTransfer.surfaces = getPolygonSurfaces(obj, layerIndex, polygonTransfer.polsIndex, surfaceByTag);
+		polygonTransfer.normals.resize(polygonTransfer.pols->size());
+	});
+
+	// Split each chunk's polygons into blocks, keeping each layer's blocks together
+	size_t totalPolygons = 0;
+	size_t numBlocks = 0;
+	for (const POLYGON_TRANSFER& polygonTransfer : polygonTransfers) {
+		numBlocks += (polygonTransfer.pols->size() + POLYGON_BATCH - 1) / POLYGON_BATCH;
+	}
+	vector<TRANSFER_BLOCK> blocks;
+	blocks.reserve(numBlocks);
+	for (size_t transferIndex = 0; transferIndex < polygonTransfers.size(); transferIndex++) {
+		const POLYGON_TRANSFER& polygonTransfer = polygonTransfers[transferIndex];
+		LAYER_TRANSFER& transfer = transfers[polygonTransfer.layerIndex];
+		if (polygonTransfer.polsIndex == 0) transfer.firstBlock = blocks.size();
+		size_t numChunkPolygons = polygonTransfer.pols->size();
+		for (size_t firstPolygon = 0; firstPolygon < numChunkPolygons; firstPolygon += POLYGON_BATCH) {
+			TRANSFER_BLOCK block;
+			block.layerIndex = polygonTransfer.layerIndex;
+			block.polygonTransfer = transferIndex;
+			block.firstPolygon = firstPolygon;
+			block.numPolygons = min(POLYGON_BATCH, numChunkPolygons - firstPolygon);
+			blocks.push_back(block);
+		}
+		transfer.numBlocks = blocks.size() - transfer.firstBlock;
+		totalPolygons += numChunkPolygons;
+	}
+	_numPolygons = int(totalPolygons);
+	setupTrace.stop();
+	setupTimer.stop();
+
+	// Face normals, shared by every vertex of a polygon, and the size of each
+	// block's mesh: an n-sided polygon becomes n vertices and n - 2 triangles.
+	// Indices are counted by surface, as blockIndices[block * numSurfaces + surface]
+	PhaseTimer normalTimer(statistics, LoadPhase::NormalGeneration);
+	TraceScope normalTrace("Normal generation", "polygons", int64_t(totalPolygons));
+	vector<uint32_t> blockIndices(blocks.size() * numSurfaces);
+	threadPool.parallelFor(blocks.size(), [&](size_t blockIndex) {
+		if (_loadControl && _loadControl->isCancelled()) return;
+		TRANSFER_BLOCK& block = blocks[blockIndex];
+		const LAYER_TRANSFER& transfer = transfers[block.layerIndex];
+		POLYGON_TRANSFER& polygonTransfer = polygonTransfers[block.polygonTransfer];
+		const POLYGON_LIST& pols = *polygonTransfer.pols;
+		uint32_t* surfaceIndices = blockIndices.data() + blockIndex * numSurfaces;
+		block.pointsInRange = hasPointsInRange(pols, block.firstPolygon, block.numPolygons, transfer.points.size());
+		for (size_t polIndex = block.firstPolygon; polIndex < block.firstPolygon + block.numPolygons; polIndex++) {
+			POLYGON pol = pols[polIndex];
+			if (isDrawable(pol, transfer.points.size(), block.pointsInRange)) {
+				polygonTransfer.normals[polIndex] = calculateNormal(transfer.points[pol.pointIndex[0]], transfer.points[pol.pointIndex[1]], transfer.points[pol.pointIndex[2]]);
+				block.numVertices += pol.numVertices;
+				block.numTriangles += pol.numVertices - 2;
+				surfaceIndices[polygonTransfer.surfaces[polIndex]] += (pol.numVertices - 2) * 3;
+			}
+			else {
+				// There were polygons with invalid numbers of vertices, or missing points
+				block.numNonTriangles++;
+			}
+			if (statistics) {
+				size_t arity = pol.numVertices < LOAD_STATISTICS::MAX_ARITY ? pol.numVertices : LOAD_STATISTICS::MAX_ARITY;
+				block.polygonsByArity[arity]++;
+			}
+		}
+	});
+	if (IsCancelled(errorReason)) return false;
+	normalTrace.stop();
+	normalTimer.stop();
+
+	// Lay the layers out one after another in the combined mesh, with each
+	// layer's vertices in polygon order and its indices in a draw range per
+	// surface. The counts become where each block writes each surface's indices
+	size_t numVertices = 0;
+	size_t numIndices = 0;
+	for (size_t layerIndex = 0; layerIndex < transfers.size(); layerIndex++) {
+		const LAYER_TRANSFER& transfer = transfers[layerIndex];
+		size_t endBlock = transfer.firstBlock + transfer.numBlocks;
+		MESH_LAYER layer = getLayerRange(obj, int(layerIndex));
+		layer.firstVertex = uint32_t(numVertices);
+		layer.firstIndex = uint32_t(numIndices);
+		layer.firstRange = uint32_t(_ranges.size());
+		for (size_t blockIndex = transfer.firstBlock; blockIndex < endBlock; blockIndex++) {
+			blocks[blockIndex].firstVertex = numVertices;
+			numVertices += blocks[blockIndex].numVertices;
+		}
+		for (uint32_t surface = 0; surface < uint32_t(numSurfaces); surface++) {
+			size_t firstIndex = numIndices;
+			for (size_t blockIndex = transfer.firstBlock; blockIndex < endBlock; blockIndex++) {
+				uint32_t& surfaceIndex = blockIndices[blockIndex * numSurfaces + surface];
+				size_t numBlockIndices = surfaceIndex;
+				surfaceIndex = uint32_t(numIndices);
+				numIndices += numBlockIndices;
+			}
+			if (numIndices > firstIndex) {
+				_ranges.push_back(MESH_RANGE { surface, uint32_t(firstIndex), uint32_t(numIndices - firstIndex) });
 			}
 		}
-		else {
-			// There were polygons with invalid numbers of vertices
-			_numNonTriangles++;
+		layer.numVertices = uint32_t(numVertices) - layer.firstVertex;
+		layer.numIndices = uint32_t(numIndices) - layer.firstIndex;
+		layer.numRanges = uint32_t(_ranges.size()) - layer.firstRange;
+		_layers.push_back(layer);
+	}
+
+	// Transfer polygon indices, each block writing straight into its places in the mesh
+	PhaseTimer triangulationTimer(statistics, LoadPhase::Triangulation);
+	TraceScope triangulationTrace("Triangulation", "polygons", int64_t(totalPolygons));
+	_vertices.resize(numVertices);
+	_indices.resize(numIndices);
+	atomic<size_t> polygonsDone {};
+	threadPool.parallelFor(blocks.size(), [&](size_t blockIndex) {
+		const TRANSFER_BLOCK& block = blocks[blockIndex];
+		const LAYER_TRANSFER& transfer = transfers[block.layerIndex];
+		const POLYGON_TRANSFER& polygonTransfer = polygonTransfers[block.polygonTransfer];
+		const POLYGON_LIST& pols = *polygonTransfer.pols;
+
+		// Stop between blocks if the load was cancelled
+		if (_loadControl) {
+			if (_loadControl->isCancelled()) return;
+			size_t started = polygonsDone.fetch_add(block.numPolygons);
+			_loadControl->reportProgress(LoadPhase::Triangulation, double(started) / totalPolygons);
+		}
+
+		uint32_t* surfaceIndices = blockIndices.data() + blockIndex * numSurfaces;
+		size_t vertexIndex = block.firstVertex;
+		for (size_t polIndex = block.firstPolygon; polIndex < block.firstPolygon + block.numPolygons; polIndex++) {
+
+			// View of the polygon's indices, without copying them
+			POLYGON pol = pols[polIndex];
+			if (isDrawable(pol, transfer.points.size(), block.pointsInRange)) {
+				uint32_t& indexCursor = surfaceIndices[polygonTransfer.surfaces[polIndex]];
+				writePolygon(pol, transfer.points, polygonTransfer.normals[polIndex], uint32_t(vertexIndex), _vertices.data() + vertexIndex, _indices.data() + indexCursor);
+				vertexIndex += pol.numVertices;
+				indexCursor += (pol.numVertices - 2) * 3;
+			}
+		}
+	});
+	if (IsCancelled(errorReason)) return false;
+
+	for (const TRANSFER_BLOCK& block : blocks) {
+		_numTriangles += int(block.numTriangles);
+		_numNonTriangles += int(block.numNonTriangles);
+	}
+
+	triangulationTrace.stop();
+	triangulationTimer.stop();
+	TraceRecorder::getShared().counter("Mesh vertices", int64_t(_vertices.size()));
+
+	if (statistics) {
+		for (const TRANSFER_BLOCK& block : blocks) {
+			for (size_t arity = 0; arity <= LOAD_STATISTICS::MAX_ARITY; arity++) {
+				statistics->polygonsByArity[arity] += block.polygonsByArity[arity];
+			}
 		}
+		statistics->phaseElements[size_t(LoadPhase::NormalGeneration)] += totalPolygons;
+		statistics->phaseElements[size_t(LoadPhase::Triangulation)] += totalPolygons;
+		statistics->meshBytes = _vertices.size() * sizeof(VERTEX) + _indices.size() * sizeof(uint32_t);
 	}
 
 	// Display warning about unsupported polygons
 	if (_numNonTriangles > 0) {
-		errorReason = L"Some polygons had an unsupported number of vertices and were skipped.";
+		errorReason = L"Some polygons had an unsupported number of vertices or missing points and were skipped.";
 	}
 
 	return true;
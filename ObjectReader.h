@@ -1,38 +1,88 @@
 #pragma once
 
-#include <DirectXMath.h>
 #include <filesystem>
-#include <windows.h>
+#include <functional>
+#include <stdint.h>
 
 #include "LightWaveObject/LightWaveObject.h"
 #include "LightWaveObject/Chunks/Surface.h"
-#include "RendererDefinitions.h"
+#include "MeshCache.h"
+#include "MeshDefinitions.h"
+
+// Triangulated polygons from one batch of a progressive load
+struct MESH_BATCH {
+	uint64_t loadId = 0;				// Load the batch came from, for consumers of several loads
+	size_t batchIndex = 0;				// Position in the load, from zero
+	size_t layerIndex = 0;				// Layer the batch's polygons belong to
+	MESH_LAYER layer {};				// That layer's range of the mesh so far, including this batch
+	size_t firstRange = 0;				// Position of the first of the ranges below in the load's draw ranges
+	std::vector<MESH_RANGE> ranges;		// Draw ranges the batch adds or extends, replacing any from firstRange on
+	std::vector<MESH_SURFACE> surfaces;	// Surface table of the load, in its first batch only
+	std::vector<VERTEX> vertices;
+	std::vector<uint32_t> indices;		// Index the vertices of the whole load, so batches can be appended as they are
+	MESH_FLOAT3 boundsMin {};			// Bounds of every point in the object, known before the first batch
+	MESH_FLOAT3 boundsMax {};
+};
 
 class ObjectReader {
 public:
 
+	// Receives each batch of a progressive load, and returns false to stop the load
+	using MeshBatchCallback = std::function<bool(MESH_BATCH& batch)>;
+
 	// Getters
-	std::vector<WORD>	GetIndices();
-	std::vector<VERTEX> GetVertices();
+	const std::wstring& GetHardwareCountersError();
+	const std::vector<uint32_t>& GetIndices();
+	const std::vector<MESH_LAYER>& GetLayers();
+	const LOAD_STATISTICS& GetLoadStatistics();
+	const std::vector<MESH_RANGE>& GetRanges();
+	const std::vector<MESH_SURFACE>& GetSurfaces();
+	const std::vector<VERTEX>& GetVertices();
 	int GetNumLayers();
 	int GetNumNonTriangles();
+	int GetNumPolygons();
 	int	GetNumTriangles();
 
+	// Setters
+	void SetCollectStatistics(bool collectStatistics);
+	void SetLoadControl(const LoadControl* loadControl);
+	void SetMeshBatchCallback(MeshBatchCallback meshBatchCallback);
+	void SetMeshCache(MeshCache* meshCache);
+	void SetSampleHardwareCounters(bool sampleHardwareCounters);
+
 	// Public methods
+	void MoveMesh(std::vector<MESH_LAYER>& layers, std::vector<MESH_SURFACE>& surfaces, std::vector<MESH_RANGE>& ranges,
+		std::vector<VERTEX>& vertices, std::vector<uint32_t>& indices);
 	bool ReadObjectFile(std::string objectPathname, std::wstring& errorReason);
+	bool TransferMeshDataFromLWO(LightWaveObject& obj, std::wstring& errorReason);
 
 private:
 
 	// Private member functions
-	bool TransferMeshDataFromLWO(unique_ptr<LightWaveObject> obj, std::wstring& errorReason);
+	LOAD_STATISTICS* GetStatisticsTarget();
+	bool IsCancelled(std::wstring& errorReason);
+	bool ReadMeshFromCache(const std::string& objectPathname);
+	void StoreMeshInCache(const std::string& objectPathname, uint64_t contentHash);
+	bool StreamMeshDataFromLWO(LightWaveObject& obj, std::wstring& errorReason);
 
 	// Private data
 	bool _objectLoaded {};
+	MeshCache* _meshCache {};				// Optional cache of triangulated meshes
+	bool _collectStatistics {};
+	LOAD_STATISTICS _statistics;			// Timings and counters of the last load
+	bool _sampleHardwareCounters {};
+	std::wstring _hardwareCountersError;
+	const LoadControl* _loadControl {};		// Checked between chunks and polygon batches, or null
+	MeshBatchCallback _meshBatchCallback;	// Set for progressive loads
 
 	// Mesh
+	std::vector<MESH_LAYER> _layers;		// Range of the mesh holding each layer
+	std::vector<MESH_SURFACE> _surfaces;	// Surfaces the draw ranges refer to
+	std::vector<MESH_RANGE> _ranges;		// Runs of each layer's indices with the same surface
 	std::vector<VERTEX> _vertices;
-	std::vector<WORD> _indices;
+	std::vector<uint32_t> _indices;
 	int _numLayers;
+	int _numPolygons;
 	int _numTriangles;
 	int _numNonTriangles;
 };
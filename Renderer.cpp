@@ -16,6 +16,23 @@ void Renderer::AdjustViewDistance(int direction) {
 	}
 }
 
+/// <summary>
+/// Get the timings and counters of the last load
+/// </summary>
+/// <returns>Load statistics</returns>
+const LOAD_STATISTICS& Renderer::GetLoadStatistics() {
+	return _loadStatistics;
+}
+
+/// <summary>
+/// Get whether a layer of the object is drawn
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <returns>True if the layer is shown</returns>
+bool Renderer::GetLayerVisible(int layerIndex) {
+	return layerIndex >= 0 && size_t(layerIndex) < _layerVisible.size() && _layerVisible[layerIndex];
+}
+
 /// <summary>
 /// Get object info
 /// </summary>
@@ -40,45 +57,25 @@ bool Renderer::Initialize(HWND outputWindow, UINT width, UINT height) {
 	// Lights
 	if (!InitializeLights()) return false;
 
+	// Background loading
+	_loader = std::make_unique<ObjectLoader>(&_meshCache);
+	_loader->SetCollectStatistics(true);
+	_loader->SetProgressive(true);
+
 	// Success
 	return true;
 }
 
 /// <summary>
-/// Load object
+/// Start loading an object in the background, cancelling any load in
+/// progress. The current object keeps rendering until the first batch of
+/// the new one streams in, or UpdateMesh swaps in a whole mesh.
 /// </summary>
-/// <returns>Load success state</returns>
-bool Renderer::LoadObject(std::string objectPathname, std::wstring& errorReason) {
-
-	// Extract mesh data from object
-	ObjectReader reader;
-	if (!reader.ReadObjectFile(objectPathname, errorReason)) {
-		return false;
-	}
-
-	// Free old buffers if required
-	if(_vertexBuffer) _vertexBuffer->Release();
-	if(_indexBuffer) _indexBuffer->Release();
-	if(_vsConstantBuffer) _vsConstantBuffer->Release();
-	if(_psConstantBuffer) _psConstantBuffer->Release();
-
-	// Get object vertices and indices
-	_vertices = reader.GetVertices();
-	_indices = reader.GetIndices();
-
-	// Set object info
-	_objectInfo.numVertices = _vertices.size();
-	_objectInfo.numLayers = reader.GetNumLayers();
-	_objectInfo.numNonTriangles = reader.GetNumNonTriangles();
-	_objectInfo.numTriangles = reader.GetNumTriangles();
-
-	// Buffers
-	if (!InitializeBuffers()) return false;
-
-	// Initialize transforms
-	if (!InitializeObjectTransforms()) return false;
-
-	return true;
+/// <param name="objectPathname">Full path and filename for the object file</param>
+/// <returns>Identifier of the load, passed to the load callbacks</returns>
+uint64_t Renderer::LoadObject(std::string objectPathname) {
+	_latestLoadId = _loader->Load(objectPathname);
+	return _latestLoadId;
 }
 
 /// <summary>
@@ -86,6 +83,8 @@ bool Renderer::LoadObject(std::string objectPathname, std::wstring& errorReason)
 /// </summary>
 void Renderer::Present() {
 
+	TraceScope trace("Present");
+
 	// Flip the back buffer
 	HRESULT hr = _swapChain->Present(0, 0);
 	assert(!FAILED(hr));
@@ -96,9 +95,7 @@ void Renderer::Present() {
 /// </summary>
 void Renderer::Render() {
 
-	// Update constant buffers
-	_deviceContext->UpdateSubresource(_vsConstantBuffer, 0, nullptr, &_vsConstantBufferData, 0, 0);
-	_deviceContext->UpdateSubresource(_psConstantBuffer, 0, nullptr, &_psConstantBufferData, 0, 0);
+	TraceScope trace("Render");
 
 	// Bind render target (Output-Merger stage)
 	_deviceContext->OMSetRenderTargets(1, &_renderTargetView, _depthStencilView);
@@ -118,8 +115,26 @@ void Renderer::Render() {
 	// Set pixel shader stage
 	_deviceContext->PSSetShader(_pixelShader, nullptr, 0);
 
-	// Draw indexed triangles
-	_deviceContext->DrawIndexed(_indices.size(), 0, 0);
+	// Update vertex shader constant buffer; every layer is in object coordinates
+	UpdateWorldMatrices(_modelMatrix);
+	_deviceContext->UpdateSubresource(_vsConstantBuffer, 0, nullptr, &_vsConstantBufferData, 0, 0);
+
+	// Draw each shown layer's range of the buffers, one draw per surface; the
+	// pixel shader constant buffer is updated before each draw
+	for (size_t layerIndex = 0; layerIndex < _layers.size(); layerIndex++) {
+		const MESH_LAYER& layer = _layers[layerIndex];
+		if (!_layerVisible[layerIndex] || layer.numIndices == 0) continue;
+
+		// Draw indexed triangles, a surface at a time
+		uint32_t endRange = layer.firstRange + layer.numRanges;
+		for (uint32_t rangeIndex = layer.firstRange; rangeIndex < endRange && rangeIndex < _ranges.size(); rangeIndex++) {
+			const MESH_RANGE& range = _ranges[rangeIndex];
+			const MESH_FLOAT4 color = range.surface < _surfaces.size() ? _surfaces[range.surface].color : MESH_FLOAT4 { 1.0f, 1.0f, 1.0f, 1.0f };
+			_psConstantBufferData.surfaceColor = DirectX::XMFLOAT4(color.x, color.y, color.z, color.w);
+			_deviceContext->UpdateSubresource(_psConstantBuffer, 0, nullptr, &_psConstantBufferData, 0, 0);
+			_deviceContext->DrawIndexed(range.numIndices, range.firstIndex, 0);
+		}
+	}
 }
 
 /// <summary>
@@ -158,6 +173,9 @@ void Renderer::Rotate(float yaw, float pitch) {
 /// </summary>
 void Renderer::Shutdown() {
 
+	// Stop loading before the resources go
+	_loader.reset();
+
 	// Depth stencil
 	if (_depthStencilState) _depthStencilState->Release();
 	if (_depthStencilView) _depthStencilView->Release();
@@ -182,6 +200,17 @@ void Renderer::Shutdown() {
 	_device->Release();
 }
 
+/// <summary>
+/// Set the functions told how background loads progress and end. Both are
+/// called on loader threads.
+/// </summary>
+/// <param name="progressCallback">Progress function, or empty for none</param>
+/// <param name="completionCallback">Completion function, or empty for none</param>
+void Renderer::SetLoadCallbacks(ObjectLoader::ProgressCallback progressCallback, ObjectLoader::CompletionCallback completionCallback) {
+	_loader->SetProgressCallback(move(progressCallback));
+	_loader->SetCompletionCallback(move(completionCallback));
+}
+
 /// <summary>
 /// Tumble model
 /// </summary>
@@ -196,6 +225,8 @@ void Renderer::Tumble(bool tumble) {
 /// </summary>
 void Renderer::Update() {
 
+	TraceScope trace("Update");
+
 	// Get current time
 	ULONGLONG currentTime = GetTickCount64();
 
@@ -218,15 +249,297 @@ void Renderer::Update() {
 	float farPlane = 500.0f;
 	_projectionMatrix = DirectX::XMMatrixTranspose(DirectX::XMMatrixPerspectiveFovRH(fovAngleY, aspectRatio, nearPlane, farPlane));
 
+	UpdateWorldMatrices(_modelMatrix);
+}
+
+/// <summary>
+/// Store the world, world-view and world-view-projection matrices for the
+/// vertex shader, from the current view and projection
+/// </summary>
+/// <param name="worldMatrix">World matrix of the geometry to draw</param>
+void Renderer::UpdateWorldMatrices(const DirectX::XMMATRIX& worldMatrix) {
+
+	// Update world
+	DirectX::XMStoreFloat4x4(&_vsConstantBufferData.world, worldMatrix);
+
 	// Update world-view
-	DirectX::XMMATRIX worldViewMatrix = _modelMatrix * _viewMatrix;
+	DirectX::XMMATRIX worldViewMatrix = worldMatrix * _viewMatrix;
 	DirectX::XMStoreFloat4x4(&_vsConstantBufferData.worldView, worldViewMatrix);
 
 	// Update world-view-projection
-	DirectX::XMMATRIX worldViewProjectionMatrix = _projectionMatrix * _viewMatrix * _modelMatrix;
+	DirectX::XMMATRIX worldViewProjectionMatrix = _projectionMatrix * _viewMatrix * worldMatrix;
 	DirectX::XMStoreFloat4x4(&_vsConstantBufferData.worldViewProj, worldViewProjectionMatrix);
 }
 
+/// <summary>
+/// Build the object buffers from the latest loaded mesh, if it has changed.
+/// Call between frames, once a load has completed.
+/// </summary>
+/// <param name="errorReason">Reason for the failure</param>
+/// <returns>False if the buffers couldn't be created</returns>
+bool Renderer::UpdateMesh(std::wstring& errorReason) {
+
+	// Every batch was queued before the load completed
+	UpdateStreamedMesh();
+
+	// Nothing to do until a different mesh is published
+	std::shared_ptr<const ObjectLoader::MESH_SNAPSHOT> mesh = _loader->GetMesh();
+	if (!mesh || mesh == _mesh) return true;
+	_mesh = mesh;
+	_loadStatistics = mesh->statistics;
+
+	// Set object info
+	_objectInfo.numVertices = int(mesh->vertices.size());
+	_objectInfo.numLayers = mesh->numLayers;
+	_objectInfo.numNonTriangles = mesh->numNonTriangles;
+	_objectInfo.numTriangles = mesh->numTriangles;
+
+	// A mesh that streamed in whole is already in the buffers; layers it
+	// streamed keep the visibility they were given meanwhile
+	bool streamed = mesh->loadId == _streamLoadId && mesh->indices.size() == _streamNumIndices;
+	_streamLoadId = 0;
+	if (!streamed) _layers.clear();
+	SetLayers(mesh->layers);
+	_surfaces = mesh->surfaces;
+	_ranges = mesh->ranges;
+	if (streamed) return true;
+
+	// Free old buffers if required
+	ReleaseObjectBuffers();
+
+	// Buffers
+	PhaseTimer bufferTimer(&_loadStatistics, LoadPhase::BufferCreation);
+	TraceScope bufferTrace("Buffer creation");
+	if (!InitializeBuffers()) {
+		errorReason = L"Couldn't create the object buffers";
+		_layers.clear();
+		_ranges.clear();
+		return false;
+	}
+	bufferTrace.stop();
+	bufferTimer.stop();
+	_loadStatistics.totalSeconds += _loadStatistics.phaseSeconds[size_t(LoadPhase::BufferCreation)];
+	_loadStatistics.phaseElements[size_t(LoadPhase::BufferCreation)] += mesh->vertices.size();
+
+	// Initialize transforms
+	if (!InitializeObjectTransforms(GetObjectWidth())) return false;
+
+	return true;
+}
+
+/// <summary>
+/// Append the batches of the latest progressive load that have arrived
+/// since the last frame. The first batch of a load replaces the current
+/// object. Each batch goes straight into the buffers, so the streamed mesh
+/// isn't also kept on the CPU. Call between frames.
+/// </summary>
+/// <returns>True if there's streamed geometry to draw</returns>
+bool Renderer::UpdateStreamedMesh() {
+
+	MESH_BATCH batch;
+	while (_loader->PopBatch(batch)) {
+
+		// Skip batches of replaced loads, and of loads already swapped in whole
+		if (batch.loadId != _latestLoadId || (_mesh && _mesh->loadId == batch.loadId)) continue;
+
+		// Start streaming a new object, framed by the bounds of all its points
+		if (batch.loadId != _streamLoadId) {
+			_streamLoadId = batch.loadId;
+			_streamNumVertices = 0;
+			_streamNumIndices = 0;
+			_mesh.reset();
+			_layers.clear();
+			_surfaces.clear();
+			_ranges.clear();
+			_vertexCapacity = 0;
+			_indexCapacity = 0;
+			InitializeObjectTransforms(batch.boundsMax.x - batch.boundsMin.x);
+		}
+
+		// Append the batch's geometry to the buffers
+		if (!UploadStreamBatch(batch)) {
+			_layers.clear();
+			_ranges.clear();
+			return false;
+		}
+
+		// The batch's layer now covers the batch as well
+		if (batch.layerIndex >= _layers.size()) {
+			_layers.resize(batch.layerIndex + 1, MESH_LAYER {});
+			_layerVisible.resize(batch.layerIndex + 1, true);
+			_layerVisible[batch.layerIndex] = (batch.layer.flags & MESH_LAYER::HIDDEN) == 0;
+		}
+		_layers[batch.layerIndex] = batch.layer;
+
+		// The batch's draw ranges replace the last ones of the load, which
+		// may have grown; the surfaces come with the first batch
+		_ranges.resize(batch.firstRange);
+		_ranges.insert(_ranges.end(), batch.ranges.begin(), batch.ranges.end());
+		if (!batch.surfaces.empty()) _surfaces = batch.surfaces;
+	}
+
+	return _streamLoadId != 0;
+}
+
+/// <summary>
+/// Show or hide a layer of the object, without touching the buffers
+/// </summary>
+/// <param name="layerIndex">Layer index</param>
+/// <param name="visible">True to draw the layer</param>
+void Renderer::SetLayerVisible(int layerIndex, bool visible) {
+	if (layerIndex >= 0 && size_t(layerIndex) < _layerVisible.size()) {
+		_layerVisible[layerIndex] = visible;
+	}
+}
+
+/// <summary>
+/// Replace the layer table. Layers already in the table keep their
+/// visibility, and new ones are shown unless the object hides them.
+/// </summary>
+/// <param name="layers">Range of the buffers holding each layer</param>
+void Renderer::SetLayers(const std::vector<MESH_LAYER>& layers) {
+
+	size_t numKnown = _layers.size() < layers.size() ? _layers.size() : layers.size();
+	_layerVisible.resize(layers.size());
+	for (size_t layerIndex = numKnown; layerIndex < layers.size(); layerIndex++) {
+		_layerVisible[layerIndex] = (layers[layerIndex].flags & MESH_LAYER::HIDDEN) == 0;
+	}
+	_layers = layers;
+}
+
+/// <summary>
+/// Stop drawing the geometry of a progressive load that failed
+/// </summary>
+/// <returns>True if streamed geometry was being drawn</returns>
+bool Renderer::DiscardStreamedMesh() {
+
+	if (_streamLoadId == 0) return false;
+
+	_streamLoadId = 0;
+	_layers.clear();
+	_surfaces.clear();
+	_ranges.clear();
+
+	return true;
+}
+
+/// <summary>
+/// Recreate the vertex and index buffers with room for the streamed
+/// geometry, at least doubling them so a load reallocates only a few times.
+/// What's been streamed so far is copied from the old buffers on the GPU.
+/// </summary>
+/// <param name="numVertices">Vertices the vertex buffer must have room for</param>
+/// <param name="numIndices">Indices the index buffer must have room for</param>
+/// <returns>Creation success</returns>
+bool Renderer::GrowStreamBuffers(size_t numVertices, size_t numIndices) {
+
+	HRESULT hr;
+
+	_vertexCapacity = _vertexCapacity * 2 > numVertices ? _vertexCapacity * 2 : numVertices;
+	_indexCapacity = _indexCapacity * 2 > numIndices ? _indexCapacity * 2 : numIndices;
+
+	// Create vertex buffer
+	ID3D11Buffer* vertexBuffer = nullptr;
+	D3D11_BUFFER_DESC bufferDescription;
+	ZeroMemory(&bufferDescription, sizeof(D3D11_BUFFER_DESC));
+	bufferDescription.Usage = D3D11_USAGE_DEFAULT;
+	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bufferDescription.ByteWidth = UINT(sizeof(VERTEX) * _vertexCapacity);
+	hr = _device->CreateBuffer(&bufferDescription, nullptr, &vertexBuffer);
+	if (FAILED(hr)) return false;
+
+	// Create index buffer
+	ID3D11Buffer* indexBuffer = nullptr;
+	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	bufferDescription.ByteWidth = UINT(sizeof(uint32_t) * _indexCapacity);
+	hr = _device->CreateBuffer(&bufferDescription, nullptr, &indexBuffer);
+	if (FAILED(hr)) {
+		vertexBuffer->Release();
+		return false;
+	}
+
+	// Copy the geometry streamed so far; buffer boxes are byte ranges along x
+	D3D11_BOX box = { 0, 0, 0, 0, 1, 1 };
+	if (_vertexBuffer && _streamNumVertices > 0) {
+		box.right = UINT(sizeof(VERTEX) * _streamNumVertices);
+		_deviceContext->CopySubresourceRegion(vertexBuffer, 0, 0, 0, 0, _vertexBuffer, 0, &box);
+	}
+	if (_indexBuffer && _streamNumIndices > 0) {
+		box.right = UINT(sizeof(uint32_t) * _streamNumIndices);
+		_deviceContext->CopySubresourceRegion(indexBuffer, 0, 0, 0, 0, _indexBuffer, 0, &box);
+	}
+
+	// Replace the old buffers
+	if (_vertexBuffer) _vertexBuffer->Release();
+	if (_indexBuffer) _indexBuffer->Release();
+	_vertexBuffer = vertexBuffer;
+	_indexBuffer = indexBuffer;
+
+	UINT stride = sizeof(VERTEX);
+	UINT offset = 0;
+	_deviceContext->IASetVertexBuffers(0, 1, &_vertexBuffer, &stride, &offset);
+	_deviceContext->IASetIndexBuffer(_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// The first object streamed in has no constant buffers yet
+	if (!_vsConstantBuffer && !InitializeConstantBuffers()) return false;
+
+	return true;
+}
+
+/// <summary>
+/// Release the object's vertex, index and constant buffers
+/// </summary>
+void Renderer::ReleaseObjectBuffers() {
+
+	if(_vertexBuffer) _vertexBuffer->Release();
+	if(_indexBuffer) _indexBuffer->Release();
+	if(_vsConstantBuffer) _vsConstantBuffer->Release();
+	if(_psConstantBuffer) _psConstantBuffer->Release();
+	_vertexBuffer = nullptr;
+	_indexBuffer = nullptr;
+	_vsConstantBuffer = nullptr;
+	_psConstantBuffer = nullptr;
+	_vertexCapacity = 0;
+	_indexCapacity = 0;
+}
+
+/// <summary>
+/// Append a batch of a progressive load to the buffers, growing them if
+/// it doesn't fit
+/// </summary>
+/// <param name="batch">Batch to append</param>
+/// <returns>False if the buffers couldn't grow</returns>
+bool Renderer::UploadStreamBatch(const MESH_BATCH& batch) {
+
+	if (batch.indices.empty()) return true;
+
+	TraceScope trace("Stream upload", "indices", int64_t(batch.indices.size()));
+	size_t numVertices = _streamNumVertices + batch.vertices.size();
+	size_t numIndices = _streamNumIndices + batch.indices.size();
+	if (numVertices > _vertexCapacity || numIndices > _indexCapacity) {
+		if (!GrowStreamBuffers(numVertices, numIndices)) return false;
+	}
+
+	// Buffer boxes are byte ranges along x
+	D3D11_BOX box = { 0, 0, 0, 0, 1, 1 };
+
+	if (!batch.vertices.empty()) {
+		box.left = UINT(sizeof(VERTEX) * _streamNumVertices);
+		box.right = UINT(sizeof(VERTEX) * numVertices);
+		_deviceContext->UpdateSubresource(_vertexBuffer, 0, &box, batch.vertices.data(), 0, 0);
+	}
+
+	box.left = UINT(sizeof(uint32_t) * _streamNumIndices);
+	box.right = UINT(sizeof(uint32_t) * numIndices);
+	_deviceContext->UpdateSubresource(_indexBuffer, 0, &box, batch.indices.data(), 0, 0);
+
+	_streamNumVertices = numVertices;
+	_streamNumIndices = numIndices;
+
+	return true;
+}
+
 /// <summary>
 /// Initialize the depth buffer
 /// </summary>
@@ -438,7 +751,6 @@ bool Renderer::InitializeShaders() {
 	D3D11_INPUT_ELEMENT_DESC layoutDescription[] = {
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 	// { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	UINT numLayoutElements = ARRAYSIZE(layoutDescription);
@@ -496,12 +808,12 @@ bool Renderer::InitializeBuffers() {
 	ZeroMemory(&bufferDescription, sizeof(D3D11_BUFFER_DESC));
 	bufferDescription.Usage = D3D11_USAGE_DEFAULT;
 	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferDescription.ByteWidth = sizeof(VERTEX) * _vertices.size();
+	bufferDescription.ByteWidth = UINT(sizeof(VERTEX) * _mesh->vertices.size());
 
 	// Create vertex buffer
 	D3D11_SUBRESOURCE_DATA vertexInitData;
 	ZeroMemory(&vertexInitData, sizeof(D3D11_SUBRESOURCE_DATA));
-	vertexInitData.pSysMem = &_vertices[0];
+	vertexInitData.pSysMem = _mesh->vertices.data();
 	hr = _device->CreateBuffer(&bufferDescription, &vertexInitData, &_vertexBuffer);
 	if (FAILED(hr)) return false;
 
@@ -515,21 +827,21 @@ bool Renderer::InitializeBuffers() {
 
 	// Configure index buffer description
 	bufferDescription.Usage = D3D11_USAGE_DEFAULT;
-	bufferDescription.ByteWidth = sizeof(WORD) * _indices.size();
+	bufferDescription.ByteWidth = UINT(sizeof(uint32_t) * _mesh->indices.size());
 	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bufferDescription.CPUAccessFlags = 0;
 
 	// Configure index buffer initialization data
 	D3D11_SUBRESOURCE_DATA indexInitData;
 	ZeroMemory(&indexInitData, sizeof(D3D11_SUBRESOURCE_DATA));
-	indexInitData.pSysMem = &_indices[0];
+	indexInitData.pSysMem = _mesh->indices.data();
 
 	// Create index buffer
 	hr = _device->CreateBuffer(&bufferDescription, &indexInitData, &_indexBuffer);
 	if (FAILED(hr)) return false;
 
-	// Set index buffer
-	_deviceContext->IASetIndexBuffer(_indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	// Set index buffer; 32-bit indices allow meshes over 65535 vertices
+	_deviceContext->IASetIndexBuffer(_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	// Configure primitive topology
 	_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -537,6 +849,17 @@ bool Renderer::InitializeBuffers() {
 	///////////////////////////////////////
 	// Constant Buffers
 
+	return InitializeConstantBuffers();
+}
+
+/// <summary>
+/// Initialize the shader constant buffers
+/// </summary>
+/// <returns>Initialization success</returns>
+bool Renderer::InitializeConstantBuffers() {
+
+	HRESULT hr;
+
 	// Create vertex shader constant buffer 
 	CD3D11_BUFFER_DESC vsConstantBufferDesc(sizeof(_vsConstantBufferData), D3D11_BIND_CONSTANT_BUFFER);
 	hr = _device->CreateBuffer(&vsConstantBufferDesc, nullptr, &_vsConstantBuffer);
@@ -557,15 +880,13 @@ bool Renderer::InitializeBuffers() {
 /// <summary>
 /// Initialize and store object transformations
 /// </summary>
+/// <param name="objectWidth">Width of the object, which sets the view distance</param>
 /// <returns></returns>
-bool Renderer::InitializeObjectTransforms() {
+bool Renderer::InitializeObjectTransforms(float objectWidth) {
 
 	// Initialize object translation
 	_modelMatrix = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f);
 
-	// Get object dimensions
-	float objectWidth = GetObjectWidth();
-
 	// Calculate required view distance
 	_viewZ = (objectWidth / 2.0f) / tan(45.0f) * -15.0f;
 
@@ -630,18 +951,26 @@ ID3DBlob* Renderer::CompileShaderFromFile(LPCWSTR shaderPathname, LPCSTR compile
 float Renderer::GetObjectWidth() {
 
 	// Initialize min and max dimensions
-	float minX = _vertices[0].pos.x;
-	float maxX = minX;
-
-	// Check all vertices
-	for (VERTEX& vertex : _vertices) {
-
-		// Update min and max
-		if (vertex.pos.x < minX) {
-			minX = vertex.pos.x;
-		}
-		else if (vertex.pos.x > maxX) {
-			maxX = vertex.pos.x;
+	float minX = 0.0f;
+	float maxX = 0.0f;
+	bool first = true;
+
+	// Check all vertices of every layer
+	for (const MESH_LAYER& layer : _mesh->layers) {
+		for (uint32_t vertexIndex = layer.firstVertex; vertexIndex < layer.firstVertex + layer.numVertices; vertexIndex++) {
+			float x = _mesh->vertices[vertexIndex].pos.x;
+
+			// Update min and max
+			if (first) {
+				minX = maxX = x;
+				first = false;
+			}
+			else if (x < minX) {
+				minX = x;
+			}
+			else if (x > maxX) {
+				maxX = x;
+			}
 		}
 	}
 
@@ -4,11 +4,12 @@
 #include <DirectXMath.h>
 
 #include <assert.h>
+#include <memory>
 #include <stdio.h>
 #include <string>
 #include <vector>
 
-#include "ObjectReader.h"
+#include "ObjectLoader.h"
 #include "RendererDefinitions.h"
 
 class Renderer {
@@ -23,12 +24,19 @@ public:
 	};
 
 	// Getters
+	bool GetLayerVisible(int layerIndex);
+	const LOAD_STATISTICS& GetLoadStatistics();
 	ObjectInfo	GetObjectInfo();
 
+	// Setters
+	void SetLayerVisible(int layerIndex, bool visible);
+	void SetLoadCallbacks(ObjectLoader::ProgressCallback progressCallback, ObjectLoader::CompletionCallback completionCallback);
+
 	// Public methods
 	void AdjustViewDistance(int direction);
+	bool DiscardStreamedMesh();
 	bool Initialize(HWND outputWindow, UINT width, UINT height);
-	bool LoadObject(std::string objectPathname, std::wstring& errorReason);
+	uint64_t LoadObject(std::string objectPathname);
 	void Present();
 	void Render();
 	void ResetTransformations();
@@ -36,6 +44,8 @@ public:
 	void Shutdown();
 	void Tumble(bool tumble);
 	void Update();
+	bool UpdateMesh(std::wstring& errorReason);
+	bool UpdateStreamedMesh();
 
 private:
 
@@ -48,9 +58,16 @@ private:
 	bool InitializeViewport();
 
 	bool InitializeBuffers();
-	bool InitializeObjectTransforms();
+	bool InitializeConstantBuffers();
+	bool InitializeObjectTransforms(float objectWidth);
 	bool InitializeLights();
 
+	bool GrowStreamBuffers(size_t numVertices, size_t numIndices);
+	void ReleaseObjectBuffers();
+	void SetLayers(const std::vector<MESH_LAYER>& layers);
+	void UpdateWorldMatrices(const DirectX::XMMATRIX& worldMatrix);
+	bool UploadStreamBatch(const MESH_BATCH& batch);
+
 	ID3DBlob* CompileShaderFromFile(LPCWSTR shaderPathname, LPCSTR compilerTarget);
 	float GetObjectWidth();
 
@@ -91,11 +108,25 @@ private:
 	UINT _windowHeight;
 
 	// Mesh
-	std::vector<VERTEX> _vertices;
-	std::vector<WORD> _indices;
+	MeshCache _meshCache;					// Triangulated meshes of objects loaded before
+	std::unique_ptr<ObjectLoader> _loader;	// Loads objects in the background
+	std::shared_ptr<const ObjectLoader::MESH_SNAPSHOT> _mesh;	// Mesh the buffers were built from
+	std::vector<MESH_LAYER> _layers;		// Range of the buffers holding each layer
+	std::vector<MESH_SURFACE> _surfaces;	// Shading of each surface
+	std::vector<MESH_RANGE> _ranges;		// Index range of each layer's surfaces
+	std::vector<bool> _layerVisible;		// Whether each layer is drawn
+
+	// Progressive loads, appended to the buffers as their batches arrive
+	uint64_t _latestLoadId {};				// Batches of other loads are skipped
+	uint64_t _streamLoadId {};				// Load being streamed into the buffers, or zero
+	size_t _streamNumVertices {};			// Vertices streamed into the vertex buffer so far
+	size_t _streamNumIndices {};			// Indices streamed into the index buffer so far
+	size_t _vertexCapacity {};				// Vertices the vertex buffer has room for
+	size_t _indexCapacity {};				// Indices the index buffer has room for
 
 	// Object info
 	ObjectInfo _objectInfo;
+	LOAD_STATISTICS _loadStatistics;		// Timings and counters of the last load
 
 	// Transformations
 	DirectX::XMMATRIX _modelMatrix;
@@ -4,14 +4,7 @@
 #pragma once
 #include <DirectXMath.h>
 
-//
-// Vertex structure
-//
-struct VERTEX {
-    DirectX::XMFLOAT3 pos;
-	DirectX::XMFLOAT3 normal;
-    DirectX::XMFLOAT4 color;
-};
+#include "MeshDefinitions.h"
 
 //
 // Vertex shader constant buffer
@@ -29,6 +22,7 @@ struct CONSTANT_BUFFER_PS {
 	DirectX::XMFLOAT4 ambient;
 	DirectX::XMFLOAT3 lightPosition;
 	bool padding;
+	DirectX::XMFLOAT4 surfaceColor;	// Color of the surface being drawn
 };
 
 //
@@ -6,6 +6,7 @@ cbuffer psCB : register(b1)
 {
     float4 ambient;
     float3 lightPosition;
+    float4 surfaceColor;
 };
 
 struct PS_INPUT
@@ -13,7 +14,6 @@ struct PS_INPUT
     float4 position : SV_POSITION;
     float3 worldPosition : POSITION0;
     float3 worldNormal : NORMAL;
-    float4 color : COLOR0;
 };
 
 //
@@ -26,7 +26,7 @@ float4 main(PS_INPUT i) : SV_TARGET
     float diff = saturate(dot(i.worldNormal, -lightDir));
     
     // Calculate output color
-    float3 col = ambient.rgb + (i.color.rgb * diff);
+    float3 col = ambient.rgb + (surfaceColor.rgb * diff);
     
     return float4(col, 1.0f);
 }
\ No newline at end of file
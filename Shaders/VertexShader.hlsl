@@ -13,7 +13,6 @@ struct VS_INPUT
 {
     float4 pos : POSITION;
     float4 normal : NORMAL0;
-    float4 col : COLOR0;
 };
 
 struct VS_OUTPUT
@@ -21,7 +20,6 @@ struct VS_OUTPUT
     float4 pos : SV_Position;
     float3 worldPosition : POSITION0;
     float3 worldNormal : NORMAL0;
-    float4 col : COLOR0;
 };
 
 //
@@ -31,11 +29,8 @@ VS_OUTPUT main(VS_INPUT i)
 {
     VS_OUTPUT o;
     
-    // Pass through some values
-    o.col = i.col;
-    
-    // Transform normal
-    o.worldNormal = normalize(mul(i.normal, world)).xyz;
+    // Transform normal as a direction, so the world translation isn't applied
+    o.worldNormal = normalize(mul(float4(i.normal.xyz, 0.0f), world).xyz);
     
     // Calculate vertex world position
     o.worldPosition = mul(i.pos, world).xyz;